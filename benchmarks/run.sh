@@ -0,0 +1,27 @@
+#!/bin/bash
+# Compares the time taken by each way of running a program: the native executable, the code compiled in memory (`--run`)
+# the bytecode VM (`--vm`) and the C translation (`--emit-c`) compiled by `cc -O2`. `empty.bc` measures the startup time.
+# The calls aren't computed while compiling (`--max-evaluation-steps=0`), so that the programs run all their code.
+# Usage: benchmarks/run.sh PATH_TO_COMPILER
+COMPILER=$(realpath "${1:-build/Compiler}")
+BENCHMARKS=$(dirname "$(realpath "$0")")
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+measure()
+{
+    local start=$(date +%s%N)
+    "$@" </dev/null >/dev/null 2>&1
+    local code=$?
+    echo "$(( ($(date +%s%N) - start) / 1000000 )) ms (exit $code)"
+}
+
+for program in "$BENCHMARKS"/*.bc; do
+    echo "$(basename "$program")"
+    (cd "$WORK" && "$COMPILER" --emit-executable --target=linux --max-evaluation-steps=0 "$program" </dev/null >/dev/null 2>&1)
+    echo "  native:    $(measure "$WORK/out")"
+    echo "  --run:     $(measure "$COMPILER" --run --max-evaluation-steps=0 "$program")"
+    echo "  --vm:      $(measure "$COMPILER" --vm --max-evaluation-steps=0 "$program")"
+    (cd "$WORK" && "$COMPILER" --emit-c "$program" </dev/null >/dev/null 2>&1 && cc -O2 -o out_c out.c)
+    echo "  C -O2:     $(measure "$WORK/out_c")"
+done
\ No newline at end of file
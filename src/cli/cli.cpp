@@ -1,11 +1,57 @@
 #include "cli.hpp"
 
-CLIArguments::CLIArguments(int argc, char* argv[]) : pathToFileToCompile(pathToFileToCompile)
+#include <string>
+#include <charconv>
+
+// Reads the number after the prefix of an option like `--max-evaluation-steps=N`
+static bool parseNumberOption(const std::string& option, const std::string& prefix, size_t& value)
+{
+    if(option.rfind(prefix, 0) != 0)
+        return false;
+    const char* end = option.data() + option.size();
+    auto result = std::from_chars(option.data() + prefix.size(), end, value);
+    return result.ec == std::errc() && result.ptr == end && option.size() > prefix.size();
+}
+
+CLIArguments::CLIArguments(int argc, char* argv[]) : pathToFileToCompile(pathToFileToCompile), outputFormat(OutputFormat::Assembly),
+    targetPlatform(TargetPlatform::Windows), isRunRequested(false), isInterpretRequested(false), areBoundsChecked(true), isAvx2Enabled(false),
+    maxEvaluationSteps(DEFAULT_MAX_EVALUATION_STEPS), maxEvaluationDepth(DEFAULT_MAX_EVALUATION_DEPTH)
 {
-    if(argc != 2)
+    // Every parameter before the path is an option
+    bool isValid = argc >= 2;
+    for(int i = 1; i < argc - 1; i++)
     {
-        std::cerr << "You need to pass exactly 1 parameter to this program" << std::endl;
-        std::cerr << "Parameter: [PATH_TO_FILE_TO_COMPILE]" << std::endl;
+        std::string option = argv[i];
+        if(option == "--emit-object")
+            outputFormat = OutputFormat::ObjectFile;
+        else if(option == "--emit-executable")
+            outputFormat = OutputFormat::Executable;
+        else if(option == "--emit-c")
+            outputFormat = OutputFormat::C;
+        else if(option == "--target=windows")
+            targetPlatform = TargetPlatform::Windows;
+        else if(option == "--target=linux")
+            targetPlatform = TargetPlatform::Linux;
+        else if(option == "--run")
+            isRunRequested = true;
+        else if(option == "--vm")
+            isInterpretRequested = true;
+        else if(option == "--no-bounds-checks")
+            areBoundsChecked = false;
+        else if(option == "--avx2")
+            isAvx2Enabled = true;
+        else if(parseNumberOption(option, "--max-evaluation-steps=", maxEvaluationSteps))
+            continue;
+        else if(parseNumberOption(option, "--max-evaluation-depth=", maxEvaluationDepth))
+            continue;
+        else
+            isValid = false;
+    }
+
+    if(!isValid)
+    {
+        std::cerr << "You need to pass the path of the file to compile to this program, optionally preceded by some options" << std::endl;
+        std::cerr << "Parameters: [--emit-object | --emit-executable | --emit-c | --run | --vm] [--target=windows | --target=linux] [--no-bounds-checks] [--avx2] [--max-evaluation-steps=N] [--max-evaluation-depth=N] [PATH_TO_FILE_TO_COMPILE]" << std::endl;
         std::cerr << "Example:" << std::endl;
         std::cerr << "Compiler.exe my_program.bc" << std::endl;
 
@@ -14,10 +60,50 @@ CLIArguments::CLIArguments(int argc, char* argv[]) : pathToFileToCompile(pathToF
         return;
     }
 
-    pathToFileToCompile = argv[1];
+    pathToFileToCompile = argv[argc - 1];
 }
 
 char* CLIArguments::getPathToFileToCompile()
 {
     return pathToFileToCompile;
+}
+
+OutputFormat CLIArguments::getOutputFormat()
+{
+    return outputFormat;
+}
+
+TargetPlatform CLIArguments::getTargetPlatform()
+{
+    return targetPlatform;
+}
+
+bool CLIArguments::shouldRun()
+{
+    return isRunRequested;
+}
+
+bool CLIArguments::shouldInterpret()
+{
+    return isInterpretRequested;
+}
+
+bool CLIArguments::shouldCheckBounds()
+{
+    return areBoundsChecked;
+}
+
+bool CLIArguments::shouldUseAvx2()
+{
+    return isAvx2Enabled;
+}
+
+size_t CLIArguments::getMaxEvaluationSteps()
+{
+    return maxEvaluationSteps;
+}
+
+size_t CLIArguments::getMaxEvaluationDepth()
+{
+    return maxEvaluationDepth;
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include <iostream>
 
+#include "../compiler/settings.hpp"
+#include "../compiler/generation/target.hpp"
+#include "../compiler/optimizer/compile_time_evaluation.hpp"
+
 /**
  * @struct CLIArguments
  * @brief A structure representing command-line interface (CLI) arguments for the compiler program.
@@ -27,6 +31,71 @@ public:
      */
     char* getPathToFileToCompile();
 
+    /**
+     * @brief Retrieves the kind of file that the compiler must write.
+     *
+     * @return OutputFormat::ObjectFile if `--emit-object` is passed, OutputFormat::Executable if `--emit-executable` is passed,
+     * OutputFormat::C if `--emit-c` is passed, otherwise OutputFormat::Assembly.
+     */
+    OutputFormat getOutputFormat();
+
+    /**
+     * @brief Retrieves the operating system the compiled program runs on.
+     *
+     * @return TargetPlatform::Linux if `--target=linux` is passed, otherwise TargetPlatform::Windows.
+     */
+    TargetPlatform getTargetPlatform();
+
+    /**
+     * @brief Checks if the program must be run in the compiler instead of being written to a file.
+     *
+     * @return True if `--run` is passed.
+     */
+    bool shouldRun();
+
+    /**
+     * @brief Checks if the program must be compiled to bytecode and run by the virtual machine of the compiler.
+     *
+     * @return True if `--vm` is passed.
+     */
+    bool shouldInterpret();
+
+    /**
+     * @brief Checks if the generated code must check that the indices of the elements are in the bounds of their array.
+     *
+     * @return False if `--no-bounds-checks` is passed.
+     */
+    bool shouldCheckBounds();
+
+    /**
+     * @brief Checks if the vectorized loops can use the AVX2 instructions.
+     *
+     * @return True if `--avx2` is passed.
+     */
+    bool shouldUseAvx2();
+
+    /**
+     * @brief Retrieves the number of statements and expressions that the evaluation of each call can run while compiling.
+     *
+     * @return N if `--max-evaluation-steps=N` is passed, otherwise DEFAULT_MAX_EVALUATION_STEPS (0 doesn't evaluate any call).
+     */
+    size_t getMaxEvaluationSteps();
+
+    /**
+     * @brief Retrieves the number of nested calls that the evaluation of each call can reach while compiling.
+     *
+     * @return N if `--max-evaluation-depth=N` is passed, otherwise DEFAULT_MAX_EVALUATION_DEPTH.
+     */
+    size_t getMaxEvaluationDepth();
+
 private:
     char* pathToFileToCompile;
+    OutputFormat outputFormat;
+    TargetPlatform targetPlatform;
+    bool isRunRequested;
+    bool isInterpretRequested;
+    bool areBoundsChecked;
+    bool isAvx2Enabled;
+    size_t maxEvaluationSteps;
+    size_t maxEvaluationDepth;
 };
\ No newline at end of file
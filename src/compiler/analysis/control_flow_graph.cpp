@@ -0,0 +1,106 @@
+#include "control_flow_graph.hpp"
+
+ControlFlowGraph::ControlFlowGraph(const std::vector<StatementNode*>& statements)
+{
+    entry = createBlock();
+    exit = createBlock();
+    size_t last = build(statements, entry);
+    addEdge(last, exit);
+}
+
+const std::vector<BasicBlock>& ControlFlowGraph::getBlocks() const
+{
+    return blocks;
+}
+
+size_t ControlFlowGraph::getEntry() const
+{
+    return entry;
+}
+
+size_t ControlFlowGraph::getExit() const
+{
+    return exit;
+}
+
+std::optional<size_t> ControlFlowGraph::getHeaderOf(const StatementWhileNode* loop) const
+{
+    auto header = loopHeaders.find(loop);
+    if(header == loopHeaders.end())
+        return std::nullopt;
+    return header->second;
+}
+
+const StatementWhileNode* ControlFlowGraph::getLoopOfHeader(size_t block) const
+{
+    for(auto [loop, header] : loopHeaders)
+    {
+        if(header == block)
+            return loop;
+    }
+    return nullptr;
+}
+
+size_t ControlFlowGraph::createBlock()
+{
+    blocks.push_back(BasicBlock { });
+    return blocks.size() - 1;
+}
+
+void ControlFlowGraph::addEdge(size_t from, size_t to)
+{
+    blocks[from].successors.push_back(to);
+    blocks[to].predecessors.push_back(from);
+}
+
+size_t ControlFlowGraph::build(const std::vector<StatementNode*>& statements, size_t current)
+{
+    for(auto statement : statements)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                current = build(node->statements, current);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                blocks[current].statements.push_back(statement);
+                blocks[current].condition = node->condition;
+                size_t thenBlock = createBlock();
+                size_t elseBlock = createBlock();
+                size_t endBlock = createBlock();
+                addEdge(current, thenBlock);
+                addEdge(current, elseBlock);
+                addEdge(build(node->scope->statements, thenBlock), endBlock);
+                if(node->elseScope.has_value())
+                    elseBlock = build(node->elseScope.value()->statements, elseBlock);
+                addEdge(elseBlock, endBlock);
+                current = endBlock;
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                size_t headerBlock = createBlock();
+                size_t bodyBlock = createBlock();
+                size_t endBlock = createBlock();
+                addEdge(current, headerBlock);
+                blocks[headerBlock].statements.push_back(statement);
+                blocks[headerBlock].condition = node->condition;
+                loopHeaders[node] = headerBlock;
+                addEdge(headerBlock, bodyBlock);
+                addEdge(headerBlock, endBlock);
+                addEdge(build(node->scope->statements, bodyBlock), headerBlock);
+                current = endBlock;
+            }
+            else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+            {
+                blocks[current].statements.push_back(statement);
+                addEdge(current, exit);
+                // The code after a return is unreachable
+                current = createBlock();
+            }
+            else if constexpr (!std::is_same_v<T, StatementFunctionDefinitionNode*>)
+                blocks[current].statements.push_back(statement);
+        }, statement->variant);
+    }
+    return current;
+}
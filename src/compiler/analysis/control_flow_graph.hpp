@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include "../parser/node/statement.hpp"
+
+/**
+ * @brief Structure representing a sequence of statements that is always executed from the first to the last one.
+ */
+struct BasicBlock
+{
+    std::vector<const StatementNode*> statements;
+    /// The condition evaluated at the end of the block when it has 2 successors: the first one is reached when it's true.
+    const ExpressionNode* condition = nullptr;
+    std::vector<size_t> successors;
+    std::vector<size_t> predecessors;
+};
+
+/**
+ * @brief Class representing the control flow graph of the code of a function (or of the code outside of the functions).
+ *
+ * It's built from the statements of the AST: every `if` and `while` ends the current block, and the definitions of the
+ * functions are skipped because their code is never executed in place.
+ */
+class ControlFlowGraph
+{
+public:
+    /**
+     * @brief Build the graph of some statements.
+     * @param statements The statements, in the order they are executed.
+     */
+    ControlFlowGraph(const std::vector<StatementNode*>& statements);
+
+    const std::vector<BasicBlock>& getBlocks() const;
+    size_t getEntry() const;
+    /// The block reached after the last statement and by every `return`.
+    size_t getExit() const;
+
+    /**
+     * @brief Get the block that evaluates the condition of a while loop.
+     */
+    std::optional<size_t> getHeaderOf(const StatementWhileNode* loop) const;
+    /**
+     * @brief Get the while loop whose condition is evaluated by a block.
+     */
+    const StatementWhileNode* getLoopOfHeader(size_t block) const;
+
+private:
+    size_t createBlock();
+    void addEdge(size_t from, size_t to);
+    /**
+     * @brief Add the statements to the graph starting from the `current` block.
+     * @return The block where the code after the statements continues.
+     */
+    size_t build(const std::vector<StatementNode*>& statements, size_t current);
+
+    std::vector<BasicBlock> blocks;
+    size_t entry;
+    size_t exit;
+    std::unordered_map<const StatementWhileNode*, size_t> loopHeaders;
+};
@@ -0,0 +1,98 @@
+#include "dominator_tree.hpp"
+
+#include <functional>
+
+DominatorTree::DominatorTree(const ControlFlowGraph& graph)
+{
+    const auto& blocks = graph.getBlocks();
+    immediateDominators.assign(blocks.size(), UNDEFINED);
+    children.assign(blocks.size(), { });
+    order.assign(blocks.size(), UNDEFINED);
+
+    std::vector<size_t> postorder;
+    std::vector<bool> visited(blocks.size(), false);
+    std::function<void(size_t)> visit = [&](size_t block)
+    {
+        visited[block] = true;
+        for(auto successor : blocks[block].successors)
+        {
+            if(!visited[successor])
+                visit(successor);
+        }
+        postorder.push_back(block);
+    };
+    visit(graph.getEntry());
+    std::vector<size_t> reversePostorder(postorder.rbegin(), postorder.rend());
+    for(size_t i = 0; i < reversePostorder.size(); i++)
+        order[reversePostorder[i]] = i;
+
+    auto intersect = [&](size_t first, size_t second)
+    {
+        while(first != second)
+        {
+            while(order[first] > order[second])
+                first = immediateDominators[first];
+            while(order[second] > order[first])
+                second = immediateDominators[second];
+        }
+        return first;
+    };
+
+    size_t entry = graph.getEntry();
+    immediateDominators[entry] = entry;
+    bool hasChanged = true;
+    while(hasChanged)
+    {
+        hasChanged = false;
+        for(auto block : reversePostorder)
+        {
+            if(block == entry)
+                continue;
+            size_t newDominator = UNDEFINED;
+            for(auto predecessor : blocks[block].predecessors)
+            {
+                if(immediateDominators[predecessor] == UNDEFINED)
+                    continue;
+                newDominator = newDominator == UNDEFINED ? predecessor : intersect(predecessor, newDominator);
+            }
+            if(newDominator != immediateDominators[block])
+            {
+                immediateDominators[block] = newDominator;
+                hasChanged = true;
+            }
+        }
+    }
+
+    for(size_t block = 0; block < blocks.size(); block++)
+    {
+        if(block != entry && immediateDominators[block] != UNDEFINED)
+            children[immediateDominators[block]].push_back(block);
+    }
+}
+
+std::optional<size_t> DominatorTree::getImmediateDominator(size_t block) const
+{
+    if(immediateDominators[block] == UNDEFINED || immediateDominators[block] == block)
+        return std::nullopt;
+    return immediateDominators[block];
+}
+
+const std::vector<size_t>& DominatorTree::getChildren(size_t block) const
+{
+    return children[block];
+}
+
+bool DominatorTree::dominates(size_t dominator, size_t block) const
+{
+    if(!isReachable(dominator) || !isReachable(block))
+        return false;
+    // The dominators of a block come before it in the reverse postorder
+    while(order[block] > order[dominator])
+        block = immediateDominators[block];
+    return block == dominator;
+}
+
+bool DominatorTree::isReachable(size_t block) const
+{
+    return immediateDominators[block] != UNDEFINED;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+
+#include "control_flow_graph.hpp"
+
+/**
+ * @brief Class representing the dominator tree of a control flow graph.
+ *
+ * A block dominates another block if every path from the entry to the second block goes through the first one.
+ * The tree is computed with the iterative algorithm of Cooper, Harvey and Kennedy over the reverse postorder of the blocks.
+ */
+class DominatorTree
+{
+public:
+    DominatorTree(const ControlFlowGraph& graph);
+
+    /**
+     * @brief Get the immediate dominator of a block.
+     * @return The parent of the block in the tree, or std::nullopt for the entry and the unreachable blocks.
+     */
+    std::optional<size_t> getImmediateDominator(size_t block) const;
+    /**
+     * @brief Get the blocks immediately dominated by a block.
+     */
+    const std::vector<size_t>& getChildren(size_t block) const;
+
+    /**
+     * @brief Check if `dominator` dominates `block` (every block dominates itself).
+     */
+    bool dominates(size_t dominator, size_t block) const;
+    bool isReachable(size_t block) const;
+
+private:
+    static constexpr size_t UNDEFINED = static_cast<size_t>(-1);
+
+    std::vector<size_t> immediateDominators;
+    std::vector<std::vector<size_t>> children;
+    /// Position of each block in the reverse postorder.
+    std::vector<size_t> order;
+};
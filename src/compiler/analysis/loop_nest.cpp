@@ -0,0 +1,87 @@
+#include "loop_nest.hpp"
+
+#include <algorithm>
+
+LoopNest::LoopNest(const ControlFlowGraph& graph, const DominatorTree& dominatorTree)
+{
+    const auto& blocks = graph.getBlocks();
+    std::unordered_map<size_t, Loop*> loopsByHeader;
+    for(size_t block = 0; block < blocks.size(); block++)
+    {
+        for(auto successor : blocks[block].successors)
+        {
+            if(!dominatorTree.dominates(successor, block))
+                continue;
+
+            // `block -> successor` is a back edge
+            auto& loop = loopsByHeader[successor];
+            if(loop == nullptr)
+            {
+                loops.push_back(std::make_unique<Loop>(Loop
+                {
+                    .statement = graph.getLoopOfHeader(successor),
+                    .header = successor,
+                    .blocks = std::vector<bool>(blocks.size(), false),
+                    .parent = nullptr,
+                    .depth = 1
+                }));
+                loop = loops.back().get();
+                loop->blocks[successor] = true;
+            }
+            loop->latches.push_back(block);
+
+            // The body of the loop is made of the blocks that reach the latch without going through the header
+            std::vector<size_t> worklist = { block };
+            while(!worklist.empty())
+            {
+                size_t current = worklist.back();
+                worklist.pop_back();
+                if(loop->blocks[current])
+                    continue;
+                loop->blocks[current] = true;
+                for(auto predecessor : blocks[current].predecessors)
+                    worklist.push_back(predecessor);
+            }
+        }
+    }
+
+    // A loop is inside the smallest loop that contains its header
+    auto blocksCount = [](const Loop* loop) { return std::count(loop->blocks.begin(), loop->blocks.end(), true); };
+    for(auto& loop : loops)
+    {
+        for(auto& other : loops)
+        {
+            if(other.get() == loop.get() || !other->blocks[loop->header])
+                continue;
+            if(loop->parent == nullptr || blocksCount(other.get()) < blocksCount(loop->parent))
+                loop->parent = other.get();
+        }
+    }
+    // The loops are sorted from the outermost, so the depth of a parent is known before its inner loops
+    std::sort(loops.begin(), loops.end(), [&](const auto& first, const auto& second) { return blocksCount(first.get()) > blocksCount(second.get()); });
+    for(auto& loop : loops)
+    {
+        if(loop->parent == nullptr)
+            outermostLoops.push_back(loop.get());
+        else
+        {
+            loop->depth = loop->parent->depth + 1;
+            loop->parent->innerLoops.push_back(loop.get());
+        }
+        if(loop->statement != nullptr)
+            loopsByStatement[loop->statement] = loop.get();
+    }
+}
+
+const std::vector<Loop*>& LoopNest::getOutermostLoops() const
+{
+    return outermostLoops;
+}
+
+const Loop* LoopNest::getLoop(const StatementWhileNode* statement) const
+{
+    auto loop = loopsByStatement.find(statement);
+    if(loop == loopsByStatement.end())
+        return nullptr;
+    return loop->second;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "control_flow_graph.hpp"
+#include "dominator_tree.hpp"
+
+/**
+ * @brief Structure representing a natural loop of the control flow graph.
+ */
+struct Loop
+{
+    const StatementWhileNode* statement;
+    /// The block that evaluates the condition of the loop, it dominates all the blocks of the loop.
+    size_t header;
+    /// The blocks that jump back to the header.
+    std::vector<size_t> latches;
+    /// For each block of the graph, true if it's part of the loop (the inner loops included).
+    std::vector<bool> blocks;
+    Loop* parent;
+    std::vector<Loop*> innerLoops;
+    /// 1 for the outermost loops.
+    size_t depth;
+};
+
+/**
+ * @brief Class representing the loops of a control flow graph, each one inside the loops that contain it.
+ *
+ * The loops are found from the back edges of the graph: the edges whose destination dominates their source.
+ */
+class LoopNest
+{
+public:
+    LoopNest(const ControlFlowGraph& graph, const DominatorTree& dominatorTree);
+
+    /**
+     * @brief Get the loops that aren't inside another loop.
+     */
+    const std::vector<Loop*>& getOutermostLoops() const;
+    /**
+     * @brief Get the loop of a while statement, or nullptr if the statement isn't in the graph.
+     */
+    const Loop* getLoop(const StatementWhileNode* statement) const;
+
+private:
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::vector<Loop*> outermostLoops;
+    std::unordered_map<const StatementWhileNode*, Loop*> loopsByStatement;
+};
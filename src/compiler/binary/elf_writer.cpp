@@ -0,0 +1,324 @@
+#include "elf_writer.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <set>
+
+namespace
+{
+    const uint16_t ET_REL = 1;
+    const uint16_t ET_EXEC = 2;
+    const uint16_t EM_X86_64 = 62;
+
+    const uint32_t SHT_PROGBITS = 1;
+    const uint32_t SHT_SYMTAB = 2;
+    const uint32_t SHT_STRTAB = 3;
+    const uint32_t SHT_RELA = 4;
+
+    const uint64_t SHF_WRITE = 0x1;
+    const uint64_t SHF_ALLOC = 0x2;
+    const uint64_t SHF_EXECINSTR = 0x4;
+    const uint64_t SHF_INFO_LINK = 0x40;
+
+    const uint8_t STB_LOCAL = 0;
+    const uint8_t STB_GLOBAL = 1;
+    const uint8_t STT_NOTYPE = 0;
+
+    const uint32_t PT_LOAD = 1;
+    const uint32_t PF_X = 0x1;
+    const uint32_t PF_W = 0x2;
+    const uint32_t PF_R = 0x4;
+
+    const size_t HEADER_SIZE = 64;
+    const size_t SECTION_HEADER_SIZE = 64;
+    const size_t PROGRAM_HEADER_SIZE = 56;
+    const size_t SYMBOL_SIZE = 24;
+    const size_t RELOCATION_SIZE = 24;
+
+    const uint64_t EXECUTABLE_BASE_ADDRESS = 0x400000;
+    const uint64_t PAGE_SIZE = 0x1000;
+
+    /**
+     * @brief Helper that appends little endian values to the content of a file.
+     */
+    class ByteWriter
+    {
+    public:
+        std::vector<uint8_t> bytes;
+
+        void write(uint64_t value, size_t size)
+        {
+            for(size_t i = 0; i < size; i++)
+                bytes.push_back((value >> (8 * i)) & 0xFF);
+        }
+        void write(const std::vector<uint8_t>& content)
+        {
+            bytes.insert(bytes.end(), content.begin(), content.end());
+        }
+        void align(size_t alignment)
+        {
+            while(bytes.size() % alignment != 0)
+                bytes.push_back(0);
+        }
+    };
+
+    /**
+     * @brief A string table of an ELF file: a sequence of null terminated strings referred by their offset.
+     */
+    class StringTable
+    {
+    public:
+        StringTable() : content(1, 0) {}
+
+        uint32_t add(const std::string& string)
+        {
+            uint32_t offset = content.size();
+            content.insert(content.end(), string.begin(), string.end());
+            content.push_back(0);
+            return offset;
+        }
+
+        std::vector<uint8_t> content;
+    };
+
+    void writeHeader(ByteWriter& writer, uint16_t type, uint64_t entry, uint64_t programHeadersOffset, uint16_t programHeadersCount,
+                     uint64_t sectionHeadersOffset, uint16_t sectionHeadersCount, uint16_t sectionNamesIndex)
+    {
+        writer.write({ 0x7F, 'E', 'L', 'F', 2 /* 64 bits */, 1 /* little endian */, 1 /* version */, 0 /* System V */ });
+        writer.write(0, 8);
+        writer.write(type, 2);
+        writer.write(EM_X86_64, 2);
+        writer.write(1, 4);
+        writer.write(entry, 8);
+        writer.write(programHeadersOffset, 8);
+        writer.write(sectionHeadersOffset, 8);
+        writer.write(0, 4);
+        writer.write(HEADER_SIZE, 2);
+        writer.write(programHeadersCount == 0 ? 0 : PROGRAM_HEADER_SIZE, 2);
+        writer.write(programHeadersCount, 2);
+        writer.write(sectionHeadersCount == 0 ? 0 : SECTION_HEADER_SIZE, 2);
+        writer.write(sectionHeadersCount, 2);
+        writer.write(sectionNamesIndex, 2);
+    }
+
+    uint32_t relocationTypeOf(RelocationType type)
+    {
+        switch(type)
+        {
+            case RelocationType::Absolute64: return 1;          // R_X86_64_64
+            case RelocationType::Relative32: return 2;          // R_X86_64_PC32
+            case RelocationType::FunctionRelative32: return 4;  // R_X86_64_PLT32
+            case RelocationType::Absolute32Signed: return 11;   // R_X86_64_32S
+        }
+        return 0;
+    }
+}
+
+namespace elf
+{
+    std::vector<uint8_t> writeRelocatableObject(const ObjectCode& object)
+    {
+        enum SectionIndex : uint16_t { Null, Text, Data, ReadOnlyData, TextRelocations, Symbols, Strings, SectionNames, Count };
+
+        auto sectionIndexOf = [](ObjectSection section) -> uint16_t
+        {
+            switch(section)
+            {
+                case ObjectSection::Text: return Text;
+                case ObjectSection::Data: return Data;
+                case ObjectSection::ReadOnlyData: return ReadOnlyData;
+            }
+            return Null;
+        };
+        auto isGlobal = [&](const std::string& name)
+        {
+            return std::find(object.globalSymbols.begin(), object.globalSymbols.end(), name) != object.globalSymbols.end();
+        };
+
+        // The local symbols must come before the global ones
+        StringTable strings;
+        ByteWriter symbols;
+        std::unordered_map<std::string, uint32_t> symbolIndices;
+        uint32_t symbolsCount = 0;
+        auto addSymbol = [&](const std::string& name, uint8_t binding, uint16_t sectionIndex, uint64_t value)
+        {
+            symbols.write(name.empty() ? 0 : strings.add(name), 4);
+            symbols.write((binding << 4) | STT_NOTYPE, 1);
+            symbols.write(0, 1);
+            symbols.write(sectionIndex, 2);
+            symbols.write(value, 8);
+            symbols.write(0, 8);
+            symbolIndices[name] = symbolsCount++;
+        };
+        addSymbol("", STB_LOCAL, Null, 0);
+        for(const SymbolDefinition& symbol : object.symbols)
+        {
+            if(!isGlobal(symbol.name))
+                addSymbol(symbol.name, STB_LOCAL, sectionIndexOf(symbol.section), symbol.offset);
+        }
+        uint32_t firstGlobalSymbol = symbolsCount;
+        for(const SymbolDefinition& symbol : object.symbols)
+        {
+            if(isGlobal(symbol.name))
+                addSymbol(symbol.name, STB_GLOBAL, sectionIndexOf(symbol.section), symbol.offset);
+        }
+        for(const std::string& externalSymbol : object.externalSymbols)
+            addSymbol(externalSymbol, STB_GLOBAL, Null, 0);
+
+        ByteWriter relocations;
+        for(const Relocation& relocation : object.textRelocations)
+        {
+            relocations.write(relocation.offset, 8);
+            relocations.write((static_cast<uint64_t>(symbolIndices[relocation.symbol]) << 32) | relocationTypeOf(relocation.type), 8);
+            relocations.write(relocation.addend, 8);
+        }
+
+        struct Section
+        {
+            std::string name;
+            uint32_t type;
+            uint64_t flags;
+            const std::vector<uint8_t>* content;
+            uint32_t link;
+            uint32_t info;
+            uint64_t alignment;
+            uint64_t entrySize;
+            uint64_t offset = 0;
+            uint32_t nameOffset = 0;
+        };
+        StringTable sectionNames;
+        std::vector<Section> sections = {
+            { "", 0, 0, nullptr, 0, 0, 0, 0 },
+            { ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, &object.text, 0, 0, 16, 0 },
+            { ".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, &object.data, 0, 0, 8, 0 },
+            { ".rodata", SHT_PROGBITS, SHF_ALLOC, &object.readOnlyData, 0, 0, 8, 0 },
+            { ".rela.text", SHT_RELA, SHF_INFO_LINK, &relocations.bytes, Symbols, Text, 8, RELOCATION_SIZE },
+            { ".symtab", SHT_SYMTAB, 0, &symbols.bytes, Strings, firstGlobalSymbol, 8, SYMBOL_SIZE },
+            { ".strtab", SHT_STRTAB, 0, &strings.content, 0, 0, 1, 0 },
+            { ".shstrtab", SHT_STRTAB, 0, &sectionNames.content, 0, 0, 1, 0 },
+        };
+        for(Section& section : sections)
+            section.nameOffset = section.name.empty() ? 0 : sectionNames.add(section.name);
+
+        ByteWriter writer;
+        writer.write(std::vector<uint8_t>(HEADER_SIZE, 0));
+        for(Section& section : sections)
+        {
+            if(section.content == nullptr)
+                continue;
+            writer.align(section.alignment);
+            section.offset = writer.bytes.size();
+            writer.write(*section.content);
+        }
+        writer.align(8);
+        uint64_t sectionHeadersOffset = writer.bytes.size();
+        for(const Section& section : sections)
+        {
+            writer.write(section.nameOffset, 4);
+            writer.write(section.type, 4);
+            writer.write(section.flags, 8);
+            writer.write(0, 8);
+            writer.write(section.offset, 8);
+            writer.write(section.content == nullptr ? 0 : section.content->size(), 8);
+            writer.write(section.link, 4);
+            writer.write(section.info, 4);
+            writer.write(section.alignment, 8);
+            writer.write(section.entrySize, 8);
+        }
+
+        ByteWriter header;
+        writeHeader(header, ET_REL, 0, 0, 0, sectionHeadersOffset, Count, SectionNames);
+        std::copy(header.bytes.begin(), header.bytes.end(), writer.bytes.begin());
+        return writer.bytes;
+    }
+
+    std::optional<std::vector<uint8_t>> writeExecutable(const ObjectCode& object, const std::string& entrySymbol)
+    {
+        struct Segment
+        {
+            ObjectSection section;
+            const std::vector<uint8_t>* content;
+            uint32_t flags;
+            uint64_t address = 0;
+        };
+        // Each section gets its own pages, so that it can be loaded with its own permissions
+        std::vector<Segment> segments = {
+            { ObjectSection::Text, &object.text, PF_R | PF_X },
+            { ObjectSection::ReadOnlyData, &object.readOnlyData, PF_R },
+            { ObjectSection::Data, &object.data, PF_R | PF_W }
+        };
+        uint64_t nextAddress = EXECUTABLE_BASE_ADDRESS + PAGE_SIZE;
+        for(Segment& segment : segments)
+        {
+            segment.address = nextAddress;
+            nextAddress += (segment.content->size() + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+        }
+
+        bool hasErrors = false;
+        std::set<std::string> undefinedSymbols;
+        auto addressOf = [&](const std::string& name) -> std::optional<uint64_t>
+        {
+            const SymbolDefinition* symbol = object.findSymbol(name);
+            if(symbol == nullptr)
+            {
+                if(undefinedSymbols.insert(name).second)
+                    std::cerr << "The symbol `" << name << "` isn't defined in the program, so it can't be linked as a static executable" << std::endl;
+                hasErrors = true;
+                return std::nullopt;
+            }
+            auto segment = std::find_if(segments.begin(), segments.end(), [&](const Segment& segment) { return segment.section == symbol->section; });
+            return segment->address + symbol->offset;
+        };
+
+        std::vector<uint8_t> text = object.text;
+        for(const Relocation& relocation : object.textRelocations)
+        {
+            auto symbolAddress = addressOf(relocation.symbol);
+            if(!symbolAddress.has_value())
+                continue;
+            long long value = symbolAddress.value() + relocation.addend;
+            size_t size = 4;
+            if(relocation.type == RelocationType::Absolute64)
+                size = 8;
+            else if(relocation.type == RelocationType::Relative32 || relocation.type == RelocationType::FunctionRelative32)
+                value -= segments[0].address + relocation.offset;
+            if(size == 4 && (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()))
+            {
+                std::cerr << "The address of `" << relocation.symbol << "` doesn't fit in 32 bits" << std::endl;
+                hasErrors = true;
+                continue;
+            }
+            for(size_t i = 0; i < size; i++)
+                text[relocation.offset + i] = (value >> (8 * i)) & 0xFF;
+        }
+        auto entry = addressOf(entrySymbol);
+        if(hasErrors || !entry.has_value())
+            return std::nullopt;
+        segments[0].content = &text;
+
+        std::vector<Segment> loadedSegments;
+        std::copy_if(segments.begin(), segments.end(), std::back_inserter(loadedSegments), [](const Segment& segment) { return !segment.content->empty(); });
+
+        ByteWriter writer;
+        writeHeader(writer, ET_EXEC, entry.value(), HEADER_SIZE, loadedSegments.size(), 0, 0, 0);
+        for(const Segment& segment : loadedSegments)
+        {
+            writer.write(PT_LOAD, 4);
+            writer.write(segment.flags, 4);
+            writer.write(segment.address - EXECUTABLE_BASE_ADDRESS, 8);
+            writer.write(segment.address, 8);
+            writer.write(segment.address, 8);
+            writer.write(segment.content->size(), 8);
+            writer.write(segment.content->size(), 8);
+            writer.write(PAGE_SIZE, 8);
+        }
+        for(const Segment& segment : loadedSegments)
+        {
+            writer.align(PAGE_SIZE);
+            writer.bytes.resize(segment.address - EXECUTABLE_BASE_ADDRESS, 0);
+            writer.write(*segment.content);
+        }
+        return writer.bytes;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "x86_encoder.hpp"
+
+namespace elf
+{
+    /**
+     * @brief Create an ELF64 relocatable object file (like the ones created by `nasm -felf64`) with the given code.
+     *
+     * The file contains the `.text`, `.data` and `.rodata` sections, and the relocations of the text section
+     * that the linker resolves with the addresses of the data and of the external symbols.
+     * @param object The encoded program.
+     * @return The content of the file.
+     */
+    std::vector<uint8_t> writeRelocatableObject(const ObjectCode& object);
+
+    /**
+     * @brief Create a statically linked ELF64 executable file with the given code, without calling a linker.
+     * @param object The encoded program, which mustn't refer to any external symbol.
+     * @param entrySymbol The name of the symbol where the execution starts.
+     * @return The content of the file, or std::nullopt if the program can't be linked (the errors are printed).
+     */
+    std::optional<std::vector<uint8_t>> writeExecutable(const ObjectCode& object, const std::string& entrySymbol);
+}
\ No newline at end of file
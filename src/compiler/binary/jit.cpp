@@ -0,0 +1,277 @@
+#include "jit.hpp"
+
+#include <iostream>
+
+#if defined(__linux__) && defined(__x86_64__)
+
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <csetjmp>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// The functions called by the generated code use the Windows x64 calling convention, and they can't expect the stack to be aligned
+#define RUNTIME_FUNCTION __attribute__((ms_abi, force_align_arg_pointer))
+
+const size_t PAGE_SIZE = 0x1000;
+// `jmp QWORD [rip]` followed by the 64 bits address of the function, padded to 16 bytes
+const size_t STUB_SIZE = 16;
+
+// Where `ExitProcess` goes back to, and the exit code it has been called with
+static std::jmp_buf exitPoint;
+static int exitCode;
+// The sizes of the pages allocated with `VirtualAlloc`, that `VirtualFree` releases without knowing their size
+static std::unordered_map<void*, size_t> pageAllocations;
+// The bytes read from the system by `ReadFile` and not returned yet, with the handle they come from
+const size_t READ_CHUNK_SIZE = 65536;
+static char readChunk[READ_CHUNK_SIZE];
+static size_t readChunkStart = 0;
+static size_t readChunkEnd = 0;
+static long long readChunkHandle = -1;
+
+namespace runtime
+{
+    RUNTIME_FUNCTION static void exitProcess(unsigned long long code)
+    {
+        exitCode = static_cast<int>(code);
+        std::longjmp(exitPoint, 1);
+    }
+
+    // -10, -11 and -12 are the handles of stdin, stdout and stderr
+    RUNTIME_FUNCTION static long long getStdHandle(long long handle)
+    {
+        return -10 - handle;
+    }
+
+    RUNTIME_FUNCTION static int writeFile(long long handle, const char* buffer, unsigned long long count, unsigned int* written, void* overlapped)
+    {
+        ssize_t result = write(handle, buffer, count);
+        if(result < 0)
+            return 0;
+        if(written != nullptr)
+            *written = result;
+        return 1;
+    }
+
+    // Like the console of Windows, a call reads at most one line. The input is read from the system in chunks, and the system
+    // is called again only when the chunk ends before the line (0 bytes are read at the end of the input or after an error)
+    RUNTIME_FUNCTION static int readFile(long long handle, char* buffer, unsigned long long count, unsigned int* read, void* overlapped)
+    {
+        if(handle != readChunkHandle)
+        {
+            readChunkHandle = handle;
+            readChunkStart = readChunkEnd = 0;
+        }
+        unsigned long long readCount = 0;
+        bool isLineRead = false;
+        while(readCount < count && !isLineRead)
+        {
+            if(readChunkStart == readChunkEnd)
+            {
+                ssize_t chunkSize;
+                do
+                    chunkSize = ::read(handle, readChunk, READ_CHUNK_SIZE);
+                while(chunkSize < 0 && errno == EINTR);
+                if(chunkSize <= 0)
+                    break;
+                readChunkStart = 0;
+                readChunkEnd = chunkSize;
+            }
+            while(readCount < count && readChunkStart < readChunkEnd && !isLineRead)
+            {
+                buffer[readCount] = readChunk[readChunkStart++];
+                isLineRead = buffer[readCount++] == '\n';
+            }
+        }
+        if(read != nullptr)
+            *read = readCount;
+        return 1;
+    }
+
+    // Only the terminals have a mode, like the consoles of Windows
+    RUNTIME_FUNCTION static int getConsoleMode(long long handle, unsigned int* mode)
+    {
+        return isatty(handle);
+    }
+
+    RUNTIME_FUNCTION static long long getProcessHeap()
+    {
+        return 1;
+    }
+
+    RUNTIME_FUNCTION static void* heapAlloc(long long heap, unsigned long long flags, unsigned long long size)
+    {
+        return std::calloc(1, size);
+    }
+
+    RUNTIME_FUNCTION static int heapFree(long long heap, unsigned long long flags, void* memory)
+    {
+        std::free(memory);
+        return 1;
+    }
+
+    RUNTIME_FUNCTION static void* virtualAlloc(void* address, unsigned long long size, unsigned int type, unsigned int protection)
+    {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED)
+            return nullptr;
+        pageAllocations[memory] = size;
+        return memory;
+    }
+
+    RUNTIME_FUNCTION static int virtualFree(void* address, unsigned long long size, unsigned int type)
+    {
+        auto allocation = pageAllocations.find(address);
+        if(allocation == pageAllocations.end())
+            return 0;
+        munmap(address, allocation->second);
+        pageAllocations.erase(allocation);
+        return 1;
+    }
+}
+
+static const std::unordered_map<std::string, void*>& runtimeFunctions()
+{
+    static const std::unordered_map<std::string, void*> functions = {
+        { "ExitProcess", reinterpret_cast<void*>(&runtime::exitProcess) },
+        { "GetStdHandle", reinterpret_cast<void*>(&runtime::getStdHandle) },
+        { "WriteFile", reinterpret_cast<void*>(&runtime::writeFile) },
+        { "ReadFile", reinterpret_cast<void*>(&runtime::readFile) },
+        { "GetConsoleMode", reinterpret_cast<void*>(&runtime::getConsoleMode) },
+        { "GetProcessHeap", reinterpret_cast<void*>(&runtime::getProcessHeap) },
+        { "HeapAlloc", reinterpret_cast<void*>(&runtime::heapAlloc) },
+        { "HeapFree", reinterpret_cast<void*>(&runtime::heapFree) },
+        { "VirtualAlloc", reinterpret_cast<void*>(&runtime::virtualAlloc) },
+        { "VirtualFree", reinterpret_cast<void*>(&runtime::virtualFree) },
+    };
+    return functions;
+}
+
+static size_t alignToPage(size_t size)
+{
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+static void writePerfMap(const ObjectCode& object, const uint8_t* text)
+{
+    std::ofstream file("/tmp/perf-" + std::to_string(getpid()) + ".map");
+    for(const FunctionRange& range : object.functionRanges)
+        file << std::hex << reinterpret_cast<uintptr_t>(text + range.offset) << " " << range.size << " " << range.name << "\n";
+}
+
+std::optional<int> jit::run(const ObjectCode& object, const std::string& entrySymbol)
+{
+    // The external functions are called through stubs placed after the code, so that they are always near enough for a `call rel32`
+    size_t stubsOffset = (object.text.size() + STUB_SIZE - 1) / STUB_SIZE * STUB_SIZE;
+    size_t textSize = alignToPage(stubsOffset + STUB_SIZE * object.externalSymbols.size());
+    size_t readOnlyDataSize = alignToPage(object.readOnlyData.size());
+    size_t totalSize = textSize + readOnlyDataSize + alignToPage(object.data.size());
+
+    // Memory in the low 2 GB lets the program use the addresses of its symbols as 32 bits values
+    void* memory = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if(memory == MAP_FAILED)
+        memory = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+    {
+        std::cerr << "Can't allocate the memory of the program" << std::endl;
+        return std::nullopt;
+    }
+    uint8_t* text = static_cast<uint8_t*>(memory);
+    uint8_t* readOnlyData = text + textSize;
+    uint8_t* data = readOnlyData + readOnlyDataSize;
+    std::copy(object.text.begin(), object.text.end(), text);
+    std::copy(object.readOnlyData.begin(), object.readOnlyData.end(), readOnlyData);
+    std::copy(object.data.begin(), object.data.end(), data);
+
+    bool hasErrors = false;
+    std::unordered_map<std::string, uint8_t*> externalAddresses;
+    for(size_t i = 0; i < object.externalSymbols.size(); i++)
+    {
+        const std::string& symbol = object.externalSymbols[i];
+        auto function = runtimeFunctions().find(symbol);
+        if(function == runtimeFunctions().end())
+        {
+            std::cerr << "The external symbol `" << symbol << "` isn't available in the in-process runtime" << std::endl;
+            hasErrors = true;
+            continue;
+        }
+        uint8_t* stub = text + stubsOffset + STUB_SIZE * i;
+        const uint8_t jumpToNextQuadWord[] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+        std::memcpy(stub, jumpToNextQuadWord, sizeof(jumpToNextQuadWord));
+        std::memcpy(stub + sizeof(jumpToNextQuadWord), &function->second, sizeof(void*));
+        externalAddresses[symbol] = stub;
+    }
+
+    auto addressOf = [&](const std::string& name) -> uint8_t*
+    {
+        if(auto external = externalAddresses.find(name); external != externalAddresses.end())
+            return external->second;
+        const SymbolDefinition* symbol = object.findSymbol(name);
+        if(symbol == nullptr)
+            return nullptr;
+        switch(symbol->section)
+        {
+            case ObjectSection::Text: return text + symbol->offset;
+            case ObjectSection::ReadOnlyData: return readOnlyData + symbol->offset;
+            case ObjectSection::Data: return data + symbol->offset;
+        }
+        return nullptr;
+    };
+
+    for(const Relocation& relocation : object.textRelocations)
+    {
+        uint8_t* symbolAddress = addressOf(relocation.symbol);
+        if(symbolAddress == nullptr)
+        {
+            hasErrors = true;
+            continue;
+        }
+        long long value = reinterpret_cast<long long>(symbolAddress) + relocation.addend;
+        size_t size = 4;
+        if(relocation.type == RelocationType::Absolute64)
+            size = 8;
+        else if(relocation.type == RelocationType::Relative32 || relocation.type == RelocationType::FunctionRelative32)
+            value -= reinterpret_cast<long long>(text + relocation.offset);
+        if(size == 4 && (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()))
+        {
+            std::cerr << "The address of `" << relocation.symbol << "` doesn't fit in 32 bits" << std::endl;
+            hasErrors = true;
+            continue;
+        }
+        std::memcpy(text + relocation.offset, &value, size);
+    }
+
+    uint8_t* entry = addressOf(entrySymbol);
+    if(hasErrors || entry == nullptr || mprotect(text, textSize, PROT_READ | PROT_EXEC) != 0 ||
+       (readOnlyDataSize > 0 && mprotect(readOnlyData, readOnlyDataSize, PROT_READ) != 0))
+    {
+        munmap(memory, totalSize);
+        return std::nullopt;
+    }
+
+    writePerfMap(object, text);
+
+    // The program writes directly to the file descriptors
+    std::cout.flush();
+    exitCode = 0;
+    if(setjmp(exitPoint) == 0)
+        reinterpret_cast<void(*)()>(entry)();
+
+    munmap(memory, totalSize);
+    return exitCode;
+}
+
+#else
+
+std::optional<int> jit::run(const ObjectCode& object, const std::string& entrySymbol)
+{
+    std::cerr << "The programs can be run in the compiler only on Linux x86-64" << std::endl;
+    return std::nullopt;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <optional>
+
+#include "x86_encoder.hpp"
+
+namespace jit
+{
+    /**
+     * @brief Load an encoded program in the memory of the compiler and run it, without writing any file.
+     *
+     * The functions of `kernel32` called by the program are resolved to functions of the compiler, and the
+     * position of each function of the program is written in `/tmp/perf-<pid>.map` so that `perf` can name them.
+     * Only Linux x86-64 can run the programs.
+     * @param object The program encoded with the Windows x64 target.
+     * @param entrySymbol The name of the symbol where the execution starts.
+     * @return The exit code of the program, or std::nullopt if it can't be loaded (the errors are printed).
+     */
+    std::optional<int> run(const ObjectCode& object, const std::string& entrySymbol);
+}
\ No newline at end of file
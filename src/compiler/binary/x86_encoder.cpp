@@ -0,0 +1,1078 @@
+#include "x86_encoder.hpp"
+#include "../token/tokenizer.hpp"
+#include "../generation/special/consts.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+/**
+ * @brief Structure representing an operand of an instruction: a register, an immediate or a memory location.
+ */
+struct X86Encoder::Operand
+{
+    enum class Kind
+    {
+        Register,
+        Immediate,
+        Memory
+    };
+
+    Kind kind;
+    /// The size in bytes of the value, or 0 if it isn't known.
+    int size = 0;
+
+    int registerNumber = 0;
+    /// `ah`, `bh`, `ch` and `dh` can't be used in an instruction with a REX prefix.
+    bool isHighByteRegister = false;
+    /// `spl`, `bpl`, `sil` and `dil` can be used only in an instruction with a REX prefix.
+    bool needsRex = false;
+
+    /// The value of an immediate, or the displacement of a memory location.
+    long long value = 0;
+    /// The symbol whose address is added to the value, if not empty.
+    std::string symbol;
+
+    std::optional<int> base;
+    std::optional<int> index;
+    int scale = 1;
+    bool isRipRelative = false;
+};
+
+struct RegisterInfo
+{
+    int number;
+    int size;
+    bool isHighByteRegister;
+    bool needsRex;
+};
+
+static const std::unordered_map<std::string, RegisterInfo>& registers()
+{
+    static const std::unordered_map<std::string, RegisterInfo> registers = []()
+    {
+        std::unordered_map<std::string, RegisterInfo> registers;
+        const std::vector<std::string> names64 = { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi" };
+        const std::vector<std::string> names32 = { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi" };
+        const std::vector<std::string> names16 = { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di" };
+        const std::vector<std::string> names8 = { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil" };
+        const std::vector<std::string> highNames8 = { "ah", "ch", "dh", "bh" };
+        for(int i = 0; i < 8; i++)
+        {
+            registers[names64[i]] = RegisterInfo { i, 8, false, false };
+            registers[names32[i]] = RegisterInfo { i, 4, false, false };
+            registers[names16[i]] = RegisterInfo { i, 2, false, false };
+            registers[names8[i]] = RegisterInfo { i, 1, false, i >= 4 };
+        }
+        for(int i = 0; i < 4; i++)
+            registers[highNames8[i]] = RegisterInfo { i + 4, 1, true, false };
+        for(int i = 8; i < 16; i++)
+        {
+            std::string name = "r" + std::to_string(i);
+            registers[name] = RegisterInfo { i, 8, false, false };
+            registers[name + "d"] = RegisterInfo { i, 4, false, false };
+            registers[name + "w"] = RegisterInfo { i, 2, false, false };
+            registers[name + "b"] = RegisterInfo { i, 1, false, false };
+        }
+        for(int i = 0; i < 16; i++)
+        {
+            registers["xmm" + std::to_string(i)] = RegisterInfo { i, 16, false, false };
+            registers["ymm" + std::to_string(i)] = RegisterInfo { i, 32, false, false };
+        }
+        return registers;
+    }();
+    return registers;
+}
+
+static std::optional<int> conditionCodeOf(const std::string& suffix)
+{
+    static const std::unordered_map<std::string, int> conditionCodes = {
+        { "o", 0x0 }, { "no", 0x1 }, { "b", 0x2 }, { "c", 0x2 }, { "nae", 0x2 }, { "ae", 0x3 }, { "nb", 0x3 }, { "nc", 0x3 },
+        { "e", 0x4 }, { "z", 0x4 }, { "ne", 0x5 }, { "nz", 0x5 }, { "be", 0x6 }, { "na", 0x6 }, { "a", 0x7 }, { "nbe", 0x7 },
+        { "s", 0x8 }, { "ns", 0x9 }, { "p", 0xA }, { "pe", 0xA }, { "np", 0xB }, { "po", 0xB },
+        { "l", 0xC }, { "nge", 0xC }, { "ge", 0xD }, { "nl", 0xD }, { "le", 0xE }, { "ng", 0xE }, { "g", 0xF }, { "nle", 0xF },
+    };
+    auto conditionCode = conditionCodes.find(suffix);
+    if(conditionCode == conditionCodes.end())
+        return std::nullopt;
+    return conditionCode->second;
+}
+
+static std::string trim(const std::string& string)
+{
+    auto start = string.find_first_not_of(" \t\r");
+    if(start == std::string::npos)
+        return "";
+    auto end = string.find_last_not_of(" \t\r");
+    return string.substr(start, end - start + 1);
+}
+
+static std::string toLower(std::string string)
+{
+    std::transform(string.begin(), string.end(), string.begin(), [](unsigned char character) { return std::tolower(character); });
+    return string;
+}
+
+static std::optional<long long> parseNumber(const std::string& text)
+{
+    std::string digits = text;
+    bool isNegative = !digits.empty() && digits[0] == '-';
+    if(isNegative)
+        digits = trim(digits.substr(1));
+    int base = 10;
+    if(digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+    {
+        digits = digits.substr(2);
+        base = 16;
+    }
+    if(digits.empty())
+        return std::nullopt;
+
+    // Big unsigned constants (like the magic numbers of the divisions) are written as they are
+    unsigned long long value = 0;
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+    if(result.ec != std::errc() || result.ptr != digits.data() + digits.size())
+        return std::nullopt;
+    return isNegative ? -static_cast<long long>(value) : static_cast<long long>(value);
+}
+
+static bool isIdentifier(const std::string& text)
+{
+    return !text.empty() && !std::isdigit((unsigned char) text[0]) && std::all_of(text.begin(), text.end(), [](unsigned char character)
+    {
+        return std::isalnum(character) || character == '_' || character == '.' || character == '$' || character == '@';
+    });
+}
+
+static bool fitsInt8(long long value)
+{
+    return value >= std::numeric_limits<int8_t>::min() && value <= std::numeric_limits<int8_t>::max();
+}
+
+static bool fitsInt32(long long value)
+{
+    return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+}
+
+const SymbolDefinition* ObjectCode::findSymbol(const std::string& name) const
+{
+    auto symbol = std::find_if(symbols.begin(), symbols.end(), [&](const SymbolDefinition& symbol) { return symbol.name == name; });
+    if(symbol == symbols.end())
+        return nullptr;
+    return &*symbol;
+}
+
+std::optional<ObjectCode> X86Encoder::encode(const AssemblyProgram& program)
+{
+    object = ObjectCode
+    {
+        .globalSymbols = program.globalSymbols,
+        .externalSymbols = program.externalSymbols
+    };
+    labelReferences.clear();
+    lastGlobalLabel.clear();
+    errors.clear();
+
+    auto encodeData = [&](const std::vector<DataDefinition>& definitions, ObjectSection section, std::vector<uint8_t>& bytes)
+    {
+        for(const DataDefinition& definition : definitions)
+        {
+            size_t size = definition.type == DataType::Word ? 2 : definition.type == DataType::QuadWord || definition.type == DataType::String ? 8 : 1;
+            while(bytes.size() % size != 0)
+                bytes.push_back(0);
+            object.symbols.push_back(SymbolDefinition { .name = definition.name, .section = section, .offset = bytes.size() });
+
+            if(definition.type == DataType::String)
+            {
+                // The symbol points to the characters, after the length
+                auto string = decodeStringLiteral(definition.value);
+                for(int i = 0; i < STRING_LENGTH_SIZE; i++)
+                    bytes.push_back((string.size() >> (8 * i)) & 0xFF);
+                object.symbols.back().offset = bytes.size();
+                bytes.insert(bytes.end(), string.begin(), string.end());
+                bytes.push_back(0);
+                continue;
+            }
+            auto value = parseNumber(definition.value);
+            if(definition.type == DataType::Reserved)
+            {
+                bytes.resize(bytes.size() + value.value_or(0), 0);
+                if(!value.has_value())
+                    errors.push_back("Invalid size of `" + definition.name + "`: " + definition.value);
+                continue;
+            }
+            if(!value.has_value())
+                errors.push_back("Invalid value of `" + definition.name + "`: " + definition.value);
+            for(size_t i = 0; i < size; i++)
+                bytes.push_back((value.value_or(0) >> (8 * i)) & 0xFF);
+        }
+    };
+    encodeData(program.data, ObjectSection::Data, object.data);
+    encodeData(program.readOnlyData, ObjectSection::ReadOnlyData, object.readOnlyData);
+
+    for(const AssemblyLine& line : program.text.getLines())
+    {
+        if(line.isDeleted)
+            continue;
+        switch(line.type)
+        {
+            case AssemblyLineType::Instruction:
+                if(!encodeLine(line.mnemonic, line.operands))
+                {
+                    std::string text = line.mnemonic;
+                    for(size_t i = 0; i < line.operands.size(); i++)
+                        text += (i == 0 ? " " : ", ") + line.operands[i];
+                    errors.push_back("Can't encode the instruction `" + text + "`");
+                }
+                break;
+            case AssemblyLineType::Label:
+                defineLabel(line.mnemonic);
+                break;
+            case AssemblyLineType::Opaque:
+                encodeUserCode(line.mnemonic);
+                break;
+            case AssemblyLineType::Other:
+                break;
+        }
+    }
+
+    // The jumps to the labels of the text section are resolved now, the other references are left to the linker
+    for(const Relocation& reference : labelReferences)
+    {
+        const SymbolDefinition* symbol = object.findSymbol(reference.symbol);
+        if(symbol != nullptr && symbol->section == ObjectSection::Text)
+        {
+            long long distance = static_cast<long long>(symbol->offset) + reference.addend - static_cast<long long>(reference.offset);
+            for(size_t i = 0; i < 4; i++)
+                object.text[reference.offset + i] = (distance >> (8 * i)) & 0xFF;
+        }
+        else if(symbol != nullptr || std::find(object.externalSymbols.begin(), object.externalSymbols.end(), reference.symbol) != object.externalSymbols.end())
+            object.textRelocations.push_back(reference);
+        else
+            errors.push_back("Undefined symbol `" + reference.symbol + "`");
+    }
+    for(const Relocation& relocation : object.textRelocations)
+    {
+        bool isDefined = object.findSymbol(relocation.symbol) != nullptr ||
+            std::find(object.externalSymbols.begin(), object.externalSymbols.end(), relocation.symbol) != object.externalSymbols.end();
+        if(!isDefined)
+            errors.push_back("Undefined symbol `" + relocation.symbol + "`");
+    }
+
+    computeFunctionRanges(program.functions);
+
+    if(!errors.empty())
+    {
+        for(const std::string& error : errors)
+            std::cerr << error << std::endl;
+        return std::nullopt;
+    }
+    return std::move(object);
+}
+
+void X86Encoder::computeFunctionRanges(const std::vector<FunctionSymbol>& functions)
+{
+    // The code belongs to the innermost function that has started and hasn't ended yet
+    struct Event
+    {
+        size_t offset;
+        bool isEnd;
+        std::string function;
+    };
+    std::vector<Event> events;
+    for(const FunctionSymbol& function : functions)
+    {
+        const SymbolDefinition* start = object.findSymbol(function.name);
+        if(start == nullptr || start->section != ObjectSection::Text)
+            continue;
+        events.push_back(Event { .offset = start->offset, .isEnd = false, .function = function.name });
+        const SymbolDefinition* end = function.endLabel.has_value() ? object.findSymbol(function.endLabel.value()) : nullptr;
+        if(end != nullptr && end->section == ObjectSection::Text)
+            events.push_back(Event { .offset = end->offset, .isEnd = true, .function = function.name });
+    }
+    // A function that ends where another one starts is closed first
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+    {
+        return a.offset != b.offset ? a.offset < b.offset : a.isEnd > b.isEnd;
+    });
+
+    std::vector<std::string> openFunctions;
+    size_t rangeStart = 0;
+    auto closeRange = [&](size_t offset)
+    {
+        if(!openFunctions.empty() && offset > rangeStart)
+            object.functionRanges.push_back(FunctionRange { .name = openFunctions.back(), .offset = rangeStart, .size = offset - rangeStart });
+        rangeStart = offset;
+    };
+    for(const Event& event : events)
+    {
+        closeRange(event.offset);
+        if(!event.isEnd)
+            openFunctions.push_back(event.function);
+        else
+        {
+            auto function = std::find(openFunctions.rbegin(), openFunctions.rend(), event.function);
+            if(function != openFunctions.rend())
+                openFunctions.erase(std::next(function).base());
+        }
+    }
+    closeRange(object.text.size());
+}
+
+void X86Encoder::defineLabel(const std::string& label)
+{
+    std::string name = qualifyLabel(label);
+    if(label[0] != '.')
+        lastGlobalLabel = label;
+    if(object.findSymbol(name) != nullptr)
+        errors.push_back("The label `" + name + "` is defined more than once");
+    object.symbols.push_back(SymbolDefinition { .name = name, .section = ObjectSection::Text, .offset = object.text.size() });
+}
+
+std::string X86Encoder::qualifyLabel(const std::string& label) const
+{
+    // Like in NASM, a label that starts with a dot belongs to the previous label without a dot
+    if(!label.empty() && label[0] == '.')
+        return lastGlobalLabel + label;
+    return label;
+}
+
+bool X86Encoder::encodeUserCode(const std::string& code)
+{
+    size_t start = 0;
+    while(start <= code.size())
+    {
+        size_t end = code.find('\n', start);
+        if(end == std::string::npos)
+            end = code.size();
+        std::string line = code.substr(start, end - start);
+        start = end + 1;
+
+        // The comments end the line, unless the semicolon is inside a string
+        char quote = 0;
+        for(size_t i = 0; i < line.size(); i++)
+        {
+            if(quote != 0)
+                quote = line[i] == quote ? 0 : quote;
+            else if(line[i] == '"' || line[i] == '\'' || line[i] == '`')
+                quote = line[i];
+            else if(line[i] == ';')
+            {
+                line = line.substr(0, i);
+                break;
+            }
+        }
+        line = trim(line);
+
+        auto labelEnd = line.find(':');
+        if(labelEnd != std::string::npos && isIdentifier(trim(line.substr(0, labelEnd))))
+        {
+            defineLabel(trim(line.substr(0, labelEnd)));
+            line = trim(line.substr(labelEnd + 1));
+        }
+        if(line.empty())
+            continue;
+
+        auto mnemonicEnd = line.find_first_of(" \t");
+        std::string mnemonic = line.substr(0, mnemonicEnd);
+        std::vector<std::string> operands;
+        if(mnemonicEnd != std::string::npos)
+        {
+            std::string operandsText = line.substr(mnemonicEnd);
+            size_t operandStart = 0;
+            while(operandStart <= operandsText.size())
+            {
+                size_t operandEnd = operandsText.find(',', operandStart);
+                if(operandEnd == std::string::npos)
+                    operandEnd = operandsText.size();
+                operands.push_back(trim(operandsText.substr(operandStart, operandEnd - operandStart)));
+                operandStart = operandEnd + 1;
+            }
+        }
+        if(!encodeLine(mnemonic, operands))
+        {
+            errors.push_back("Can't encode the instruction `" + line + "` written with the asm! macro");
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<X86Encoder::Operand> X86Encoder::parseOperand(const std::string& text) const
+{
+    std::string operandText = trim(text);
+    int explicitSize = 0;
+    auto firstWordEnd = operandText.find_first_of(" \t[");
+    if(firstWordEnd != std::string::npos)
+    {
+        static const std::unordered_map<std::string, int> sizes = { { "byte", 1 }, { "word", 2 }, { "dword", 4 }, { "qword", 8 } };
+        auto size = sizes.find(toLower(operandText.substr(0, firstWordEnd)));
+        if(size != sizes.end())
+        {
+            explicitSize = size->second;
+            operandText = trim(operandText.substr(firstWordEnd));
+        }
+    }
+    if(operandText.empty())
+        return std::nullopt;
+
+    if(operandText[0] == '[')
+    {
+        if(operandText.back() != ']')
+            return std::nullopt;
+        Operand operand = { .kind = Operand::Kind::Memory, .size = explicitSize };
+        std::string address = trim(operandText.substr(1, operandText.size() - 2));
+        if(toLower(address).rfind("rel ", 0) == 0)
+        {
+            operand.isRipRelative = true;
+            address = trim(address.substr(4));
+        }
+
+        // The address is a sum of terms: registers (optionally scaled), numbers and a symbol
+        size_t position = 0;
+        int sign = 1;
+        while(position < address.size())
+        {
+            size_t termEnd = address.find_first_of("+-", position + 1);
+            if(termEnd == std::string::npos)
+                termEnd = address.size();
+            std::string term = trim(address.substr(position, termEnd - position));
+            if(!term.empty() && (term[0] == '+' || term[0] == '-'))
+            {
+                sign = term[0] == '-' ? -1 : 1;
+                term = trim(term.substr(1));
+            }
+            position = termEnd;
+
+            auto multiplication = term.find('*');
+            std::string registerName = toLower(trim(term.substr(0, multiplication)));
+            auto registerInfo = registers().find(registerName);
+            if(multiplication != std::string::npos)
+            {
+                auto scale = parseNumber(trim(term.substr(multiplication + 1)));
+                if(registerInfo == registers().end() || !scale.has_value() || sign < 0 || operand.index.has_value())
+                    return std::nullopt;
+                operand.index = registerInfo->second.number;
+                operand.scale = scale.value();
+            }
+            else if(registerInfo != registers().end())
+            {
+                if(sign < 0 || registerInfo->second.size != 8)
+                    return std::nullopt;
+                if(!operand.base.has_value())
+                    operand.base = registerInfo->second.number;
+                else if(!operand.index.has_value())
+                    operand.index = registerInfo->second.number;
+                else
+                    return std::nullopt;
+            }
+            else if(auto number = parseNumber(term))
+                operand.value += sign * number.value();
+            else if(isIdentifier(term) && operand.symbol.empty() && sign > 0)
+                operand.symbol = qualifyLabel(term);
+            else
+                return std::nullopt;
+        }
+        if(operand.scale != 1 && operand.scale != 2 && operand.scale != 4 && operand.scale != 8)
+            return std::nullopt;
+        // `rsp` can't be an index
+        if(operand.index == 4 && operand.scale == 1 && operand.base.has_value() && operand.base != 4)
+            std::swap(operand.base, operand.index);
+        if(operand.index == 4 || (operand.isRipRelative && (operand.base.has_value() || operand.index.has_value())))
+            return std::nullopt;
+        return operand;
+    }
+
+    auto registerInfo = registers().find(toLower(operandText));
+    if(registerInfo != registers().end())
+    {
+        return Operand
+        {
+            .kind = Operand::Kind::Register,
+            .size = registerInfo->second.size,
+            .registerNumber = registerInfo->second.number,
+            .isHighByteRegister = registerInfo->second.isHighByteRegister,
+            .needsRex = registerInfo->second.needsRex
+        };
+    }
+    if(auto number = parseNumber(operandText))
+        return Operand { .kind = Operand::Kind::Immediate, .size = explicitSize, .value = number.value() };
+    if(isIdentifier(operandText))
+        return Operand { .kind = Operand::Kind::Immediate, .size = explicitSize, .symbol = qualifyLabel(operandText) };
+    return std::nullopt;
+}
+
+void X86Encoder::emitByte(uint8_t byte)
+{
+    object.text.push_back(byte);
+}
+
+void X86Encoder::emitValue(unsigned long long value, size_t size)
+{
+    for(size_t i = 0; i < size; i++)
+        emitByte((value >> (8 * i)) & 0xFF);
+}
+
+void X86Encoder::emitImmediate(const Operand& immediate, size_t size)
+{
+    if(!immediate.symbol.empty())
+    {
+        object.textRelocations.push_back(Relocation
+        {
+            .offset = object.text.size(),
+            .type = size == 8 ? RelocationType::Absolute64 : RelocationType::Absolute32Signed,
+            .symbol = immediate.symbol,
+            .addend = immediate.value
+        });
+        emitValue(0, size);
+        return;
+    }
+    emitValue(immediate.value, size);
+}
+
+void X86Encoder::emitWithModRM(const std::vector<uint8_t>& opcode, int operandSize, int regField, bool isRegFieldByteRegister,
+                               const Operand& rm, size_t immediateSize)
+{
+    if(operandSize == 2)
+        emitByte(0x66);
+
+    uint8_t rex = 0x40;
+    if(operandSize == 8)
+        rex |= 0x08;
+    if(regField & 8)
+        rex |= 0x04;
+    if(rm.kind == Operand::Kind::Memory)
+    {
+        if(rm.index.has_value() && (rm.index.value() & 8))
+            rex |= 0x02;
+        if(rm.base.has_value() && (rm.base.value() & 8))
+            rex |= 0x01;
+    }
+    else if(rm.registerNumber & 8)
+        rex |= 0x01;
+    bool needsRex = rex != 0x40 || isRegFieldByteRegister || (rm.kind == Operand::Kind::Register && rm.needsRex);
+    if(needsRex)
+        emitByte(rex);
+    for(uint8_t byte : opcode)
+        emitByte(byte);
+    emitModRM(regField, rm, immediateSize);
+}
+
+void X86Encoder::emitWithVex(uint8_t prefix, uint8_t opcodeMap, bool isWide, bool is256Bits, int sourceRegister, uint8_t opcode, int regField,
+                             const Operand& rm, size_t immediateSize)
+{
+    // The 3 bytes form of the prefix, with the inverted bits of the REX prefix and of the additional source register
+    bool extendsIndex = rm.kind == Operand::Kind::Memory && rm.index.has_value() && (rm.index.value() & 8);
+    bool extendsBase = rm.kind == Operand::Kind::Memory ? rm.base.has_value() && (rm.base.value() & 8) : (rm.registerNumber & 8) != 0;
+    uint8_t prefixBits = prefix == 0x66 ? 1 : prefix == 0xF3 ? 2 : prefix == 0xF2 ? 3 : 0;
+    emitByte(0xC4);
+    emitByte(((regField & 8) ? 0 : 0x80) | (extendsIndex ? 0 : 0x40) | (extendsBase ? 0 : 0x20) | opcodeMap);
+    emitByte((isWide ? 0x80 : 0) | ((~sourceRegister & 15) << 3) | (is256Bits ? 0x04 : 0) | prefixBits);
+    emitByte(opcode);
+    emitModRM(regField, rm, immediateSize);
+}
+
+void X86Encoder::emitModRM(int regField, const Operand& rm, size_t immediateSize)
+{
+    uint8_t reg = (regField & 7) << 3;
+    if(rm.kind == Operand::Kind::Register)
+    {
+        emitByte(0xC0 | reg | (rm.registerNumber & 7));
+        return;
+    }
+
+    auto emitDisplacement32 = [&](RelocationType type, long long addend)
+    {
+        if(!rm.symbol.empty())
+        {
+            object.textRelocations.push_back(Relocation { .offset = object.text.size(), .type = type, .symbol = rm.symbol, .addend = addend });
+            emitValue(0, 4);
+        }
+        else
+            emitValue(rm.value, 4);
+    };
+
+    if(rm.isRipRelative)
+    {
+        emitByte(0x00 | reg | 0x05);
+        // The distance is computed from the end of the instruction
+        emitDisplacement32(RelocationType::Relative32, rm.value - 4 - static_cast<long long>(immediateSize));
+        return;
+    }
+    if(!rm.base.has_value())
+    {
+        emitByte(0x00 | reg | 0x04);
+        int index = rm.index.has_value() ? (rm.index.value() & 7) : 4;
+        int scaleBits = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        emitByte((scaleBits << 6) | (index << 3) | 0x05);
+        emitDisplacement32(RelocationType::Absolute32Signed, rm.value);
+        return;
+    }
+
+    int base = rm.base.value() & 7;
+    bool needsSib = rm.index.has_value() || base == 4;
+    uint8_t mod;
+    if(!rm.symbol.empty() || !fitsInt8(rm.value))
+        mod = 0x80;
+    else if(rm.value == 0 && base != 5)
+        mod = 0x00;
+    else
+        mod = 0x40;
+
+    emitByte(mod | reg | (needsSib ? 0x04 : base));
+    if(needsSib)
+    {
+        int index = rm.index.has_value() ? (rm.index.value() & 7) : 4;
+        int scaleBits = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        emitByte((scaleBits << 6) | (index << 3) | base);
+    }
+    if(mod == 0x40)
+        emitByte(rm.value & 0xFF);
+    else if(mod == 0x80)
+        emitDisplacement32(RelocationType::Absolute32Signed, rm.value);
+}
+
+void X86Encoder::emitWithRegisterInOpcode(uint8_t opcode, int operandSize, const Operand& registerOperand)
+{
+    if(operandSize == 2)
+        emitByte(0x66);
+    uint8_t rex = 0x40;
+    if(operandSize == 8)
+        rex |= 0x08;
+    if(registerOperand.registerNumber & 8)
+        rex |= 0x01;
+    if(rex != 0x40 || registerOperand.needsRex)
+        emitByte(rex);
+    emitByte(opcode + (registerOperand.registerNumber & 7));
+}
+
+void X86Encoder::emitRelativeTarget(const std::vector<uint8_t>& opcode, const std::string& label)
+{
+    for(uint8_t byte : opcode)
+        emitByte(byte);
+    bool isExternal = std::find(object.externalSymbols.begin(), object.externalSymbols.end(), label) != object.externalSymbols.end();
+    labelReferences.push_back(Relocation
+    {
+        .offset = object.text.size(),
+        .type = isExternal ? RelocationType::FunctionRelative32 : RelocationType::Relative32,
+        .symbol = label,
+        .addend = -4
+    });
+    emitValue(0, 4);
+}
+
+bool X86Encoder::encodeLine(const std::string& mnemonicText, const std::vector<std::string>& operandsText)
+{
+    std::string mnemonic = toLower(mnemonicText);
+    // The `rep` prefix is written like a mnemonic followed by the string instruction
+    if(mnemonic == "rep" && operandsText.size() == 1)
+        return encodeLine("rep " + toLower(trim(operandsText[0])), {});
+    std::vector<Operand> operands;
+    for(const std::string& operandText : operandsText)
+    {
+        auto operand = parseOperand(operandText);
+        if(!operand.has_value())
+            return false;
+        operands.push_back(operand.value());
+    }
+    using Kind = Operand::Kind;
+    auto isRegisterOrMemory = [](const Operand& operand) { return operand.kind == Kind::Register || operand.kind == Kind::Memory; };
+    // The size of an instruction is given by its register operands, or by the size written before the memory operand
+    auto sizeOf = [&]() -> int
+    {
+        for(const Operand& operand : operands)
+        {
+            if(operand.kind == Kind::Register)
+                return operand.size;
+        }
+        for(const Operand& operand : operands)
+        {
+            if(operand.kind == Kind::Memory && operand.size != 0)
+                return operand.size;
+        }
+        return 0;
+    };
+
+    static const std::unordered_map<std::string, int> arithmeticOperations = {
+        { "add", 0 }, { "or", 1 }, { "adc", 2 }, { "sbb", 3 }, { "and", 4 }, { "sub", 5 }, { "xor", 6 }, { "cmp", 7 }
+    };
+    static const std::unordered_map<std::string, int> unaryOperations = {
+        { "not", 2 }, { "neg", 3 }, { "mul", 4 }, { "imul", 5 }, { "div", 6 }, { "idiv", 7 }
+    };
+    static const std::unordered_map<std::string, int> shiftOperations = {
+        { "rol", 0 }, { "ror", 1 }, { "shl", 4 }, { "sal", 4 }, { "shr", 5 }, { "sar", 7 }
+    };
+
+    if(operands.empty())
+    {
+        static const std::unordered_map<std::string, std::vector<uint8_t>> noOperandInstructions = {
+            { "ret", { 0xC3 } }, { "leave", { 0xC9 } }, { "nop", { 0x90 } }, { "cqo", { 0x48, 0x99 } }, { "cdq", { 0x99 } },
+            { "syscall", { 0x0F, 0x05 } }, { "hlt", { 0xF4 } }, { "int3", { 0xCC } },
+            { "movsb", { 0xA4 } }, { "stosb", { 0xAA } }, { "rep movsb", { 0xF3, 0xA4 } }, { "rep stosb", { 0xF3, 0xAA } },
+            { "vzeroupper", { 0xC5, 0xF8, 0x77 } }
+        };
+        auto instruction = noOperandInstructions.find(mnemonic);
+        if(instruction == noOperandInstructions.end())
+            return false;
+        for(uint8_t byte : instruction->second)
+            emitByte(byte);
+        return true;
+    }
+
+    // The AVX2 instructions have a VEX prefix, and a first source operand that isn't overwritten
+    auto isVectorRegister = [](const Operand& operand) { return operand.kind == Kind::Register && (operand.size == 16 || operand.size == 32); };
+    if(mnemonic.starts_with("v") && std::any_of(operands.begin(), operands.end(), isVectorRegister))
+    {
+        struct VexOperation
+        {
+            uint8_t prefix;
+            uint8_t opcodeMap;
+            uint8_t opcode;
+        };
+        static const std::unordered_map<std::string, VexOperation> vexOperations = {
+            { "vpaddb", { 0x66, 1, 0xFC } }, { "vpaddq", { 0x66, 1, 0xD4 } }, { "vpsubb", { 0x66, 1, 0xF8 } }, { "vpsubq", { 0x66, 1, 0xFB } },
+            { "vpsadbw", { 0x66, 1, 0xF6 } }, { "vpxor", { 0x66, 1, 0xEF } }, { "vpunpckhqdq", { 0x66, 1, 0x6D } }
+        };
+        const Operand& destination = operands[0];
+        bool is256Bits = destination.size == 32 || (operands.size() > 1 && operands[1].size == 32);
+        if(auto operation = vexOperations.find(mnemonic); operation != vexOperations.end() && operands.size() == 3 &&
+           isVectorRegister(destination) && isVectorRegister(operands[1]) && (isVectorRegister(operands[2]) || operands[2].kind == Kind::Memory))
+        {
+            emitWithVex(operation->second.prefix, operation->second.opcodeMap, false, is256Bits, operands[1].registerNumber, operation->second.opcode,
+                        destination.registerNumber, operands[2], 0);
+        }
+        else if(mnemonic == "vmovdqu" && operands.size() == 2 && isVectorRegister(destination) && (isVectorRegister(operands[1]) || operands[1].kind == Kind::Memory))
+            emitWithVex(0xF3, 1, false, is256Bits, 0, 0x6F, destination.registerNumber, operands[1], 0);
+        else if(mnemonic == "vmovdqu" && operands.size() == 2 && destination.kind == Kind::Memory && isVectorRegister(operands[1]))
+            emitWithVex(0xF3, 1, false, is256Bits, 0, 0x7F, operands[1].registerNumber, destination, 0);
+        else if(mnemonic == "vpbroadcastq" && operands.size() == 2 && isVectorRegister(destination) && operands[1].size == 16)
+            emitWithVex(0x66, 2, false, is256Bits, 0, 0x59, destination.registerNumber, operands[1], 0);
+        else if(mnemonic == "vmovq" && operands.size() == 2 && destination.size == 16 && operands[1].kind == Kind::Register && operands[1].size == 8)
+            emitWithVex(0x66, 1, true, false, 0, 0x6E, destination.registerNumber, operands[1], 0);
+        else if(mnemonic == "vmovq" && operands.size() == 2 && destination.kind == Kind::Register && destination.size == 8 && operands[1].size == 16)
+            emitWithVex(0x66, 1, true, false, 0, 0x7E, operands[1].registerNumber, destination, 0);
+        else if(mnemonic == "vextracti128" && operands.size() == 3 && destination.size == 16 && operands[1].size == 32 && operands[2].kind == Kind::Immediate)
+        {
+            emitWithVex(0x66, 3, false, true, 0, 0x39, operands[1].registerNumber, destination, 1);
+            emitImmediate(operands[2], 1);
+        }
+        else
+            return false;
+        return true;
+    }
+
+    // The SSE2 instructions work on the `xmm` registers, and their mandatory prefix takes the place of the operand size prefix
+    auto isXmmRegister = [](const Operand& operand) { return operand.kind == Kind::Register && operand.size == 16; };
+    if(std::any_of(operands.begin(), operands.end(), isXmmRegister))
+    {
+        static const std::unordered_map<std::string, std::pair<uint8_t, uint8_t>> sseOperations = {
+            { "movdqu", { 0xF3, 0x6F } }, { "movdqa", { 0x66, 0x6F } }, { "pcmpeqb", { 0x66, 0x74 } }, { "pminub", { 0x66, 0xDA } },
+            { "pand", { 0x66, 0xDB } }, { "por", { 0x66, 0xEB } }, { "pxor", { 0x66, 0xEF } }, { "punpcklqdq", { 0x66, 0x6C } },
+            { "punpckhqdq", { 0x66, 0x6D } }, { "paddb", { 0x66, 0xFC } }, { "paddq", { 0x66, 0xD4 } }, { "psubb", { 0x66, 0xF8 } },
+            { "psubq", { 0x66, 0xFB } }, { "psadbw", { 0x66, 0xF6 } }
+        };
+        auto emitSse = [&](uint8_t prefix, uint8_t opcode, int operandSize, int regField, const Operand& rm)
+        {
+            emitByte(prefix);
+            emitWithModRM({ 0x0F, opcode }, operandSize, regField, false, rm, 0);
+        };
+        if(operands.size() != 2)
+            return false;
+        const Operand& destination = operands[0];
+        const Operand& source = operands[1];
+        auto operation = sseOperations.find(mnemonic);
+        if(operation != sseOperations.end() && isXmmRegister(destination) && (isXmmRegister(source) || source.kind == Kind::Memory))
+            emitSse(operation->second.first, operation->second.second, 4, destination.registerNumber, source);
+        else if((mnemonic == "movdqu" || mnemonic == "movdqa") && destination.kind == Kind::Memory && isXmmRegister(source))
+            emitSse(mnemonic == "movdqu" ? 0xF3 : 0x66, 0x7F, 4, source.registerNumber, destination);
+        else if(mnemonic == "pmovmskb" && destination.kind == Kind::Register && destination.size == 4 && isXmmRegister(source))
+            emitSse(0x66, 0xD7, 4, destination.registerNumber, source);
+        else if(((mnemonic == "movd" && source.size == 4) || (mnemonic == "movq" && source.size == 8)) && isXmmRegister(destination) && source.kind == Kind::Register)
+            emitSse(0x66, 0x6E, source.size, destination.registerNumber, source);
+        else if(mnemonic == "movq" && destination.kind == Kind::Register && destination.size == 8 && isXmmRegister(source))
+            emitSse(0x66, 0x7E, 8, source.registerNumber, destination);
+        else
+            return false;
+        return true;
+    }
+
+    if(mnemonic == "bsf" && operands.size() == 2 && operands[0].kind == Kind::Register && operands[0].size != 1 && isRegisterOrMemory(operands[1]))
+    {
+        emitWithModRM({ 0x0F, 0xBC }, operands[0].size, operands[0].registerNumber, false, operands[1], 0);
+        return true;
+    }
+
+    if(auto operation = arithmeticOperations.find(mnemonic); operation != arithmeticOperations.end() && operands.size() == 2)
+    {
+        const Operand& destination = operands[0];
+        const Operand& source = operands[1];
+        int size = sizeOf();
+        uint8_t opcodeBase = operation->second * 8;
+        if(size == 0 || !isRegisterOrMemory(destination))
+            return false;
+        if(source.kind == Kind::Register)
+        {
+            emitWithModRM({ static_cast<uint8_t>(opcodeBase + (size == 1 ? 0x00 : 0x01)) }, size, source.registerNumber, source.needsRex, destination, 0);
+            return true;
+        }
+        if(source.kind == Kind::Memory)
+        {
+            if(destination.kind != Kind::Register)
+                return false;
+            emitWithModRM({ static_cast<uint8_t>(opcodeBase + (size == 1 ? 0x02 : 0x03)) }, size, destination.registerNumber, destination.needsRex, source, 0);
+            return true;
+        }
+        if(size == 1)
+        {
+            emitWithModRM({ 0x80 }, size, operation->second, false, destination, 1);
+            emitImmediate(source, 1);
+        }
+        else if(source.symbol.empty() && fitsInt8(source.value))
+        {
+            emitWithModRM({ 0x83 }, size, operation->second, false, destination, 1);
+            emitImmediate(source, 1);
+        }
+        else
+        {
+            if(source.symbol.empty() && size == 8 && !fitsInt32(source.value))
+                return false;
+            size_t immediateSize = size == 2 ? 2 : 4;
+            emitWithModRM({ 0x81 }, size, operation->second, false, destination, immediateSize);
+            emitImmediate(source, immediateSize);
+        }
+        return true;
+    }
+
+    if(mnemonic == "mov" && operands.size() == 2)
+    {
+        const Operand& destination = operands[0];
+        const Operand& source = operands[1];
+        int size = sizeOf();
+        if(size == 0 || !isRegisterOrMemory(destination))
+            return false;
+        if(source.kind == Kind::Register)
+        {
+            emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0x88 : 0x89) }, size, source.registerNumber, source.needsRex, destination, 0);
+            return true;
+        }
+        if(source.kind == Kind::Memory)
+        {
+            if(destination.kind != Kind::Register)
+                return false;
+            emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0x8A : 0x8B) }, size, destination.registerNumber, destination.needsRex, source, 0);
+            return true;
+        }
+        if(destination.kind == Kind::Register)
+        {
+            if(size == 8 && source.symbol.empty() && fitsInt32(source.value))
+            {
+                emitWithModRM({ 0xC7 }, size, 0, false, destination, 4);
+                emitImmediate(source, 4);
+            }
+            else if(size == 8 && source.symbol.empty() && source.value >= 0 && source.value <= std::numeric_limits<uint32_t>::max())
+            {
+                // Writing the 32 bits register clears the upper half
+                emitWithRegisterInOpcode(0xB8, 4, destination);
+                emitImmediate(source, 4);
+            }
+            else
+            {
+                emitWithRegisterInOpcode(size == 1 ? 0xB0 : 0xB8, size, destination);
+                emitImmediate(source, size);
+            }
+            return true;
+        }
+        if(size == 8 && source.symbol.empty() && !fitsInt32(source.value))
+            return false;
+        size_t immediateSize = std::min(size, 4);
+        emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xC6 : 0xC7) }, size, 0, false, destination, immediateSize);
+        emitImmediate(source, immediateSize);
+        return true;
+    }
+
+    if((mnemonic == "movzx" || mnemonic == "movsx") && operands.size() == 2 && operands[0].kind == Kind::Register && isRegisterOrMemory(operands[1]))
+    {
+        int sourceSize = operands[1].size;
+        if(sourceSize != 1 && sourceSize != 2)
+            return false;
+        uint8_t opcode = (mnemonic == "movzx" ? 0xB6 : 0xBE) + (sourceSize == 2 ? 1 : 0);
+        bool sourceNeedsRex = operands[1].kind == Kind::Register && operands[1].needsRex;
+        emitWithModRM({ 0x0F, opcode }, operands[0].size, operands[0].registerNumber, sourceNeedsRex, operands[1], 0);
+        return true;
+    }
+
+    if(mnemonic == "movsxd" && operands.size() == 2 && operands[0].kind == Kind::Register && isRegisterOrMemory(operands[1]))
+    {
+        emitWithModRM({ 0x63 }, 8, operands[0].registerNumber, false, operands[1], 0);
+        return true;
+    }
+
+    if(mnemonic == "lea" && operands.size() == 2 && operands[0].kind == Kind::Register && operands[1].kind == Kind::Memory)
+    {
+        emitWithModRM({ 0x8D }, operands[0].size, operands[0].registerNumber, false, operands[1], 0);
+        return true;
+    }
+
+    if(mnemonic == "test" && operands.size() == 2 && isRegisterOrMemory(operands[0]))
+    {
+        int size = sizeOf();
+        if(size == 0)
+            return false;
+        if(operands[1].kind == Kind::Register)
+        {
+            emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0x84 : 0x85) }, size, operands[1].registerNumber, operands[1].needsRex, operands[0], 0);
+            return true;
+        }
+        if(operands[1].kind != Kind::Immediate)
+            return false;
+        size_t immediateSize = size == 1 ? 1 : size == 2 ? 2 : 4;
+        emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xF6 : 0xF7) }, size, 0, false, operands[0], immediateSize);
+        emitImmediate(operands[1], immediateSize);
+        return true;
+    }
+
+    if(mnemonic == "imul" && operands.size() >= 2 && operands[0].kind == Kind::Register)
+    {
+        // `imul rax, 5` is `imul rax, rax, 5`
+        Operand source = operands.size() == 3 || operands[1].kind != Kind::Immediate ? operands[1] : operands[0];
+        const Operand& immediate = operands.back();
+        if(immediate.kind != Kind::Immediate)
+        {
+            if(operands.size() != 2)
+                return false;
+            emitWithModRM({ 0x0F, 0xAF }, operands[0].size, operands[0].registerNumber, false, source, 0);
+            return true;
+        }
+        if(immediate.symbol.empty() && fitsInt8(immediate.value))
+        {
+            emitWithModRM({ 0x6B }, operands[0].size, operands[0].registerNumber, false, source, 1);
+            emitImmediate(immediate, 1);
+        }
+        else
+        {
+            if(immediate.symbol.empty() && !fitsInt32(immediate.value))
+                return false;
+            emitWithModRM({ 0x69 }, operands[0].size, operands[0].registerNumber, false, source, 4);
+            emitImmediate(immediate, 4);
+        }
+        return true;
+    }
+
+    if(auto operation = unaryOperations.find(mnemonic); operation != unaryOperations.end() && operands.size() == 1 && isRegisterOrMemory(operands[0]))
+    {
+        int size = sizeOf();
+        if(size == 0)
+            return false;
+        emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xF6 : 0xF7) }, size, operation->second, false, operands[0], 0);
+        return true;
+    }
+
+    if((mnemonic == "inc" || mnemonic == "dec") && operands.size() == 1 && isRegisterOrMemory(operands[0]))
+    {
+        int size = sizeOf();
+        if(size == 0)
+            return false;
+        emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xFE : 0xFF) }, size, mnemonic == "inc" ? 0 : 1, false, operands[0], 0);
+        return true;
+    }
+
+    if(auto operation = shiftOperations.find(mnemonic); operation != shiftOperations.end() && operands.size() == 2 && isRegisterOrMemory(operands[0]))
+    {
+        int size = operands[0].size;
+        if(size == 0)
+            return false;
+        if(operands[1].kind == Kind::Register && operands[1].registerNumber == 1 && operands[1].size == 1)
+        {
+            emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xD2 : 0xD3) }, size, operation->second, false, operands[0], 0);
+            return true;
+        }
+        if(operands[1].kind != Kind::Immediate || !operands[1].symbol.empty())
+            return false;
+        emitWithModRM({ static_cast<uint8_t>(size == 1 ? 0xC0 : 0xC1) }, size, operation->second, false, operands[0], 1);
+        emitImmediate(operands[1], 1);
+        return true;
+    }
+
+    if(mnemonic == "push" && operands.size() == 1)
+    {
+        const Operand& source = operands[0];
+        if(source.kind == Kind::Register)
+        {
+            if(source.size != 8)
+                return false;
+            emitWithRegisterInOpcode(0x50, 0, source);
+        }
+        else if(source.kind == Kind::Memory)
+            emitWithModRM({ 0xFF }, 0, 6, false, source, 0);
+        else if(source.symbol.empty() && fitsInt8(source.value))
+        {
+            emitByte(0x6A);
+            emitImmediate(source, 1);
+        }
+        else
+        {
+            if(source.symbol.empty() && !fitsInt32(source.value))
+                return false;
+            emitByte(0x68);
+            emitImmediate(source, 4);
+        }
+        return true;
+    }
+
+    if(mnemonic == "pop" && operands.size() == 1)
+    {
+        const Operand& destination = operands[0];
+        if(destination.kind == Kind::Register && destination.size == 8)
+            emitWithRegisterInOpcode(0x58, 0, destination);
+        else if(destination.kind == Kind::Memory)
+            emitWithModRM({ 0x8F }, 0, 0, false, destination, 0);
+        else
+            return false;
+        return true;
+    }
+
+    if((mnemonic == "call" || mnemonic == "jmp") && operands.size() == 1)
+    {
+        const Operand& target = operands[0];
+        if(target.kind == Kind::Immediate)
+        {
+            if(target.symbol.empty())
+                return false;
+            emitRelativeTarget({ static_cast<uint8_t>(mnemonic == "call" ? 0xE8 : 0xE9) }, target.symbol);
+        }
+        else
+            emitWithModRM({ 0xFF }, 0, mnemonic == "call" ? 2 : 4, false, target, 0);
+        return true;
+    }
+
+    if(mnemonic.size() > 1 && mnemonic[0] == 'j' && operands.size() == 1 && operands[0].kind == Kind::Immediate && !operands[0].symbol.empty())
+    {
+        auto conditionCode = conditionCodeOf(mnemonic.substr(1));
+        if(!conditionCode.has_value())
+            return false;
+        emitRelativeTarget({ 0x0F, static_cast<uint8_t>(0x80 + conditionCode.value()) }, operands[0].symbol);
+        return true;
+    }
+
+    if(mnemonic.rfind("set", 0) == 0 && operands.size() == 1 && isRegisterOrMemory(operands[0]))
+    {
+        auto conditionCode = conditionCodeOf(mnemonic.substr(3));
+        if(!conditionCode.has_value() || (operands[0].kind == Kind::Register && operands[0].size != 1))
+            return false;
+        bool needsRex = operands[0].kind == Kind::Register && operands[0].needsRex;
+        emitWithModRM({ 0x0F, static_cast<uint8_t>(0x90 + conditionCode.value()) }, 0, 0, needsRex, operands[0], 0);
+        return true;
+    }
+
+    if(mnemonic.rfind("cmov", 0) == 0 && operands.size() == 2 && operands[0].kind == Kind::Register && isRegisterOrMemory(operands[1]))
+    {
+        auto conditionCode = conditionCodeOf(mnemonic.substr(4));
+        if(!conditionCode.has_value())
+            return false;
+        emitWithModRM({ 0x0F, static_cast<uint8_t>(0x40 + conditionCode.value()) }, operands[0].size, operands[0].registerNumber, false, operands[1], 0);
+        return true;
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+#include "../generation/assembly.hpp"
+
+/**
+ * @brief Enumeration representing the sections of the encoded program.
+ */
+enum class ObjectSection
+{
+    Text,
+    Data,
+    ReadOnlyData
+};
+
+/**
+ * @brief Enumeration representing how an address that is known only when the program is linked is written in the code.
+ */
+enum class RelocationType
+{
+    /// The 64 bits address of the symbol.
+    Absolute64,
+    /// The 32 bits address of the symbol, sign extended to 64 bits by the processor.
+    Absolute32Signed,
+    /// The 32 bits distance from the position of the relocation to the symbol.
+    Relative32,
+    /// Like Relative32, but the symbol is a function that can be defined in another file.
+    FunctionRelative32
+};
+
+/**
+ * @brief Structure representing a place of the text section that must be filled with the address of a symbol.
+ */
+struct Relocation
+{
+    size_t offset;
+    RelocationType type;
+    std::string symbol;
+    long long addend;
+};
+
+/**
+ * @brief Structure representing the position of a symbol defined by the program.
+ */
+struct SymbolDefinition
+{
+    std::string name;
+    ObjectSection section;
+    size_t offset;
+};
+
+/**
+ * @brief Structure representing a contiguous piece of the machine code of a function.
+ *
+ * The code of a function can be split in more pieces, when other functions are written inside it.
+ */
+struct FunctionRange
+{
+    std::string name;
+    size_t offset;
+    size_t size;
+};
+
+/**
+ * @brief Structure representing the machine code and the data of a program, before they are linked.
+ */
+struct ObjectCode
+{
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> readOnlyData;
+    /// The addresses in the text section that refer to the data sections or to the external symbols.
+    std::vector<Relocation> textRelocations;
+    /// The symbols defined by the program, in the order they are defined.
+    std::vector<SymbolDefinition> symbols;
+    std::vector<std::string> globalSymbols;
+    std::vector<std::string> externalSymbols;
+    /// The pieces of the text section that belong to each function, sorted by offset.
+    std::vector<FunctionRange> functionRanges;
+
+    /**
+     * @brief Get the definition of a symbol of the program.
+     */
+    const SymbolDefinition* findSymbol(const std::string& name) const;
+};
+
+/**
+ * @brief Class responsible for translating the generated assembly code to x86-64 machine code.
+ *
+ * It understands the NASM syntax of the instructions produced by the Generator and of the most common instructions
+ * written by the user with the `asm!` macro. The jumps always use 32 bits offsets, so the size of each instruction
+ * is known as soon as it's encoded and the labels are resolved in a single pass.
+ */
+class X86Encoder
+{
+public:
+    /**
+     * @brief Encode a whole program.
+     * @return The encoded program, or std::nullopt if it contains an instruction that can't be encoded (the errors are printed).
+     */
+    std::optional<ObjectCode> encode(const AssemblyProgram& program);
+
+private:
+    struct Operand;
+
+    bool encodeLine(const std::string& mnemonic, const std::vector<std::string>& operands);
+    bool encodeUserCode(const std::string& code);
+    void defineLabel(const std::string& label);
+    std::string qualifyLabel(const std::string& label) const;
+    std::optional<Operand> parseOperand(const std::string& text) const;
+    void computeFunctionRanges(const std::vector<FunctionSymbol>& functions);
+
+    void emitByte(uint8_t byte);
+    void emitValue(unsigned long long value, size_t size);
+    void emitWithModRM(const std::vector<uint8_t>& opcode, int operandSize, int regField, bool isRegFieldByteRegister,
+                       const Operand& rm, size_t immediateSize);
+    void emitWithVex(uint8_t prefix, uint8_t opcodeMap, bool isWide, bool is256Bits, int sourceRegister, uint8_t opcode, int regField,
+                     const Operand& rm, size_t immediateSize);
+    void emitModRM(int regField, const Operand& rm, size_t immediateSize);
+    void emitWithRegisterInOpcode(uint8_t opcode, int operandSize, const Operand& registerOperand);
+    void emitImmediate(const Operand& immediate, size_t size);
+    void emitRelativeTarget(const std::vector<uint8_t>& opcode, const std::string& label);
+
+    ObjectCode object;
+    std::vector<Relocation> labelReferences;
+    std::string lastGlobalLabel;
+    std::vector<std::string> errors;
+};
\ No newline at end of file
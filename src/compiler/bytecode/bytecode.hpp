@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Enumeration representing the operations of the bytecode.
+ *
+ * Each operation works on the registers of the frame of the current function: `a` is the destination,
+ * `b` and `c` are the operands, and `immediate` is a constant or the distance of the target of a jump.
+ */
+enum class OpCode : uint8_t
+{
+    /// a = immediate
+    LoadImmediate,
+    /// a = constants[immediate]
+    LoadConstant,
+    /// a = the address of the characters of strings[immediate]
+    LoadString,
+    /// a = b
+    Move,
+
+    /// a = b + c
+    Add,
+    /// a = b + immediate
+    AddImmediate,
+    /// a = b - c
+    Sub,
+    /// a = b * c
+    Mul,
+    /// a = b / c (unsigned, like the native code)
+    Div,
+    /// a = b < c
+    LessThan,
+    /// a = b > c
+    GreaterThan,
+    /// a = b == c
+    EqualTo,
+    /// a = b != c
+    NotEqualTo,
+
+    /// a = the address of the elements of an array, from the slot `immediate` of the arrays of the frame, after setting to 0 the first `a` bytes
+    AllocateArray,
+    /// End the program with INDEX_OUT_OF_BOUNDS_EXIT_CODE if a isn't between 0 and immediate - 1
+    CheckIndex,
+    /// a = the 64 bits element c of the array whose elements are at b
+    LoadInt,
+    /// a = the byte c of the array whose elements are at b
+    LoadByte,
+    /// The 64 bits element b of the array whose elements are at a = c
+    StoreInt,
+    /// The byte b of the array whose elements are at a = the lowest byte of c
+    StoreByte,
+
+    /// Continue from `immediate` instructions after the next one
+    Jump,
+    /// Jump if a == 0
+    JumpIfZero,
+    /// Jump if a != 0
+    JumpIfNotZero,
+    /// Jump if b < c
+    JumpIfLess,
+    /// Jump if b >= c
+    JumpIfGreaterOrEqual,
+    /// Jump if b > c
+    JumpIfGreater,
+    /// Jump if b <= c
+    JumpIfLessOrEqual,
+    /// Jump if b == c
+    JumpIfEqual,
+    /// Jump if b != c
+    JumpIfNotEqual,
+
+    /// a = functions[immediate](registers from b), the registers of the callee start at the register b of the caller
+    Call,
+    /// Replace the frame of the current function with the one of functions[immediate], whose arguments are in the registers from b
+    TailCall,
+    /// a = the intrinsic whose IntrinsicType is immediate, called with the registers from b
+    CallIntrinsic,
+    /// Return the value of a to the caller
+    Return,
+    /// End the program with the exit code in a
+    Exit,
+
+    Count
+};
+
+/**
+ * @brief Structure representing an instruction of the bytecode.
+ */
+struct Instruction
+{
+    OpCode opcode;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+    int32_t immediate;
+};
+
+/**
+ * @brief Structure representing the bytecode of a function.
+ */
+struct BytecodeFunction
+{
+    std::string name;
+    size_t parametersCount;
+    /// The number of registers of the frame of the function: the parameters, the variables and the temporary values.
+    size_t registersCount;
+    /// The number of 8 bytes slots of the frame used by the elements of the arrays declared in the function.
+    size_t arraySlotsCount = 0;
+    std::vector<Instruction> code;
+};
+
+/**
+ * @brief Structure representing a whole program compiled to bytecode.
+ */
+struct BytecodeModule
+{
+    /// The functions of the program, the first one is the code outside of the functions.
+    std::vector<BytecodeFunction> functions;
+    /// The 64 bits constants that don't fit in the immediate of an instruction.
+    std::vector<long long> constants;
+    /// The characters of the string literals, that the VM stores after their length and followed by a null character.
+    std::vector<std::string> strings;
+};
\ No newline at end of file
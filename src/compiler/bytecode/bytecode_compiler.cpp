@@ -0,0 +1,634 @@
+#include "bytecode_compiler.hpp"
+
+#include <iostream>
+#include <limits>
+
+#include "../token/tokenizer.hpp"
+#include "../generation/generation_data.hpp"
+#include "../generation/special/intrinsic.hpp"
+#include "../generation/utils.hpp"
+#include "../optimizer/ast.hpp"
+
+const size_t MAX_REGISTERS = std::numeric_limits<uint16_t>::max();
+
+static bool fitsInImmediate(long long value)
+{
+    return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+}
+
+// Get the value of the expression, if it's a number literal (optionally between brackets)
+static std::optional<long long> getNumberLiteral(const ExpressionNode* expression)
+{
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return std::nullopt;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionBracketsNode*>(atom->variant))
+        return getNumberLiteral(std::get<ExpressionBracketsNode*>(atom->variant)->expression);
+    if(!std::holds_alternative<ExpressionLiteralNode*>(atom->variant))
+        return std::nullopt;
+    const Token& literal = std::get<ExpressionLiteralNode*>(atom->variant)->literal;
+    if(literal.type != TokenType::LiteralNumber)
+        return std::nullopt;
+    return static_cast<long long>(std::stoull(literal.value.value()));
+}
+
+// Get the variable read by the expression, if it's only a variable (optionally between brackets)
+static const ExpressionIdentNode* getIdent(const ExpressionNode* expression)
+{
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return nullptr;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionBracketsNode*>(atom->variant))
+        return getIdent(std::get<ExpressionBracketsNode*>(atom->variant)->expression);
+    if(std::holds_alternative<ExpressionIdentNode*>(atom->variant))
+        return std::get<ExpressionIdentNode*>(atom->variant);
+    return nullptr;
+}
+
+// Get the function called by the expression, if it's only a function call (optionally between brackets)
+static const ExpressionFunctionCallNode* getFunctionCall(const ExpressionNode* expression)
+{
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return nullptr;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionBracketsNode*>(atom->variant))
+        return getFunctionCall(std::get<ExpressionBracketsNode*>(atom->variant)->expression);
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+        return std::get<ExpressionFunctionCallNode*>(atom->variant);
+    return nullptr;
+}
+
+// The instruction computing the operator, or std::nullopt for the logical operators, whose operands are compiled to jumps
+static std::optional<OpCode> operationOf(Operator operation)
+{
+    switch(operation)
+    {
+        case Operator::Add: return OpCode::Add;
+        case Operator::Sub: return OpCode::Sub;
+        case Operator::Mul: return OpCode::Mul;
+        case Operator::Div: return OpCode::Div;
+        case Operator::GreaterThan: return OpCode::GreaterThan;
+        case Operator::LessThan: return OpCode::LessThan;
+        case Operator::EqualTo: return OpCode::EqualTo;
+        case Operator::NotEqualTo: return OpCode::NotEqualTo;
+        case Operator::And:
+        case Operator::Or: return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+// The jump taken when the comparison has the given value, or std::nullopt if the operator isn't a comparison
+static std::optional<OpCode> comparisonJumpOf(Operator operation, bool jumpIfTrue)
+{
+    switch(operation)
+    {
+        case Operator::LessThan: return jumpIfTrue ? OpCode::JumpIfLess : OpCode::JumpIfGreaterOrEqual;
+        case Operator::GreaterThan: return jumpIfTrue ? OpCode::JumpIfGreater : OpCode::JumpIfLessOrEqual;
+        case Operator::EqualTo: return jumpIfTrue ? OpCode::JumpIfEqual : OpCode::JumpIfNotEqual;
+        case Operator::NotEqualTo: return jumpIfTrue ? OpCode::JumpIfNotEqual : OpCode::JumpIfEqual;
+        default: return std::nullopt;
+    }
+}
+
+BytecodeCompiler::BytecodeCompiler(bool checkBounds, bool evaluatePureCalls, size_t maxEvaluationSteps, size_t maxEvaluationDepth)
+    : checkBounds(checkBounds), evaluatePureCalls(evaluatePureCalls), maxEvaluationSteps(maxEvaluationSteps), maxEvaluationDepth(maxEvaluationDepth) {}
+
+std::optional<BytecodeModule> BytecodeCompiler::compile(const ProgramNode& program)
+{
+    module = BytecodeModule { };
+    functionIndices.clear();
+    errors.clear();
+    compileTimeEvaluation.reset();
+    if(evaluatePureCalls)
+        compileTimeEvaluation.emplace(program.nodes, maxEvaluationSteps, maxEvaluationDepth);
+
+    // The functions can be called before their definition, so they are all known before compiling any code
+    module.functions.push_back(BytecodeFunction { .name = "main", .parametersCount = 0, .registersCount = 0 });
+    std::vector<const StatementFunctionDefinitionNode*> definitions;
+    for(const StatementNode* statement : program.nodes)
+    {
+        if(!std::holds_alternative<StatementFunctionDefinitionNode*>(statement->variant))
+            continue;
+        auto definition = std::get<StatementFunctionDefinitionNode*>(statement->variant);
+        const std::string& name = definition->functionName->ident.value.value();
+        if(functionIndices.contains(name))
+        {
+            errors.push_back("The function `" + name + "` is defined more than once!");
+            continue;
+        }
+        functionIndices[name] = module.functions.size();
+        module.functions.push_back(BytecodeFunction { .name = name, .parametersCount = definition->parameters.size(), .registersCount = 0 });
+        definitions.push_back(definition);
+    }
+
+    compileFunction(program.nodes, { }, 0);
+    for(const StatementFunctionDefinitionNode* definition : definitions)
+        compileFunction(definition->implementation->statements, definition->parameters, functionIndices[definition->functionName->ident.value.value()]);
+
+    for(const std::string& error : errors)
+        std::cerr << error << std::endl;
+    if(!errors.empty())
+        return std::nullopt;
+    return std::move(module);
+}
+
+void BytecodeCompiler::compileFunction(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters, size_t functionIndex)
+{
+    currentFunction = functionIndex;
+    scopes.clear();
+    scopeStartRegisters.clear();
+    arrayScopes.clear();
+    scopeStartArraySlots.clear();
+    nextRegister = 0;
+    nextArraySlot = 0;
+    boundsCheckElimination.reset();
+    if(checkBounds)
+        boundsCheckElimination.emplace(statements);
+    hasStackArrays = ast::containsStackArray(statements);
+
+    enterScope();
+    for(const StatementDeclareVariableNode* parameter : parameters)
+    {
+        // An array is passed as the address of its elements
+        const std::string& name = parameter->name->ident.value.value();
+        scopes.back()[name] = allocateRegister();
+        if(parameter->arrayLength.has_value())
+            arrayScopes.back()[name] = BytecodeArray { .declaration = parameter, .hasElementsOnStack = false };
+    }
+    compileStatements(statements);
+
+    // Reaching the end of the program exits with 0, and reaching the end of a function returns 0
+    uint16_t zero = allocateRegister();
+    emit(OpCode::LoadImmediate, zero);
+    emit(functionIndex == 0 ? OpCode::Exit : OpCode::Return, zero);
+    exitScope();
+}
+
+void BytecodeCompiler::compileStatements(const std::vector<StatementNode*>& statements)
+{
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        // An array declared with a value gets the address of its elements from it, the others have their elements in the frame
+        auto declaration = std::get_if<StatementDeclareVariableNode*>(&statements[i]->variant);
+        if(declaration != nullptr && (*declaration)->arrayLength.has_value() && ast::initializationOf(statements, i) == nullptr)
+            compileStackArray(*declaration);
+        else
+            compileStatement(statements[i]);
+    }
+}
+
+void BytecodeCompiler::compileStackArray(const StatementDeclareVariableNode* declaration)
+{
+    const std::string& name = declaration->name->ident.value.value();
+    if(scopes.back().contains(name))
+    {
+        errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::VariableAlreadyDefined, .hint = name }));
+        return;
+    }
+    size_t slotsCount = utils::countArraySlots(declaration);
+    if(!fitsInImmediate(static_cast<long long>(nextArraySlot + slotsCount) * 8))
+    {
+        errors.push_back("The arrays of the function `" + module.functions[currentFunction].name + "` are too big!");
+        return;
+    }
+
+    uint16_t variable = allocateRegister();
+    emit(OpCode::LoadImmediate, variable, 0, 0, static_cast<int32_t>(slotsCount * 8));
+    emit(OpCode::AllocateArray, variable, 0, 0, static_cast<int32_t>(nextArraySlot));
+    scopes.back()[name] = variable;
+    arrayScopes.back()[name] = BytecodeArray { .declaration = declaration, .hasElementsOnStack = true };
+    nextArraySlot += slotsCount;
+    size_t& arraySlotsCount = module.functions[currentFunction].arraySlotsCount;
+    arraySlotsCount = std::max(arraySlotsCount, nextArraySlot);
+}
+
+void BytecodeCompiler::compileStatement(const StatementNode* statement)
+{
+    // The temporary values of a statement aren't used after it
+    size_t startRegister = nextRegister;
+
+    std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, StatementReturnNode*>)
+        {
+            const ExpressionFunctionCallNode* call = getFunctionCall(node->expression);
+            if(call != nullptr && currentFunction != 0 && !hasStackArrays && functionIndices.contains(call->functionName->ident.value.value()) &&
+               !evaluatedValueOf(call).has_value())
+            {
+                compileFunctionCall(call, 0, true);
+                return;
+            }
+            uint16_t value = compileOperand(node->expression);
+            emit(currentFunction == 0 ? OpCode::Exit : OpCode::Return, value);
+        }
+        else if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+        {
+            const std::string& name = node->name->ident.value.value();
+            if(scopes.back().contains(name))
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::VariableAlreadyDefined, .hint = name }));
+                return;
+            }
+            uint16_t variable = allocateRegister();
+            emit(OpCode::LoadImmediate, variable);
+            scopes.back()[name] = variable;
+            if(node->arrayLength.has_value())
+                arrayScopes.back()[name] = BytecodeArray { .declaration = node, .hasElementsOnStack = false };
+            startRegister = nextRegister;
+        }
+        else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+        {
+            const std::string& name = node->name->ident.value.value();
+            std::optional<uint16_t> variable = findVariable(name);
+            if(!variable.has_value())
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = name }));
+                return;
+            }
+            if(node->index.has_value())
+            {
+                // The index is checked before the value is computed, like in the native code
+                auto element = compileElement(node->name, node->index.value());
+                if(!element.has_value())
+                    return;
+                uint16_t value = compileOperand(node->value);
+                OpCode store = ast::elementSizeOf(findArray(name)->declaration) == 1 ? OpCode::StoreByte : OpCode::StoreInt;
+                emit(store, element->first, element->second, value);
+                return;
+            }
+            if(std::optional<BytecodeArray> array = findArray(name); array.has_value() && array->hasElementsOnStack)
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::ArrayAssignment, .hint = name }));
+                return;
+            }
+            compileExpression(node->value, variable.value());
+        }
+        else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+            compileScope(node);
+        else if constexpr (std::is_same_v<T, StatementIfNode*>)
+        {
+            std::vector<size_t> jumpsToElse = compileConditionalJump(node->condition, false);
+            compileScope(node->scope);
+            if(node->elseScope.has_value())
+            {
+                size_t jumpToEnd = getCodeSize();
+                emit(OpCode::Jump);
+                patchJumps(jumpsToElse, getCodeSize());
+                compileScope(node->elseScope.value());
+                patchJump(jumpToEnd, getCodeSize());
+            }
+            else
+                patchJumps(jumpsToElse, getCodeSize());
+        }
+        else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+        {
+            // The loop is rotated, so that each iteration ends with a single conditional jump
+            size_t jumpToCondition = getCodeSize();
+            emit(OpCode::Jump);
+            size_t bodyStart = getCodeSize();
+            compileScope(node->scope);
+            patchJump(jumpToCondition, getCodeSize());
+            patchJumps(compileConditionalJump(node->condition, true), bodyStart);
+        }
+        else if constexpr (std::is_same_v<T, StatementFunctionDefinitionNode*>)
+        {
+            // The functions are compiled on their own by `compile`, that looks for them only outside of the scopes
+            if(currentFunction != 0 || scopes.size() > 1)
+                errors.push_back("The function `" + node->functionName->ident.value.value() + "` must be defined outside of the other functions and scopes!");
+        }
+        else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+        {
+            // A pure call whose value is known has nothing left to do
+            if(!evaluatedValueOf(node).has_value())
+                compileFunctionCall(node, allocateRegister());
+        }
+        else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+        {
+            errors.push_back("The `" + node->macroName->ident.value.value() + "` macro can't be run by the bytecode VM: "
+                             "compile the program to native code instead");
+        }
+    }, statement->variant);
+
+    nextRegister = startRegister;
+}
+
+void BytecodeCompiler::compileScope(const StatementScopeNode* scope)
+{
+    enterScope();
+    compileStatements(scope->statements);
+    exitScope();
+}
+
+void BytecodeCompiler::compileExpression(const ExpressionNode* expression, uint16_t destination)
+{
+    size_t startRegister = nextRegister;
+
+    std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionAtomNode*>)
+        {
+            std::visit([&](auto atom)
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                {
+                    if(atom->literal.type == TokenType::LiteralString)
+                    {
+                        emit(OpCode::LoadString, destination, 0, 0, static_cast<int32_t>(module.strings.size()));
+                        module.strings.push_back(decodeStringLiteral(atom->literal.value.value()));
+                        return;
+                    }
+                    compileNumber(getNumberLiteral(expression).value(), destination);
+                }
+                else if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+                {
+                    uint16_t variable = compileOperand(expression);
+                    if(variable != destination)
+                        emit(OpCode::Move, destination, variable);
+                }
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    compileExpression(atom->expression, destination);
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                    compileFunctionCall(atom, destination);
+                else if constexpr (std::is_same_v<V, ExpressionIndexNode*>)
+                {
+                    if(auto element = compileElement(atom->array, atom->index))
+                    {
+                        OpCode load = ast::elementSizeOf(findArray(atom->array->ident.value.value())->declaration) == 1 ? OpCode::LoadByte : OpCode::LoadInt;
+                        emit(load, destination, element->first, element->second);
+                    }
+                }
+            }, node->variant);
+        }
+        else if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+        {
+            // Additions and subtractions of small constants don't need a register for the constant
+            std::optional<long long> rhsConstant = getNumberLiteral(node->rhs);
+            std::optional<long long> lhsConstant = getNumberLiteral(node->lhs);
+            if(rhsConstant.has_value() && (node->operation == Operator::Add || node->operation == Operator::Sub))
+            {
+                long long value = node->operation == Operator::Add ? rhsConstant.value() : -rhsConstant.value();
+                if(fitsInImmediate(value))
+                {
+                    emit(OpCode::AddImmediate, destination, compileOperand(node->lhs), 0, static_cast<int32_t>(value));
+                    return;
+                }
+            }
+            if(lhsConstant.has_value() && node->operation == Operator::Add && fitsInImmediate(lhsConstant.value()))
+            {
+                emit(OpCode::AddImmediate, destination, compileOperand(node->rhs), 0, static_cast<int32_t>(lhsConstant.value()));
+                return;
+            }
+
+            if(node->operation == Operator::And || node->operation == Operator::Or)
+            {
+                // The destination is written only after the operands, by the instruction of the path that is taken
+                std::vector<size_t> jumpsToFalse = compileConditionalJump(expression, false);
+                emit(OpCode::LoadImmediate, destination, 0, 0, 1);
+                size_t jumpToEnd = getCodeSize();
+                emit(OpCode::Jump);
+                patchJumps(jumpsToFalse, getCodeSize());
+                emit(OpCode::LoadImmediate, destination);
+                patchJump(jumpToEnd, getCodeSize());
+                return;
+            }
+
+            std::optional<OpCode> operation = operationOf(node->operation);
+            if(!operation.has_value())
+            {
+                errors.push_back("Internal error: the logical operators must be compiled to jumps!");
+                return;
+            }
+            uint16_t lhs = compileOperand(node->lhs);
+            uint16_t rhs = compileOperand(node->rhs);
+            emit(operation.value(), destination, lhs, rhs);
+        }
+    }, expression->variant);
+
+    nextRegister = startRegister;
+}
+
+uint16_t BytecodeCompiler::compileOperand(const ExpressionNode* expression)
+{
+    const ExpressionIdentNode* ident = getIdent(expression);
+    if(ident != nullptr)
+    {
+        const std::string& name = ident->ident.value.value();
+        std::optional<uint16_t> variable = findVariable(name);
+        if(variable.has_value())
+            return variable.value();
+        errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = name }));
+    }
+
+    uint16_t temporary = allocateRegister();
+    if(ident == nullptr)
+        compileExpression(expression, temporary);
+    return temporary;
+}
+
+void BytecodeCompiler::compileFunctionCall(const ExpressionFunctionCallNode* call, uint16_t destination, bool isTailCall)
+{
+    if(auto value = evaluatedValueOf(call))
+    {
+        compileNumber(value.value(), destination);
+        return;
+    }
+
+    const std::string& name = call->functionName->ident.value.value();
+    auto function = functionIndices.find(name);
+    // The functions of the program replace the intrinsics with the same name
+    std::optional<Intrinsic> intrinsic = function == functionIndices.end() ? findIntrinsic(name) : std::nullopt;
+    size_t parametersCount = 0;
+    if(function != functionIndices.end())
+        parametersCount = module.functions[function->second].parametersCount;
+    else if(intrinsic.has_value())
+        parametersCount = intrinsic->parametersCount;
+    if((function == functionIndices.end() && !intrinsic.has_value()) || parametersCount != call->arguments.size())
+    {
+        errors.push_back("The function call `" + name + "` is invalid!");
+        return;
+    }
+
+    // The arguments are the first registers of the frame of the callee, that starts after the registers used by the caller
+    size_t startRegister = nextRegister;
+    for(size_t i = 0; i < call->arguments.size(); i++)
+        allocateRegister();
+    for(size_t i = 0; i < call->arguments.size(); i++)
+        compileExpression(call->arguments[i], static_cast<uint16_t>(startRegister + i));
+    if(intrinsic.has_value())
+        emit(OpCode::CallIntrinsic, destination, static_cast<uint16_t>(startRegister), 0, static_cast<int32_t>(intrinsic->type));
+    else
+        emit(isTailCall ? OpCode::TailCall : OpCode::Call, destination, static_cast<uint16_t>(startRegister), 0, static_cast<int32_t>(function->second));
+    nextRegister = startRegister;
+}
+
+std::optional<long long> BytecodeCompiler::evaluatedValueOf(const ExpressionFunctionCallNode* call) const
+{
+    if(!compileTimeEvaluation.has_value())
+        return std::nullopt;
+    return compileTimeEvaluation->getValue(call);
+}
+
+void BytecodeCompiler::compileNumber(long long value, uint16_t destination)
+{
+    if(fitsInImmediate(value))
+        emit(OpCode::LoadImmediate, destination, 0, 0, static_cast<int32_t>(value));
+    else
+    {
+        emit(OpCode::LoadConstant, destination, 0, 0, static_cast<int32_t>(module.constants.size()));
+        module.constants.push_back(value);
+    }
+}
+
+std::optional<std::pair<uint16_t, uint16_t>> BytecodeCompiler::compileElement(const ExpressionIdentNode* arrayName, const ExpressionNode* index)
+{
+    const std::string& name = arrayName->ident.value.value();
+    std::optional<BytecodeArray> array = findArray(name);
+    if(!array.has_value())
+    {
+        CodeGenerationErrorType error = findVariable(name).has_value() ? CodeGenerationErrorType::NotAnArray : CodeGenerationErrorType::UndeclaredVariable;
+        errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = error, .hint = name }));
+        return std::nullopt;
+    }
+
+    size_t length = array->declaration->arrayLength.value();
+    uint16_t indexRegister = compileOperand(index);
+    if(checkBounds && !(boundsCheckElimination.has_value() && boundsCheckElimination->isInBounds(index, length)))
+    {
+        if(!fitsInImmediate(static_cast<long long>(length)))
+        {
+            errors.push_back("The array `" + name + "` is too long to check its indices in the bytecode VM!");
+            return std::nullopt;
+        }
+        emit(OpCode::CheckIndex, indexRegister, 0, 0, static_cast<int32_t>(length));
+    }
+    return std::make_pair(findVariable(name).value(), indexRegister);
+}
+
+std::vector<size_t> BytecodeCompiler::compileConditionalJump(const ExpressionNode* condition, bool jumpIfTrue)
+{
+    condition = ast::skipBrackets(condition);
+    size_t startRegister = nextRegister;
+    std::vector<size_t> jumps;
+
+    auto binary = std::holds_alternative<ExpressionBinaryOperatorNode*>(condition->variant) ?
+        std::get<ExpressionBinaryOperatorNode*>(condition->variant) : nullptr;
+    if(binary != nullptr && (binary->operation == Operator::And || binary->operation == Operator::Or))
+    {
+        // `a || b` jumps when it's true as soon as one of the operands is true, and `a && b` jumps when it's false as soon as one is false
+        if(jumpIfTrue == (binary->operation == Operator::Or))
+        {
+            jumps = compileConditionalJump(binary->lhs, jumpIfTrue);
+            std::vector<size_t> rhsJumps = compileConditionalJump(binary->rhs, jumpIfTrue);
+            jumps.insert(jumps.end(), rhsJumps.begin(), rhsJumps.end());
+            return jumps;
+        }
+
+        // Otherwise the left operand can only decide that the jump isn't taken, and skips the right one
+        std::vector<size_t> skipJumps = compileConditionalJump(binary->lhs, !jumpIfTrue);
+        jumps = compileConditionalJump(binary->rhs, jumpIfTrue);
+        patchJumps(skipJumps, getCodeSize());
+        return jumps;
+    }
+    // `value == 0` (like `!value`) and `value != 0` jump on the value itself, so that `!(a && b)` is short-circuited too
+    if(binary != nullptr && (binary->operation == Operator::EqualTo || binary->operation == Operator::NotEqualTo) &&
+       getNumberLiteral(binary->rhs) == 0 && std::holds_alternative<ExpressionBinaryOperatorNode*>(ast::skipBrackets(binary->lhs)->variant))
+        return compileConditionalJump(binary->lhs, jumpIfTrue == (binary->operation == Operator::NotEqualTo));
+
+    // Comparisons are fused with the jump, so that they don't need to produce a value
+    std::optional<OpCode> comparisonJump = binary != nullptr ? comparisonJumpOf(binary->operation, jumpIfTrue) : std::nullopt;
+    if(comparisonJump.has_value())
+    {
+        uint16_t lhs = compileOperand(binary->lhs);
+        uint16_t rhs = compileOperand(binary->rhs);
+        jumps.push_back(getCodeSize());
+        emit(comparisonJump.value(), 0, lhs, rhs);
+    }
+    else
+    {
+        uint16_t value = compileOperand(condition);
+        jumps.push_back(getCodeSize());
+        emit(jumpIfTrue ? OpCode::JumpIfNotZero : OpCode::JumpIfZero, value);
+    }
+
+    nextRegister = startRegister;
+    return jumps;
+}
+
+void BytecodeCompiler::emit(OpCode opcode, uint16_t a, uint16_t b, uint16_t c, int32_t immediate)
+{
+    module.functions[currentFunction].code.push_back(Instruction { .opcode = opcode, .a = a, .b = b, .c = c, .immediate = immediate });
+}
+
+void BytecodeCompiler::patchJump(size_t jumpIndex, size_t targetIndex)
+{
+    module.functions[currentFunction].code[jumpIndex].immediate = static_cast<int32_t>(targetIndex) - static_cast<int32_t>(jumpIndex + 1);
+}
+
+void BytecodeCompiler::patchJumps(const std::vector<size_t>& jumpIndices, size_t targetIndex)
+{
+    for(size_t jumpIndex : jumpIndices)
+        patchJump(jumpIndex, targetIndex);
+}
+
+size_t BytecodeCompiler::getCodeSize() const
+{
+    return module.functions[currentFunction].code.size();
+}
+
+uint16_t BytecodeCompiler::allocateRegister()
+{
+    if(nextRegister >= MAX_REGISTERS)
+    {
+        errors.push_back("The function `" + module.functions[currentFunction].name + "` needs too many registers!");
+        return 0;
+    }
+    size_t& registersCount = module.functions[currentFunction].registersCount;
+    registersCount = std::max(registersCount, nextRegister + 1);
+    return static_cast<uint16_t>(nextRegister++);
+}
+
+void BytecodeCompiler::enterScope()
+{
+    scopes.emplace_back();
+    scopeStartRegisters.push_back(nextRegister);
+    arrayScopes.emplace_back();
+    scopeStartArraySlots.push_back(nextArraySlot);
+}
+
+void BytecodeCompiler::exitScope()
+{
+    // The registers of the variables of the scope are reused by the following code
+    scopes.pop_back();
+    nextRegister = scopeStartRegisters.back();
+    scopeStartRegisters.pop_back();
+    arrayScopes.pop_back();
+    nextArraySlot = scopeStartArraySlots.back();
+    scopeStartArraySlots.pop_back();
+}
+
+std::optional<uint16_t> BytecodeCompiler::findVariable(const std::string& name) const
+{
+    for(auto scope = scopes.rbegin(); scope != scopes.rend(); scope++)
+    {
+        if(auto variable = scope->find(name); variable != scope->end())
+            return variable->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<BytecodeArray> BytecodeCompiler::findArray(const std::string& name) const
+{
+    // The innermost variable with the name hides the others, even if it isn't an array
+    for(size_t i = scopes.size(); i-- > 0; )
+    {
+        if(scopes[i].contains(name))
+        {
+            auto array = arrayScopes[i].find(name);
+            return array == arrayScopes[i].end() ? std::nullopt : std::optional<BytecodeArray>(array->second);
+        }
+    }
+    return std::nullopt;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include "bytecode.hpp"
+#include "../parser/node/core.hpp"
+#include "../optimizer/bounds_check_elimination.hpp"
+#include "../optimizer/compile_time_evaluation.hpp"
+
+/**
+ * @brief Structure representing an array of the program, whose variable contains the address of its elements.
+ */
+struct BytecodeArray
+{
+    const StatementDeclareVariableNode* declaration;
+    /// If true the elements are in the frame of the function, and the variable can't get the address of other elements.
+    bool hasElementsOnStack;
+};
+
+/**
+ * @brief Class responsible for compiling the parsed program to the bytecode run by the VirtualMachine.
+ *
+ * Each variable gets its own register of the frame of its function, and the temporary values use the registers
+ * after the variables, like a stack. The code written with the `asm!` macro can't be compiled, because it's written
+ * for the processor: the programs that use it must be compiled to native code.
+ */
+class BytecodeCompiler
+{
+public:
+    /**
+     * @brief Constructor for the BytecodeCompiler class.
+     * @param checkBounds If true the program exits with INDEX_OUT_OF_BOUNDS_EXIT_CODE when the index of an element isn't in the bounds of its array.
+     * @param evaluatePureCalls If true the calls of the pure functions whose arguments are constants are replaced by their result.
+     * @param maxEvaluationSteps The number of statements and expressions that the evaluation of each call can run while compiling.
+     * @param maxEvaluationDepth The number of nested calls that the evaluation of each call can reach while compiling.
+     */
+    BytecodeCompiler(bool checkBounds = true, bool evaluatePureCalls = true, size_t maxEvaluationSteps = DEFAULT_MAX_EVALUATION_STEPS,
+                     size_t maxEvaluationDepth = DEFAULT_MAX_EVALUATION_DEPTH);
+
+    /**
+     * @brief Compile a whole program.
+     * @param program The root node of the parsed program.
+     * @return The compiled program, or std::nullopt if it can't be compiled (the errors are printed).
+     */
+    std::optional<BytecodeModule> compile(const ProgramNode& program);
+
+private:
+    void compileFunction(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters, size_t functionIndex);
+    void compileStatements(const std::vector<StatementNode*>& statements);
+    void compileStatement(const StatementNode* statement);
+    void compileScope(const StatementScopeNode* scope);
+    /**
+     * @brief Compile the declaration of an array whose elements are in the frame of the function, all set to 0.
+     */
+    void compileStackArray(const StatementDeclareVariableNode* declaration);
+    /**
+     * @brief Get the registers that contain the address of the elements of an array and the index of an element, checking the index
+     * if it isn't proven to be in the bounds of the array.
+     * @return The two registers, or std::nullopt if the name isn't an array (the error is saved).
+     */
+    std::optional<std::pair<uint16_t, uint16_t>> compileElement(const ExpressionIdentNode* arrayName, const ExpressionNode* index);
+
+    /**
+     * @brief Compile an expression that writes its value in the register `destination`.
+     *
+     * The destination is written only by the last instruction, so it can also be an operand of the expression.
+     */
+    void compileExpression(const ExpressionNode* expression, uint16_t destination);
+    /**
+     * @brief Get the register that contains the value of an expression, computing it in a temporary register if it isn't a variable.
+     */
+    uint16_t compileOperand(const ExpressionNode* expression);
+    /**
+     * @brief Compile a call that writes the returned value in the register `destination`.
+     * @param isTailCall If true the call is the value returned by the current function, and it reuses the frame of the current function.
+     */
+    void compileFunctionCall(const ExpressionFunctionCallNode* call, uint16_t destination, bool isTailCall = false);
+    /**
+     * @brief Get the result of a call computed while compiling, if it's a call of a pure function with constant arguments.
+     */
+    std::optional<long long> evaluatedValueOf(const ExpressionFunctionCallNode* call) const;
+    void compileNumber(long long value, uint16_t destination);
+    /**
+     * @brief Compile the jumps taken when the condition has the given value.
+     *
+     * The operands of `&&` and `||` get their own jumps, so that the right one is evaluated only when the left one doesn't decide the condition.
+     *
+     * @return The indices of the jumps, whose target must be set with patchJumps.
+     */
+    std::vector<size_t> compileConditionalJump(const ExpressionNode* condition, bool jumpIfTrue);
+
+    void emit(OpCode opcode, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, int32_t immediate = 0);
+    /**
+     * @brief Make the jump at `jumpIndex` continue from the instruction at `targetIndex`.
+     */
+    void patchJump(size_t jumpIndex, size_t targetIndex);
+    void patchJumps(const std::vector<size_t>& jumpIndices, size_t targetIndex);
+    size_t getCodeSize() const;
+
+    uint16_t allocateRegister();
+    void enterScope();
+    void exitScope();
+    std::optional<uint16_t> findVariable(const std::string& name) const;
+    /**
+     * @brief Get the array with the given name, or std::nullopt if the variable with this name isn't an array.
+     */
+    std::optional<BytecodeArray> findArray(const std::string& name) const;
+
+    BytecodeModule module;
+    std::unordered_map<std::string, size_t> functionIndices;
+    size_t currentFunction = 0;
+    std::vector<std::unordered_map<std::string, uint16_t>> scopes;
+    /// The first register that isn't used by a variable or by a temporary value.
+    size_t nextRegister = 0;
+    std::vector<size_t> scopeStartRegisters;
+    /// The arrays declared in each scope of `scopes`.
+    std::vector<std::unordered_map<std::string, BytecodeArray>> arrayScopes;
+    /// The first slot of the arrays of the frame that isn't used by the arrays of the scopes.
+    size_t nextArraySlot = 0;
+    std::vector<size_t> scopeStartArraySlots;
+    bool checkBounds;
+    /// The accesses to the elements whose index doesn't need to be checked, in the function being compiled.
+    std::optional<BoundsCheckElimination> boundsCheckElimination;
+    bool evaluatePureCalls;
+    size_t maxEvaluationSteps;
+    size_t maxEvaluationDepth;
+    /// The results of the calls of the program computed while compiling, if the pure calls are evaluated.
+    std::optional<CompileTimeEvaluation> compileTimeEvaluation;
+    /// If true the function being compiled has arrays in its frame, that the arguments of a tail call could point to.
+    bool hasStackArrays = false;
+    std::vector<std::string> errors;
+};
\ No newline at end of file
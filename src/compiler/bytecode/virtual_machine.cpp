@@ -0,0 +1,319 @@
+#include "virtual_machine.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+
+#include "../generation/special/intrinsic.hpp"
+#include "../generation/special/consts.hpp"
+
+#if defined(__GNUC__)
+#define USE_COMPUTED_GOTO
+#endif
+
+// The initial number of registers of the stack, that grows when a call needs more
+const size_t INITIAL_STACK_SIZE = 1 << 16;
+// The maximum depth of the calls, to stop the infinite recursions before they use all the memory
+const size_t MAX_CALL_DEPTH = 1 << 20;
+// The number of 8 bytes slots for the elements of the arrays of all the frames (8 MiB, like the stack of a native program).
+// It can't grow, because the program keeps the addresses of the elements
+const size_t ARRAYS_STACK_SIZE = 1 << 20;
+
+/**
+ * @brief Structure representing where a call goes back to when the callee returns.
+ */
+struct CallFrame
+{
+    const Instruction* returnAddress;
+    size_t base;
+    /// The first slot of the arrays of the caller.
+    size_t arraysBase;
+    uint16_t resultRegister;
+};
+
+// Like in the native code, the length of a string is in the 8 bytes before its characters
+static long long& lengthOf(long long string)
+{
+    return reinterpret_cast<long long*>(string)[-1];
+}
+
+static long long allocate(long long size)
+{
+    if(size < 0)
+        return 0;
+    auto memory = static_cast<long long*>(std::calloc(1, sizeof(long long) + std::max(size, 1LL)));
+    return memory == nullptr ? 0 : reinterpret_cast<long long>(memory + 1);
+}
+
+// The standard output of C is already buffered, and line buffered when it's a terminal, like the runtime of the native code,
+// and the allocator of C already reuses the small blocks
+static long long callIntrinsic(IntrinsicType type, const long long* arguments)
+{
+    switch(type)
+    {
+        case IntrinsicType::Print:
+        {
+            const char* text = reinterpret_cast<const char*>(arguments[0]);
+            std::fputs(text, stdout);
+            return static_cast<long long>(std::strlen(text));
+        }
+        case IntrinsicType::Read:
+        {
+            char* buffer = reinterpret_cast<char*>(arguments[0]);
+            if(arguments[1] <= 0)
+                return 0;
+            // The user must see what the program printed before it waits for the input
+            std::fflush(stdout);
+            if(std::fgets(buffer, static_cast<int>(std::min(arguments[1], static_cast<long long>(INT32_MAX))), stdin) == nullptr)
+                buffer[0] = '\0';
+            return lengthOf(arguments[0]) = static_cast<long long>(std::strlen(buffer));
+        }
+        case IntrinsicType::Alloc:
+            return allocate(arguments[0]);
+        case IntrinsicType::Free:
+            if(arguments[0] != 0)
+                std::free(reinterpret_cast<long long*>(arguments[0]) - 1);
+            return 0;
+        case IntrinsicType::Length:
+            return lengthOf(arguments[0]);
+        case IntrinsicType::Slice:
+        {
+            long long end = std::clamp(arguments[2], 0LL, lengthOf(arguments[0]));
+            long long start = std::clamp(arguments[1], 0LL, end);
+            long long slice = allocate(end - start + 1);
+            if(slice == 0)
+                return 0;
+            std::memcpy(reinterpret_cast<char*>(slice), reinterpret_cast<const char*>(arguments[0]) + start, end - start);
+            lengthOf(slice) = end - start;
+            return slice;
+        }
+        case IntrinsicType::Concat:
+        {
+            long long firstLength = lengthOf(arguments[0]);
+            long long secondLength = lengthOf(arguments[1]);
+            long long result = allocate(firstLength + secondLength + 1);
+            if(result == 0)
+                return 0;
+            std::memcpy(reinterpret_cast<char*>(result), reinterpret_cast<const char*>(arguments[0]), firstLength);
+            std::memcpy(reinterpret_cast<char*>(result) + firstLength, reinterpret_cast<const char*>(arguments[1]), secondLength);
+            lengthOf(result) = firstLength + secondLength;
+            return result;
+        }
+        case IntrinsicType::Memcopy:
+            if(arguments[2] > 0)
+                std::memcpy(reinterpret_cast<char*>(arguments[0]), reinterpret_cast<const char*>(arguments[1]), arguments[2]);
+            return arguments[0];
+        case IntrinsicType::Memfill:
+            if(arguments[2] > 0)
+                std::memset(reinterpret_cast<char*>(arguments[0]), static_cast<int>(arguments[1] & 0xFF), arguments[2]);
+            return arguments[0];
+        case IntrinsicType::Memcompare:
+        {
+            // The difference between the first different bytes, like the native code, and not only its sign like `memcmp`
+            const auto first = reinterpret_cast<const unsigned char*>(arguments[0]);
+            const auto second = reinterpret_cast<const unsigned char*>(arguments[1]);
+            for(long long i = 0; i < arguments[2]; i++)
+            {
+                if(first[i] != second[i])
+                    return static_cast<long long>(first[i]) - second[i];
+            }
+            return 0;
+        }
+        case IntrinsicType::Strlength:
+            return static_cast<long long>(std::strlen(reinterpret_cast<const char*>(arguments[0])));
+    }
+    return 0;
+}
+
+std::optional<long long> VirtualMachine::run(const BytecodeModule& module)
+{
+    // The registers of all the frames: the frame of a callee starts at the register that contains its first argument
+    std::vector<long long> stack(std::max(INITIAL_STACK_SIZE, module.functions[0].registersCount));
+    std::vector<CallFrame> callStack;
+    size_t base = 0;
+    long long* registers = stack.data();
+    const Instruction* pc = module.functions[0].code.data();
+    const Instruction* instruction = nullptr;
+    // The elements of the arrays of each frame are after the ones of its caller, and they are set to 0 by AllocateArray
+    std::unique_ptr<long long[]> arraysStack(new long long[ARRAYS_STACK_SIZE]);
+    size_t arraysBase = 0;
+    size_t arraysEnd = module.functions[0].arraySlotsCount;
+    if(arraysEnd > ARRAYS_STACK_SIZE)
+    {
+        std::cerr << "Stack overflow in the function `" << module.functions[0].name << "`" << std::endl;
+        return std::nullopt;
+    }
+
+    // The string literals with their length before their characters, like in the native code
+    std::vector<std::vector<long long>> literals;
+    std::vector<long long> literalAddresses;
+    for(const std::string& string : module.strings)
+    {
+        std::vector<long long>& literal = literals.emplace_back(1 + (string.size() + sizeof(long long)) / sizeof(long long), 0);
+        literal[0] = static_cast<long long>(string.size());
+        std::memcpy(literal.data() + 1, string.data(), string.size());
+        literalAddresses.push_back(reinterpret_cast<long long>(literal.data() + 1));
+    }
+
+#define A registers[instruction->a]
+#define B registers[instruction->b]
+#define C registers[instruction->c]
+#define JUMP_IF(condition) if(condition) pc += instruction->immediate
+
+#ifdef USE_COMPUTED_GOTO
+    // Each instruction jumps directly to the next one, so that each of them has its own indirect branch to predict
+    static void* const dispatchTable[] = {
+        &&LoadImmediate, &&LoadConstant, &&LoadString, &&Move,
+        &&Add, &&AddImmediate, &&Sub, &&Mul, &&Div, &&LessThan, &&GreaterThan, &&EqualTo, &&NotEqualTo,
+        &&AllocateArray, &&CheckIndex, &&LoadInt, &&LoadByte, &&StoreInt, &&StoreByte,
+        &&Jump, &&JumpIfZero, &&JumpIfNotZero, &&JumpIfLess, &&JumpIfGreaterOrEqual, &&JumpIfGreater, &&JumpIfLessOrEqual, &&JumpIfEqual, &&JumpIfNotEqual,
+        &&Call, &&TailCall, &&CallIntrinsic, &&Return, &&Exit
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<size_t>(OpCode::Count));
+
+#define INSTRUCTION(name) name:
+#define NEXT() instruction = pc++; goto *dispatchTable[static_cast<size_t>(instruction->opcode)]
+
+    NEXT();
+#else
+#define INSTRUCTION(name) case OpCode::name:
+#define NEXT() goto dispatch
+
+dispatch:
+    instruction = pc++;
+    switch(instruction->opcode)
+#endif
+    {
+        INSTRUCTION(LoadImmediate) A = instruction->immediate; NEXT();
+        INSTRUCTION(LoadConstant) A = module.constants[instruction->immediate]; NEXT();
+        INSTRUCTION(LoadString) A = literalAddresses[instruction->immediate]; NEXT();
+        INSTRUCTION(Move) A = B; NEXT();
+
+        INSTRUCTION(Add) A = B + C; NEXT();
+        INSTRUCTION(AddImmediate) A = B + instruction->immediate; NEXT();
+        INSTRUCTION(Sub) A = B - C; NEXT();
+        INSTRUCTION(Mul) A = B * C; NEXT();
+        INSTRUCTION(Div)
+        {
+            if(C == 0)
+            {
+                std::cerr << "Division by zero" << std::endl;
+                return std::nullopt;
+            }
+            A = static_cast<long long>(static_cast<unsigned long long>(B) / static_cast<unsigned long long>(C));
+            NEXT();
+        }
+        INSTRUCTION(LessThan) A = B < C; NEXT();
+        INSTRUCTION(GreaterThan) A = B > C; NEXT();
+        INSTRUCTION(EqualTo) A = B == C; NEXT();
+        INSTRUCTION(NotEqualTo) A = B != C; NEXT();
+
+        INSTRUCTION(AllocateArray)
+        {
+            long long* elements = arraysStack.get() + arraysBase + instruction->immediate;
+            std::memset(elements, 0, A);
+            A = reinterpret_cast<long long>(elements);
+            NEXT();
+        }
+        INSTRUCTION(CheckIndex)
+        {
+            // A negative index is a huge unsigned number, like in the native code
+            if(static_cast<unsigned long long>(A) >= static_cast<unsigned long long>(instruction->immediate))
+            {
+                std::fflush(stdout);
+                std::cerr << "Index out of bounds" << std::endl;
+                return INDEX_OUT_OF_BOUNDS_EXIT_CODE;
+            }
+            NEXT();
+        }
+        INSTRUCTION(LoadInt) A = reinterpret_cast<const long long*>(B)[C]; NEXT();
+        INSTRUCTION(LoadByte) A = reinterpret_cast<const unsigned char*>(B)[C]; NEXT();
+        INSTRUCTION(StoreInt) reinterpret_cast<long long*>(A)[B] = C; NEXT();
+        INSTRUCTION(StoreByte) reinterpret_cast<unsigned char*>(A)[B] = static_cast<unsigned char>(C); NEXT();
+
+        INSTRUCTION(Jump) pc += instruction->immediate; NEXT();
+        INSTRUCTION(JumpIfZero) JUMP_IF(A == 0); NEXT();
+        INSTRUCTION(JumpIfNotZero) JUMP_IF(A != 0); NEXT();
+        INSTRUCTION(JumpIfLess) JUMP_IF(B < C); NEXT();
+        INSTRUCTION(JumpIfGreaterOrEqual) JUMP_IF(B >= C); NEXT();
+        INSTRUCTION(JumpIfGreater) JUMP_IF(B > C); NEXT();
+        INSTRUCTION(JumpIfLessOrEqual) JUMP_IF(B <= C); NEXT();
+        INSTRUCTION(JumpIfEqual) JUMP_IF(B == C); NEXT();
+        INSTRUCTION(JumpIfNotEqual) JUMP_IF(B != C); NEXT();
+
+        INSTRUCTION(Call)
+        {
+            const BytecodeFunction& callee = module.functions[instruction->immediate];
+            if(callStack.size() >= MAX_CALL_DEPTH)
+            {
+                std::cerr << "Stack overflow in the function `" << callee.name << "`" << std::endl;
+                return std::nullopt;
+            }
+            if(arraysEnd + callee.arraySlotsCount > ARRAYS_STACK_SIZE)
+            {
+                std::cerr << "Stack overflow in the function `" << callee.name << "`" << std::endl;
+                return std::nullopt;
+            }
+            callStack.push_back(CallFrame { .returnAddress = pc, .base = base, .arraysBase = arraysBase, .resultRegister = instruction->a });
+            arraysBase = arraysEnd;
+            arraysEnd += callee.arraySlotsCount;
+            base += instruction->b;
+            if(base + callee.registersCount > stack.size())
+                stack.resize(std::max(stack.size() * 2, base + callee.registersCount));
+            registers = stack.data() + base;
+            pc = callee.code.data();
+            NEXT();
+        }
+        INSTRUCTION(TailCall)
+        {
+            // The recursion in tail position doesn't grow the call stack, like in the native code
+            const BytecodeFunction& callee = module.functions[instruction->immediate];
+            std::copy(registers + instruction->b, registers + instruction->b + callee.parametersCount, registers);
+            if(arraysBase + callee.arraySlotsCount > ARRAYS_STACK_SIZE)
+            {
+                std::cerr << "Stack overflow in the function `" << callee.name << "`" << std::endl;
+                return std::nullopt;
+            }
+            arraysEnd = arraysBase + callee.arraySlotsCount;
+            if(base + callee.registersCount > stack.size())
+            {
+                stack.resize(std::max(stack.size() * 2, base + callee.registersCount));
+                registers = stack.data() + base;
+            }
+            pc = callee.code.data();
+            NEXT();
+        }
+        INSTRUCTION(CallIntrinsic) A = callIntrinsic(static_cast<IntrinsicType>(instruction->immediate), registers + instruction->b); NEXT();
+        INSTRUCTION(Return)
+        {
+            long long value = A;
+            CallFrame frame = callStack.back();
+            callStack.pop_back();
+            pc = frame.returnAddress;
+            base = frame.base;
+            arraysEnd = arraysBase;
+            arraysBase = frame.arraysBase;
+            registers = stack.data() + base;
+            registers[frame.resultRegister] = value;
+            NEXT();
+        }
+        INSTRUCTION(Exit) return A;
+
+#ifndef USE_COMPUTED_GOTO
+        case OpCode::Count: break;
+#endif
+    }
+
+#undef A
+#undef B
+#undef C
+#undef JUMP_IF
+#undef INSTRUCTION
+#undef NEXT
+
+    return std::nullopt;
+}
\ No newline at end of file
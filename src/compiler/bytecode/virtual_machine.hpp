@@ -0,0 +1,21 @@
+#pragma once
+
+#include <optional>
+
+#include "bytecode.hpp"
+
+/**
+ * @brief Class responsible for running the programs compiled to bytecode, without generating native code.
+ *
+ * The instructions are dispatched with computed gotos when the compiler supports them (GCC and Clang), and with a switch otherwise.
+ */
+class VirtualMachine
+{
+public:
+    /**
+     * @brief Run a program until it exits.
+     * @param module The compiled program.
+     * @return The exit code of the program, or std::nullopt if it has been stopped by an error (the error is printed).
+     */
+    std::optional<long long> run(const BytecodeModule& module);
+};
\ No newline at end of file
@@ -0,0 +1,820 @@
+#include "c_generator.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <regex>
+#include <limits>
+#include <unordered_set>
+#include <algorithm>
+#include <cctype>
+
+#include "../token/tokenizer.hpp"
+#include "../generation/generation_data.hpp"
+#include "../generation/special/consts.hpp"
+#include "../generation/asm_macro.hpp"
+#include "../optimizer/ast.hpp"
+
+const std::string INDENTATION = "    ";
+
+// The arithmetic of the native code wraps around, while the overflow of the signed integers of C is undefined
+const std::string RUNTIME_HELPERS =
+    "static inline int64_t wrapping_add(int64_t a, int64_t b) { return (int64_t)((uint64_t)a + (uint64_t)b); }\n"
+    "static inline int64_t wrapping_sub(int64_t a, int64_t b) { return (int64_t)((uint64_t)a - (uint64_t)b); }\n"
+    "static inline int64_t wrapping_mul(int64_t a, int64_t b) { return (int64_t)((uint64_t)a * (uint64_t)b); }\n"
+    "static inline int64_t unsigned_div(int64_t a, int64_t b) { return (int64_t)((uint64_t)a / (uint64_t)b); }\n";
+
+// Like in the native code, a negative index is a huge unsigned number; the output written before the error is kept
+const std::string CHECK_INDEX_HELPER =
+    "static inline int64_t runtime_check_index(int64_t index, int64_t length)\n"
+    "{\n"
+    "    if((uint64_t)index >= (uint64_t)length)\n"
+    "    {\n"
+    "        fflush(stdout);\n"
+    "        fputs(\"Index out of bounds\\n\", stderr);\n"
+    "        exit(" + std::to_string(INDEX_OUT_OF_BOUNDS_EXIT_CODE) + ");\n"
+    "    }\n"
+    "    return index;\n"
+    "}\n";
+
+// The intrinsics, defined only when the program calls them: the standard output and the allocator of C already work like the native ones.
+// The strings keep their length before their characters, like in the native code
+const std::unordered_map<IntrinsicType, CFunction> INTRINSIC_FUNCTIONS = {
+    { IntrinsicType::Print, CFunction { .name = "runtime_print", .returnType = CType::Int, .parameterTypes = { CType::String } } },
+    { IntrinsicType::Read, CFunction { .name = "runtime_read", .returnType = CType::Int, .parameterTypes = { CType::String, CType::Int } } },
+    { IntrinsicType::Alloc, CFunction { .name = "runtime_alloc", .returnType = CType::String, .parameterTypes = { CType::Int } } },
+    { IntrinsicType::Free, CFunction { .name = "runtime_free", .returnType = CType::Int, .parameterTypes = { CType::String } } },
+    { IntrinsicType::Length, CFunction { .name = "runtime_length", .returnType = CType::Int, .parameterTypes = { CType::String } } },
+    { IntrinsicType::Slice, CFunction { .name = "runtime_slice", .returnType = CType::String, .parameterTypes = { CType::String, CType::Int, CType::Int } } },
+    { IntrinsicType::Concat, CFunction { .name = "runtime_concat", .returnType = CType::String, .parameterTypes = { CType::String, CType::String } } },
+    { IntrinsicType::Memcopy, CFunction { .name = "runtime_memcopy", .returnType = CType::String, .parameterTypes = { CType::String, CType::String, CType::Int } } },
+    { IntrinsicType::Memfill, CFunction { .name = "runtime_memfill", .returnType = CType::String, .parameterTypes = { CType::String, CType::Int, CType::Int } } },
+    { IntrinsicType::Memcompare, CFunction { .name = "runtime_memcompare", .returnType = CType::Int, .parameterTypes = { CType::String, CType::String, CType::Int } } },
+    { IntrinsicType::Strlength, CFunction { .name = "runtime_strlength", .returnType = CType::Int, .parameterTypes = { CType::String } } }
+};
+// The intrinsics whose definition uses other intrinsics
+const std::unordered_map<IntrinsicType, std::vector<IntrinsicType>> INTRINSIC_DEPENDENCIES = {
+    { IntrinsicType::Slice, { IntrinsicType::Alloc, IntrinsicType::Length } },
+    { IntrinsicType::Concat, { IntrinsicType::Alloc, IntrinsicType::Length } }
+};
+const std::unordered_map<IntrinsicType, std::string> INTRINSIC_DEFINITIONS = {
+    { IntrinsicType::Print, "static int64_t runtime_print(char* text) { fputs(text, stdout); return (int64_t)strlen(text); }\n" },
+    { IntrinsicType::Read,
+        "static int64_t runtime_read(char* buffer, int64_t size)\n"
+        "{\n"
+        "    if(size <= 0)\n"
+        "        return 0;\n"
+        "    fflush(stdout);\n"
+        "    if(fgets(buffer, size > INT_MAX ? INT_MAX : (int)size, stdin) == NULL)\n"
+        "        buffer[0] = '\\0';\n"
+        "    ((int64_t*)buffer)[-1] = (int64_t)strlen(buffer);\n"
+        "    return ((int64_t*)buffer)[-1];\n"
+        "}\n" },
+    { IntrinsicType::Alloc,
+        "static char* runtime_alloc(int64_t size)\n"
+        "{\n"
+        "    int64_t* memory = size < 0 ? NULL : (int64_t*)calloc(1, sizeof(int64_t) + (size > 0 ? (size_t)size : 1));\n"
+        "    return memory == NULL ? NULL : (char*)(memory + 1);\n"
+        "}\n" },
+    { IntrinsicType::Free, "static int64_t runtime_free(char* memory) { if(memory != NULL) free((int64_t*)memory - 1); return 0; }\n" },
+    { IntrinsicType::Length, "static int64_t runtime_length(char* text) { return ((int64_t*)text)[-1]; }\n" },
+    { IntrinsicType::Slice,
+        "static char* runtime_slice(char* text, int64_t start, int64_t end)\n"
+        "{\n"
+        "    int64_t length = runtime_length(text);\n"
+        "    end = end > length ? length : end < 0 ? 0 : end;\n"
+        "    start = start < 0 ? 0 : start > end ? end : start;\n"
+        "    char* slice = runtime_alloc(end - start + 1);\n"
+        "    if(slice == NULL)\n"
+        "        return NULL;\n"
+        "    memcpy(slice, text + start, (size_t)(end - start));\n"
+        "    ((int64_t*)slice)[-1] = end - start;\n"
+        "    return slice;\n"
+        "}\n" },
+    { IntrinsicType::Concat,
+        "static char* runtime_concat(char* first, char* second)\n"
+        "{\n"
+        "    int64_t firstLength = runtime_length(first), secondLength = runtime_length(second);\n"
+        "    char* result = runtime_alloc(firstLength + secondLength + 1);\n"
+        "    if(result == NULL)\n"
+        "        return NULL;\n"
+        "    memcpy(result, first, (size_t)firstLength);\n"
+        "    memcpy(result + firstLength, second, (size_t)secondLength);\n"
+        "    ((int64_t*)result)[-1] = firstLength + secondLength;\n"
+        "    return result;\n"
+        "}\n" },
+    { IntrinsicType::Memcopy, "static char* runtime_memcopy(char* destination, char* source, int64_t size) { if(size > 0) memcpy(destination, source, (size_t)size); return destination; }\n" },
+    { IntrinsicType::Memfill, "static char* runtime_memfill(char* destination, int64_t value, int64_t size) { if(size > 0) memset(destination, (int)(value & 0xFF), (size_t)size); return destination; }\n" },
+    { IntrinsicType::Memcompare,
+        "static int64_t runtime_memcompare(char* first, char* second, int64_t size)\n"
+        "{\n"
+        "    for(int64_t i = 0; i < size; i++)\n"
+        "    {\n"
+        "        if(first[i] != second[i])\n"
+        "            return (int64_t)(unsigned char)first[i] - (unsigned char)second[i];\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n" },
+    { IntrinsicType::Strlength, "static int64_t runtime_strlength(char* text) { return (int64_t)strlen(text); }\n" }
+};
+
+// The names of the program that can't be used in C, because they are keywords or they are already used by the translation
+const std::unordered_set<std::string> RESERVED_NAMES = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum", "extern", "float", "for", "goto",
+    "if", "inline", "int", "long", "register", "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+    "typedef", "union", "unsigned", "void", "volatile", "while", "_Bool", "_Complex", "_Imaginary",
+    "main", "wrapping_add", "wrapping_sub", "wrapping_mul", "unsigned_div", "int64_t", "uint64_t", "INT64_C", "UINT64_C",
+    "runtime_print", "runtime_read", "runtime_alloc", "runtime_free", "runtime_length", "runtime_slice", "runtime_concat",
+    "runtime_memcopy", "runtime_memfill", "runtime_memcompare", "runtime_strlength", "runtime_check_index", "uint8_t",
+    "stdin", "stdout", "stderr", "exit", "fputs", "fflush", "fgets", "strlen", "memcpy", "memset", "calloc", "free", "size_t", "NULL", "INT_MAX"
+};
+
+// The registers that the `asm!` code may change: every one except the stack pointer and the frame pointer
+const std::string ASM_CLOBBERS =
+    "\"rax\", \"rbx\", \"rcx\", \"rdx\", \"rsi\", \"rdi\", \"r8\", \"r9\", \"r10\", \"r11\", \"r12\", \"r13\", \"r14\", \"r15\", \"cc\", \"memory\"";
+
+// The GCC constraints of the registers that the operands of the `asm!` code can use
+const std::unordered_map<std::string, std::string> REGISTER_CONSTRAINTS = {
+    { "r", "r" }, { "rax", "a" }, { "rbx", "b" }, { "rcx", "c" }, { "rdx", "d" }, { "rsi", "S" }, { "rdi", "D" }
+};
+
+// The symbols defined by the native code, that don't exist in the C translation
+const std::unordered_set<std::string> NATIVE_SYMBOLS = {
+    "stdout", "stdin", "bytesWritten", "heapHandle",
+    "ExitProcess", "GetStdHandle", "WriteFile", "ReadFile", "GetConsoleMode", "GetProcessHeap", "HeapAlloc", "HeapFree", "VirtualAlloc", "VirtualFree"
+};
+
+const std::unordered_set<std::string> STACK_REGISTERS = { "rsp", "esp", "sp", "spl", "rbp", "ebp", "bp", "bpl" };
+const std::unordered_set<std::string> CONTROL_FLOW_INSTRUCTIONS = { "call", "ret", "push", "pop", "enter", "leave", "syscall", "int", "loop" };
+const std::unordered_set<std::string> NASM_DIRECTIVES = { "db", "dw", "dd", "dq", "times", "section", "global", "extern", "default", "align" };
+
+static std::string cName(const std::string& name)
+{
+    return RESERVED_NAMES.contains(name) ? name + "_" : name;
+}
+
+static std::string cTypeName(CType type)
+{
+    return type == CType::String ? "char*" : "int64_t";
+}
+
+static CType typeOf(const ExpressionIdentNode* type)
+{
+    return type->ident.type == TokenType::KeywordString ? CType::String : CType::Int;
+}
+
+// The arrays are the address of their elements
+static CType typeOf(const StatementDeclareVariableNode* declaration)
+{
+    return declaration->arrayLength.has_value() ? CType::String : typeOf(declaration->type);
+}
+
+static std::string convert(const CExpression& expression, CType type)
+{
+    if(expression.type == type)
+        return expression.code;
+    return "(" + cTypeName(type) + ")" + expression.code;
+}
+
+// Remove the brackets around the whole code, if there are
+static std::string withoutBrackets(const std::string& code)
+{
+    if(code.size() < 2 || code.front() != '(' || code.back() != ')')
+        return code;
+    int depth = 0;
+    for(size_t i = 0; i < code.size() - 1; i++)
+    {
+        if(code[i] == '(')
+            depth++;
+        else if(code[i] == ')')
+            depth--;
+        if(depth == 0)
+            return code;
+    }
+    return code.substr(1, code.size() - 2);
+}
+
+// Write the characters as a C string literal
+static std::string escapeString(const std::string& bytes)
+{
+    std::ostringstream literal;
+    literal << "\"";
+    for(unsigned char character : bytes)
+    {
+        switch(character)
+        {
+            case '\n': literal << "\\n"; break;
+            case '\t': literal << "\\t"; break;
+            case '\r': literal << "\\r"; break;
+            case '"': literal << "\\\""; break;
+            case '\\': literal << "\\\\"; break;
+            default:
+                if(character < 0x20 || character >= 0x7F)
+                {
+                    // Always 3 digits, so that the next character can't be read as part of the escape sequence
+                    literal << "\\" << static_cast<char>('0' + (character >> 6)) << static_cast<char>('0' + ((character >> 3) & 7)) << static_cast<char>('0' + (character & 7));
+                }
+                else
+                    literal << character;
+        }
+    }
+    literal << "\"";
+    return literal.str();
+}
+
+// Get why a line of `asm!` code can't be translated to GCC extended asm, or std::nullopt if it can
+static std::optional<std::string> findUntranslatableAsm(const std::string& line, const std::unordered_map<std::string, CFunction>& functions)
+{
+    if(line.find(':') != std::string::npos)
+        return "it defines a label";
+
+    std::vector<std::string> words;
+    const std::regex wordPattern("[A-Za-z_.][A-Za-z0-9_.]*");
+    for(auto word = std::sregex_iterator(line.begin(), line.end(), wordPattern); word != std::sregex_iterator(); word++)
+        words.push_back(word->str());
+    if(words.empty())
+        return std::nullopt;
+
+    std::string mnemonic = words.front();
+    std::transform(mnemonic.begin(), mnemonic.end(), mnemonic.begin(), ::tolower);
+    if(mnemonic.front() == 'j' || CONTROL_FLOW_INSTRUCTIONS.contains(mnemonic))
+        return "it changes the control flow or the stack with `" + mnemonic + "`";
+    if(NASM_DIRECTIVES.contains(mnemonic))
+        return "it uses the NASM directive `" + mnemonic + "`";
+
+    for(const std::string& word : words)
+    {
+        std::string lowercaseWord = word;
+        std::transform(lowercaseWord.begin(), lowercaseWord.end(), lowercaseWord.begin(), ::tolower);
+        if(STACK_REGISTERS.contains(lowercaseWord))
+            return "it accesses the stack frame through `" + word + "`, and the C compiler decides the layout of the frame";
+        if(lowercaseWord == "rel")
+            return "it uses a symbol of the native code";
+        if(NATIVE_SYMBOLS.contains(word) || functions.contains(word))
+            return "it uses the symbol `" + word + "` of the native code";
+    }
+    return std::nullopt;
+}
+
+// Translate a line of NASM code to the Intel syntax of GAS, as a string of GCC extended asm
+static std::string translateAsmLine(const std::string& line)
+{
+    static const std::regex sizePattern("\\b(byte|word|dword|qword)\\s*\\[", std::regex::icase);
+    std::string gasLine = std::regex_replace(line, sizePattern, "$1 PTR [");
+
+    std::string escaped;
+    for(char character : gasLine)
+    {
+        if(character == '"' || character == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(character);
+    }
+    return "\"" + escaped + "\\n\\t\"";
+}
+
+CGenerator::CGenerator(bool checkBounds) : checkBounds(checkBounds) {}
+
+std::optional<std::string> CGenerator::generate(const ProgramNode& program)
+{
+    functions.clear();
+    usedIntrinsics.clear();
+    stringLiterals.clear();
+    errors.clear();
+    code.clear();
+    usesBoundsChecks = false;
+
+    // The functions can be called before their definition, so they are all declared before the code
+    std::vector<const StatementFunctionDefinitionNode*> definitions;
+    for(const StatementNode* statement : program.nodes)
+    {
+        if(!std::holds_alternative<StatementFunctionDefinitionNode*>(statement->variant))
+            continue;
+        auto definition = std::get<StatementFunctionDefinitionNode*>(statement->variant);
+        const std::string& name = definition->functionName->ident.value.value();
+        if(functions.contains(name))
+        {
+            errors.push_back("The function `" + name + "` is defined more than once!");
+            continue;
+        }
+        CFunction function { .name = cName(name), .returnType = typeOf(definition->returnType) };
+        for(const StatementDeclareVariableNode* parameter : definition->parameters)
+            function.parameterTypes.push_back(typeOf(parameter));
+        functions[name] = function;
+        definitions.push_back(definition);
+    }
+
+    for(const StatementFunctionDefinitionNode* definition : definitions)
+        generateFunction(definition);
+
+    currentReturnType = std::nullopt;
+    if(checkBounds)
+        boundsCheckElimination.emplace(program.nodes);
+    emitLine("int main(void)");
+    emitLine("{");
+    indentation++;
+    enterScope();
+    generateStatements(program.nodes);
+    if(!std::holds_alternative<StatementReturnNode*>(program.nodes.back()->variant))
+        emitLine("return 0;");
+    exitScope();
+    indentation--;
+    emitLine("}");
+
+    for(const std::string& error : errors)
+        std::cerr << error << std::endl;
+    if(!errors.empty())
+        return std::nullopt;
+
+    std::ostringstream source;
+    source << "#include <stdint.h>\n";
+    if(!usedIntrinsics.empty() || usesBoundsChecks)
+        source << "#include <stdio.h>\n#include <stdlib.h>\n#include <string.h>\n#include <limits.h>\n";
+    source << "\n" << RUNTIME_HELPERS;
+    if(usesBoundsChecks)
+        source << CHECK_INDEX_HELPER;
+    for(const Intrinsic& intrinsic : INTRINSICS)
+    {
+        if(usedIntrinsics.contains(intrinsic.type))
+            source << INTRINSIC_DEFINITIONS.at(intrinsic.type);
+    }
+    if(!stringLiterals.empty())
+        source << "\n";
+    for(size_t i = 0; i < stringLiterals.size(); i++)
+    {
+        // Like in the native code, the length of a string is before its characters, and the literals are read-only
+        std::string characters = decodeStringLiteral(stringLiterals[i]);
+        source << "static const struct { int64_t length; char characters[" << characters.size() + 1 << "]; } strLit" << i
+            << " = { " << characters.size() << ", " << escapeString(characters) << " };\n";
+    }
+    source << "\n";
+    for(const StatementFunctionDefinitionNode* definition : definitions)
+    {
+        const CFunction& function = functions[definition->functionName->ident.value.value()];
+        source << "static " << cTypeName(function.returnType) << " " << function.name << "(";
+        for(size_t i = 0; i < function.parameterTypes.size(); i++)
+            source << (i > 0 ? ", " : "") << cTypeName(function.parameterTypes[i]);
+        source << (function.parameterTypes.empty() ? "void" : "") << ");\n";
+    }
+    source << "\n" << code;
+    return source.str();
+}
+
+void CGenerator::generateFunction(const StatementFunctionDefinitionNode* definition)
+{
+    const CFunction& function = functions[definition->functionName->ident.value.value()];
+    currentReturnType = function.returnType;
+    scopes.clear();
+    arrayScopes.clear();
+    enterScope();
+    boundsCheckElimination.reset();
+    if(checkBounds)
+        boundsCheckElimination.emplace(definition->implementation->statements);
+
+    std::string parameters;
+    for(const StatementDeclareVariableNode* parameter : definition->parameters)
+    {
+        const std::string& name = parameter->name->ident.value.value();
+        scopes.back()[name] = typeOf(parameter);
+        if(parameter->arrayLength.has_value())
+            arrayScopes.back()[name] = CArray { .declaration = parameter, .hasElementsOnStack = false };
+        parameters += (parameters.empty() ? "" : ", ") + cTypeName(typeOf(parameter)) + " " + cName(name);
+    }
+    emitLine("static " + cTypeName(function.returnType) + " " + function.name + "(" + (parameters.empty() ? "void" : parameters) + ")");
+    emitLine("{");
+    indentation++;
+    const std::vector<StatementNode*>& statements = definition->implementation->statements;
+    generateStatements(statements);
+    // Reaching the end of a function returns 0
+    if(statements.empty() || !std::holds_alternative<StatementReturnNode*>(statements.back()->variant))
+        emitLine("return 0;");
+    indentation--;
+    emitLine("}");
+    emitLine("");
+    exitScope();
+}
+
+void CGenerator::generateStatements(const std::vector<StatementNode*>& statements)
+{
+    for(size_t i = 0; i < statements.size(); )
+        i += generateStatementInList(statements, i);
+}
+
+size_t CGenerator::generateStatementInList(const std::vector<StatementNode*>& statements, size_t index)
+{
+    // `int x; x = value;` becomes `int64_t x = value;`, unless the value reads the variable before it's initialized.
+    // An array declared this way gets the address of its elements from the value
+    const StatementNode* statement = statements[index];
+    if(const StatementAssignVariableNode* assignment = ast::initializationOf(statements, index))
+    {
+        auto declaration = std::get<StatementDeclareVariableNode*>(statement->variant);
+        const std::string& name = declaration->name->ident.value.value();
+        if(!scopes.back().contains(name))
+        {
+            CType type = typeOf(declaration);
+            CExpression value = generateExpression(assignment->value);
+            scopes.back()[name] = type;
+            if(declaration->arrayLength.has_value())
+                arrayScopes.back()[name] = CArray { .declaration = declaration, .hasElementsOnStack = false };
+            emitLine(cTypeName(type) + " " + cName(name) + " = " + withoutBrackets(convert(value, type)) + ";");
+            return 2;
+        }
+    }
+
+    generateStatement(statement);
+    return 1;
+}
+
+void CGenerator::generateStatement(const StatementNode* statement)
+{
+    std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, StatementReturnNode*>)
+        {
+            CExpression value = generateExpression(node->expression);
+            // The exit code of the process is the low part of the returned value, like in the native code
+            if(currentReturnType.has_value())
+                emitLine("return " + withoutBrackets(convert(value, currentReturnType.value())) + ";");
+            else
+                emitLine("return (int)" + convert(value, CType::Int) + ";");
+        }
+        else if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+        {
+            const std::string& name = node->name->ident.value.value();
+            if(scopes.back().contains(name))
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::VariableAlreadyDefined, .hint = name }));
+                return;
+            }
+            scopes.back()[name] = typeOf(node);
+            if(node->arrayLength.has_value())
+            {
+                // The elements are a compound literal, set to 0 each time the declaration is reached
+                arrayScopes.back()[name] = CArray { .declaration = node, .hasElementsOnStack = true };
+                size_t slotsCount = (node->arrayLength.value() * ast::elementSizeOf(node) + 7) / 8;
+                emitLine("char* " + cName(name) + " = (char*)(int64_t[" + std::to_string(slotsCount) + "]){ 0 };");
+            }
+            else
+                emitLine(cTypeName(typeOf(node->type)) + " " + cName(name) + " = 0;");
+        }
+        else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+        {
+            const std::string& name = node->name->ident.value.value();
+            std::optional<CType> type = findVariable(name);
+            if(!type.has_value())
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = name }));
+                return;
+            }
+            if(node->index.has_value())
+            {
+                std::optional<std::string> element = generateElement(node->name, node->index.value());
+                if(!element.has_value())
+                    return;
+                // A byte keeps the low 8 bits of the value
+                std::string elementType = ast::elementSizeOf(findArray(name)->declaration) == 1 ? "uint8_t" : "int64_t";
+                std::string value = convert(generateExpression(node->value), CType::Int);
+                value = elementType == "uint8_t" ? "(uint8_t)" + value : withoutBrackets(value);
+                // The index is checked before the value is computed, like in the native code
+                if(ast::containsFunctionCall(node->value))
+                    emitLine("{ " + elementType + "* element = &" + element.value() + "; *element = " + value + "; }");
+                else
+                    emitLine(element.value() + " = " + value + ";");
+                return;
+            }
+            if(std::optional<CArray> array = findArray(name); array.has_value() && array->hasElementsOnStack)
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::ArrayAssignment, .hint = name }));
+                return;
+            }
+            emitLine(cName(name) + " = " + withoutBrackets(convert(generateExpression(node->value), type.value())) + ";");
+        }
+        else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+            generateScope(node);
+        else if constexpr (std::is_same_v<T, StatementIfNode*>)
+        {
+            emitLine("if(" + withoutBrackets(generateExpression(node->condition).code) + ")");
+            generateScope(node->scope);
+            if(node->elseScope.has_value())
+            {
+                emitLine("else");
+                generateScope(node->elseScope.value());
+            }
+        }
+        else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+        {
+            emitLine("while(" + withoutBrackets(generateExpression(node->condition).code) + ")");
+            generateScope(node->scope);
+        }
+        else if constexpr (std::is_same_v<T, StatementFunctionDefinitionNode*>)
+        {
+            // The functions are generated on their own by `generate`, that looks for them only outside of the scopes
+            if(currentReturnType.has_value() || scopes.size() > 1)
+                errors.push_back("The function `" + node->functionName->ident.value.value() + "` must be defined outside of the other functions and scopes!");
+        }
+        else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+            emitLine(generateFunctionCall(node).code + ";");
+        else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+        {
+            if(node->macroName->ident.value.value() == "asm!")
+                generateAsmMacro(node);
+            else
+                errors.push_back("The `" + node->macroName->ident.value.value() + "` macro isn't supported by the C backend");
+        }
+    }, statement->variant);
+}
+
+void CGenerator::generateScope(const StatementScopeNode* scope)
+{
+    emitLine("{");
+    indentation++;
+    enterScope();
+    generateStatements(scope->statements);
+    exitScope();
+    indentation--;
+    emitLine("}");
+}
+
+void CGenerator::generateAsmMacro(const StatementMacroNode* macro)
+{
+    std::string error;
+    std::optional<AsmMacro> asmMacro = parseAsmMacro(macro, error);
+    if(!asmMacro.has_value())
+    {
+        errors.push_back(error);
+        return;
+    }
+
+    // A `%` of the code isn't an operand of GCC, and the operands are named by their position
+    std::string code;
+    for(char character : asmMacro->code)
+        code += character == '%' ? std::string("%%") : std::string(1, character);
+    std::string outputs;
+    std::string inputs;
+    if(hasAsmOperands(macro))
+    {
+        std::vector<std::string> operandTexts;
+        for(size_t i = 0; i < asmMacro->operands.size(); i++)
+        {
+            const AsmOperand& operand = asmMacro->operands[i];
+            auto constraint = REGISTER_CONSTRAINTS.find(operand.constraint);
+            if(constraint == REGISTER_CONSTRAINTS.end())
+            {
+                errors.push_back("The `" + operand.constraint + "` operands of the asm! macro can't be translated to C. Compile the program with the native backend instead");
+                return;
+            }
+            std::string name = "op" + std::to_string(i);
+            operandTexts.push_back("%[" + name + "]");
+            if(operand.type == AsmOperandType::Input)
+            {
+                inputs += (inputs.empty() ? "" : ", ") + std::string("[") + name + "] \"" + constraint->second + "\" (" + withoutBrackets(generateExpression(operand.value).code) + ")";
+                continue;
+            }
+
+            const std::string& variableName = operand.variableName.value();
+            if(!findVariable(variableName).has_value())
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = variableName }));
+                return;
+            }
+            if(std::optional<CArray> array = findArray(variableName); array.has_value() && array->hasElementsOnStack)
+            {
+                errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::ArrayAssignment, .hint = variableName }));
+                return;
+            }
+            // An output gets a register that isn't used by the inputs, like in the native code
+            std::string modifier = operand.type == AsmOperandType::Output ? "=&" : "+";
+            outputs += (outputs.empty() ? "" : ", ") + std::string("[") + name + "] \"" + modifier + constraint->second + "\" (" + cName(variableName) + ")";
+        }
+        asmMacro->code = code;
+        std::optional<std::string> substitutedCode = substituteAsmOperands(asmMacro.value(), operandTexts, error);
+        if(!substitutedCode.has_value())
+        {
+            errors.push_back(error);
+            return;
+        }
+        code = substitutedCode.value();
+    }
+
+    std::vector<std::string> lines;
+    std::istringstream assemblyCode(code);
+    for(std::string line; std::getline(assemblyCode, line); )
+    {
+        // The comments of NASM start with `;`, that separates the instructions in GAS
+        line = line.substr(0, line.find(';'));
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if(line.empty())
+            continue;
+
+        if(std::optional<std::string> reason = findUntranslatableAsm(line, functions); reason.has_value())
+        {
+            errors.push_back("The `asm!` code `" + line + "` can't be translated to C: " + reason.value() + ". Compile the program with the native backend instead");
+            return;
+        }
+        lines.push_back(line);
+    }
+
+    // The code without operands may change any register, the other code only the clobbered ones
+    std::string clobbers = ASM_CLOBBERS;
+    if(hasAsmOperands(macro))
+    {
+        clobbers = "\"cc\"";
+        for(const std::string& clobberedRegister : asmMacro->clobberedRegisters)
+            clobbers += ", \"" + clobberedRegister + "\"";
+        if(asmMacro->clobbersMemory)
+            clobbers += ", \"memory\"";
+    }
+
+    emitLine("__asm__ volatile(");
+    indentation++;
+    emitLine("\".intel_syntax noprefix\\n\\t\"");
+    for(const std::string& line : lines)
+        emitLine(translateAsmLine(line));
+    emitLine("\".att_syntax prefix\"");
+    emitLine(":" + (outputs.empty() ? "" : " " + outputs) + " :" + (inputs.empty() ? "" : " " + inputs) + " : " + clobbers + ");");
+    indentation--;
+}
+
+CExpression CGenerator::generateExpression(const ExpressionNode* expression)
+{
+    return std::visit([&](auto node) -> CExpression
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionAtomNode*>)
+        {
+            return std::visit([&](auto atom) -> CExpression
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                {
+                    const std::string& literal = atom->literal.value.value();
+                    if(atom->literal.type == TokenType::LiteralString)
+                        return CExpression { .code = defineStringLiteral(literal), .type = CType::String };
+
+                    unsigned long long value = std::stoull(literal);
+                    if(value <= static_cast<unsigned long long>(std::numeric_limits<int32_t>::max()))
+                        return CExpression { .code = std::to_string(value), .type = CType::Int };
+                    if(value <= static_cast<unsigned long long>(std::numeric_limits<int64_t>::max()))
+                        return CExpression { .code = "INT64_C(" + std::to_string(value) + ")", .type = CType::Int };
+                    return CExpression { .code = "(int64_t)UINT64_C(" + std::to_string(value) + ")", .type = CType::Int };
+                }
+                else if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+                {
+                    const std::string& name = atom->ident.value.value();
+                    std::optional<CType> type = findVariable(name);
+                    if(!type.has_value())
+                    {
+                        errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = name }));
+                        return CExpression { .code = "0", .type = CType::Int };
+                    }
+                    return CExpression { .code = cName(name), .type = type.value() };
+                }
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return generateExpression(atom->expression);
+                else if constexpr (std::is_same_v<V, ExpressionIndexNode*>)
+                    return CExpression { .code = generateElement(atom->array, atom->index).value_or("0"), .type = CType::Int };
+                else
+                    return generateFunctionCall(atom);
+            }, node->variant);
+        }
+        else
+        {
+            CExpression lhs = generateExpression(node->lhs);
+            CExpression rhs = generateExpression(node->rhs);
+            std::string lhsInt = convert(lhs, CType::Int);
+            std::string rhsInt = convert(rhs, CType::Int);
+
+            switch(node->operation)
+            {
+                case Operator::Add:
+                    // Adding a number to a string moves its address, like in the native code
+                    if(lhs.type != rhs.type)
+                        return CExpression { .code = "(" + lhs.code + " + " + rhs.code + ")", .type = CType::String };
+                    return CExpression { .code = "wrapping_add(" + lhsInt + ", " + rhsInt + ")", .type = CType::Int };
+                case Operator::Sub:
+                    if(lhs.type == CType::String && rhs.type == CType::Int)
+                        return CExpression { .code = "(" + lhs.code + " - " + rhs.code + ")", .type = CType::String };
+                    return CExpression { .code = "wrapping_sub(" + lhsInt + ", " + rhsInt + ")", .type = CType::Int };
+                case Operator::Mul:
+                    return CExpression { .code = "wrapping_mul(" + lhsInt + ", " + rhsInt + ")", .type = CType::Int };
+                case Operator::Div:
+                    return CExpression { .code = "unsigned_div(" + lhsInt + ", " + rhsInt + ")", .type = CType::Int };
+                case Operator::GreaterThan:
+                    return CExpression { .code = "(" + lhsInt + " > " + rhsInt + ")", .type = CType::Int };
+                case Operator::LessThan:
+                    return CExpression { .code = "(" + lhsInt + " < " + rhsInt + ")", .type = CType::Int };
+                case Operator::EqualTo:
+                    return CExpression { .code = "(" + lhsInt + " == " + rhsInt + ")", .type = CType::Int };
+                case Operator::NotEqualTo:
+                    return CExpression { .code = "(" + lhsInt + " != " + rhsInt + ")", .type = CType::Int };
+                case Operator::And:
+                    return CExpression { .code = "(int64_t)(" + lhsInt + " && " + rhsInt + ")", .type = CType::Int };
+                case Operator::Or:
+                    return CExpression { .code = "(int64_t)(" + lhsInt + " || " + rhsInt + ")", .type = CType::Int };
+            }
+            return CExpression { .code = "0", .type = CType::Int };
+        }
+    }, expression->variant);
+}
+
+CExpression CGenerator::generateFunctionCall(const ExpressionFunctionCallNode* call)
+{
+    const std::string& name = call->functionName->ident.value.value();
+    const CFunction* function = nullptr;
+    // The functions of the program replace the intrinsics with the same name
+    if(auto definedFunction = functions.find(name); definedFunction != functions.end())
+        function = &definedFunction->second;
+    else if(std::optional<Intrinsic> intrinsic = findIntrinsic(name); intrinsic.has_value())
+    {
+        function = &INTRINSIC_FUNCTIONS.at(intrinsic->type);
+        usedIntrinsics.insert(intrinsic->type);
+        if(auto dependencies = INTRINSIC_DEPENDENCIES.find(intrinsic->type); dependencies != INTRINSIC_DEPENDENCIES.end())
+            usedIntrinsics.insert(dependencies->second.begin(), dependencies->second.end());
+    }
+    if(function == nullptr || function->parameterTypes.size() != call->arguments.size())
+    {
+        errors.push_back("The function call `" + name + "` is invalid!");
+        return CExpression { .code = "0", .type = CType::Int };
+    }
+
+    std::string arguments;
+    for(size_t i = 0; i < call->arguments.size(); i++)
+        arguments += (i > 0 ? ", " : "") + withoutBrackets(convert(generateExpression(call->arguments[i]), function->parameterTypes[i]));
+    return CExpression { .code = function->name + "(" + arguments + ")", .type = function->returnType };
+}
+
+std::optional<std::string> CGenerator::generateElement(const ExpressionIdentNode* arrayName, const ExpressionNode* index)
+{
+    const std::string& name = arrayName->ident.value.value();
+    std::optional<CArray> array = findArray(name);
+    if(!array.has_value())
+    {
+        CodeGenerationErrorType error = findVariable(name).has_value() ? CodeGenerationErrorType::NotAnArray : CodeGenerationErrorType::UndeclaredVariable;
+        errors.push_back(codeGenerationErrorToString(CodeGenerationError { .type = error, .hint = name }));
+        return std::nullopt;
+    }
+
+    size_t length = array->declaration->arrayLength.value();
+    std::string indexCode = withoutBrackets(convert(generateExpression(index), CType::Int));
+    if(checkBounds && !(boundsCheckElimination.has_value() && boundsCheckElimination->isInBounds(index, length)))
+    {
+        usesBoundsChecks = true;
+        indexCode = "runtime_check_index(" + indexCode + ", INT64_C(" + std::to_string(length) + "))";
+    }
+    std::string elementType = ast::elementSizeOf(array->declaration) == 1 ? "uint8_t" : "int64_t";
+    return "((" + elementType + "*)" + cName(name) + ")[" + indexCode + "]";
+}
+
+std::string CGenerator::defineStringLiteral(const std::string& stringLiteral)
+{
+    // Like in the native code, the same literals share their characters
+    auto literal = std::find(stringLiterals.begin(), stringLiterals.end(), stringLiteral);
+    size_t index = std::distance(stringLiterals.begin(), literal);
+    if(literal == stringLiterals.end())
+        stringLiterals.push_back(stringLiteral);
+    // A `string` is a `char*`, so the constness is cast away: writing in a literal faults like in the native code
+    return "((char*)strLit" + std::to_string(index) + ".characters)";
+}
+
+void CGenerator::emitLine(const std::string& line)
+{
+    for(size_t i = 0; i < indentation && !line.empty(); i++)
+        code += INDENTATION;
+    code += line + "\n";
+}
+
+void CGenerator::enterScope()
+{
+    scopes.emplace_back();
+    arrayScopes.emplace_back();
+}
+
+void CGenerator::exitScope()
+{
+    scopes.pop_back();
+    arrayScopes.pop_back();
+}
+
+std::optional<CType> CGenerator::findVariable(const std::string& name) const
+{
+    for(auto scope = scopes.rbegin(); scope != scopes.rend(); scope++)
+    {
+        if(auto variable = scope->find(name); variable != scope->end())
+            return variable->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<CArray> CGenerator::findArray(const std::string& name) const
+{
+    // The innermost variable with the name hides the others, even if it isn't an array
+    for(size_t i = scopes.size(); i-- > 0; )
+    {
+        if(scopes[i].contains(name))
+        {
+            auto array = arrayScopes[i].find(name);
+            return array == arrayScopes[i].end() ? std::nullopt : std::optional<CArray>(array->second);
+        }
+    }
+    return std::nullopt;
+}
\ No newline at end of file
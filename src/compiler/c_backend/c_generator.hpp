@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../parser/node/core.hpp"
+#include "../generation/special/intrinsic.hpp"
+#include "../optimizer/bounds_check_elimination.hpp"
+
+/**
+ * @brief Enumeration representing the C types of the values of the language.
+ */
+enum class CType
+{
+    /// `int`, that is `int64_t`.
+    Int,
+    /// `string`, that is `char*`.
+    String
+};
+
+/**
+ * @brief Structure representing an expression translated to C.
+ */
+struct CExpression
+{
+    std::string code;
+    CType type;
+};
+
+/**
+ * @brief Structure representing the C declaration of a function of the program.
+ */
+struct CFunction
+{
+    std::string name;
+    CType returnType;
+    std::vector<CType> parameterTypes;
+};
+
+/**
+ * @brief Structure representing an array of the program, that is a `char*` to its elements in C.
+ */
+struct CArray
+{
+    const StatementDeclareVariableNode* declaration;
+    /// If true the elements are a compound literal of the scope, and the variable can't get the address of other elements.
+    bool hasElementsOnStack;
+};
+
+/**
+ * @brief Class responsible for translating the parsed program to portable C99, so that it can be compiled by an optimizing C compiler.
+ *
+ * The code outside of the functions becomes `main`, and the arithmetic wraps around like in the native code.
+ * The `asm!` blocks are translated to GCC extended asm when they don't depend on the stack frame or on the symbols
+ * of the native code, otherwise they are reported as errors. Their operands become the operands of the extended asm.
+ */
+class CGenerator
+{
+public:
+    /**
+     * @brief Constructor for the CGenerator class.
+     * @param checkBounds If true the program exits with INDEX_OUT_OF_BOUNDS_EXIT_CODE when the index of an element isn't in the bounds of its array.
+     */
+    CGenerator(bool checkBounds = true);
+
+    /**
+     * @brief Translate a whole program to C.
+     * @param program The root node of the parsed program.
+     * @return The source code of the C translation unit, or std::nullopt if the program can't be translated (the errors are printed).
+     */
+    std::optional<std::string> generate(const ProgramNode& program);
+
+private:
+    void generateFunction(const StatementFunctionDefinitionNode* definition);
+    void generateStatements(const std::vector<StatementNode*>& statements);
+    /**
+     * @brief Generate the `index`-th statement of a list, merging a declaration with the assignment that follows it.
+     * @return The number of statements of the list that have been generated.
+     */
+    size_t generateStatementInList(const std::vector<StatementNode*>& statements, size_t index);
+    void generateStatement(const StatementNode* statement);
+    void generateScope(const StatementScopeNode* scope);
+    void generateAsmMacro(const StatementMacroNode* macro);
+
+    CExpression generateExpression(const ExpressionNode* expression);
+    CExpression generateFunctionCall(const ExpressionFunctionCallNode* call);
+    /**
+     * @brief Get the element of an array as an lvalue, with the check of its index if it isn't proven to be in the bounds of the array.
+     * @return The element, or std::nullopt if the name isn't an array (the error is saved).
+     */
+    std::optional<std::string> generateElement(const ExpressionIdentNode* arrayName, const ExpressionNode* index);
+    /**
+     * @brief Get the name of the static array that contains the characters of a string literal, defining it if needed.
+     */
+    std::string defineStringLiteral(const std::string& stringLiteral);
+
+    void emitLine(const std::string& line);
+    void enterScope();
+    void exitScope();
+    std::optional<CType> findVariable(const std::string& name) const;
+    /**
+     * @brief Get the array with the given name, or std::nullopt if the variable with this name isn't an array.
+     */
+    std::optional<CArray> findArray(const std::string& name) const;
+
+    std::unordered_map<std::string, CFunction> functions;
+    std::unordered_set<IntrinsicType> usedIntrinsics;
+    std::vector<std::unordered_map<std::string, CType>> scopes;
+    /// The arrays declared in each scope of `scopes`.
+    std::vector<std::unordered_map<std::string, CArray>> arrayScopes;
+    bool checkBounds;
+    /// The accesses to the elements whose index doesn't need to be checked, in the function being generated.
+    std::optional<BoundsCheckElimination> boundsCheckElimination;
+    bool usesBoundsChecks = false;
+    /// The return type of the function being generated, or std::nullopt when generating `main`.
+    std::optional<CType> currentReturnType;
+    std::vector<std::string> stringLiterals;
+    std::string code;
+    size_t indentation = 0;
+    std::vector<std::string> errors;
+};
\ No newline at end of file
@@ -1,8 +1,15 @@
 #include "compiler.hpp"
 #include "token/token.hpp"
+#include "binary/x86_encoder.hpp"
+#include "binary/elf_writer.hpp"
+#include "binary/jit.hpp"
+#include "bytecode/bytecode_compiler.hpp"
+#include "bytecode/virtual_machine.hpp"
+#include "c_backend/c_generator.hpp"
 
 #include <fstream>
 #include <sstream>
+#include <filesystem>
 
 Compiler::Compiler(Tokenizer tokenizer, Parser parser, Generator generator, CompilerSettings settings): 
     tokenizer(tokenizer), parser(std::move(parser)), generator(generator), settings(settings)
@@ -18,9 +25,10 @@ static void logSection(const std::string& sectionName)
     std::cout << std::endl << PREFIX << sectionName << SUFFIX << std::endl << std::endl;
 }
 
-std::string Compiler::compile(const std::string& input)
+std::optional<ProgramNode> Compiler::parse(const std::string& input)
 {
-    logSection("Tokenizing");
+    if(settings.showCompilationSteps)
+        logSection("Tokenizing");
     std::vector<Token> tokens = tokenizer.tokenize(input);
     if(settings.showTokenizerOutput)
     {
@@ -30,18 +38,53 @@ std::string Compiler::compile(const std::string& input)
         }
     }
 
-    logSection("Parsing");
+    if(settings.showCompilationSteps)
+        logSection("Parsing");
     ProgramNode program = parser.parse(tokens);
     if(program.nodes.empty())
-        return "";
+        return std::nullopt;
     if(settings.showParserOutput)
         std::cout << program;
 
-    logSection("Generating output");
-    std::string output = generator.generate(program);
+    return program;
+}
 
-    if(settings.showGeneratorOutput)
-        std::cout << "Output:\n" << output;
+std::optional<AssemblyProgram> Compiler::compile(const std::string& input)
+{
+    std::optional<ProgramNode> program = parse(input);
+    if(!program.has_value())
+        return std::nullopt;
+
+    if(settings.showCompilationSteps)
+        logSection("Generating output");
+    std::optional<AssemblyProgram> output = generator.generate(program.value());
+
+    if(settings.showGeneratorOutput && output.has_value())
+    {
+        std::cout << "Output:\n";
+        output.value().print(std::cout);
+    }
+
+    if(settings.showOptimizerStatistics)
+    {
+        logSection("Peephole optimizer");
+        for (const PeepholeRule& rule : generator.getPeepholeRules())
+        {
+            std::cout << rule.name << ": " << rule.hits << std::endl;
+        }
+
+        logSection("Loop vectorizer");
+        for (const LoopVectorizationReport& report : generator.getVectorizationReports())
+        {
+            std::cout << "Loop at line " << report.lineNumber << ": " << report.description << std::endl;
+        }
+
+        logSection("Compile-time evaluation");
+        for (const CompileTimeEvaluationReport& report : generator.getEvaluationReports())
+        {
+            std::cout << "Call at line " << report.lineNumber << ": " << report.description << std::endl;
+        }
+    }
 
     return output;
 }
@@ -52,13 +95,65 @@ int Compiler::compileAndWriteToFile(const std::string& inputFilePath, const std:
 
     std::string input = readFile(inputFilePath);
 
-    std::string output = compile(input);
+    if(settings.outputFormat == OutputFormat::C)
+        return compileToC(input, outputFilePath) ? 0 : 1;
+
+    std::optional<AssemblyProgram> output = compile(input);
 
-    writeOutputToFile(output, outputFilePath);
+    if(!writeOutputToFile(output, outputFilePath))
+        return 1;
 
     return 0;
 }
 
+int Compiler::compileAndRun(const std::string& inputFilePath)
+{
+    std::optional<AssemblyProgram> output = compile(readFile(inputFilePath));
+    if(!output.has_value() || output.value().globalSymbols.empty())
+        return 1;
+
+    std::optional<ObjectCode> object = X86Encoder().encode(output.value());
+    if(!object.has_value())
+        return 1;
+
+    return jit::run(object.value(), output.value().globalSymbols.front()).value_or(1);
+}
+
+int Compiler::compileAndInterpret(const std::string& inputFilePath)
+{
+    std::optional<ProgramNode> program = parse(readFile(inputFilePath));
+    if(!program.has_value())
+        return 1;
+
+    const GeneratorSettings& generatorSettings = generator.getSettings();
+    std::optional<BytecodeModule> module = BytecodeCompiler(generatorSettings.checkBounds, generatorSettings.evaluatePureCalls,
+                                                            generatorSettings.maxEvaluationSteps, generatorSettings.maxEvaluationDepth).compile(program.value());
+    if(!module.has_value())
+        return 1;
+
+    return static_cast<int>(VirtualMachine().run(module.value()).value_or(1));
+}
+
+bool Compiler::compileToC(const std::string& input, const std::string& outputFilePath)
+{
+    std::optional<ProgramNode> program = parse(input);
+    if(!program.has_value())
+        return false;
+
+    if(settings.showCompilationSteps)
+        logSection("Generating C");
+    std::optional<std::string> output = CGenerator(generator.getSettings().checkBounds).generate(program.value());
+    if(!output.has_value())
+        return false;
+    if(settings.showGeneratorOutput)
+        std::cout << "Output:\n" << output.value();
+
+    std::fstream file(outputFilePath, std::ios::out);
+    file << output.value();
+    file.close();
+    return true;
+}
+
 std::string Compiler::readFile(const std::string& filePath)
 {
     std::stringstream contentStream;
@@ -70,9 +165,39 @@ std::string Compiler::readFile(const std::string& filePath)
     return content;
 }
 
-void Compiler::writeOutputToFile(const std::string& output, const std::string& fileName)
+bool Compiler::writeOutputToFile(const std::optional<AssemblyProgram>& program, const std::string& fileName)
 {
-    std::fstream file(fileName, std::ios::out);
-    file << output;
+    if(settings.outputFormat == OutputFormat::Assembly)
+    {
+        std::fstream file(fileName, std::ios::out);
+        if(program.has_value())
+            program.value().print(file);
+        file.close();
+        return true;
+    }
+
+    if(!program.has_value())
+        return false;
+    std::optional<ObjectCode> object = X86Encoder().encode(program.value());
+    if(!object.has_value())
+        return false;
+
+    std::optional<std::vector<uint8_t>> content;
+    if(settings.outputFormat == OutputFormat::ObjectFile)
+        content = elf::writeRelocatableObject(object.value());
+    else if(!program.value().globalSymbols.empty())
+        content = elf::writeExecutable(object.value(), program.value().globalSymbols.front());
+    if(!content.has_value())
+        return false;
+
+    std::fstream file(fileName, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(content.value().data()), content.value().size());
     file.close();
+
+    if(settings.outputFormat == OutputFormat::Executable)
+    {
+        std::filesystem::permissions(fileName, std::filesystem::perms::owner_exec | std::filesystem::perms::group_exec | std::filesystem::perms::others_exec,
+                                     std::filesystem::perm_options::add);
+    }
+    return true;
 }
\ No newline at end of file
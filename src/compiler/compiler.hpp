@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <optional>
 
 #include "settings.hpp"
 #include "token/tokenizer.hpp"
@@ -28,9 +29,9 @@ public:
     /**
      * @brief Compiles the given source code and returns the result.
      * @param input The source code to be compiled.
-     * @return The compiled code as a string.
+     * @return The compiled program, or std::nullopt if the source code is invalid.
      */
-    std::string compile(const std::string& input);
+    std::optional<AssemblyProgram> compile(const std::string& input);
     
     /**
      * @brief Compiles the source code from a file and writes the result to another file.
@@ -40,6 +41,22 @@ public:
      */
     int compileAndWriteToFile(const std::string& inputFilePath, const std::string& outputFilePath);
 
+    /**
+     * @brief Compiles the source code from a file and runs it in the process of the compiler, without writing any file.
+     * @param inputFilePath The path to the source code file.
+     * @return The exit code of the program, or 1 if it can't be compiled or run.
+     */
+    int compileAndRun(const std::string& inputFilePath);
+
+    /**
+     * @brief Compiles the source code from a file to bytecode and runs it in the virtual machine of the compiler.
+     *
+     * Nothing is encoded or mapped in memory, so the program starts immediately, but the programs that use the `asm!` macro can't be run.
+     * @param inputFilePath The path to the source code file.
+     * @return The exit code of the program, or 1 if it can't be compiled or run.
+     */
+    int compileAndInterpret(const std::string& inputFilePath);
+
 private:
     /**
      * @brief Reads the contents of a file.
@@ -48,11 +65,25 @@ private:
      */
     std::string readFile(const std::string& filePath);
     /**
-     * @brief Writes the output string to a file.
-     * @param output The string to be written to the file.
+     * @brief Tokenizes and parses the source code.
+     * @param input The source code to be parsed.
+     * @return The parsed program, or std::nullopt if the source code is invalid.
+     */
+    std::optional<ProgramNode> parse(const std::string& input);
+    /**
+     * @brief Writes the program to a file, in the output format of the settings.
+     * @param program The program to be written to the file, if the compilation succeeded.
      * @param fileName The name of the output file.
+     * @return True if the file has been written, false if the program couldn't be encoded or linked.
+     */
+    bool writeOutputToFile(const std::optional<AssemblyProgram>& program, const std::string& fileName);
+    /**
+     * @brief Translates the source code to C and writes it to a file, instead of generating assembly code.
+     * @param input The source code to be translated.
+     * @param outputFilePath The path to the output file for the C code.
+     * @return True if the file has been written, false if the source code is invalid or can't be translated.
      */
-    void writeOutputToFile(const std::string& output, const std::string& fileName);
+    bool compileToC(const std::string& input, const std::string& outputFilePath);
 
     Tokenizer tokenizer;
     Parser parser;
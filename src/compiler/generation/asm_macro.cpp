@@ -0,0 +1,185 @@
+#include "asm_macro.hpp"
+
+#include <algorithm>
+
+#include "../optimizer/ast.hpp"
+#include "../token/tokenizer.hpp"
+
+// Returns the text of a string literal, or std::nullopt if the expression isn't a string literal
+static std::optional<std::string> stringLiteralOf(const ExpressionNode* expression)
+{
+    auto atom = std::get_if<ExpressionAtomNode*>(&expression->variant);
+    if(atom == nullptr || !std::holds_alternative<ExpressionLiteralNode*>((*atom)->variant))
+        return std::nullopt;
+    const Token& literal = std::get<ExpressionLiteralNode*>((*atom)->variant)->literal;
+    if(literal.type != TokenType::LiteralString)
+        return std::nullopt;
+    return literal.value.value();
+}
+
+static bool isOperandRegister(const std::string& name)
+{
+    return std::find(ASM_OPERAND_REGISTERS.begin(), ASM_OPERAND_REGISTERS.end(), name) != ASM_OPERAND_REGISTERS.end();
+}
+
+bool hasAsmOperands(const StatementMacroNode* macro)
+{
+    return macro->macroName->ident.value.value() == "asm!" && macro->arguments.size() > 1;
+}
+
+// Parses `in(constraint, value)`, `out(constraint, variable)` or `inout(constraint, variable)`
+static std::optional<AsmOperand> parseOperand(const ExpressionFunctionCallNode* call, std::string& error)
+{
+    const std::string& kind = call->functionName->ident.value.value();
+    AsmOperandType type = kind == "in" ? AsmOperandType::Input : kind == "out" ? AsmOperandType::Output : AsmOperandType::InputOutput;
+    std::optional<std::string> constraint = call->arguments.size() == 2 ? stringLiteralOf(call->arguments[0]) : std::nullopt;
+    if(!constraint.has_value())
+    {
+        error = "The `" + kind + "` operand of the asm! macro should have a string literal constraint and a value";
+        return std::nullopt;
+    }
+    if(constraint.value() != "r" && constraint.value() != "m" && !isOperandRegister(constraint.value()))
+    {
+        error = "The constraint `" + constraint.value() + "` of the asm! macro should be `r`, `m` or a 64 bits register (except `rsp` and `rbp`)";
+        return std::nullopt;
+    }
+
+    std::optional<std::string> variableName = ast::variableNameOf(call->arguments[1]);
+    if(!variableName.has_value() && (type != AsmOperandType::Input || constraint.value() == "m"))
+    {
+        error = "The `" + kind + "(\"" + constraint.value() + "\", ...)` operand of the asm! macro should be a variable";
+        return std::nullopt;
+    }
+    return AsmOperand { .type = type, .constraint = constraint.value(), .value = call->arguments[1], .variableName = variableName };
+}
+
+std::optional<AsmMacro> parseAsmMacro(const StatementMacroNode* macro, std::string& error)
+{
+    std::optional<std::string> code = macro->arguments.empty() ? std::nullopt : stringLiteralOf(macro->arguments[0]);
+    if(!code.has_value())
+    {
+        error = "The asm! macro should start with a string literal argument";
+        return std::nullopt;
+    }
+
+    // The code with operands is decoded like the other string literals (so `\n` separates its instructions), while the code
+    // without operands is kept as written, because it may contain NASM strings with their own escapes
+    std::string decodedCode = hasAsmOperands(macro) ? decodeStringLiteral(code.value()) : code.value();
+    AsmMacro asmMacro { .code = decodedCode, .operands = { }, .clobberedRegisters = { }, .clobbersMemory = false };
+    std::vector<std::string> usedRegisters;
+    for(size_t i = 1; i < macro->arguments.size(); i++)
+    {
+        auto atom = std::get_if<ExpressionAtomNode*>(&macro->arguments[i]->variant);
+        auto call = atom != nullptr ? std::get_if<ExpressionFunctionCallNode*>(&(*atom)->variant) : nullptr;
+        std::string kind = call != nullptr ? (*call)->functionName->ident.value.value() : "";
+        if(kind == "clobber")
+        {
+            for(auto argument : (*call)->arguments)
+            {
+                std::optional<std::string> name = stringLiteralOf(argument);
+                if(name == "memory")
+                    asmMacro.clobbersMemory = true;
+                // The flags are never kept between the statements
+                else if(name == "cc")
+                    continue;
+                else if(name.has_value() && isOperandRegister(name.value()))
+                {
+                    asmMacro.clobberedRegisters.push_back(name.value());
+                    usedRegisters.push_back(name.value());
+                }
+                else
+                {
+                    error = "The asm! macro can only clobber `memory`, `cc` and the 64 bits registers (except `rsp` and `rbp`)";
+                    return std::nullopt;
+                }
+            }
+        }
+        else if(kind == "in" || kind == "out" || kind == "inout")
+        {
+            std::optional<AsmOperand> operand = parseOperand(*call, error);
+            if(!operand.has_value())
+                return std::nullopt;
+            if(isOperandRegister(operand->constraint))
+                usedRegisters.push_back(operand->constraint);
+            asmMacro.operands.push_back(operand.value());
+        }
+        else
+        {
+            error = "The arguments of the asm! macro after the code should be `in(...)`, `out(...)`, `inout(...)` or `clobber(...)`";
+            return std::nullopt;
+        }
+    }
+
+    std::sort(usedRegisters.begin(), usedRegisters.end());
+    auto duplicate = std::adjacent_find(usedRegisters.begin(), usedRegisters.end());
+    if(duplicate != usedRegisters.end())
+    {
+        error = "The register `" + *duplicate + "` is used more than once by the operands and the clobbers of the asm! macro";
+        return std::nullopt;
+    }
+    return asmMacro;
+}
+
+std::vector<std::string> asmOutputsOf(const StatementMacroNode* macro)
+{
+    std::string error;
+    std::optional<AsmMacro> asmMacro = hasAsmOperands(macro) ? parseAsmMacro(macro, error) : std::nullopt;
+    if(!asmMacro.has_value())
+        return { };
+
+    std::vector<std::string> outputs;
+    for(const AsmOperand& operand : asmMacro->operands)
+    {
+        if(operand.type != AsmOperandType::Input)
+            outputs.push_back(operand.variableName.value());
+    }
+    return outputs;
+}
+
+bool asmMacroClobbersMemory(const StatementMacroNode* macro)
+{
+    if(macro->macroName->ident.value.value() != "asm!")
+        return false;
+    if(!hasAsmOperands(macro))
+        return true;
+    std::string error;
+    std::optional<AsmMacro> asmMacro = parseAsmMacro(macro, error);
+    return !asmMacro.has_value() || asmMacro->clobbersMemory;
+}
+
+std::optional<std::string> substituteAsmOperands(const AsmMacro& macro, const std::vector<std::string>& operandTexts, std::string& error)
+{
+    std::string code;
+    for(size_t i = 0; i < macro.code.size(); i++)
+    {
+        char character = macro.code[i];
+        if((character == '{' || character == '}') && i + 1 < macro.code.size() && macro.code[i + 1] == character)
+        {
+            code.push_back(character);
+            i++;
+            continue;
+        }
+        if(character != '{')
+        {
+            code.push_back(character);
+            continue;
+        }
+
+        size_t end = macro.code.find('}', i);
+        std::string reference = macro.code.substr(i + 1, end == std::string::npos ? std::string::npos : end - i - 1);
+        std::optional<size_t> operandIndex;
+        for(size_t operand = 0; operand < macro.operands.size() && !operandIndex.has_value(); operand++)
+        {
+            if(std::to_string(operand) == reference || macro.operands[operand].variableName == reference)
+                operandIndex = operand;
+        }
+        if(end == std::string::npos || !operandIndex.has_value())
+        {
+            error = "The asm! macro refers to the operand `{" + reference + "}`, that doesn't exist";
+            return std::nullopt;
+        }
+        code += operandTexts[operandIndex.value()];
+        i = end;
+    }
+    return code;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include "../parser/node/statement.hpp"
+
+/// The registers that the operands of an `asm!` macro can use: `rsp` and `rbp` keep the stack and the frame.
+const std::vector<std::string> ASM_OPERAND_REGISTERS = {
+    "rax", "rcx", "rdx", "rbx", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+/// The registers chosen for the operands with the `r` constraint: the ones that the functions can overwrite.
+const std::vector<std::string> ASM_SCRATCH_REGISTERS = {
+    "rax", "rcx", "rdx", "rbx", "r8", "r9", "r10", "r11"
+};
+
+/**
+ * @brief Enumeration representing how the code written with the `asm!` macro uses an operand.
+ */
+enum class AsmOperandType
+{
+    /// `in(constraint, value)`: the value is computed before the code.
+    Input,
+    /// `out(constraint, variable)`: the variable gets the value left by the code.
+    Output,
+    /// `inout(constraint, variable)`: the code reads the value of the variable and changes it.
+    InputOutput
+};
+
+/**
+ * @brief Structure representing a value passed to the code written with the `asm!` macro, or written by it.
+ */
+struct AsmOperand
+{
+    AsmOperandType type;
+    /// `r` for a register chosen by the compiler, `m` for the memory of a variable, or the name of a register (like `rcx`).
+    std::string constraint;
+    /// The value of an input, or the variable written by an output.
+    const ExpressionNode* value;
+    /// The name of the variable of the operand, if its value is just a variable.
+    std::optional<std::string> variableName;
+};
+
+/**
+ * @brief Structure representing an `asm!` macro with its operands, like `asm!("add {sum}, {1}", inout("r", sum), in("r", a * 2), clobber("rcx"))`.
+ *
+ * The code refers to the operands with `{position}`, or `{name}` when their value is a variable (`{{` and `}}` are the braces).
+ * Its escapes (like `\n`) are decoded like the ones of the other string literals.
+ * The registers that aren't operands or clobbered keep their value, and the memory isn't changed except for the
+ * outputs, unless `memory` is clobbered. The registers named by the operands or clobbered that the functions must
+ * preserve (`rsi`, `rdi` and `r12`-`r15`) are saved around the code.
+ */
+struct AsmMacro
+{
+    std::string code;
+    std::vector<AsmOperand> operands;
+    std::vector<std::string> clobberedRegisters;
+    bool clobbersMemory;
+};
+
+/**
+ * @brief Check if a macro is an `asm!` macro with operands.
+ *
+ * The `asm!` macros with only the code access the variables with hard-coded offsets from `rsp`, so they can change any of them.
+ */
+bool hasAsmOperands(const StatementMacroNode* macro);
+
+/**
+ * @brief Get the code and the operands of an `asm!` macro.
+ * @param error The reason why the macro isn't valid, if it isn't.
+ * @return The macro, or std::nullopt if it isn't valid.
+ */
+std::optional<AsmMacro> parseAsmMacro(const StatementMacroNode* macro, std::string& error);
+
+/**
+ * @brief Get the names of the variables written by an `asm!` macro with operands (none if it isn't valid).
+ */
+std::vector<std::string> asmOutputsOf(const StatementMacroNode* macro);
+
+/**
+ * @brief Check if an `asm!` macro may write in memory: the ones without operands, and the ones that clobber `memory`.
+ */
+bool asmMacroClobbersMemory(const StatementMacroNode* macro);
+
+/**
+ * @brief Replace the references to the operands in the code of an `asm!` macro.
+ * @param operandTexts The text that replaces each operand, in the order of the operands.
+ * @param error The reason why the code isn't valid, if it isn't.
+ * @return The code, or std::nullopt if it refers to an operand that doesn't exist.
+ */
+std::optional<std::string> substituteAsmOperands(const AsmMacro& macro, const std::vector<std::string>& operandTexts, std::string& error);
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "assembly.hpp"
+
+#include "special/consts.hpp"
+#include "../token/tokenizer.hpp"
+
+void AssemblyCode::emit(const std::string& mnemonic, std::vector<std::string> operands, const std::string& comment)
+{
+    lines.push_back(AssemblyLine { .type = AssemblyLineType::Instruction, .mnemonic = mnemonic, .operands = std::move(operands), .comment = comment });
+}
+
+void AssemblyCode::emitLabel(const std::string& label)
+{
+    lines.push_back(AssemblyLine { .type = AssemblyLineType::Label, .mnemonic = label });
+}
+
+void AssemblyCode::emitComment(const std::string& comment)
+{
+    lines.push_back(AssemblyLine { .type = AssemblyLineType::Other, .comment = comment });
+}
+
+void AssemblyCode::emitBlankLine()
+{
+    lines.push_back(AssemblyLine { .type = AssemblyLineType::Other });
+}
+
+void AssemblyCode::emitUserCode(const std::string& code)
+{
+    lines.push_back(AssemblyLine { .type = AssemblyLineType::Opaque, .mnemonic = code });
+}
+
+std::vector<AssemblyLine>& AssemblyCode::getLines()
+{
+    return lines;
+}
+
+const std::vector<AssemblyLine>& AssemblyCode::getLines() const
+{
+    return lines;
+}
+
+void AssemblyCode::print(std::ostream& output) const
+{
+    for(const AssemblyLine& line : lines)
+    {
+        if(line.isDeleted)
+            continue;
+        switch(line.type)
+        {
+            case AssemblyLineType::Instruction:
+                output << TAB << line.mnemonic;
+                for(size_t i = 0; i < line.operands.size(); i++)
+                    output << (i == 0 ? " " : ", ") << line.operands[i];
+                if(!line.comment.empty())
+                    output << " ; " << line.comment;
+                break;
+            case AssemblyLineType::Label:
+                output << line.mnemonic << ":";
+                break;
+            case AssemblyLineType::Other:
+                if(!line.comment.empty())
+                    output << TAB << "; " << line.comment;
+                break;
+            case AssemblyLineType::Opaque:
+                output << line.mnemonic;
+                break;
+        }
+        output << NEW_LINE;
+    }
+}
+
+static void printDataDefinition(std::ostream& output, const DataDefinition& definition)
+{
+    switch(definition.type)
+    {
+        case DataType::Word:
+            output << TAB << definition.name << " dw " << definition.value << NEW_LINE;
+            break;
+        case DataType::QuadWord:
+            output << TAB << definition.name << " dq " << definition.value << NEW_LINE;
+            break;
+        case DataType::String:
+            output << TAB << "dq " << decodeStringLiteral(definition.value).size() << NEW_LINE;
+            output << TAB << definition.name << " db `" << definition.value << "`, 0" << NEW_LINE;
+            output << TAB << definition.name << "_len equ $-" << definition.name << NEW_LINE;
+            break;
+        case DataType::Reserved:
+            output << TAB << definition.name << " times " << definition.value << " db 0" << NEW_LINE;
+            break;
+    }
+}
+
+void AssemblyProgram::print(std::ostream& output) const
+{
+    if(!data.empty())
+    {
+        output << "section .data" << NEW_LINE;
+        for(const DataDefinition& definition : data)
+            printDataDefinition(output, definition);
+        output << NEW_LINE;
+    }
+    if(!readOnlyData.empty())
+    {
+        output << "section .rodata" << NEW_LINE;
+        for(const DataDefinition& definition : readOnlyData)
+            printDataDefinition(output, definition);
+        output << NEW_LINE;
+    }
+
+    output << "section .text" << NEW_LINE;
+    for(const std::string& symbol : globalSymbols)
+        output << TAB << "global " << symbol << NEW_LINE;
+    for(const std::string& symbol : externalSymbols)
+        output << TAB << "extern " << symbol << NEW_LINE;
+    text.print(output);
+}
\ No newline at end of file
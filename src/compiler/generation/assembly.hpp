@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <optional>
+
+/**
+ * @brief Enumeration representing the kinds of line of the generated assembly code.
+ */
+enum class AssemblyLineType
+{
+    Instruction,
+    Label,
+    /// Blank lines and comments: they don't change the behaviour of the program.
+    Other,
+    /// Code written by the user through the `asm!` macro: it's never touched and it stops every analysis.
+    Opaque
+};
+
+/**
+ * @brief Structure representing a single line of the generated assembly code.
+ */
+struct AssemblyLine
+{
+    AssemblyLineType type;
+    /// The mnemonic of an instruction, the name of a label or the text of the user code.
+    std::string mnemonic;
+    /// The operands of an instruction, written with the NASM syntax (`rax`, `5`, `QWORD [rbp - 8]`, a label...).
+    std::vector<std::string> operands;
+    std::string comment;
+
+    bool isDeleted = false;
+};
+
+/**
+ * @brief Class representing the code of the text section, as a list of lines that the optimizations can rewrite.
+ */
+class AssemblyCode
+{
+public:
+    /**
+     * @brief Add an instruction at the end of the code.
+     * @param comment A comment written on the same line of the instruction, if not empty.
+     */
+    void emit(const std::string& mnemonic, std::vector<std::string> operands = { }, const std::string& comment = "");
+    void emitLabel(const std::string& label);
+    void emitComment(const std::string& comment);
+    void emitBlankLine();
+    /**
+     * @brief Add some code written by the user, that is copied as it is.
+     */
+    void emitUserCode(const std::string& code);
+
+    std::vector<AssemblyLine>& getLines();
+    const std::vector<AssemblyLine>& getLines() const;
+
+    /**
+     * @brief Write the code with the NASM syntax, skipping the deleted lines.
+     */
+    void print(std::ostream& output) const;
+
+private:
+    std::vector<AssemblyLine> lines;
+};
+
+/**
+ * @brief Enumeration representing the size of a variable of a data section.
+ */
+enum class DataType
+{
+    Word,
+    QuadWord,
+    /// A string that ends with a 0 byte, preceded by its length (a quad word before the label).
+    String,
+    /// A buffer of bytes set to 0, whose size is the value.
+    Reserved
+};
+
+/**
+ * @brief Structure representing a variable of a data section.
+ */
+struct DataDefinition
+{
+    std::string name;
+    DataType type;
+    /// The initial value: a number, or the text of a string (with the escape sequences of a NASM backquoted string),
+    /// or the size of a DataType::Reserved buffer.
+    std::string value;
+};
+
+/**
+ * @brief Structure representing where the code of a function is in the text section, used to name the machine code when it's profiled.
+ */
+struct FunctionSymbol
+{
+    /// The label at the start of the function.
+    std::string name;
+    /// The label right after the end of the function, if the function is written inside the code of another function.
+    std::optional<std::string> endLabel;
+};
+
+/**
+ * @brief Structure representing the whole generated program, before it's written to a file.
+ */
+struct AssemblyProgram
+{
+    std::vector<std::string> globalSymbols;
+    /// The symbols defined outside of the program, like the functions of the operating system.
+    std::vector<std::string> externalSymbols;
+    std::vector<DataDefinition> data;
+    std::vector<DataDefinition> readOnlyData;
+    AssemblyCode text;
+    /// The functions of the text section, in the order they are generated.
+    std::vector<FunctionSymbol> functions;
+
+    /**
+     * @brief Write the program with the NASM syntax.
+     */
+    void print(std::ostream& output) const;
+};
\ No newline at end of file
@@ -6,7 +6,9 @@
 enum class CodeGenerationErrorType
 {
     VariableAlreadyDefined,
-    UndeclaredVariable
+    UndeclaredVariable,
+    NotAnArray,
+    ArrayAssignment
 };
 
 /**
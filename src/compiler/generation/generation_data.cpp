@@ -10,30 +10,35 @@ std::string codeGenerationErrorToString(CodeGenerationError error)
         return "VariableAlreadyDefined: " + error.hint;
     case CodeGenerationErrorType::UndeclaredVariable:
         return "UndeclaredVariable: " + error.hint;
+    case CodeGenerationErrorType::NotAnArray:
+        return "NotAnArray: " + error.hint;
+    case CodeGenerationErrorType::ArrayAssignment:
+        return "ArrayAssignment: " + error.hint;
     }
 
     return "";
 }
 
-std::string GenerateData::convertToProgram()
+AssemblyProgram GenerateData::takeProgram(const std::string& entryPoint)
 {
+    AssemblyProgram program = AssemblyProgram
+    {
+        .globalSymbols = { entryPoint },
+        .externalSymbols = std::move(externalSymbols),
+        .data = std::move(dataSection),
+        .text = std::move(code),
+        .functions = std::move(functions)
+    };
     for(auto stringLiteral : stringLiterals)
     {
-        auto stringLiteralName = getNameOfStringLiteral(stringLiteral).value();
-        roDataSection << TAB << stringLiteralName << " db `" << stringLiteral << "`, 0" << NEW_LINE;
-        roDataSection << TAB << stringLiteralName << "_len equ $-" << stringLiteralName << NEW_LINE;
+        program.readOnlyData.push_back(DataDefinition
+        {
+            .name = getNameOfStringLiteral(stringLiteral).value(),
+            .type = DataType::String,
+            .value = stringLiteral
+        });
     }
-
-    auto dataSectionStr = dataSection.str();
-    auto roDataSectionStr = roDataSection.str();
-
-    std::string program = "";
-    if(!dataSectionStr.empty())
-        program += "section .data" + NEW_LINE + dataSectionStr + NEW_LINE;
-    if(!roDataSectionStr.empty())
-        program += "section .rodata" + NEW_LINE + roDataSectionStr + NEW_LINE;
-        
-    return program + output.str();
+    return program;
 }
 
 void GenerateData::enterScope()
@@ -41,23 +46,40 @@ void GenerateData::enterScope()
     Scope* newScope = new Scope
     {
         .startStackPtr = stackSize,
+        .startFrameSlot = currentFrame.has_value() ? currentFrame.value().usedSlots : 0,
         .parentScope = currentScope
     };
     currentScope->innerScopes.push_back(newScope);
     currentScope = newScope;
 }
 
-void GenerateData::exitScope()
+void GenerateData::exitScope(bool shouldFreeStack)
 {
     auto variablesToRemove = stackSize - currentScope->startStackPtr;
     stackSize = currentScope->startStackPtr;
-    output << TAB << "add rsp, " << variablesToRemove * 8 << NEW_LINE;
+    if(shouldFreeStack && variablesToRemove != 0)
+        code.emit("add", { "rsp", std::to_string(variablesToRemove * 8) });
+    // The slots of the scope can be reused by the next scopes
+    if(currentFrame.has_value())
+        currentFrame.value().usedSlots = currentScope->startFrameSlot;
     currentScope = currentScope->parentScope;
 }
 
 void GenerateData::defineVariable(const std::string &variableName)
 {
-    defineVariableWithOffsetStack(variableName, 0);
+    if(currentFrame.has_value())
+    {
+        StackFrame& frame = currentFrame.value();
+        frame.usedSlots++;
+        defineVariableWithFrameOffset(variableName, -8 * (long long) frame.usedSlots);
+    }
+    else
+        defineVariableWithOffsetStack(variableName, 0);
+}
+
+void GenerateData::defineVariableWithFrameOffset(const std::string &variableName, long long frameOffset)
+{
+    currentScope->definedVariables[variableName] = Variable{.stackPtr = 0, .frameOffset = frameOffset};
 }
 
 void GenerateData::defineVariableWithOffsetStack(const std::string &variableName, size_t offsetStack)
@@ -74,6 +96,10 @@ std::optional<Variable> GenerateData::getVariableByName(const std::string &varia
         if(variable != scopeBeingSearched->definedVariables.end())
             return variable->second;
 
+        // The variables outside of a function live in another stack frame
+        if(currentFunctionDefinition.has_value() && scopeBeingSearched == currentFunctionDefinition.value().scope)
+            break;
+
         scopeBeingSearched = scopeBeingSearched->parentScope;
     }
 
@@ -89,6 +115,20 @@ void GenerateData::defineFunction(Function function)
 {
     currentScope->definedFunctions[function.name] = std::move(function);
 }
+CallingConvention GenerateData::getCallingConvention(const std::string &functionName)
+{
+    auto signature = functionSignatures.find(functionName);
+    if(signature == functionSignatures.end())
+        return CallingConvention::Stack;
+    return signature->second.callingConvention;
+}
+bool GenerateData::mayClobberMemory(const std::string &functionName)
+{
+    auto signature = functionSignatures.find(functionName);
+    if(signature == functionSignatures.end())
+        return true;
+    return signature->second.mayClobberMemory;
+}
 void GenerateData::callFunction(Function function)
 {
     currentScope->calledFunctions.push_back(std::move(function));
@@ -105,7 +145,7 @@ bool isFunctioCallValid(Function functionCall, Scope* scopeBeingSearched)
             if(functionDefinition.parameters.size() != functionCall.parameters.size())
                 return false;
             // Do all the parameters of the function call and definition have the same type?
-            for(int i = 0; i < functionDefinition.parameters.size(); i++)
+            for(size_t i = 0; i < functionDefinition.parameters.size(); i++)
             {
                 if(functionDefinition.parameters[i]->type->ident.value != functionCall.parameters[i]->type->ident.value)
                     return false;
@@ -135,6 +175,11 @@ std::optional<Function> GenerateData::checkIfFunctionCallsAreValid()
     return std::nullopt;
 }
 
+bool GenerateData::usesIntrinsic(IntrinsicType type) const
+{
+    return std::any_of(intrinsics.begin(), intrinsics.end(), [&](const Intrinsic& intrinsic) { return intrinsic.type == type; });
+}
+
 std::optional<std::string> GenerateData::getNameOfStringLiteral(const std::string &stringLiteral)
 {
     auto it = std::find(stringLiterals.begin(), stringLiterals.end(), stringLiteral);
@@ -158,13 +203,13 @@ std::string GenerateData::defineStringLiteral(const std::string &stringLiteral)
 
 void GenerateData::pushOnStack(const std::string &registerName)
 {
-    output << TAB << "push " << registerName << NEW_LINE;
+    code.emit("push", { registerName });
     stackSize++;
 }
 
 void GenerateData::popFromStack(const std::string &registerName)
 {
-    output << TAB << "pop " << registerName << NEW_LINE;
+    code.emit("pop", { registerName });
     stackSize--;
 }
 std::string GenerateData::generateLabel()
@@ -1,14 +1,21 @@
 #pragma once
 
 #include <string>
-#include <sstream>
 #include <unordered_map>
 #include <optional>
 
 #include "special/consts.hpp"
+#include "assembly.hpp"
 #include "../parser/node/statement.hpp"
 #include "special/function.hpp"
+#include "special/intrinsic.hpp"
 #include "error.hpp"
+#include "../optimizer/loop_invariant_code_motion.hpp"
+#include "../optimizer/loop_unrolling.hpp"
+#include "../optimizer/loop_vectorization.hpp"
+#include "../optimizer/global_value_numbering.hpp"
+#include "../optimizer/bounds_check_elimination.hpp"
+#include "../optimizer/compile_time_evaluation.hpp"
 
 std::string codeGenerationErrorToString(CodeGenerationError error);
 
@@ -20,6 +27,7 @@ struct Variable;
 struct Scope
 {
     size_t startStackPtr;
+    size_t startFrameSlot;
     std::unordered_map<std::string, Variable> definedVariables;
     std::unordered_map<std::string, Function> definedFunctions;
     std::vector<Function> calledFunctions;
@@ -33,12 +41,38 @@ struct Scope
 struct Variable
 {
     size_t stackPtr;
+    /// Offset from `rbp` of the variable, when it lives in a slot of the stack frame.
+    std::optional<long long> frameOffset;
+    /// The declaration of the variable if it's an array: the variable contains the address of its elements.
+    const StatementDeclareVariableNode* arrayDeclaration = nullptr;
+    /// If true the elements of the array are on the stack, and the variable can't get the address of other elements.
+    bool hasElementsOnStack = false;
+    /// Offset from `rbp` of the elements of an array in the stack frame, that are accessed without loading their address.
+    std::optional<long long> elementsFrameOffset = std::nullopt;
 };
 
 struct FunctionDefinition
 {
+    std::string name;
     Scope* scope;
+    std::vector<std::string> parameterNames;
     size_t parametersCount;
+    CallingConvention callingConvention;
+    /// The label at the start of the body, where the calls of the function to itself in tail position jump.
+    std::optional<std::string> tailRecursionLabel;
+    /// If true the function has arrays on the stack, that the arguments of a tail call could point to.
+    bool hasStackArrays = false;
+};
+
+/**
+ * @brief Structure representing a stack frame addressed through `rbp`, allocated once when entering the function.
+ *
+ * Each variable gets a fixed slot, and the slots of a scope are reused by the following scopes.
+ */
+struct StackFrame
+{
+    size_t slotsCount;
+    size_t usedSlots;
 };
 
 /**
@@ -46,28 +80,67 @@ struct FunctionDefinition
  */
 struct GenerateData
 {
-    GenerateData() : output(std::stringstream()), stackSize(0), globalScope(Scope { }), currentScope(&globalScope), labelCount(0) {}
+    GenerateData() : stackSize(0), globalScope(Scope { }), currentScope(&globalScope), labelCount(0) {}
 
-    std::stringstream output;
-    std::stringstream dataSection;
-    std::stringstream roDataSection;
+    /// The code of the text section.
+    AssemblyCode code;
+    std::vector<DataDefinition> dataSection;
+    std::vector<std::string> externalSymbols;
     std::vector<std::string> stringLiterals;
+    std::vector<FunctionSymbol> functions;
     std::vector<CodeGenerationError> errors;
     size_t stackSize;
 
     Scope globalScope;
     Scope* currentScope;
     std::optional<FunctionDefinition> currentFunctionDefinition;
+    /// The frame of the code being generated, or std::nullopt if the variables are pushed on the stack.
+    std::optional<StackFrame> currentFrame;
+    /// The loop invariant expressions of the code being generated, if the loops are optimized.
+    std::optional<LoopInvariantCodeMotion> loopInvariants;
+    /// How the counted loops of the code being generated are unrolled, if the loops are optimized.
+    std::optional<LoopUnrolling> loopUnrolling;
+    /// How the counted loops of the code being generated are vectorized, if the loops are vectorized.
+    std::optional<LoopVectorization> loopVectorization;
+    /// The computations of the code being generated whose result is reused, if the common subexpressions are eliminated.
+    /// Their slots are the last ones of the current frame.
+    std::optional<GlobalValueNumbering> valueNumbering;
+    /// The accesses to the elements of the arrays whose index doesn't need to be checked, if the bounds checks are eliminated.
+    std::optional<BoundsCheckElimination> boundsCheckElimination;
+    /// The results of the calls computed while compiling, if the pure calls are evaluated.
+    std::optional<CompileTimeEvaluation> compileTimeEvaluation;
+    /// The slot of the stack frame of each loop invariant expression computed before the loops that are being generated.
+    std::unordered_map<const ExpressionNode*, Variable> hoistedExpressions;
+    /// The number of TEMPORARY_REGISTERS that keep an operand while the other operand of its binary operation is computed.
+    size_t usedTemporaryRegisters = 0;
+    /// The signature of each function defined in the program, known before generating any call.
+    std::unordered_map<std::string, FunctionSignature> functionSignatures;
+    /// The intrinsics called by the program, whose code is generated with the runtime.
+    std::vector<Intrinsic> intrinsics;
+    /// If true the code jumps to the runtime when the index of an element is out of the bounds of its array.
+    bool usesBoundsChecks = false;
     
     unsigned int labelCount;
 
-    std::string convertToProgram();
+    /**
+     * @brief Move the generated code, the variables and the string literals into a program.
+     * @param entryPoint The symbol where the execution of the program starts, the only one exported.
+     */
+    AssemblyProgram takeProgram(const std::string& entryPoint);
 
     void enterScope();
-    void exitScope();
+    /**
+     * @brief Exit the current scope.
+     * @param shouldFreeStack If true, the code that removes the variables of the scope from the stack is generated.
+     */
+    void exitScope(bool shouldFreeStack = true);
 
+    /**
+     * @brief Define a variable in the current scope: in a slot of the current frame, or on the top of the stack.
+     */
     void defineVariable(const std::string &variableName);
     void defineVariableWithOffsetStack(const std::string &variableName, size_t offsetStack);
+    void defineVariableWithFrameOffset(const std::string &variableName, long long frameOffset);
     
     std::optional<Variable> getVariableByName(const std::string &variableName);
 
@@ -79,8 +152,21 @@ struct GenerateData
     bool doesVariableExist(const std::string &variableName);
 
     void defineFunction(Function function);
+    /**
+     * @brief Get the calling convention of a function.
+     *
+     * The functions that aren't defined in the program (like the labels written in an `asm!` macro) use CallingConvention::Stack.
+     */
+    CallingConvention getCallingConvention(const std::string &functionName);
+    /**
+     * @brief Check if calling a function may write in the stack frame of the caller.
+     *
+     * The functions that aren't defined in the program (like the labels written in an `asm!` macro) may do it.
+     */
+    bool mayClobberMemory(const std::string &functionName);
     void callFunction(Function function);
     std::optional<Function> checkIfFunctionCallsAreValid();
+    bool usesIntrinsic(IntrinsicType type) const;
 
     std::optional<std::string> getNameOfStringLiteral(const std::string &stringLiteral);
     std::string defineStringLiteral(const std::string &stringLiteral);
@@ -2,57 +2,191 @@
 
 #include <iostream>
 #include <variant>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
 
 #include "special/consts.hpp"
 #include "utils.hpp"
+#include "runtime.hpp"
+#include "asm_macro.hpp"
+#include "../optimizer/ast.hpp"
 
-Generator::Generator() {}
+Generator::Generator() : Generator(GeneratorSettings {}) {}
 
-std::string Generator::generate(const ProgramNode &program)
+Generator::Generator(GeneratorSettings settings) : settings(settings), target(Target::create(settings.targetPlatform)) {}
+
+std::optional<AssemblyProgram> Generator::generate(const ProgramNode &program)
 {
     GenerateData generation = GenerateData();
+    vectorizationReports.clear();
+    evaluationReports.clear();
+    if(settings.evaluatePureCalls)
+    {
+        generation.compileTimeEvaluation.emplace(program.nodes, settings.maxEvaluationSteps, settings.maxEvaluationDepth);
+        evaluationReports = generation.compileTimeEvaluation.value().getReports();
+    }
 
-    generation.dataSection << TAB << "stdout dq 0" << NEW_LINE;
-    generation.dataSection << TAB << "stdin dq 0" << NEW_LINE;
-    generation.dataSection << TAB << "bytesWritten dw 0" << NEW_LINE;
+    target->declareRuntime(program, generation);
 
-    generation.output << "section .text" << NEW_LINE;
-    generation.output << TAB << "global " << START << NEW_LINE;
-    //generation.output << TAB << "default rel;     Tells NASM to use RIP-rel addressing by default" << NEW_LINE;
-    generation.output << TAB << "extern " << EXIT_PROCESS_WINDOWS << NEW_LINE;
-    utils::useStdout(generation);
-    utils::useStdin(generation);
-    utils::useHeapAllocation(generation);
-    generation.output << START << ":" << NEW_LINE;
-    utils::getStdoutHandle(generation);
-    utils::getStdinHandle(generation);
-    utils::getHeapHandle(generation);
+    // A function can be called before its definition, so the signatures are collected before generating the code
+    std::unordered_map<std::string, std::unordered_set<std::string>> calledFunctions;
+    for(auto node : program.nodes)
+    {
+        if(auto definition = std::get_if<StatementFunctionDefinitionNode*>(&node->variant))
+        {
+            const std::string& functionName = (*definition)->functionName->ident.value.value();
+            generation.functionSignatures[functionName] = FunctionSignature
+            {
+                .callingConvention = utils::containsAsmMacro((*definition)->implementation->statements) ? CallingConvention::Stack : CallingConvention::Registers,
+                .isExternallyVisible = utils::isNameUsedByAsmMacro(program.nodes, functionName),
+                .mayClobberMemory = utils::containsAsmMacro((*definition)->implementation->statements, asmMacroClobbersMemory)
+            };
+            calledFunctions[functionName] = ast::calledFunctionsOf((*definition)->implementation->statements);
+        }
+    }
+    runtime::declareIntrinsics(program, generation);
+    // A function that calls a function that may write anywhere in memory may do it too
+    bool hasChanged = true;
+    while(hasChanged)
+    {
+        hasChanged = false;
+        for(auto& [functionName, signature] : generation.functionSignatures)
+        {
+            if(signature.mayClobberMemory)
+                continue;
+            signature.mayClobberMemory = std::any_of(calledFunctions[functionName].begin(), calledFunctions[functionName].end(),
+                [&](const std::string& calledFunction) { return generation.mayClobberMemory(calledFunction); });
+            hasChanged |= signature.mayClobberMemory;
+        }
+    }
+
+    generation.code.emitLabel(target->getEntryPoint());
+    generation.functions.push_back(FunctionSymbol { .name = target->getEntryPoint() });
+    generation.code.emit("push", { "rbp" });
+    generation.code.emit("mov", { "rbp", "rsp" });
+    if(!utils::containsAsmMacro(program.nodes))
+    {
+        size_t optimizationSlotsCount = analyzeStatements(program.nodes, { }, generation);
+        generateFramePrologue(utils::countFrameSlots(program.nodes, generation.loopInvariants) + optimizationSlotsCount, generation);
+    }
+    target->generateStartup(generation);
+    runtime::generateStartup(generation);
 
-    for (StatementNode* statement : program.nodes)
+    for (size_t i = 0; i < program.nodes.size(); i++)
     {
-        generateStatement(statement, generation);
+        generateStatementInList(program.nodes, i, generation);
 
         for (auto error : generation.errors)
             std::cerr << codeGenerationErrorToString(error) << std::endl;
         generation.errors.clear();
     }
 
-    generation.output << NEW_LINE << TAB << "; Default return" << NEW_LINE;
-    utils::generateExitCode("0", generation.output);
+    generation.code.emitBlankLine();
+    generation.code.emitComment("Default return");
+    runtime::generateExit("0", *target, generation);
+    runtime::generateIntrinsics(*target, generation);
+    target->generateRuntimeFunctions(program, generation);
 
     std::optional<Function> invalidFunctionCall = generation.checkIfFunctionCallsAreValid();
     if(invalidFunctionCall.has_value())
     {
         std::cerr << "The function call `" << invalidFunctionCall.value().name << "` is invalid!" << std::endl;
-        return "";
+        return std::nullopt;
     }
 
-    return generation.convertToProgram();
+    if(settings.usePeepholeOptimizer)
+        peepholeOptimizer.optimize(generation.code);
+
+    return generation.takeProgram(target->getEntryPoint());
+}
+
+const std::vector<PeepholeRule>& Generator::getPeepholeRules() const
+{
+    return peepholeOptimizer.getRules();
+}
+
+const GeneratorSettings& Generator::getSettings() const
+{
+    return settings;
+}
+
+const std::vector<LoopVectorizationReport>& Generator::getVectorizationReports() const
+{
+    return vectorizationReports;
+}
+
+const std::vector<CompileTimeEvaluationReport>& Generator::getEvaluationReports() const
+{
+    return evaluationReports;
 }
 
 // Size of the return address from a function
 const int RETURN_ADDRESS_SIZE = 1;
 
+// Saves the call, so that it can be checked against the definition of the function once all the code is generated
+static void registerFunctionCall(const ExpressionFunctionCallNode* expression, GenerateData &generation)
+{
+    // TODO:
+    // Also the memory of `temporary` is never deallocated
+    StatementDeclareVariableNode* temporary = new StatementDeclareVariableNode(StatementDeclareVariableNode
+    {
+        .type = new ExpressionIdentNode(ExpressionIdentNode {.ident = Token { .type = TokenType::Unknown, .value = std::nullopt }}),
+        .name = new ExpressionIdentNode(ExpressionIdentNode {.ident = Token { .type = TokenType::Unknown, .value = std::nullopt }}),
+    });
+    auto parameters = std::vector<StatementDeclareVariableNode*>(expression->arguments.size(), temporary);
+    generation.callFunction(Function 
+    {
+        .name = expression->functionName->ident.value.value(),
+        .parameters = parameters
+    });
+}
+
+// Returns the result of a call computed while compiling, if it's a call of a pure function with constant arguments
+static std::optional<long long> evaluatedValueOf(const ExpressionFunctionCallNode* call, GenerateData &generation)
+{
+    if(!generation.compileTimeEvaluation.has_value())
+        return std::nullopt;
+    return generation.compileTimeEvaluation.value().getValue(call);
+}
+
+// Returns the function call whose value is returned by the statement, if it's `return f(...);`
+static const ExpressionFunctionCallNode* tailCallOf(const StatementReturnNode* statement)
+{
+    auto expression = ast::skipBrackets(statement->expression);
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return nullptr;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(!std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+        return nullptr;
+    return std::get<ExpressionFunctionCallNode*>(atom->variant);
+}
+
+// Checks for a `return f(...);` statement where `f` is the function with the given name
+static bool hasSelfTailCall(const std::vector<StatementNode*>& statements, const std::string& functionName)
+{
+    return std::any_of(statements.begin(), statements.end(), [&](const StatementNode* statement)
+    {
+        return std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementReturnNode*>)
+            {
+                auto call = tailCallOf(node);
+                return call != nullptr && call->functionName->ident.value.value() == functionName;
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return hasSelfTailCall(node->statements, functionName);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return hasSelfTailCall(node->scope->statements, functionName) || (node->elseScope.has_value() && hasSelfTailCall(node->elseScope.value()->statements, functionName));
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return hasSelfTailCall(node->scope->statements, functionName);
+            else
+                return false;
+        }, statement->variant);
+    });
+}
+
 void Generator::generateStatement(const StatementNode* statement, GenerateData &generation)
 {
     struct Visitor
@@ -64,28 +198,19 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
 
         void operator()(const StatementReturnNode* statement)
         {
-            generation.output << NEW_LINE << TAB << "; Return" << NEW_LINE;
+            generation.code.emitBlankLine();
+            generation.code.emitComment("Return");
+            if(generator.generateTailCall(statement, generation))
+                return;
             generator.generateExpression("rax", statement->expression, generation);
-
-            auto currentFunctionDefinition = generation.currentFunctionDefinition;
-            if(currentFunctionDefinition.has_value())
-            {
-                auto variablesToRemove = 8 * (generation.stackSize - currentFunctionDefinition.value().scope->startStackPtr - RETURN_ADDRESS_SIZE);
-                generation.output << TAB << "mov rcx, QWORD [rsp + " << (variablesToRemove - currentFunctionDefinition.value().parametersCount * 8) << "]" << NEW_LINE;
-                if(variablesToRemove != 0)
-                    generation.output << TAB << "add rsp, " << (variablesToRemove - 8) << NEW_LINE;
-                generation.output << TAB << "mov QWORD [rsp + 8], rax" << NEW_LINE;
-                generation.output << TAB << "mov QWORD [rsp], rcx" << NEW_LINE;
-                generation.output << TAB << "ret" << NEW_LINE;
-
-            }
-            else
-                utils::generateExitCode("rax", generation.output);
+            generator.generateReturn(generation);
         }
         void operator()(const StatementMacroNode* statement)
         {
             std::string macroName = statement->macroName->ident.value.value();
-            if(macroName == "asm!")
+            if(macroName == "asm!" && hasAsmOperands(statement))
+                generator.generateAsmMacro(statement, generation);
+            else if(macroName == "asm!")
             {
                 if(statement->arguments.size() == 1)
                 {
@@ -100,7 +225,9 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                                 if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
                                 {
                                     std::string assemblyCode = insideArg->literal.value.value();
-                                    generation.output << assemblyCode << NEW_LINE;
+                                    generation.code.emitComment(ASM_MACRO_START);
+                                    generation.code.emitUserCode(assemblyCode);
+                                    generation.code.emitComment(ASM_MACRO_END);
                                 }
                                 else
                                     std::cerr << "The asm! macro should have only a string literal argument" << std::endl;
@@ -133,7 +260,7 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                                     
                                     std::cerr << "This feature isn't supported yet!" << std::endl;
                                     /*std::string includedFileContent = "";
-                                    generation.output << includedFileContent << NEW_LINE;*/
+                                    generation.code.emitUserCode(includedFileContent);*/
                                 }
                                 else
                                     std::cerr << "The include! macro should have only a string literal argument" << std::endl;
@@ -153,20 +280,7 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
         }
         void operator()(const StatementDeclareVariableNode* statement)
         {
-            const std::string &variableName = statement->name->ident.value.value();
-            if (generation.doesVariableExist(variableName))
-            {
-                generation.errors.push_back(CodeGenerationError
-                {
-                    .type = CodeGenerationErrorType::VariableAlreadyDefined,
-                    .hint = variableName
-                });
-                return;
-            }
-
-            generation.defineVariable(variableName);
-            generation.output << TAB << "mov rax, 0 ; Declaring variable named `" << variableName << "`" << NEW_LINE;
-            generation.pushOnStack("rax");
+            generator.generateVariableDeclaration(statement, true, generation);
         }
         void operator()(const StatementScopeNode* statement)
         {
@@ -177,29 +291,19 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
             auto hasElse = statement->elseScope.has_value();
             auto endIfLabel = generation.generateLabel();
             auto startElseLabel = generation.generateLabel();
-            generator.generateExpression("rax", statement->condition, generation);
-            generation.output << TAB << "test rax, rax" << NEW_LINE;
-            generation.output << TAB << "jz " << (hasElse ? startElseLabel : endIfLabel) << NEW_LINE;
+            generator.generateConditionalJump(statement->condition, hasElse ? startElseLabel : endIfLabel, false, generation);
             generator.generateStatementScope(statement->scope, generation);
             if(hasElse)
             {
-                generation.output << TAB << "jmp " << endIfLabel << NEW_LINE;
-                generation.output << startElseLabel << ":" << NEW_LINE;
+                generation.code.emit("jmp", { endIfLabel });
+                generation.code.emitLabel(startElseLabel);
                 generator.generateStatementScope(statement->elseScope.value(), generation);
             }
-            generation.output << endIfLabel << ":" << NEW_LINE;
+            generation.code.emitLabel(endIfLabel);
         }
         void operator()(const StatementWhileNode* statement)
         {
-            auto startLoopLabel = generation.generateLabel();
-            auto endLoopLabel = generation.generateLabel();
-            generation.output << startLoopLabel << ":" << NEW_LINE;
-            generator.generateExpression("rax", statement->condition, generation);
-            generation.output << TAB << "test rax, rax" << NEW_LINE;
-            generation.output << TAB << "jz " << endLoopLabel << NEW_LINE;
-            generator.generateStatementScope(statement->scope, generation);
-            generation.output << TAB << "jmp " << startLoopLabel << NEW_LINE;
-            generation.output << endLoopLabel << ":" << NEW_LINE;
+            generator.generateWhileLoop(statement, generation);
         }
         void operator()(const StatementAssignVariableNode* statement)
         {
@@ -214,7 +318,22 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                 return;
             }
 
+            if(statement->index.has_value())
+            {
+                generator.generateElementAssignment(statement, generation);
+                return;
+            }
+
             Variable variable = generation.getVariableByName(variableName).value();
+            if(variable.hasElementsOnStack)
+            {
+                generation.errors.push_back(CodeGenerationError
+                {
+                    .type = CodeGenerationErrorType::ArrayAssignment,
+                    .hint = variableName
+                });
+                return;
+            }
             std::visit(
                 [&](auto arg)
                 {
@@ -229,15 +348,12 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                                 if(arg->literal.type == TokenType::LiteralString)
                                 {
                                     std::string stringLiteralName = generation.defineStringLiteral(arg->literal.value.value());
-                                    generation.output << TAB << "mov rdx"// << utils::accessVariable(generation, variable) 
-                                        << ", " << stringLiteralName << NEW_LINE;
-                                    generation.output << TAB << "mov " << utils::accessVariable(generation, variable) 
-                                        << ", rdx" << NEW_LINE;
+                                    generation.code.emit("mov", { "rdx", stringLiteralName });
+                                    generation.code.emit("mov", { utils::accessVariable(generation, variable), "rdx" });
                                 }
                                 else
                                 {
-                                    generation.output << TAB << "mov " << utils::accessVariable(generation, variable) 
-                                        << ", " << arg->literal.value.value() << NEW_LINE;
+                                    generation.code.emit("mov", { utils::accessVariable(generation, variable), arg->literal.value.value() });
                                 }
                             }
                             else if constexpr (std::is_same_v<T, ExpressionIdentNode*>)
@@ -254,8 +370,7 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                                     .variant = &atomNode
                                 };
                                 generator.generateExpression("rax", &node, generation);
-                                generation.output << TAB << "mov " << utils::accessVariable(generation, variable) 
-                                    << ", rax" << NEW_LINE;
+                                generation.code.emit("mov", { utils::accessVariable(generation, variable), "rax" });
                             }
                             else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
                             {
@@ -267,8 +382,12 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                                     .variant = &atomNode
                                 };
                                 generator.generateExpression("rax", &node, generation);
-                                generation.output << TAB << "mov " << utils::accessVariable(generation, variable) 
-                                    << ", rax" << NEW_LINE;
+                                generation.code.emit("mov", { utils::accessVariable(generation, variable), "rax" });
+                            }
+                            else if constexpr (std::is_same_v<T, ExpressionIndexNode*> || std::is_same_v<T, ExpressionBracketsNode*>)
+                            {
+                                generator.generateExpression("rax", statement->value, generation);
+                                generation.code.emit("mov", { utils::accessVariable(generation, variable), "rax" });
                             }
                             else
                                 std::cerr << "Unsupported type!" << std::endl;
@@ -276,12 +395,9 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                     }
                     else if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
                     {
-                        auto node = ExpressionNode {
-                            .variant = arg
-                        };
-                        generator.generateExpression("rax", &node, generation);
-                        generation.output << TAB << "mov " << utils::accessVariable(generation, variable) 
-                            << ", rax" << NEW_LINE;
+                        // The node of the statement is used, because the optimizations remember the expressions by their node
+                        generator.generateExpression("rax", statement->value, generation);
+                        generation.code.emit("mov", { utils::accessVariable(generation, variable), "rax" });
                     }
                     else
                         std::cerr << "Unsupported type!" << std::endl;
@@ -297,7 +413,8 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
                 return;
             }
             auto endFunctionLabel = generation.generateLabel();
-            generation.output << NEW_LINE << TAB << "jmp " << endFunctionLabel << ";  Skip the function definition" << NEW_LINE;
+            generation.code.emitBlankLine();
+            generation.code.emit("jmp", { endFunctionLabel }, "Skip the function definition");
 
             auto functionName = statement->functionName->ident.value.value();
             
@@ -308,23 +425,105 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
 
             generation.enterScope();
 
-            generation.output << functionName << ":" << NEW_LINE;
+            auto previousFrame = generation.currentFrame;
+            auto previousLoopInvariants = std::move(generation.loopInvariants);
+            auto previousLoopUnrolling = std::move(generation.loopUnrolling);
+            auto previousLoopVectorization = std::move(generation.loopVectorization);
+            auto previousValueNumbering = std::move(generation.valueNumbering);
+            auto previousBoundsCheckElimination = std::move(generation.boundsCheckElimination);
+            generation.loopInvariants = std::nullopt;
+            generation.loopUnrolling = std::nullopt;
+            generation.loopVectorization = std::nullopt;
+            generation.valueNumbering = std::nullopt;
+            generation.boundsCheckElimination = std::nullopt;
+            auto parametersCount = statement->parameters.size();
+            auto callingConvention = generation.getCallingConvention(functionName);
+            if(callingConvention == CallingConvention::Stack)
+            {
+                generation.code.emitLabel(functionName);
+                generation.functions.push_back(FunctionSymbol { .name = functionName, .endLabel = endFunctionLabel });
+                // The user code expects the parameters and the variables to be pushed on the stack
+                generation.currentFrame = std::nullopt;
+                generation.stackSize += RETURN_ADDRESS_SIZE + parametersCount;
+                for(size_t i = 0; i < parametersCount; i++)
+                {
+                    generation.defineVariableWithOffsetStack(statement->parameters[parametersCount - i - 1]->name->ident.value.value(), 2 + i);
+                }
+            }
+            else
+            {
+                if(generation.functionSignatures[functionName].isExternallyVisible)
+                    generator.generateAbiWrapper(functionName, parametersCount, generation);
 
-            generation.stackSize += RETURN_ADDRESS_SIZE + statement->parameters.size();
-            for(int i = 0; i < statement->parameters.size(); i++)
+                generation.code.emitLabel(utils::internalFunctionLabel(functionName));
+                generation.functions.push_back(FunctionSymbol { .name = utils::internalFunctionLabel(functionName), .endLabel = endFunctionLabel });
+                generation.code.emit("push", { "rbp" });
+                generation.code.emit("mov", { "rbp", "rsp" });
+                auto registerParametersCount = std::min(parametersCount, ARGUMENT_REGISTERS.size());
+                size_t optimizationSlotsCount = generator.analyzeStatements(statement->implementation->statements, statement->parameters, generation);
+                generator.generateFramePrologue(utils::countFrameSlots(statement->implementation->statements, generation.loopInvariants) + registerParametersCount + optimizationSlotsCount, generation);
+                for(size_t i = 0; i < parametersCount; i++)
+                {
+                    const std::string& parameterName = statement->parameters[i]->name->ident.value.value();
+                    if(i < registerParametersCount)
+                    {
+                        // The parameters passed in registers are saved in the frame, like any other variable
+                        generation.defineVariable(parameterName);
+                        auto parameter = generation.getVariableByName(parameterName).value();
+                        generation.code.emit("mov", { utils::accessVariable(generation, parameter), ARGUMENT_REGISTERS[i] });
+                    }
+                    else
+                    {
+                        // The other parameters are above the saved `rbp` and the return address
+                        generation.defineVariableWithFrameOffset(parameterName, 16 + 8 * (parametersCount - i - 1));
+                    }
+                }
+            }
+            std::vector<std::string> parameterNames;
+            for(auto parameter : statement->parameters)
+            {
+                parameterNames.push_back(parameter->name->ident.value.value());
+                // An array is passed as the address of its elements
+                if(parameter->arrayLength.has_value())
+                    generation.currentScope->definedVariables[parameter->name->ident.value.value()].arrayDeclaration = parameter;
+            }
+            generation.currentFunctionDefinition = FunctionDefinition
             {
-                generation.defineVariableWithOffsetStack(statement->parameters[statement->parameters.size() - i - 1]->name->ident.value.value(), 2 + i);
+                .name = functionName,
+                .scope = generation.currentScope,
+                .parameterNames = parameterNames,
+                .parametersCount = parametersCount,
+                .callingConvention = callingConvention,
+                .hasStackArrays = ast::containsStackArray(statement->implementation->statements)
+            };
+            if(callingConvention == CallingConvention::Registers && !generation.currentFunctionDefinition.value().hasStackArrays && hasSelfTailCall(statement->implementation->statements, functionName))
+            {
+                // The recursion becomes a loop that starts after the prologue
+                auto tailRecursionLabel = generation.generateLabel();
+                generation.code.emitLabel(tailRecursionLabel);
+                generation.currentFunctionDefinition.value().tailRecursionLabel = tailRecursionLabel;
             }
-            generation.currentFunctionDefinition = FunctionDefinition { .scope = generation.currentScope, .parametersCount = statement->parameters.size() };
-            generator.generateStatementScopeWithoutEntering(statement->implementation, generation);
+            generator.generateStatementList(statement->implementation->statements, generation);
+
+            // Reaching the end of a function returns 0
+            generation.code.emit("mov", { "rax", "0" });
+            generator.generateReturn(generation);
             generation.currentFunctionDefinition = std::nullopt;
-            
-            generation.output << TAB << "ret" << NEW_LINE;
+            generation.exitScope(false);
+            generation.currentFrame = previousFrame;
+            generation.loopInvariants = std::move(previousLoopInvariants);
+            generation.loopUnrolling = std::move(previousLoopUnrolling);
+            generation.loopVectorization = std::move(previousLoopVectorization);
+            generation.valueNumbering = std::move(previousValueNumbering);
+            generation.boundsCheckElimination = std::move(previousBoundsCheckElimination);
 
-            generation.output << endFunctionLabel << ":" << NEW_LINE;
+            generation.code.emitLabel(endFunctionLabel);
         }
         void operator()(ExpressionFunctionCallNode* expression)
         {
+            // A pure call whose value is known has nothing left to do
+            if(evaluatedValueOf(expression, generation).has_value())
+                return;
             auto atom = ExpressionAtomNode
             {
                 .variant = expression
@@ -343,12 +542,483 @@ void Generator::generateStatement(const StatementNode* statement, GenerateData &
 
 void Generator::generateStatementScopeWithoutEntering(const StatementScopeNode* statement, GenerateData &generation)
 {
-    for(auto statement : statement->statements)
-        generateStatement(statement, generation);
+    generateStatementList(statement->statements, generation);
 
     generation.exitScope();
 }
 
+void Generator::generateStatementList(const std::vector<StatementNode*>& statements, GenerateData &generation)
+{
+    for(size_t i = 0; i < statements.size(); i++)
+        generateStatementInList(statements, i, generation);
+}
+
+void Generator::generateStatementInList(const std::vector<StatementNode*>& statements, size_t index, GenerateData &generation)
+{
+    // `int x = value;` is a declaration followed by an assignment: the variable doesn't need to be set to 0 first,
+    // and an array gets the address of its elements from the value
+    if(ast::initializationOf(statements, index) != nullptr)
+    {
+        auto declaration = std::get<StatementDeclareVariableNode*>(statements[index]->variant);
+        if(generation.currentFrame.has_value() || declaration->arrayLength.has_value())
+        {
+            generateVariableDeclaration(declaration, false, generation);
+            return;
+        }
+    }
+
+    generateStatement(statements[index], generation);
+}
+
+void Generator::generateVariableDeclaration(const StatementDeclareVariableNode* statement, bool shouldInitialize, GenerateData &generation)
+{
+    const std::string &variableName = statement->name->ident.value.value();
+    if (generation.doesVariableExist(variableName))
+    {
+        generation.errors.push_back(CodeGenerationError
+        {
+            .type = CodeGenerationErrorType::VariableAlreadyDefined,
+            .hint = variableName
+        });
+        return;
+    }
+
+    if(statement->arrayLength.has_value() && shouldInitialize)
+    {
+        generateStackArray(statement, generation);
+        return;
+    }
+
+    generation.defineVariable(variableName);
+    if(statement->arrayLength.has_value())
+        generation.currentScope->definedVariables[variableName].arrayDeclaration = statement;
+    if(generation.currentFrame.has_value())
+    {
+        if(shouldInitialize)
+        {
+            auto variable = generation.getVariableByName(variableName).value();
+            generation.code.emit("mov", { utils::accessVariable(generation, variable), "0" }, "Declaring variable named `" + variableName + "`");
+        }
+    }
+    else
+    {
+        generation.code.emit("mov", { "rax", "0" }, "Declaring variable named `" + variableName + "`");
+        generation.pushOnStack("rax");
+    }
+}
+
+// Arrays with at most this number of slots are set to 0 with a store for each slot, the others with a loop
+const size_t MAX_UNROLLED_ZEROING_SLOTS = 8;
+// The constant indices are added to the displacement of the address only while it surely fits in 32 bits
+const long long MAX_FOLDED_INDEX = 1LL << 24;
+
+// Returns `[base + offset]`, without the size of the operand
+static std::string addressOf(const std::string& base, long long offset)
+{
+    if(offset == 0)
+        return "[" + base + "]";
+    return "[" + base + (offset < 0 ? " - " : " + ") + std::to_string(std::abs(offset)) + "]";
+}
+
+// Sets to 0 the slots that start at `[base + offset]`
+static void generateZeroing(const std::string& base, long long offset, size_t slotsCount, GenerateData& generation)
+{
+    if(slotsCount <= MAX_UNROLLED_ZEROING_SLOTS)
+    {
+        for(size_t i = 0; i < slotsCount; i++)
+            generation.code.emit("mov", { "QWORD " + addressOf(base, offset + 8 * (long long) i), "0" });
+        return;
+    }
+
+    auto zeroingLabel = generation.generateLabel();
+    generation.code.emit("lea", { "rax", addressOf(base, offset) });
+    generation.code.emit("mov", { "rcx", std::to_string(slotsCount) });
+    generation.code.emitLabel(zeroingLabel);
+    generation.code.emit("mov", { "QWORD [rax + rcx*8 - 8]", "0" });
+    generation.code.emit("sub", { "rcx", "1" });
+    generation.code.emit("jnz", { zeroingLabel });
+}
+
+void Generator::generateStackArray(const StatementDeclareVariableNode* statement, GenerateData &generation)
+{
+    const std::string &variableName = statement->name->ident.value.value();
+    size_t slotsCount = utils::countArraySlots(statement);
+    std::string comment = "Declaring array named `" + variableName + "`";
+    if(generation.currentFrame.has_value())
+    {
+        // The elements are in the slots after the one of the variable, that contains their address
+        generation.defineVariable(variableName);
+        StackFrame& frame = generation.currentFrame.value();
+        frame.usedSlots += slotsCount;
+        long long elementsFrameOffset = -8 * (long long) frame.usedSlots;
+        generation.code.emitComment(comment);
+        generateZeroing("rbp", elementsFrameOffset, slotsCount, generation);
+        generation.code.emit("lea", { "rax", addressOf("rbp", elementsFrameOffset) });
+
+        Variable& variable = generation.currentScope->definedVariables[variableName];
+        variable.arrayDeclaration = statement;
+        variable.hasElementsOnStack = true;
+        variable.elementsFrameOffset = elementsFrameOffset;
+        generation.code.emit("mov", { utils::accessVariable(generation, variable), "rax" });
+        return;
+    }
+
+    // The elements are pushed on the stack before the variable
+    generation.code.emit("sub", { "rsp", std::to_string(8 * slotsCount) }, comment);
+    generation.stackSize += slotsCount;
+    generateZeroing("rsp", 0, slotsCount, generation);
+    generation.code.emit("mov", { "rax", "rsp" });
+    generation.defineVariable(variableName);
+    Variable& variable = generation.currentScope->definedVariables[variableName];
+    variable.arrayDeclaration = statement;
+    variable.hasElementsOnStack = true;
+    generation.pushOnStack("rax");
+}
+
+// Returns the array with the given name, or std::nullopt (with an error) if it doesn't exist or it isn't an array
+static std::optional<Variable> arrayVariableOf(const ExpressionIdentNode* name, GenerateData& generation)
+{
+    const std::string& variableName = name->ident.value.value();
+    std::optional<Variable> variable = generation.getVariableByName(variableName);
+    if(!variable.has_value() || variable.value().arrayDeclaration == nullptr)
+    {
+        generation.errors.push_back(CodeGenerationError
+        {
+            .type = variable.has_value() ? CodeGenerationErrorType::NotAnArray : CodeGenerationErrorType::UndeclaredVariable,
+            .hint = variableName
+        });
+        return std::nullopt;
+    }
+    return variable;
+}
+
+// Returns the address of an element (without the size of the operand), whose index is a constant or is in `indexRegister`.
+// The address of the elements is loaded in `rcx`, unless they are in the stack frame.
+static std::string elementAddressOf(const Variable& array, std::optional<long long> constantIndex, const std::string& indexRegister, GenerateData& generation)
+{
+    long long elementSize = ast::elementSizeOf(array.arrayDeclaration);
+    std::string base = "rbp";
+    long long displacement = array.elementsFrameOffset.value_or(0) + elementSize * constantIndex.value_or(0);
+    if(!array.elementsFrameOffset.has_value())
+    {
+        base = "rcx";
+        generation.code.emit("mov", { "rcx", utils::accessVariable(generation, array) });
+    }
+    if(!constantIndex.has_value())
+        base += " + " + indexRegister + (elementSize == 1 ? "" : "*" + std::to_string(elementSize));
+    return addressOf(base, displacement);
+}
+
+// Returns the memory operand of an element, like elementAddressOf
+static std::string elementOperandOf(const Variable& array, std::optional<long long> constantIndex, const std::string& indexRegister, GenerateData& generation)
+{
+    return (ast::elementSizeOf(array.arrayDeclaration) == 1 ? "BYTE " : "QWORD ") + elementAddressOf(array, constantIndex, indexRegister, generation);
+}
+
+std::optional<long long> Generator::generateIndex(const Variable& array, const ExpressionNode* index, GenerateData &generation)
+{
+    size_t length = array.arrayDeclaration->arrayLength.value();
+    bool isChecked = settings.checkBounds &&
+        !(generation.boundsCheckElimination.has_value() && generation.boundsCheckElimination.value().isInBounds(index, length));
+    std::optional<long long> constantIndex = ast::numberOf(index);
+    if(constantIndex.has_value() && constantIndex.value() >= 0 && constantIndex.value() < MAX_FOLDED_INDEX && (!isChecked || constantIndex.value() < (long long) length))
+        return constantIndex;
+
+    generateExpression("rax", index, generation);
+    if(isChecked)
+    {
+        // A negative index is a huge unsigned number, so a single comparison checks both bounds
+        generation.usesBoundsChecks = true;
+        if(length <= INT32_MAX)
+            generation.code.emit("cmp", { "rax", std::to_string(length) });
+        else
+        {
+            generation.code.emit("mov", { "rcx", std::to_string(length) });
+            generation.code.emit("cmp", { "rax", "rcx" });
+        }
+        generation.code.emit("jae", { runtime::INDEX_OUT_OF_BOUNDS });
+    }
+    return std::nullopt;
+}
+
+void Generator::generateElementAssignment(const StatementAssignVariableNode* statement, GenerateData &generation)
+{
+    std::optional<Variable> array = arrayVariableOf(statement->name, generation);
+    if(!array.has_value())
+        return;
+
+    std::optional<long long> constantIndex = generateIndex(array.value(), statement->index.value(), generation);
+    // The index waits in a temporary register while the value is computed, or on the stack if the value calls a function
+    std::string indexRegister = "rdx";
+    bool isIndexInTemporary = !constantIndex.has_value() && generation.usedTemporaryRegisters < TEMPORARY_REGISTERS.size() &&
+        !ast::containsFunctionCall(statement->value);
+    if(isIndexInTemporary)
+    {
+        indexRegister = TEMPORARY_REGISTERS[generation.usedTemporaryRegisters];
+        generation.code.emit("mov", { indexRegister, "rax" });
+        generation.usedTemporaryRegisters++;
+    }
+    else if(!constantIndex.has_value())
+        generation.pushOnStack("rax");
+
+    generateExpression("rax", statement->value, generation);
+    if(isIndexInTemporary)
+        generation.usedTemporaryRegisters--;
+    else if(!constantIndex.has_value())
+        generation.popFromStack(indexRegister);
+    std::string element = elementOperandOf(array.value(), constantIndex, indexRegister, generation);
+    generation.code.emit("mov", { element, ast::elementSizeOf(array.value().arrayDeclaration) == 1 ? "al" : "rax" });
+}
+
+void Generator::generateAsmMacro(const StatementMacroNode* statement, GenerateData &generation)
+{
+    std::string error;
+    std::optional<AsmMacro> macro = parseAsmMacro(statement, error);
+    if(!macro.has_value())
+    {
+        std::cerr << error << std::endl;
+        return;
+    }
+
+    // The operands with the `r` constraint get the scratch registers that aren't chosen by the user nor clobbered
+    std::vector<std::string> usedRegisters = macro->clobberedRegisters;
+    for(const AsmOperand& operand : macro->operands)
+        usedRegisters.push_back(operand.constraint);
+    std::vector<std::string> operandTexts;
+    auto freeRegister = ASM_SCRATCH_REGISTERS.begin();
+    for(const AsmOperand& operand : macro->operands)
+    {
+        if(operand.variableName.has_value())
+        {
+            const std::string& variableName = operand.variableName.value();
+            std::optional<Variable> variable = generation.getVariableByName(variableName);
+            if(!variable.has_value())
+            {
+                generation.errors.push_back(CodeGenerationError { .type = CodeGenerationErrorType::UndeclaredVariable, .hint = variableName });
+                return;
+            }
+            if(operand.type != AsmOperandType::Input && variable.value().hasElementsOnStack)
+            {
+                generation.errors.push_back(CodeGenerationError { .type = CodeGenerationErrorType::ArrayAssignment, .hint = variableName });
+                return;
+            }
+        }
+
+        if(operand.constraint != "r")
+        {
+            operandTexts.push_back(operand.constraint);
+            continue;
+        }
+        freeRegister = std::find_if(freeRegister, ASM_SCRATCH_REGISTERS.end(), [&](const std::string& registerName)
+        {
+            return std::find(usedRegisters.begin(), usedRegisters.end(), registerName) == usedRegisters.end();
+        });
+        if(freeRegister == ASM_SCRATCH_REGISTERS.end())
+        {
+            std::cerr << "The operands and the clobbers of the asm! macro need more than " << ASM_SCRATCH_REGISTERS.size() << " scratch registers" << std::endl;
+            return;
+        }
+        operandTexts.push_back(*freeRegister++);
+    }
+
+    // The registers that the functions must preserve are saved before the operands are loaded, so that the `m` operands
+    // are accessed with the final stack size
+    std::vector<std::string> savedRegisters;
+    for(const std::string& registerName : ASM_OPERAND_REGISTERS)
+    {
+        if(std::find(ASM_SCRATCH_REGISTERS.begin(), ASM_SCRATCH_REGISTERS.end(), registerName) == ASM_SCRATCH_REGISTERS.end() &&
+           std::find(usedRegisters.begin(), usedRegisters.end(), registerName) != usedRegisters.end())
+            savedRegisters.push_back(registerName);
+    }
+    generation.code.emitComment(ASM_MACRO_START);
+    for(const std::string& registerName : savedRegisters)
+        generation.pushOnStack(registerName);
+
+    // The inputs that need to be computed can use any register, so they wait on the stack until the others are computed
+    std::vector<size_t> computedInputs;
+    for(size_t i = 0; i < macro->operands.size(); i++)
+    {
+        const AsmOperand& operand = macro->operands[i];
+        if(operand.type == AsmOperandType::Input && operand.constraint != "m" && !operand.variableName.has_value() &&
+           !ast::numberOf(operand.value).has_value())
+        {
+            generateExpression("rax", operand.value, generation);
+            generation.pushOnStack("rax");
+            computedInputs.push_back(i);
+        }
+    }
+    for(auto input = computedInputs.rbegin(); input != computedInputs.rend(); input++)
+        generation.popFromStack(operandTexts[*input]);
+    for(size_t i = 0; i < macro->operands.size(); i++)
+    {
+        const AsmOperand& operand = macro->operands[i];
+        if(operand.constraint == "m")
+            operandTexts[i] = utils::accessVariable(generation, generation.getVariableByName(operand.variableName.value()).value());
+        else if(operand.type != AsmOperandType::Output && operand.variableName.has_value())
+            generation.code.emit("mov", { operandTexts[i], utils::accessVariable(generation, generation.getVariableByName(operand.variableName.value()).value()) });
+        else if(operand.type == AsmOperandType::Input && ast::numberOf(operand.value).has_value())
+            generation.code.emit("mov", { operandTexts[i], std::to_string(ast::numberOf(operand.value).value()) });
+    }
+
+    std::optional<std::string> code = substituteAsmOperands(macro.value(), operandTexts, error);
+    if(!code.has_value())
+    {
+        std::cerr << error << std::endl;
+        return;
+    }
+    generation.code.emitUserCode(code.value());
+
+    for(size_t i = 0; i < macro->operands.size(); i++)
+    {
+        const AsmOperand& operand = macro->operands[i];
+        if(operand.type != AsmOperandType::Input && operand.constraint != "m")
+            generation.code.emit("mov", { utils::accessVariable(generation, generation.getVariableByName(operand.variableName.value()).value()), operandTexts[i] });
+    }
+    for(auto savedRegister = savedRegisters.rbegin(); savedRegister != savedRegisters.rend(); savedRegister++)
+        generation.popFromStack(*savedRegister);
+    generation.code.emitComment(ASM_MACRO_END);
+}
+
+size_t Generator::analyzeStatements(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters,
+                                    GenerateData &generation)
+{
+    if(settings.optimizeLoops)
+    {
+        generation.loopInvariants.emplace(statements);
+        generation.loopUnrolling.emplace(statements, settings.loopUnrollFactor, settings.maxFullUnrollTripCount);
+    }
+    if(settings.optimizeLoops && settings.vectorizeLoops)
+    {
+        generation.loopVectorization.emplace(statements, parameters, settings.useAvx2 ? 32 : 16, &generation.loopUnrolling.value());
+        const auto& reports = generation.loopVectorization.value().getReports();
+        vectorizationReports.insert(vectorizationReports.end(), reports.begin(), reports.end());
+    }
+    if(settings.checkBounds && settings.eliminateBoundsChecks)
+        generation.boundsCheckElimination.emplace(statements);
+    size_t unrollingSlotsCount = generation.loopUnrolling.has_value() ? generation.loopUnrolling.value().getSlotsCount() : 0;
+    if(!settings.eliminateCommonSubexpressions)
+        return unrollingSlotsCount;
+
+    auto mayClobberMemory = [&generation](const std::string& functionName) { return generation.mayClobberMemory(functionName); };
+    generation.valueNumbering.emplace(statements, mayClobberMemory, generation.loopInvariants.has_value() ? &generation.loopInvariants.value() : nullptr);
+    return generation.valueNumbering.value().getSlotsCount() + unrollingSlotsCount;
+}
+
+void Generator::generateFramePrologue(size_t slotsCount, GenerateData &generation)
+{
+    generation.currentFrame = StackFrame { .slotsCount = slotsCount, .usedSlots = 0 };
+
+    // Keep `rsp` aligned to 16 bytes, as it is after `push rbp`
+    size_t frameSize = (slotsCount * 8 + 15) / 16 * 16;
+    if(frameSize != 0)
+        generation.code.emit("sub", { "rsp", std::to_string(frameSize) });
+}
+
+void Generator::generateReturn(GenerateData &generation)
+{
+    auto currentFunctionDefinition = generation.currentFunctionDefinition;
+    if(!currentFunctionDefinition.has_value())
+    {
+        runtime::generateExit("rax", *target, generation);
+        return;
+    }
+
+    if(currentFunctionDefinition.value().callingConvention == CallingConvention::Registers)
+    {
+        generation.code.emit("mov", { "rsp", "rbp" });
+        generation.code.emit("pop", { "rbp" });
+        generation.code.emit("ret");
+        return;
+    }
+
+    auto parametersCount = currentFunctionDefinition.value().parametersCount;
+    // Bytes between `rsp` and the return address
+    size_t returnAddressOffset = 8 * (generation.stackSize - currentFunctionDefinition.value().scope->startStackPtr - RETURN_ADDRESS_SIZE - parametersCount);
+
+    // The returned value replaces the parameters on the stack, and the caller pops it
+    long long stackAdjustment = returnAddressOffset + 8 * (long long) parametersCount - 8;
+    generation.code.emit("mov", { "rcx", "QWORD [rsp + " + std::to_string(returnAddressOffset) + "]" });
+    if(stackAdjustment > 0)
+        generation.code.emit("add", { "rsp", std::to_string(stackAdjustment) });
+    else if(stackAdjustment < 0)
+        generation.code.emit("sub", { "rsp", std::to_string(-stackAdjustment) });
+    generation.code.emit("mov", { "QWORD [rsp + 8]", "rax" });
+    generation.code.emit("mov", { "QWORD [rsp]", "rcx" });
+    generation.code.emit("ret");
+}
+
+bool Generator::generateTailCall(const StatementReturnNode* statement, GenerateData &generation)
+{
+    auto currentFunctionDefinition = generation.currentFunctionDefinition;
+    if(!currentFunctionDefinition.has_value() || currentFunctionDefinition.value().callingConvention != CallingConvention::Registers ||
+       currentFunctionDefinition.value().hasStackArrays)
+        return false;
+    auto call = tailCallOf(statement);
+    if(call == nullptr || evaluatedValueOf(call, generation).has_value())
+        return false;
+    const std::string& functionName = call->functionName->ident.value.value();
+    if(generation.getCallingConvention(functionName) != CallingConvention::Registers)
+        return false;
+
+    auto argumentsCount = call->arguments.size();
+    const FunctionDefinition& function = currentFunctionDefinition.value();
+    if(functionName == function.name && argumentsCount == function.parametersCount && function.tailRecursionLabel.has_value())
+    {
+        // All the arguments are evaluated before overwriting the parameters, because they can read them
+        generation.code.emitComment("Tail recursion");
+        for(auto argument : call->arguments)
+        {
+            generateExpression("rax", argument, generation);
+            generation.pushOnStack("rax");
+        }
+        for(int i = argumentsCount - 1; i >= 0; i--)
+        {
+            generation.popFromStack("rax");
+            auto parameter = generation.getVariableByName(function.parameterNames[i]).value();
+            generation.code.emit("mov", { utils::accessVariable(generation, parameter), "rax" });
+        }
+        generation.code.emit("jmp", { function.tailRecursionLabel.value() });
+        registerFunctionCall(call, generation);
+        return true;
+    }
+
+    // The arguments passed on the stack would have to replace the ones of the current function
+    if(argumentsCount > ARGUMENT_REGISTERS.size())
+        return false;
+
+    generation.code.emitComment("Tail call");
+    for(auto argument : call->arguments)
+    {
+        generateExpression("rax", argument, generation);
+        generation.pushOnStack("rax");
+    }
+    for(int i = argumentsCount - 1; i >= 0; i--)
+        generation.popFromStack(ARGUMENT_REGISTERS[i]);
+    // The called function returns directly to the caller of the current function
+    generation.code.emit("mov", { "rsp", "rbp" });
+    generation.code.emit("pop", { "rbp" });
+    generation.code.emit("jmp", { utils::internalFunctionLabel(functionName) });
+    registerFunctionCall(call, generation);
+    return true;
+}
+
+void Generator::generateAbiWrapper(const std::string& functionName, size_t parametersCount, GenerateData &generation)
+{
+    generation.code.emitLabel(functionName);
+    generation.functions.push_back(FunctionSymbol { .name = functionName, .endLabel = utils::internalFunctionLabel(functionName) });
+    generation.code.emitComment("Windows x64 entry point of `" + functionName + "`");
+    // `rbx` must be preserved for the caller, but the function can overwrite it
+    generation.code.emit("push", { "rbx" });
+    // The arguments after the 4th are above the shadow space of the caller, and they are pushed again in the order expected by the function
+    for(size_t i = ARGUMENT_REGISTERS.size(); i < parametersCount; i++)
+        generation.code.emit("push", { "QWORD [rsp + " + std::to_string(8 + 8 + SHADOW_SPACE_SIZE + 16 * (i - ARGUMENT_REGISTERS.size())) + "]" });
+    generation.code.emit("call", { utils::internalFunctionLabel(functionName) });
+    if(parametersCount > ARGUMENT_REGISTERS.size())
+        generation.code.emit("add", { "rsp", std::to_string(8 * (parametersCount - ARGUMENT_REGISTERS.size())) });
+    generation.code.emit("pop", { "rbx" });
+    generation.code.emit("ret");
+}
+
 void Generator::generateStatementScope(const StatementScopeNode* statement, GenerateData &generation)
 {
     generation.enterScope();
@@ -371,10 +1041,10 @@ void Generator::generateExpressionAtom(const std::string& registerName, const Ex
             if(expression->literal.type == TokenType::LiteralString)
             {
                 std::string stringLiteralName = generation.defineStringLiteral(expression->literal.value.value());
-                generation.output << TAB << "mov " << registerName << ", " << stringLiteralName << NEW_LINE;
+                generation.code.emit("mov", { registerName, stringLiteralName });
             }
             else
-                generation.output << TAB << "mov " << registerName << ", " << expression->literal.value.value() << NEW_LINE;
+                generation.code.emit("mov", { registerName, expression->literal.value.value() });
         }
         void operator()(const ExpressionIdentNode* expression)
         {
@@ -390,38 +1060,69 @@ void Generator::generateExpressionAtom(const std::string& registerName, const Ex
                 return;
             }
             
-            generation.output << TAB << "mov " << registerName << ", " << utils::accessVariable(generation, variable.value()) << NEW_LINE;
+            generation.code.emit("mov", { registerName, utils::accessVariable(generation, variable.value()) });
         }
         void operator()(const ExpressionBracketsNode* expression)
         {
             generator.generateExpression(registerName, expression->expression, generation);
         }
+        void operator()(const ExpressionIndexNode* expression)
+        {
+            std::optional<Variable> array = arrayVariableOf(expression->array, generation);
+            if(!array.has_value())
+                return;
+
+            std::optional<long long> constantIndex = generator.generateIndex(array.value(), expression->index, generation);
+            std::string element = elementOperandOf(array.value(), constantIndex, "rax", generation);
+            generation.code.emit(ast::elementSizeOf(array.value().arrayDeclaration) == 1 ? "movzx" : "mov", { registerName, element });
+        }
         void operator()(const ExpressionFunctionCallNode* expression)
         {
+            if(auto value = evaluatedValueOf(expression, generation))
+            {
+                generation.code.emit("mov", { registerName, std::to_string(value.value()) });
+                return;
+            }
             auto functionName = expression->functionName->ident.value.value();
-            for(int i = 0; i < expression->arguments.size(); i++)
+            auto argumentsCount = expression->arguments.size();
+            for(size_t i = 0; i < argumentsCount; i++)
             {
-                //generation.output << TAB << "; Passing the " << (i + 1) << (i == 0 ? "st" : i == 1 ? "nd" :  i == 2 ? "rd" : "th") << " argument to the function `" << functionName << "`" << NEW_LINE;
+                //generation.code.emitComment("Passing the " << (i + 1) << (i == 0 ? "st" : i == 1 ? "nd" :  i == 2 ? "rd" : "th") << " argument to the function `" << functionName << "`" << NEW_LINE;
                 generator.generateExpression("rax", expression->arguments[i], generation);
                 generation.pushOnStack("rax");
             }
-            generation.output << TAB << "call " << functionName << NEW_LINE;
-            generation.popFromStack("rax");
-            generation.stackSize -= expression->arguments.size() - 1;
-            
-            // TODO:
-            // Also the memory of `temporary` is never deallocated
-            StatementDeclareVariableNode* temporary = new StatementDeclareVariableNode(StatementDeclareVariableNode
+            if(generation.getCallingConvention(functionName) == CallingConvention::Registers)
             {
-                .type = new ExpressionIdentNode(ExpressionIdentNode {.ident = Token { .type = TokenType::Unknown, .value = std::nullopt }}),
-                .name = new ExpressionIdentNode(ExpressionIdentNode {.ident = Token { .type = TokenType::Unknown, .value = std::nullopt }}),
-            });
-            auto parameters = std::vector<StatementDeclareVariableNode*>(expression->arguments.size(), temporary);
-            generation.callFunction(Function 
+                // The arguments are moved in the registers only after all of them have been evaluated,
+                // because evaluating an argument can overwrite them
+                if(argumentsCount <= ARGUMENT_REGISTERS.size())
+                {
+                    for(int i = argumentsCount - 1; i >= 0; i--)
+                        generation.popFromStack(ARGUMENT_REGISTERS[i]);
+                }
+                else
+                {
+                    for(size_t i = 0; i < ARGUMENT_REGISTERS.size(); i++)
+                        generation.code.emit("mov", { ARGUMENT_REGISTERS[i], "QWORD [rsp + " + std::to_string(8 * (argumentsCount - i - 1)) + "]" });
+                }
+                if(!runtime::generateInlineIntrinsic(expression, generation))
+                    generation.code.emit("call", { utils::internalFunctionLabel(functionName) });
+                if(argumentsCount > ARGUMENT_REGISTERS.size())
+                {
+                    generation.code.emit("add", { "rsp", std::to_string(8 * argumentsCount) });
+                    generation.stackSize -= argumentsCount;
+                }
+                if(registerName != "rax")
+                    generation.code.emit("mov", { registerName, "rax" });
+            }
+            else
             {
-                .name = functionName,
-                .parameters = parameters
-            });
+                generation.code.emit("call", { functionName });
+                generation.popFromStack(registerName);
+                generation.stackSize -= argumentsCount - 1;
+            }
+
+            registerFunctionCall(expression, generation);
         }
     };
 
@@ -429,17 +1130,699 @@ void Generator::generateExpressionAtom(const std::string& registerName, const Ex
     std::visit(visitor, expression->variant);
 }
 
-static void generateComparison(const std::string& jumpInstruction, GenerateData &generation)
+/**
+ * @brief Get the condition code (the suffix of `jcc` and `setcc`) that is true when the comparison is true.
+ * @return The condition code, or std::nullopt if the operator isn't a comparison.
+ */
+static std::optional<std::string> conditionCodeOf(Operator operation)
+{
+    switch(operation)
+    {
+        case Operator::GreaterThan:
+            return "g";
+        case Operator::LessThan:
+            return "l";
+        case Operator::EqualTo:
+            return "e";
+        case Operator::NotEqualTo:
+            return "ne";
+        default:
+            return std::nullopt;
+    }
+}
+
+/**
+ * @brief Get the condition code that is true when the comparison is false.
+ * @return The condition code, or std::nullopt if the operator isn't a comparison.
+ */
+static std::optional<std::string> inverseConditionCodeOf(Operator operation)
+{
+    switch(operation)
+    {
+        case Operator::GreaterThan:
+            return "le";
+        case Operator::LessThan:
+            return "ge";
+        case Operator::EqualTo:
+            return "ne";
+        case Operator::NotEqualTo:
+            return "e";
+        default:
+            return std::nullopt;
+    }
+}
+
+// Sets `rax` to 1 if the comparison between `rax` and the operand is true, else to 0
+static void generateComparison(Operator operation, const std::string& rhsOperand, GenerateData &generation)
+{
+    generation.code.emit("cmp", { "rax", rhsOperand });
+    generation.code.emit("set" + *conditionCodeOf(operation), { "al" });
+    generation.code.emit("movzx", { "rax", "al" });
+}
+
+// Returns the value of the expression if it's a number literal (or a call computed while compiling) that fits in the immediate operand of an instruction
+static std::optional<long long> immediateOf(const ExpressionNode* expression, GenerateData& generation)
+{
+    auto value = ast::numberOf(expression);
+    auto atom = std::get_if<ExpressionAtomNode*>(&ast::skipBrackets(expression)->variant);
+    if(!value.has_value() && atom != nullptr && std::holds_alternative<ExpressionFunctionCallNode*>((*atom)->variant))
+        value = evaluatedValueOf(std::get<ExpressionFunctionCallNode*>((*atom)->variant), generation);
+    // Like the literals, the negative values aren't immediates: the division by a constant treats its divisor as unsigned
+    if(!value.has_value() || value.value() > INT32_MAX || value.value() < 0)
+        return std::nullopt;
+    return value;
+}
+
+// Returns the variable if the expression is just the name of a declared variable
+static std::optional<Variable> variableOf(const ExpressionNode* expression, GenerateData& generation)
+{
+    auto variableName = ast::variableNameOf(expression);
+    if(!variableName.has_value())
+        return std::nullopt;
+    return generation.getVariableByName(variableName.value());
+}
+
+// Returns `log2(value)` if the value is a power of 2
+static std::optional<unsigned int> powerOfTwoExponent(unsigned long long value)
+{
+    if(value == 0 || (value & (value - 1)) != 0)
+        return std::nullopt;
+    return std::countr_zero(value);
+}
+
+static void generateMultiplicationByConstant(long long multiplier, GenerateData& generation)
+{
+    if(multiplier == 0)
+        generation.code.emit("mov", { "rax", "0" });
+    else if(multiplier == 1)
+        return;
+    else if(auto exponent = powerOfTwoExponent(multiplier))
+        generation.code.emit("shl", { "rax", std::to_string(exponent.value()) });
+    else if(multiplier == 3 || multiplier == 5 || multiplier == 9)
+        generation.code.emit("lea", { "rax", "[rax + rax*" + std::to_string(multiplier - 1) + "]" });
+    else
+        generation.code.emit("imul", { "rax", "rax", std::to_string(multiplier) });
+}
+
+// Division is unsigned, like the `div` instruction used for non constant divisors
+static void generateDivisionByConstant(long long divisor, GenerateData& generation)
+{
+    if(divisor == 1)
+        return;
+    else if(divisor == 0)
+    {
+        // Keep the division error of the `div` instruction
+        generation.code.emit("xor", { "edx", "edx" });
+        generation.code.emit("mov", { "rbx", "0" });
+        generation.code.emit("div", { "rbx" });
+    }
+    else if(auto exponent = powerOfTwoExponent(divisor))
+        generation.code.emit("shr", { "rax", std::to_string(exponent.value()) });
+    else
+    {
+        utils::UnsignedDivisionMagic magic = utils::computeUnsignedDivisionMagic(divisor);
+        generation.code.emitComment("Division by " + std::to_string(divisor) + " through a multiplication");
+        if(magic.needsAddition)
+            generation.code.emit("mov", { "rcx", "rax" });
+        generation.code.emit("mov", { "rbx", std::to_string(magic.multiplier) });
+        generation.code.emit("mul", { "rbx" });
+        if(magic.needsAddition)
+        {
+            generation.code.emit("sub", { "rcx", "rdx" });
+            generation.code.emit("shr", { "rcx", "1" });
+            generation.code.emit("add", { "rcx", "rdx" });
+            generation.code.emit("mov", { "rax", "rcx" });
+        }
+        else
+            generation.code.emit("mov", { "rax", "rdx" });
+        if(magic.shift != 0)
+            generation.code.emit("shr", { "rax", std::to_string(magic.shift) });
+    }
+}
+
+// The slots of the reused values are the last ones of the frame, after the ones of the variables
+static Variable valueNumberingSlot(size_t slot, GenerateData& generation)
+{
+    size_t firstSlot = generation.currentFrame.value().slotsCount - generation.valueNumbering.value().getSlotsCount();
+    return Variable { .stackPtr = 0, .frameOffset = -8 * static_cast<long long>(firstSlot + slot + 1) };
+}
+
+// Returns the slot that already contains the value of an expression, computed before the loop or by a previous computation
+static std::optional<Variable> savedValueOf(const ExpressionNode* expression, GenerateData& generation)
+{
+    auto hoisted = generation.hoistedExpressions.find(expression);
+    if(hoisted != generation.hoistedExpressions.end())
+        return hoisted->second;
+    if(generation.valueNumbering.has_value() && generation.currentFrame.has_value())
+    {
+        if(auto slot = generation.valueNumbering.value().getReusedSlot(expression))
+            return valueNumberingSlot(slot.value(), generation);
+    }
+    return std::nullopt;
+}
+
+// Checks if an expression contains a computation whose result is saved for later or read from a previous one
+static bool isValueNumbered(const ExpressionNode* expression, GenerateData& generation)
+{
+    if(!generation.valueNumbering.has_value())
+        return false;
+    expression = ast::skipBrackets(expression);
+    if(generation.valueNumbering.value().getSavedSlot(expression).has_value() || generation.valueNumbering.value().getReusedSlot(expression).has_value())
+        return true;
+    if(!std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+        return false;
+    auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+    return isValueNumbered(binary->lhs, generation) || isValueNumbered(binary->rhs, generation);
+}
+
+// The number of registers needed to compute an expression without pushing any value on the stack (Sethi-Ullman number)
+static size_t registerNeedOf(const ExpressionNode* expression, GenerateData& generation)
+{
+    expression = ast::skipBrackets(expression);
+    if(!std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant) || savedValueOf(expression, generation).has_value())
+        return 1;
+    auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+    size_t lhsNeed = registerNeedOf(binary->lhs, generation);
+    // A constant or a variable on the right side is used directly as the operand of the instruction
+    if(immediateOf(binary->rhs, generation).has_value() || variableOf(binary->rhs, generation).has_value() || savedValueOf(ast::skipBrackets(binary->rhs), generation).has_value())
+        return lhsNeed;
+    size_t rhsNeed = registerNeedOf(binary->rhs, generation);
+    return lhsNeed == rhsNeed ? lhsNeed + 1 : std::max(lhsNeed, rhsNeed);
+}
+
+std::string Generator::generateBinaryOperands(const ExpressionBinaryOperatorNode* expression, GenerateData& generation)
+{
+    // A constant or a variable on the right side is used directly as the operand of the instruction
+    if(auto immediate = immediateOf(expression->rhs, generation))
+    {
+        generateExpression("rax", expression->lhs, generation);
+        return std::to_string(immediate.value());
+    }
+    if(auto variable = variableOf(expression->rhs, generation))
+    {
+        generateExpression("rax", expression->lhs, generation);
+        return utils::accessVariable(generation, variable.value());
+    }
+    if(auto savedRhs = savedValueOf(ast::skipBrackets(expression->rhs), generation))
+    {
+        generateExpression("rax", expression->lhs, generation);
+        return utils::accessVariable(generation, savedRhs.value());
+    }
+
+    // Sethi-Ullman ordering: the operand that needs more registers is computed first, while no other value is waiting
+    bool canReorder = !ast::containsFunctionCall(expression->lhs) && !ast::containsFunctionCall(expression->rhs) &&
+        !isValueNumbered(expression->lhs, generation) && !isValueNumbered(expression->rhs, generation);
+    bool isRhsFirst = canReorder && registerNeedOf(expression->rhs, generation) > registerNeedOf(expression->lhs, generation);
+    const ExpressionNode* first = isRhsFirst ? expression->rhs : expression->lhs;
+    const ExpressionNode* second = isRhsFirst ? expression->lhs : expression->rhs;
+
+    generateExpression("rax", first, generation);
+    // A called function can overwrite the temporary registers
+    if(generation.usedTemporaryRegisters < TEMPORARY_REGISTERS.size() && !ast::containsFunctionCall(second))
+    {
+        const std::string& temporary = TEMPORARY_REGISTERS[generation.usedTemporaryRegisters];
+        generation.code.emit("mov", { temporary, "rax" });
+        generation.usedTemporaryRegisters++;
+        if(isRhsFirst)
+        {
+            generateExpression("rax", second, generation);
+            generation.usedTemporaryRegisters--;
+            return temporary;
+        }
+        generateExpression("rbx", second, generation);
+        generation.usedTemporaryRegisters--;
+        generation.code.emit("mov", { "rax", temporary });
+        return "rbx";
+    }
+
+    generation.pushOnStack("rax");
+    if(isRhsFirst)
+    {
+        generateExpression("rax", second, generation);
+        generation.popFromStack("rbx");
+        return "rbx";
+    }
+    generateExpression("rbx", second, generation);
+    generation.popFromStack("rax");
+    return "rbx";
+}
+
+void Generator::generateBinaryOperation(const ExpressionBinaryOperatorNode* expression, GenerateData& generation)
+{
+    Operator operation = expression->operation;
+    bool isCommutative = operation == Operator::Add || operation == Operator::Mul;
+    // `2 * x` is generated like `x * 2`: the literal has no side effects, so the evaluation order doesn't matter
+    if(isCommutative && immediateOf(expression->lhs, generation).has_value() && !immediateOf(expression->rhs, generation).has_value())
+    {
+        ExpressionBinaryOperatorNode swapped = { .lhs = expression->rhs, .rhs = expression->lhs, .operation = operation };
+        generateBinaryOperation(&swapped, generation);
+        return;
+    }
+
+    std::optional<long long> immediate = immediateOf(expression->rhs, generation);
+    if(operation == Operator::Mul && immediate.has_value())
+    {
+        generateExpression("rax", expression->lhs, generation);
+        generateMultiplicationByConstant(immediate.value(), generation);
+        return;
+    }
+    if(operation == Operator::Div && immediate.has_value())
+    {
+        generateExpression("rax", expression->lhs, generation);
+        generateDivisionByConstant(immediate.value(), generation);
+        return;
+    }
+    if(operation == Operator::Add)
+    {
+        // `a + b * 4` becomes a single `lea`
+        auto rhs = ast::skipBrackets(expression->rhs);
+        bool isRhsSaved = savedValueOf(rhs, generation).has_value() ||
+            (generation.valueNumbering.has_value() && generation.valueNumbering.value().getSavedSlot(rhs).has_value());
+        if(std::holds_alternative<ExpressionBinaryOperatorNode*>(rhs->variant) && !isRhsSaved)
+        {
+            auto scaled = std::get<ExpressionBinaryOperatorNode*>(rhs->variant);
+            auto scale = immediateOf(scaled->rhs, generation);
+            auto scaledVariable = variableOf(scaled->lhs, generation);
+            if(scaled->operation == Operator::Mul && scaledVariable.has_value() && (scale == 2 || scale == 4 || scale == 8))
+            {
+                generateExpression("rax", expression->lhs, generation);
+                generation.code.emit("mov", { "rbx", utils::accessVariable(generation, scaledVariable.value()) });
+                generation.code.emit("lea", { "rax", "[rax + rbx*" + std::to_string(scale.value()) + "]" });
+                return;
+            }
+        }
+    }
+
+    if(operation == Operator::And || operation == Operator::Or)
+    {
+        // The value is materialized only when the operation isn't the condition of an `if` or a `while`
+        auto falseLabel = generation.generateLabel();
+        auto endLabel = generation.generateLabel();
+        generateShortCircuitJump(expression, falseLabel, false, generation);
+        generation.code.emit("mov", { "eax", "1" });
+        generation.code.emit("jmp", { endLabel });
+        generation.code.emitLabel(falseLabel);
+        generation.code.emit("xor", { "eax", "eax" });
+        generation.code.emitLabel(endLabel);
+        return;
+    }
+
+    std::string rhsOperand = generateBinaryOperands(expression, generation);
+    switch(operation)
+    {
+        case Operator::Add:
+            if(rhsOperand != "0")
+                generation.code.emit("add", { "rax", rhsOperand });
+            break;
+        case Operator::Sub:
+            if(rhsOperand != "0")
+                generation.code.emit("sub", { "rax", rhsOperand });
+            break;
+        case Operator::Mul:
+            // Only the low 64 bits are kept, so the signed multiplication gives the same result and doesn't touch `rdx`
+            generation.code.emit("imul", { "rax", rhsOperand });
+            break;
+        case Operator::Div:
+            generation.code.emit("xor", { "edx", "edx" });
+            generation.code.emit("div", { rhsOperand });
+            break;
+        case Operator::GreaterThan:
+        case Operator::LessThan:
+        case Operator::EqualTo:
+        case Operator::NotEqualTo:
+            generateComparison(operation, rhsOperand, generation);
+            break;
+        case Operator::And:
+        case Operator::Or:
+            break;
+    }
+}
+
+void Generator::generateShortCircuitJump(const ExpressionBinaryOperatorNode* expression, const std::string& label, bool jumpIfTrue, GenerateData& generation)
+{
+    // `a || b` jumps when it's true as soon as one of the operands is true, and `a && b` jumps when it's false as soon as one is false
+    bool isOr = expression->operation == Operator::Or;
+    if(jumpIfTrue == isOr)
+    {
+        generateConditionalJump(expression->lhs, label, jumpIfTrue, generation);
+        generateConditionalJump(expression->rhs, label, jumpIfTrue, generation);
+        return;
+    }
+
+    // Otherwise the left operand can only decide that the jump isn't taken, and skips the right one
+    auto skipLabel = generation.generateLabel();
+    generateConditionalJump(expression->lhs, skipLabel, !jumpIfTrue, generation);
+    generateConditionalJump(expression->rhs, label, jumpIfTrue, generation);
+    generation.code.emitLabel(skipLabel);
+}
+
+void Generator::generateConditionalJump(const ExpressionNode* condition, const std::string& label, bool jumpIfTrue, GenerateData& generation)
+{
+    condition = ast::skipBrackets(condition);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(condition->variant) && !generation.hoistedExpressions.contains(condition))
+    {
+        auto comparison = std::get<ExpressionBinaryOperatorNode*>(condition->variant);
+        if(comparison->operation == Operator::And || comparison->operation == Operator::Or)
+        {
+            generateShortCircuitJump(comparison, label, jumpIfTrue, generation);
+            return;
+        }
+        // `value == 0` (like `!value`) and `value != 0` jump on the value itself, so that `!(a && b)` is short-circuited too
+        if((comparison->operation == Operator::EqualTo || comparison->operation == Operator::NotEqualTo) && immediateOf(comparison->rhs, generation) == 0 &&
+           std::holds_alternative<ExpressionBinaryOperatorNode*>(ast::skipBrackets(comparison->lhs)->variant))
+        {
+            generateConditionalJump(comparison->lhs, label, jumpIfTrue == (comparison->operation == Operator::NotEqualTo), generation);
+            return;
+        }
+        if(auto conditionCode = conditionCodeOf(comparison->operation))
+        {
+            // The flags of the comparison are used directly, without materializing its value
+            std::string rhsOperand = generateBinaryOperands(comparison, generation);
+            generation.code.emit("cmp", { "rax", rhsOperand });
+            generation.code.emit("j" + (jumpIfTrue ? conditionCode.value() : *inverseConditionCodeOf(comparison->operation)), { label });
+            return;
+        }
+    }
+
+    generateExpression("rax", condition, generation);
+    generation.code.emit("test", { "rax", "rax" });
+    generation.code.emit(jumpIfTrue ? "jnz" : "jz", { label });
+}
+
+void Generator::generateWhileLoop(const StatementWhileNode* statement, GenerateData& generation)
+{
+    auto startLoopLabel = generation.generateLabel();
+    auto endLoopLabel = generation.generateLabel();
+    if(!settings.optimizeLoops)
+    {
+        generation.code.emitLabel(startLoopLabel);
+        generateConditionalJump(statement->condition, endLoopLabel, false, generation);
+        generateStatementScope(statement->scope, generation);
+        generation.code.emit("jmp", { startLoopLabel });
+        generation.code.emitLabel(endLoopLabel);
+        return;
+    }
+
+    const LoopUnrollingPlan* unrolling = generation.loopUnrolling.has_value() ? generation.loopUnrolling.value().getPlan(statement) : nullptr;
+    if(unrolling != nullptr && unrolling->fullUnrollTripCount.has_value())
+    {
+        generation.code.emitComment("Loop unrolled " + std::to_string(unrolling->fullUnrollTripCount.value()) + " times");
+        for(long long i = 0; i < unrolling->fullUnrollTripCount.value(); i++)
+            generateStatementScope(statement->scope, generation);
+        return;
+    }
+
+    // The loop is rotated: the condition is checked once before entering it, and then at the end of every iteration
+    generateConditionalJump(statement->condition, endLoopLabel, false, generation);
+    generation.enterScope();
+    generateLoopPreheader(statement, generation);
+    const VectorizedLoop* vectorization = generation.loopVectorization.has_value() ? generation.loopVectorization.value().getVectorizedLoop(statement) : nullptr;
+    if(vectorization != nullptr)
+    {
+        // The scalar loop runs the iterations left over by the vector loop
+        generateVectorizedLoop(*vectorization, generation);
+        generateConditionalJump(statement->condition, endLoopLabel, false, generation);
+    }
+    else if(unrolling != nullptr)
+    {
+        // The unrolled loop runs while there are enough iterations left, and the remainder loop runs the others
+        auto startUnrolledLoopLabel = generation.generateLabel();
+        auto remainderLabel = generation.generateLabel();
+        if(unrolling->unrolledBoundVariable.has_value())
+        {
+            // The bound doesn't change in the loop, so `bound - offset` is computed once, and if it overflows
+            // there can't be enough iterations left for the unrolled loop
+            generateExpression("rax", unrolling->bound, generation);
+            generation.code.emit("sub", { "rax", std::to_string(unrolling->offset) });
+            generation.code.emit("jo", { remainderLabel });
+            generation.defineVariable(unrolling->unrolledBoundVariable.value());
+            generation.code.emit("mov", { utils::accessVariable(generation, generation.getVariableByName(unrolling->unrolledBoundVariable.value()).value()), "rax" });
+        }
+        generateConditionalJump(unrolling->unrolledCondition, remainderLabel, false, generation);
+        generation.code.emitLabel(startUnrolledLoopLabel);
+        generation.code.emitComment("Loop unrolled by " + std::to_string(unrolling->factor));
+        for(size_t i = 0; i < unrolling->factor; i++)
+            generateStatementScope(statement->scope, generation);
+        generateConditionalJump(unrolling->unrolledCondition, startUnrolledLoopLabel, true, generation);
+        generation.code.emitLabel(remainderLabel);
+        generateConditionalJump(statement->condition, endLoopLabel, false, generation);
+    }
+    generation.code.emitLabel(startLoopLabel);
+    generateStatementScope(statement->scope, generation);
+    generateConditionalJump(statement->condition, startLoopLabel, true, generation);
+    if(generation.loopInvariants.has_value())
+    {
+        for(auto hoistedExpression : generation.loopInvariants.value().getHoistedExpressions(statement))
+            generation.hoistedExpressions.erase(hoistedExpression);
+    }
+    generation.exitScope();
+    generation.code.emitLabel(endLoopLabel);
+}
+
+void Generator::generateLoopPreheader(const StatementWhileNode* statement, GenerateData& generation)
+{
+    if(!generation.loopInvariants.has_value() || !generation.currentFrame.has_value())
+        return;
+
+    const auto& hoistedExpressions = generation.loopInvariants.value().getHoistedExpressions(statement);
+    for(size_t i = 0; i < hoistedExpressions.size(); i++)
+    {
+        generation.code.emitComment("Loop invariant");
+        generateExpression("rax", hoistedExpressions[i], generation);
+        // The name can't be used by a variable of the program
+        std::string slotName = "loop invariant " + std::to_string(generation.hoistedExpressions.size());
+        generation.defineVariable(slotName);
+        Variable slot = generation.getVariableByName(slotName).value();
+        generation.code.emit("mov", { utils::accessVariable(generation, slot), "rax" });
+        generation.hoistedExpressions[hoistedExpressions[i]] = slot;
+    }
+}
+
+std::string Generator::vectorRegister(size_t index) const
+{
+    return (settings.useAvx2 ? "ymm" : "xmm") + std::to_string(index);
+}
+
+// Compares `i + lanesCount - 1` with the bound of a vectorized loop, and jumps if a whole vector of iterations is left (or isn't)
+static void generateVectorLoopCondition(const VectorizedLoop& loop, const std::string& label, bool jumpIfTrue, GenerateData& generation)
+{
+    generation.code.emit("mov", { "rax", utils::accessVariable(generation, generation.getVariableByName(loop.inductionVariable).value()) });
+    generation.code.emit("add", { "rax", std::to_string(loop.lanesCount - 1) });
+    std::optional<long long> bound = ast::numberOf(loop.bound);
+    if(bound.has_value() && (bound.value() < INT32_MIN || bound.value() > INT32_MAX))
+    {
+        generation.code.emit("mov", { "rcx", std::to_string(bound.value()) });
+        generation.code.emit("cmp", { "rax", "rcx" });
+    }
+    else if(bound.has_value())
+        generation.code.emit("cmp", { "rax", std::to_string(bound.value()) });
+    else
+        generation.code.emit("cmp", { "rax", utils::accessVariable(generation, generation.getVariableByName(ast::variableNameOf(loop.bound).value()).value()) });
+    generation.code.emit(jumpIfTrue ? "jl" : "jge", { label });
+}
+
+void Generator::generateVectorizedLoop(const VectorizedLoop& loop, GenerateData& generation)
+{
+    auto scalarLoopLabel = generation.generateLabel();
+    auto vectorLoopLabel = generation.generateLabel();
+    bool isByteLoop = loop.elementSize == 1;
+    std::string inductionVariable = utils::accessVariable(generation, generation.getVariableByName(loop.inductionVariable).value());
+    generation.code.emitComment("Loop vectorized in " + std::to_string(loop.lanesCount) + " lanes");
+
+    // The vector loop runs only if all its indices are in the bounds (from `i >= 0` to `bound <= length`),
+    // otherwise the scalar loop reaches the invalid index after running the same iterations
+    std::optional<size_t> checkedLength;
+    for(const auto& [arrayName, index] : loop.accesses)
+    {
+        size_t length = generation.getVariableByName(arrayName).value().arrayDeclaration->arrayLength.value();
+        bool isChecked = settings.checkBounds &&
+            !(generation.boundsCheckElimination.has_value() && generation.boundsCheckElimination.value().isInBounds(index, length));
+        if(isChecked)
+            checkedLength = std::min(checkedLength.value_or(length), length);
+    }
+    if(checkedLength.has_value())
+    {
+        generation.code.emit("cmp", { inductionVariable, "0" });
+        generation.code.emit("jl", { scalarLoopLabel });
+        generateExpression("rax", loop.bound, generation);
+        if(checkedLength.value() <= INT32_MAX)
+            generation.code.emit("cmp", { "rax", std::to_string(checkedLength.value()) });
+        else
+        {
+            generation.code.emit("mov", { "rcx", std::to_string(std::min<size_t>(checkedLength.value(), INT64_MAX)) });
+            generation.code.emit("cmp", { "rax", "rcx" });
+        }
+        generation.code.emit("jg", { scalarLoopLabel });
+    }
+
+    // Two arrays share the elements of a vector iteration if their addresses are closer than a vector, but aren't the same
+    size_t vectorSize = loop.lanesCount * loop.elementSize;
+    for(const auto& [first, second] : loop.aliasChecks)
+    {
+        auto sameElementsLabel = generation.generateLabel();
+        generation.code.emit("mov", { "rax", utils::accessVariable(generation, generation.getVariableByName(first).value()) });
+        generation.code.emit("sub", { "rax", utils::accessVariable(generation, generation.getVariableByName(second).value()) });
+        generation.code.emit("jz", { sameElementsLabel });
+        generation.code.emit("add", { "rax", std::to_string(vectorSize - 1) });
+        generation.code.emit("cmp", { "rax", std::to_string(2 * vectorSize - 2) });
+        generation.code.emit("jbe", { scalarLoopLabel });
+        generation.code.emitLabel(sameElementsLabel);
+    }
+    generateVectorLoopCondition(loop, scalarLoopLabel, false, generation);
+
+    // The registers are the accumulators of the reductions, then the invariants, then the zeros needed by `psadbw`, then the temporary ones
+    size_t nextRegister = 0;
+    std::vector<size_t> accumulatorRegisters;
+    for(const VectorStatement& statement : loop.statements)
+    {
+        if(!statement.isReduction)
+            continue;
+        accumulatorRegisters.push_back(nextRegister);
+        std::string accumulator = vectorRegister(nextRegister++);
+        if(settings.useAvx2)
+            generation.code.emit("vpxor", { accumulator, accumulator, accumulator });
+        else
+            generation.code.emit("pxor", { accumulator, accumulator });
+    }
+    std::unordered_map<const ExpressionNode*, size_t> invariantRegisters;
+    for(const ExpressionNode* invariant : loop.invariants)
+    {
+        generateExpression("rax", invariant, generation);
+        if(isByteLoop)
+        {
+            // The multiplication copies the lowest byte in the other 7 bytes
+            generation.code.emit("movzx", { "eax", "al" });
+            generation.code.emit("mov", { "rcx", "0x0101010101010101" });
+            generation.code.emit("imul", { "rax", "rcx" });
+        }
+        std::string invariantRegister = vectorRegister(nextRegister);
+        std::string lowRegister = "xmm" + std::to_string(nextRegister);
+        if(settings.useAvx2)
+        {
+            generation.code.emit("vmovq", { lowRegister, "rax" });
+            generation.code.emit("vpbroadcastq", { invariantRegister, lowRegister });
+        }
+        else
+        {
+            generation.code.emit("movq", { lowRegister, "rax" });
+            generation.code.emit("punpcklqdq", { lowRegister, lowRegister });
+        }
+        invariantRegisters[invariant] = nextRegister++;
+    }
+    bool hasByteReduction = isByteLoop && !accumulatorRegisters.empty();
+    size_t zeroRegister = nextRegister;
+    if(hasByteReduction)
+    {
+        std::string zero = vectorRegister(nextRegister++);
+        if(settings.useAvx2)
+            generation.code.emit("vpxor", { zero, zero, zero });
+        else
+            generation.code.emit("pxor", { zero, zero });
+    }
+
+    generation.code.emitLabel(vectorLoopLabel);
+    generation.code.emit("mov", { "rax", inductionVariable });
+    size_t reductionsCount = 0;
+    std::string value = vectorRegister(nextRegister);
+    for(const VectorStatement& statement : loop.statements)
+    {
+        if(!statement.isReduction)
+        {
+            generateVectorValue(statement.assignment->value, loop.elementSize, nextRegister, invariantRegisters, generation);
+            Variable array = generation.getVariableByName(statement.assignment->name->ident.value.value()).value();
+            generation.code.emit(settings.useAvx2 ? "vmovdqu" : "movdqu", { elementAddressOf(array, std::nullopt, "rax", generation), value });
+            continue;
+        }
+
+        // The bytes are added in groups of 8 to 64 bits sums
+        std::string accumulator = vectorRegister(accumulatorRegisters[reductionsCount++]);
+        for(const ReductionTerm& term : statement.terms)
+        {
+            generateVectorValue(term.value, loop.elementSize, nextRegister, invariantRegisters, generation);
+            std::string operation = term.isSubtracted ? "psubq" : "paddq";
+            if(settings.useAvx2)
+            {
+                if(hasByteReduction)
+                    generation.code.emit("vpsadbw", { value, value, vectorRegister(zeroRegister) });
+                generation.code.emit("v" + operation, { accumulator, accumulator, value });
+            }
+            else
+            {
+                if(hasByteReduction)
+                    generation.code.emit("psadbw", { value, vectorRegister(zeroRegister) });
+                generation.code.emit(operation, { accumulator, value });
+            }
+        }
+    }
+    generation.code.emit("add", { inductionVariable, std::to_string(loop.lanesCount) });
+    generateVectorLoopCondition(loop, vectorLoopLabel, true, generation);
+
+    // The lanes of each accumulator are added together, and their sum to the variable of the reduction
+    reductionsCount = 0;
+    std::string temporary = "xmm" + std::to_string(nextRegister);
+    for(const VectorStatement& statement : loop.statements)
+    {
+        if(!statement.isReduction)
+            continue;
+        std::string accumulator = "xmm" + std::to_string(accumulatorRegisters[reductionsCount++]);
+        if(settings.useAvx2)
+        {
+            generation.code.emit("vextracti128", { temporary, vectorRegister(accumulatorRegisters[reductionsCount - 1]), "1" });
+            generation.code.emit("vpaddq", { accumulator, accumulator, temporary });
+            generation.code.emit("vpunpckhqdq", { temporary, accumulator, accumulator });
+            generation.code.emit("vpaddq", { accumulator, accumulator, temporary });
+            generation.code.emit("vmovq", { "rax", accumulator });
+        }
+        else
+        {
+            generation.code.emit("movdqa", { temporary, accumulator });
+            generation.code.emit("punpckhqdq", { temporary, temporary });
+            generation.code.emit("paddq", { accumulator, temporary });
+            generation.code.emit("movq", { "rax", accumulator });
+        }
+        generation.code.emit("add", { utils::accessVariable(generation, generation.getVariableByName(statement.assignment->name->ident.value.value()).value()), "rax" });
+    }
+    // The upper halves of the `ymm` registers would slow down the SSE instructions executed later
+    if(settings.useAvx2)
+        generation.code.emit("vzeroupper");
+    generation.code.emitLabel(scalarLoopLabel);
+}
+
+void Generator::generateVectorValue(const ExpressionNode* expression, size_t elementSize, size_t temporaryRegister,
+                                    const std::unordered_map<const ExpressionNode*, size_t>& invariantRegisters, GenerateData& generation)
 {
-    auto trueLabel = generation.generateLabel();
-    auto endLabel = generation.generateLabel();
-    generation.output << TAB << "cmp rax, rbx" << NEW_LINE;
-    generation.output << TAB << jumpInstruction << " " << trueLabel << NEW_LINE;
-    generation.output << TAB << "mov rax, 0" << NEW_LINE;
-    generation.output << TAB << "jmp " << endLabel << NEW_LINE;
-    generation.output << trueLabel << ": " << NEW_LINE;
-    generation.output << TAB << "mov rax, 1" << NEW_LINE;
-    generation.output << endLabel << ": " << NEW_LINE;
+    expression = ast::skipBrackets(expression);
+    std::string destination = vectorRegister(temporaryRegister);
+    std::string move = settings.useAvx2 ? "vmovdqu" : "movdqu";
+    if(auto invariant = invariantRegisters.find(expression); invariant != invariantRegisters.end())
+    {
+        generation.code.emit(move, { destination, vectorRegister(invariant->second) });
+        return;
+    }
+    if(std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+    {
+        // The index is the induction variable, already in `rax`
+        auto element = std::get<ExpressionIndexNode*>(std::get<ExpressionAtomNode*>(expression->variant)->variant);
+        Variable array = generation.getVariableByName(element->array->ident.value.value()).value();
+        generation.code.emit(move, { destination, elementAddressOf(array, std::nullopt, "rax", generation) });
+        return;
+    }
+
+    auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+    generateVectorValue(binary->lhs, elementSize, temporaryRegister, invariantRegisters, generation);
+    std::string source;
+    if(auto invariant = invariantRegisters.find(ast::skipBrackets(binary->rhs)); invariant != invariantRegisters.end())
+        source = vectorRegister(invariant->second);
+    else
+    {
+        generateVectorValue(binary->rhs, elementSize, temporaryRegister + 1, invariantRegisters, generation);
+        source = vectorRegister(temporaryRegister + 1);
+    }
+    std::string operation = std::string(binary->operation == Operator::Add ? "padd" : "psub") + (elementSize == 1 ? "b" : "q");
+    if(settings.useAvx2)
+        generation.code.emit("v" + operation, { destination, destination, source });
+    else
+        generation.code.emit(operation, { destination, source });
 }
 
 void Generator::generateExpression(const std::string& registerName, const ExpressionNode* expression,
@@ -459,43 +1842,25 @@ void Generator::generateExpression(const std::string& registerName, const Expres
         }
         void operator()(const ExpressionBinaryOperatorNode* expression)
         {
-            generator.generateExpression("rax", expression->lhs, generation);
-            generation.pushOnStack("rax");
-            generator.generateExpression("rbx", expression->rhs, generation);
-            generation.popFromStack("rax");
+            generator.generateBinaryOperation(expression, generation);
 
-            switch(expression->operation)
-            {
-                case Operator::Add:
-                    generation.output << TAB << "add rax, rbx" << NEW_LINE;
-                    break;
-                case Operator::Sub:
-                    generation.output << TAB << "sub rax, rbx" << NEW_LINE;
-                    break;
-                case Operator::Mul:
-                    generation.output << TAB << "mul rbx" << NEW_LINE;
-                    break;
-                case Operator::Div:
-                    generation.output << TAB << "div rbx" << NEW_LINE;
-                    break;
-                case Operator::GreaterThan:
-                    generateComparison("jg", generation);
-                    break;
-                case Operator::LessThan:
-                    generateComparison("jl", generation);
-                    break;
-                case Operator::EqualTo:
-                    generateComparison("je", generation);
-                    break;
-                case Operator::NotEqualTo:
-                    generateComparison("jne", generation);
-                    break;
-            }
-
-            generation.output << TAB << "mov rbx, rax" << NEW_LINE;
+            generation.code.emit("mov", { "rbx", "rax" });
         }
     };
 
-    Visitor visitor(registerName, *this, generation);
-    std::visit(visitor, expression->variant);
+    std::optional<size_t> savedSlot = std::nullopt;
+    if(generation.valueNumbering.has_value() && generation.currentFrame.has_value())
+        savedSlot = generation.valueNumbering.value().getSavedSlot(expression);
+
+    if(auto savedValue = savedValueOf(expression, generation))
+        generation.code.emit("mov", { registerName, utils::accessVariable(generation, savedValue.value()) });
+    else
+    {
+        Visitor visitor(registerName, *this, generation);
+        std::visit(visitor, expression->variant);
+    }
+
+    // The value is used again later, by an expression that reads it from its slot
+    if(savedSlot.has_value())
+        generation.code.emit("mov", { utils::accessVariable(generation, valueNumberingSlot(savedSlot.value(), generation)), registerName });
 }
\ No newline at end of file
@@ -3,8 +3,42 @@
 #include <string>
 
 #include "generation_data.hpp"
+#include "peephole.hpp"
+#include "target.hpp"
 #include "../parser/node/core.hpp"
 
+/**
+ * @brief Settings that change the code produced by the Generator.
+ */
+struct GeneratorSettings
+{
+    bool usePeepholeOptimizer = true;
+    /// Rotate, unroll the while loops and move the loop invariant computations out of them.
+    bool optimizeLoops = true;
+    /// The number of copies of the body of a counted loop in each iteration of the unrolled loop.
+    size_t loopUnrollFactor = 4;
+    /// Counted loops with at most this number of iterations are replaced by copies of their body.
+    size_t maxFullUnrollTripCount = 8;
+    /// Compute only once the expressions that give the same result of an expression computed before.
+    bool eliminateCommonSubexpressions = true;
+    /// Exit with INDEX_OUT_OF_BOUNDS_EXIT_CODE when the index of an element isn't in the bounds of its array.
+    bool checkBounds = true;
+    /// Don't check the indices that are proven to be in the bounds of their array.
+    bool eliminateBoundsChecks = true;
+    /// Run the iterations of the simple counted loops over arrays in the lanes of the vector registers (if the loops are optimized).
+    bool vectorizeLoops = true;
+    /// Use the 32 bytes registers of AVX2 in the vectorized loops instead of the 16 bytes ones of SSE2.
+    bool useAvx2 = false;
+    /// Replace the calls of the pure functions whose arguments are constants with their result, computed while compiling.
+    bool evaluatePureCalls = true;
+    /// The number of statements and expressions that the evaluation of each call can run while compiling.
+    size_t maxEvaluationSteps = DEFAULT_MAX_EVALUATION_STEPS;
+    /// The number of nested calls that the evaluation of each call can reach while compiling.
+    size_t maxEvaluationDepth = DEFAULT_MAX_EVALUATION_DEPTH;
+    /// The operating system the generated program runs on.
+    TargetPlatform targetPlatform = TargetPlatform::Windows;
+};
+
 /**
  * @brief Class responsible for generating assembly code based on parsed program nodes.
  */
@@ -17,13 +51,38 @@ public:
      * Initializes a Generator object.
      */
     Generator();
+    /**
+     * @brief Constructor for the Generator class.
+     * @param settings The settings used to generate the code.
+     */
+    Generator(GeneratorSettings settings);
 
     /**
      * @brief Generate assembly code for the entire program.
      * @param program The root node of the parsed program.
-     * @return The generated assembly code as a string.
+     * @return The generated program, or std::nullopt if the program is invalid.
      */
-    std::string generate(const ProgramNode& program);
+    std::optional<AssemblyProgram> generate(const ProgramNode& program);
+
+    /**
+     * @brief Get the rules of the peephole optimizer, each one with the number of times it has been applied.
+     */
+    const std::vector<PeepholeRule>& getPeepholeRules() const;
+
+    /**
+     * @brief Get the settings used to generate the code, that the other backends follow too.
+     */
+    const GeneratorSettings& getSettings() const;
+
+    /**
+     * @brief Get the result of the vectorization of every loop of the last generated program.
+     */
+    const std::vector<LoopVectorizationReport>& getVectorizationReports() const;
+
+    /**
+     * @brief Get the result of the evaluation of every call with constant arguments of the last generated program.
+     */
+    const std::vector<CompileTimeEvaluationReport>& getEvaluationReports() const;
 
 private:
     /**
@@ -46,6 +105,95 @@ private:
      */
     void generateStatementScopeWithoutEntering(const StatementScopeNode* statement, GenerateData& generation);
 
+    /**
+     * @brief Generate assembly code for a list of statements in the current scope.
+     * @param statements The statements to generate code for.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateStatementList(const std::vector<StatementNode*>& statements, GenerateData& generation);
+    /**
+     * @brief Generate assembly code for the `index`-th statement of a list, looking at the next statement if needed.
+     * @param statements The list that contains the statement.
+     * @param index The index of the statement to generate code for.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateStatementInList(const std::vector<StatementNode*>& statements, size_t index, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code for a variable declaration.
+     * @param statement The declaration to generate code for.
+     * @param shouldInitialize If false, the variable isn't set to 0 because it's assigned right after (and an array gets the address of its elements).
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateVariableDeclaration(const StatementDeclareVariableNode* statement, bool shouldInitialize, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code for the declaration of an array whose elements are on the stack, all set to 0.
+     */
+    void generateStackArray(const StatementDeclareVariableNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code that computes the index of an element, and checks that it's in the bounds of the array.
+     * @param array The variable of the array.
+     * @param index The index of the element.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     * @return The index if it's a constant that is added to the address of the element, otherwise std::nullopt and the index is in `rax`.
+     */
+    std::optional<long long> generateIndex(const Variable& array, const ExpressionNode* index, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code for an assignment to an element of an array. The index is computed before the value.
+     */
+    void generateElementAssignment(const StatementAssignVariableNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code for an `asm!` macro with operands.
+     *
+     * The inputs are loaded in their registers, the code written by the user is copied with the operands replaced by
+     * their registers or memory, and the outputs are saved in their variables.
+     */
+    void generateAsmMacro(const StatementMacroNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Run the analyses needed by the optimizations of some statements, before generating them in a stack frame.
+     * @param statements The code of a function, or the code outside of the functions.
+     * @param parameters The parameters of the function whose code is analyzed.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     * @return The number of slots of the frame needed by the optimizations, besides the ones counted by utils::countFrameSlots.
+     */
+    size_t analyzeStatements(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters,
+                             GenerateData& generation);
+
+    /**
+     * @brief Make the code use a new stack frame and generate the instruction that allocates it.
+     * @param slotsCount The number of 8 bytes slots in the frame.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateFramePrologue(size_t slotsCount, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code that returns the value in `rax` from the current function (or exits the process).
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateReturn(GenerateData& generation);
+
+    /**
+     * @brief Generate a `return f(...);` statement as a jump to `f`, reusing the stack frame of the current function.
+     *
+     * When `f` is the current function the recursion becomes a loop. Only the functions that use CallingConvention::Registers are supported.
+     * @return False if the statement isn't a tail call that can be optimized, and nothing has been generated.
+     */
+    bool generateTailCall(const StatementReturnNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Generate the Windows x64 entry point of a function that uses CallingConvention::Registers.
+     *
+     * It lets the code written with the `asm!` macro (and the external libraries) call the function with the standard convention.
+     * @param functionName The name of the function, used as label of the entry point.
+     * @param parametersCount The number of parameters of the function.
+     */
+    void generateAbiWrapper(const std::string& functionName, size_t parametersCount, GenerateData& generation);
+
     /**
      * @brief Generate assembly code for an expression.
      * @param expression The expression node to generate code for.
@@ -59,4 +207,85 @@ private:
      * @param generation Reference to the GenerateData object containing code generation information.
      */
     void generateExpressionAtom(const std::string& registerName, const ExpressionAtomNode* expression, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code that puts the left operand of a binary operation in `rax`.
+     *
+     * When both operands must be computed, the one that needs more registers is computed first (if the order can't
+     * change the result), so that fewer values wait in the registers or on the stack while the other one is computed.
+     * @param expression The binary operation whose operands are generated.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     * @return The operand that contains the right operand: `rbx`, a temporary register, an immediate or a variable in memory.
+     */
+    std::string generateBinaryOperands(const ExpressionBinaryOperatorNode* expression, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code that puts the result of a binary operation in `rax`.
+     *
+     * Constant operands are used as immediates, and multiplications and divisions by constants
+     * are replaced by shifts, `lea` and multiplications.
+     * 
+     * @param expression The binary operation to generate code for.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateBinaryOperation(const ExpressionBinaryOperatorNode* expression, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code that jumps to `label` if the condition has the given value, and falls through otherwise.
+     *
+     * Comparisons are lowered to a single `cmp` followed by a conditional jump, and `&&` and `||` to the jumps of
+     * their operands, so that the right operand is evaluated only when the left one doesn't decide the condition.
+     * 
+     * @param condition The condition of an `if` or `while` statement.
+     * @param label The label to jump to.
+     * @param jumpIfTrue If true the jump is taken when the condition is true, otherwise when it's false.
+     * @param generation Reference to the GenerateData object containing code generation information.
+     */
+    void generateConditionalJump(const ExpressionNode* condition, const std::string& label, bool jumpIfTrue, GenerateData& generation);
+    /**
+     * @brief Generate assembly code that jumps to `label` if the `&&` or `||` operation has the given value, evaluating its operands only when needed.
+     */
+    void generateShortCircuitJump(const ExpressionBinaryOperatorNode* expression, const std::string& label, bool jumpIfTrue, GenerateData& generation);
+
+    /**
+     * @brief Generate assembly code for a while loop.
+     *
+     * The loop is rotated, so that each iteration ends with a single conditional jump, and it's unrolled when it's a counted loop.
+     */
+    void generateWhileLoop(const StatementWhileNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Generate the code that computes the loop invariant expressions of a loop and stores them in the stack frame.
+     *
+     * Inside the loop the expressions are read from their slots instead of being computed again.
+     */
+    void generateLoopPreheader(const StatementWhileNode* statement, GenerateData& generation);
+
+    /**
+     * @brief Generate the vector loop that runs the iterations of a loop in groups of `lanesCount`, while enough of them are left.
+     *
+     * It's skipped when the arrays may share elements or when an index would be out of bounds, and the scalar loop
+     * generated after it runs the iterations that are left.
+     */
+    void generateVectorizedLoop(const VectorizedLoop& loop, GenerateData& generation);
+
+    /**
+     * @brief Generate the code that computes the value of a statement of a vectorized loop in all the lanes of a register.
+     * @param elementSize The size of the elements of the arrays accessed by the loop, that is the size of the lanes.
+     * @param temporaryRegister The first vector register that can be overwritten, the value is left there.
+     * @param invariantRegisters The vector register of each invariant of the loop.
+     */
+    void generateVectorValue(const ExpressionNode* expression, size_t elementSize, size_t temporaryRegister,
+                             const std::unordered_map<const ExpressionNode*, size_t>& invariantRegisters, GenerateData& generation);
+
+    /**
+     * @brief Get the name of a vector register: `xmm` with SSE2 and `ymm` with AVX2.
+     */
+    std::string vectorRegister(size_t index) const;
+
+    GeneratorSettings settings;
+    std::shared_ptr<const Target> target;
+    PeepholeOptimizer peepholeOptimizer;
+    std::vector<LoopVectorizationReport> vectorizationReports;
+    std::vector<CompileTimeEvaluationReport> evaluationReports;
 };
\ No newline at end of file
@@ -0,0 +1,650 @@
+#include "peephole.hpp"
+
+#include <unordered_set>
+#include <algorithm>
+
+#include "special/consts.hpp"
+
+// Maximum number of instructions that are visited while checking if a register is dead
+const size_t MAX_LIVENESS_STEPS = 256;
+// Maximum number of times the whole rule table is applied to the code
+const size_t MAX_PASSES = 16;
+
+const std::string FLAGS = "flags";
+
+std::optional<std::string> peephole::fullRegister(const std::string& operand)
+{
+    static const std::unordered_map<std::string, std::string> registers = {
+        { "rax", "rax" }, { "eax", "rax" }, { "ax", "rax" }, { "al", "rax" }, { "ah", "rax" },
+        { "rbx", "rbx" }, { "ebx", "rbx" }, { "bx", "rbx" }, { "bl", "rbx" }, { "bh", "rbx" },
+        { "rcx", "rcx" }, { "ecx", "rcx" }, { "cx", "rcx" }, { "cl", "rcx" }, { "ch", "rcx" },
+        { "rdx", "rdx" }, { "edx", "rdx" }, { "dx", "rdx" }, { "dl", "rdx" }, { "dh", "rdx" },
+        { "rsi", "rsi" }, { "esi", "rsi" }, { "si", "rsi" }, { "sil", "rsi" },
+        { "rdi", "rdi" }, { "edi", "rdi" }, { "di", "rdi" }, { "dil", "rdi" },
+        { "rbp", "rbp" }, { "ebp", "rbp" }, { "bp", "rbp" }, { "bpl", "rbp" },
+        { "rsp", "rsp" }, { "esp", "rsp" }, { "sp", "rsp" }, { "spl", "rsp" },
+        { "r8", "r8" }, { "r8d", "r8" }, { "r8w", "r8" }, { "r8b", "r8" },
+        { "r9", "r9" }, { "r9d", "r9" }, { "r9w", "r9" }, { "r9b", "r9" },
+        { "r10", "r10" }, { "r10d", "r10" }, { "r10w", "r10" }, { "r10b", "r10" },
+        { "r11", "r11" }, { "r11d", "r11" }, { "r11w", "r11" }, { "r11b", "r11" },
+        { "r12", "r12" }, { "r12d", "r12" }, { "r12w", "r12" }, { "r12b", "r12" },
+        { "r13", "r13" }, { "r13d", "r13" }, { "r13w", "r13" }, { "r13b", "r13" },
+        { "r14", "r14" }, { "r14d", "r14" }, { "r14w", "r14" }, { "r14b", "r14" },
+        { "r15", "r15" }, { "r15d", "r15" }, { "r15w", "r15" }, { "r15b", "r15" },
+    };
+    auto it = registers.find(operand);
+    if(it == registers.end())
+        return std::nullopt;
+    return it->second;
+}
+
+// Is the register written entirely when it's the destination (writing `eax` clears the upper half of `rax`)?
+static bool isFullWidthRegister(const std::string& operand)
+{
+    return (operand.size() == 3 && (operand[0] == 'r' || operand[0] == 'e') && !std::isdigit(operand[1]))
+        || (operand.size() >= 2 && operand[0] == 'r' && std::isdigit(operand[1]) && (std::isdigit(operand.back()) || operand.back() == 'd'));
+}
+
+static bool isMemoryOperand(const std::string& operand)
+{
+    return operand.find('[') != std::string::npos;
+}
+
+static bool isImmediate(const std::string& operand)
+{
+    return !operand.empty() && (std::isdigit(operand[0]) || (operand[0] == '-' && operand.size() > 1 && std::isdigit(operand[1])));
+}
+
+// Returns the registers used to compute the address of a memory operand
+static std::vector<std::string> registersInMemoryOperand(const std::string& operand)
+{
+    std::vector<std::string> registers;
+    auto start = operand.find('[');
+    auto end = operand.find(']');
+    if(start == std::string::npos || end == std::string::npos)
+        return registers;
+
+    std::string word;
+    for(size_t i = start + 1; i <= end; i++)
+    {
+        char c = operand[i];
+        if(std::isalnum(c))
+            word += c;
+        else
+        {
+            if(auto fullRegister = peephole::fullRegister(word))
+                registers.push_back(fullRegister.value());
+            word.clear();
+        }
+    }
+    return registers;
+}
+
+std::optional<long long> peephole::stackSlotOffset(const std::string& operand)
+{
+    std::string address = operand;
+    if(address.rfind("QWORD ", 0) == 0)
+        address = address.substr(6);
+    else if(isMemoryOperand(address))
+        return std::nullopt;
+
+    if(address == "[rsp]")
+        return 0;
+    const std::string PREFIX = "[rsp + ";
+    if(address.rfind(PREFIX, 0) != 0 || address.back() != ']')
+        return std::nullopt;
+
+    auto number = address.substr(PREFIX.size(), address.size() - PREFIX.size() - 1);
+    if(number.empty() || !std::all_of(number.begin(), number.end(), ::isdigit))
+        return std::nullopt;
+    return std::stoll(number);
+}
+
+// Returns a key that identifies the stack slot accessed by the operand (`[rsp + N]` or `[rbp - N]`)
+static std::optional<std::string> stackSlotKey(const std::string& operand)
+{
+    if(auto offset = peephole::stackSlotOffset(operand))
+        return "rsp" + std::to_string(offset.value());
+    if(operand.rfind("QWORD [rbp ", 0) == 0 && operand.back() == ']' && registersInMemoryOperand(operand) == std::vector<std::string> { "rbp" })
+        return operand;
+    return std::nullopt;
+}
+
+static std::string stackSlot(long long offset)
+{
+    return "QWORD [rsp + " + std::to_string(offset) + "]";
+}
+
+/**
+ * @brief The registers read and written by an instruction.
+ */
+struct InstructionEffects
+{
+    bool isKnown = true;
+    std::unordered_set<std::string> reads;
+    std::unordered_set<std::string> writes;
+};
+
+static void readOperand(InstructionEffects& effects, const std::string& operand)
+{
+    if(isMemoryOperand(operand))
+    {
+        for(auto& registerName : registersInMemoryOperand(operand))
+            effects.reads.insert(registerName);
+    }
+    else if(auto registerName = peephole::fullRegister(operand))
+        effects.reads.insert(registerName.value());
+}
+
+static void writeOperand(InstructionEffects& effects, const std::string& operand)
+{
+    if(isMemoryOperand(operand))
+    {
+        for(auto& registerName : registersInMemoryOperand(operand))
+            effects.reads.insert(registerName);
+    }
+    else if(auto registerName = peephole::fullRegister(operand))
+    {
+        // Writing only a part of a register keeps the rest of its old value
+        if(!isFullWidthRegister(operand))
+            effects.reads.insert(registerName.value());
+        effects.writes.insert(registerName.value());
+    }
+}
+
+static bool isConditionalJump(const std::string& mnemonic)
+{
+    return mnemonic.size() >= 2 && mnemonic[0] == 'j' && mnemonic != "jmp";
+}
+
+static InstructionEffects effectsOf(const AssemblyLine& line)
+{
+    InstructionEffects effects;
+    const std::string& mnemonic = line.mnemonic;
+    const std::vector<std::string>& operands = line.operands;
+
+    if((mnemonic == "mov" || mnemonic == "movzx" || mnemonic == "movsx" || mnemonic == "movsxd" || mnemonic == "lea") && operands.size() == 2)
+    {
+        readOperand(effects, operands[1]);
+        writeOperand(effects, operands[0]);
+    }
+    else if((mnemonic == "xor" || mnemonic == "sub") && operands.size() == 2 && operands[0] == operands[1] && !isMemoryOperand(operands[0]))
+    {
+        // Zeroing idiom: the old value isn't read
+        writeOperand(effects, operands[0]);
+        effects.writes.insert(FLAGS);
+    }
+    else if((mnemonic == "add" || mnemonic == "sub" || mnemonic == "and" || mnemonic == "or" || mnemonic == "xor" ||
+             mnemonic == "shl" || mnemonic == "shr" || mnemonic == "sar" || mnemonic == "sal") && operands.size() == 2)
+    {
+        readOperand(effects, operands[0]);
+        readOperand(effects, operands[1]);
+        writeOperand(effects, operands[0]);
+        effects.writes.insert(FLAGS);
+    }
+    else if((mnemonic == "adc" || mnemonic == "sbb") && operands.size() == 2)
+    {
+        readOperand(effects, operands[0]);
+        readOperand(effects, operands[1]);
+        writeOperand(effects, operands[0]);
+        effects.reads.insert(FLAGS);
+        effects.writes.insert(FLAGS);
+    }
+    else if(mnemonic == "imul" && (operands.size() == 2 || operands.size() == 3))
+    {
+        if(operands.size() == 2)
+            readOperand(effects, operands[0]);
+        for(size_t i = 1; i < operands.size(); i++)
+            readOperand(effects, operands[i]);
+        writeOperand(effects, operands[0]);
+        effects.writes.insert(FLAGS);
+    }
+    else if((mnemonic == "cmp" || mnemonic == "test") && operands.size() == 2)
+    {
+        readOperand(effects, operands[0]);
+        readOperand(effects, operands[1]);
+        effects.writes.insert(FLAGS);
+    }
+    else if((mnemonic == "inc" || mnemonic == "dec" || mnemonic == "neg" || mnemonic == "not") && operands.size() == 1)
+    {
+        readOperand(effects, operands[0]);
+        writeOperand(effects, operands[0]);
+        if(mnemonic != "not")
+            effects.writes.insert(FLAGS);
+    }
+    else if((mnemonic == "mul" || mnemonic == "imul" || mnemonic == "div" || mnemonic == "idiv") && operands.size() == 1)
+    {
+        readOperand(effects, operands[0]);
+        effects.reads.insert("rax");
+        if(mnemonic == "div" || mnemonic == "idiv")
+            effects.reads.insert("rdx");
+        effects.writes.insert("rax");
+        effects.writes.insert("rdx");
+        effects.writes.insert(FLAGS);
+    }
+    else if(mnemonic == "cqo" && operands.empty())
+    {
+        effects.reads.insert("rax");
+        effects.writes.insert("rdx");
+    }
+    else if(mnemonic == "push" && operands.size() == 1)
+    {
+        readOperand(effects, operands[0]);
+        effects.reads.insert("rsp");
+        effects.writes.insert("rsp");
+    }
+    else if(mnemonic == "pop" && operands.size() == 1)
+    {
+        effects.reads.insert("rsp");
+        effects.writes.insert("rsp");
+        writeOperand(effects, operands[0]);
+    }
+    else if(mnemonic.rfind("set", 0) == 0 && operands.size() == 1)
+    {
+        effects.reads.insert(FLAGS);
+        writeOperand(effects, operands[0]);
+    }
+    else if(mnemonic.rfind("cmov", 0) == 0 && operands.size() == 2)
+    {
+        effects.reads.insert(FLAGS);
+        readOperand(effects, operands[0]);
+        readOperand(effects, operands[1]);
+        writeOperand(effects, operands[0]);
+    }
+    else if(isConditionalJump(mnemonic) && operands.size() == 1)
+        effects.reads.insert(FLAGS);
+    else if(mnemonic == "nop")
+        ;
+    else
+        effects.isKnown = false;
+
+    return effects;
+}
+
+// Registers that a called function can read to get its arguments
+static bool isArgumentRegister(const std::string& registerName)
+{
+    return registerName == "rcx" || registerName == "rdx" || registerName == "r8" || registerName == "r9" || registerName == "rsp";
+}
+// Registers (and flags) that a called function is allowed to overwrite
+static bool isVolatileRegister(const std::string& registerName)
+{
+    return registerName == "rax" || registerName == "rcx" || registerName == "rdx" || registerName == "r8" ||
+        registerName == "r9" || registerName == "r10" || registerName == "r11" || registerName == FLAGS;
+}
+
+PeepholeWindow::PeepholeWindow(std::vector<AssemblyLine>& lines, const std::unordered_map<std::string, size_t>& labels, std::vector<size_t> indices) :
+    lines(lines), labels(labels), indices(std::move(indices))
+{
+}
+
+AssemblyLine& PeepholeWindow::operator[](size_t index)
+{
+    return lines[indices[index]];
+}
+
+size_t PeepholeWindow::size() const
+{
+    return indices.size();
+}
+
+void PeepholeWindow::erase(size_t index)
+{
+    lines[indices[index]].isDeleted = true;
+}
+
+void PeepholeWindow::replace(size_t index, const std::string& mnemonic, const std::vector<std::string>& operands)
+{
+    AssemblyLine& line = lines[indices[index]];
+    line.mnemonic = mnemonic;
+    line.operands = operands;
+    line.comment.clear();
+}
+
+bool PeepholeWindow::isRegisterDeadAfter(size_t index, const std::string& registerName) const
+{
+    auto fullRegister = peephole::fullRegister(registerName);
+    if(!fullRegister.has_value() || fullRegister.value() == "rsp")
+        return false;
+    return isDeadAfter(indices[index], fullRegister.value());
+}
+
+bool PeepholeWindow::areFlagsDeadAfter(size_t index) const
+{
+    return isDeadAfter(indices[index], FLAGS);
+}
+
+bool PeepholeWindow::isDeadAfter(size_t lineIndex, const std::string& registerName) const
+{
+    std::vector<size_t> pathsToVisit = { lineIndex + 1 };
+    std::unordered_set<size_t> visited;
+    size_t steps = 0;
+
+    while(!pathsToVisit.empty())
+    {
+        size_t current = pathsToVisit.back();
+        pathsToVisit.pop_back();
+
+        while(true)
+        {
+            if(current >= lines.size() || ++steps > MAX_LIVENESS_STEPS)
+                return false;
+            if(!visited.insert(current).second)
+                break;
+
+            const AssemblyLine& line = lines[current];
+            if(line.isDeleted || line.type == AssemblyLineType::Other || line.type == AssemblyLineType::Label)
+            {
+                current++;
+                continue;
+            }
+            if(line.type == AssemblyLineType::Opaque)
+                return false;
+
+            if(line.mnemonic == "jmp")
+            {
+                auto label = line.operands.size() == 1 ? labels.find(line.operands[0]) : labels.end();
+                if(label == labels.end())
+                    return false;
+                current = label->second;
+                continue;
+            }
+            if(line.mnemonic == "ret")
+            {
+                // Only the return value and the stack pointer survive a return
+                if(registerName == "rax" || registerName == "rsp")
+                    return false;
+                break;
+            }
+            if(line.mnemonic == "call")
+            {
+                if(isArgumentRegister(registerName))
+                    return false;
+                // The process ends inside `ExitProcess`
+                if(isVolatileRegister(registerName) || (line.operands.size() == 1 && line.operands[0] == EXIT_PROCESS_WINDOWS))
+                    break;
+                current++;
+                continue;
+            }
+
+            InstructionEffects effects = effectsOf(line);
+            if(!effects.isKnown || effects.reads.contains(registerName))
+                return false;
+            if(effects.writes.contains(registerName))
+                break;
+
+            if(isConditionalJump(line.mnemonic))
+            {
+                auto label = labels.find(line.operands[0]);
+                if(label == labels.end())
+                    return false;
+                pathsToVisit.push_back(label->second);
+            }
+            current++;
+        }
+    }
+
+    return true;
+}
+
+// `push X` followed by `pop X` does nothing
+static bool removePushPopPair(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "push" || window[1].mnemonic != "pop" || window[0].operands != window[1].operands)
+        return false;
+
+    window.erase(0);
+    window.erase(1);
+    return true;
+}
+
+// `push X` followed by `pop Y` is just a move
+static bool pushPopIntoMove(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "push" || window[1].mnemonic != "pop" || window[0].operands.size() != 1 || window[1].operands.size() != 1)
+        return false;
+
+    const std::string& source = window[0].operands[0];
+    const std::string& destination = window[1].operands[0];
+    auto destinationRegister = peephole::fullRegister(destination);
+    if(!destinationRegister.has_value() || destinationRegister.value() == "rsp" || !isFullWidthRegister(destination))
+        return false;
+    if(source == destination || peephole::fullRegister(source) == peephole::fullRegister("rsp") || isMemoryOperand(source))
+        return false;
+
+    window.replace(0, "mov", { destination, source });
+    window.erase(1);
+    return true;
+}
+
+// `push rax`, `mov rbx, X`, `pop rax` doesn't need to save `rax` on the stack
+static bool removePushPopAroundMove(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "push" || window[1].mnemonic != "mov" || window[2].mnemonic != "pop" ||
+        window[0].operands.size() != 1 || window[0].operands != window[2].operands || window[1].operands.size() != 2)
+        return false;
+
+    auto savedRegister = peephole::fullRegister(window[0].operands[0]);
+    auto destinationRegister = peephole::fullRegister(window[1].operands[0]);
+    if(!savedRegister.has_value() || !isFullWidthRegister(window[0].operands[0]) || savedRegister.value() == "rsp")
+        return false;
+    if(!destinationRegister.has_value() || destinationRegister == savedRegister || destinationRegister.value() == "rsp")
+        return false;
+
+    std::string source = window[1].operands[1];
+    if(isMemoryOperand(source))
+    {
+        auto usedRegisters = registersInMemoryOperand(source);
+        if(std::find(usedRegisters.begin(), usedRegisters.end(), savedRegister.value()) != usedRegisters.end())
+            return false;
+        if(std::find(usedRegisters.begin(), usedRegisters.end(), "rsp") != usedRegisters.end())
+        {
+            auto offset = peephole::stackSlotOffset(source);
+            if(!offset.has_value())
+                return false;
+            // Reading the slot that has just been pushed means reading the saved register
+            source = offset.value() == 0 ? window[0].operands[0] : stackSlot(offset.value() - 8);
+        }
+    }
+    else if(peephole::fullRegister(source) == savedRegister || peephole::fullRegister(source) == peephole::fullRegister("rsp"))
+        return false;
+
+    window.replace(1, "mov", { window[1].operands[0], source });
+    window.erase(0);
+    window.erase(2);
+    return true;
+}
+
+// `mov R, X` is useless if `R` is overwritten before being read
+static bool removeDeadMove(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "mov" || window[0].operands.size() != 2 || !isFullWidthRegister(window[0].operands[0]))
+        return false;
+    if(!window.isRegisterDeadAfter(0, window[0].operands[0]))
+        return false;
+
+    window.erase(0);
+    return true;
+}
+
+// `add rsp, 0` and `sub rsp, 0` don't change the stack (the flags they set are never used)
+static bool removeZeroStackAdjustment(PeepholeWindow& window)
+{
+    if((window[0].mnemonic != "add" && window[0].mnemonic != "sub") || window[0].operands.size() != 2 ||
+        window[0].operands[0] != "rsp" || window[0].operands[1] != "0")
+        return false;
+    if(!window.areFlagsDeadAfter(0))
+        return false;
+
+    window.erase(0);
+    return true;
+}
+
+// `mov rax, 0` is longer than `xor eax, eax`, which only needs the flags to be dead
+static bool zeroRegisterWithXor(PeepholeWindow& window)
+{
+    static const std::unordered_map<std::string, std::string> lowerHalves = {
+        { "rax", "eax" }, { "rbx", "ebx" }, { "rcx", "ecx" }, { "rdx", "edx" }, { "rsi", "esi" }, { "rdi", "edi" },
+        { "r8", "r8d" }, { "r9", "r9d" }, { "r10", "r10d" }, { "r11", "r11d" },
+        { "r12", "r12d" }, { "r13", "r13d" }, { "r14", "r14d" }, { "r15", "r15d" },
+    };
+    if(window[0].mnemonic != "mov" || window[0].operands.size() != 2 || window[0].operands[1] != "0")
+        return false;
+    auto lowerHalf = lowerHalves.find(window[0].operands[0]);
+    if(lowerHalf == lowerHalves.end() || !window.areFlagsDeadAfter(0))
+        return false;
+
+    window.replace(0, "xor", { lowerHalf->second, lowerHalf->second });
+    return true;
+}
+
+// A load from a stack slot that has just been written or read can reuse the register that holds its value
+static bool removeRedundantStackLoad(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "mov" || window[1].mnemonic != "mov" || window[0].operands.size() != 2 || window[1].operands.size() != 2)
+        return false;
+
+    const std::string& loadDestination = window[1].operands[0];
+    auto loadedSlot = stackSlotKey(window[1].operands[1]);
+    if(!loadedSlot.has_value() || !peephole::fullRegister(loadDestination).has_value() || !isFullWidthRegister(loadDestination))
+        return false;
+
+    std::string knownValue;
+    if(stackSlotKey(window[0].operands[0]) == loadedSlot)
+    {
+        // Store followed by a load of the same slot
+        knownValue = window[0].operands[1];
+        if(!isImmediate(knownValue) && !(peephole::fullRegister(knownValue).has_value() && isFullWidthRegister(knownValue)))
+            return false;
+    }
+    else if(stackSlotKey(window[0].operands[1]) == loadedSlot)
+    {
+        // Two loads of the same slot
+        knownValue = window[0].operands[0];
+        auto knownRegister = peephole::fullRegister(knownValue);
+        if(!knownRegister.has_value() || !isFullWidthRegister(knownValue) || knownRegister.value() == "rsp" || knownRegister.value() == "rbp")
+            return false;
+    }
+    else
+        return false;
+
+    if(knownValue == loadDestination)
+        window.erase(1);
+    else
+        window.replace(1, "mov", { loadDestination, knownValue });
+    return true;
+}
+
+// `mov rax, 5` followed by `mov rcx, rax` is `mov rcx, 5` if `rax` isn't read anymore
+static bool forwardMove(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "mov" || window[1].mnemonic != "mov" || window[0].operands.size() != 2 || window[1].operands.size() != 2)
+        return false;
+    const std::string& temporary = window[0].operands[0];
+    const std::string& destination = window[1].operands[0];
+    if(!isFullWidthRegister(temporary) || window[1].operands[1] != temporary || !isFullWidthRegister(destination) || destination == temporary)
+        return false;
+    if(!window.isRegisterDeadAfter(1, temporary))
+        return false;
+
+    window.replace(1, "mov", { destination, window[0].operands[1] });
+    window.erase(0);
+    return true;
+}
+
+// `sub rsp, 16` followed by `sub rsp, 32` is a single `sub rsp, 48`
+static bool combineStackAdjustments(PeepholeWindow& window)
+{
+    auto stackAdjustment = [](const AssemblyLine& line) -> std::optional<long long>
+    {
+        if((line.mnemonic != "add" && line.mnemonic != "sub") || line.operands.size() != 2 || line.operands[0] != "rsp" || !isImmediate(line.operands[1]))
+            return std::nullopt;
+        long long value = std::stoll(line.operands[1]);
+        return line.mnemonic == "add" ? value : -value;
+    };
+    auto first = stackAdjustment(window[0]);
+    auto second = stackAdjustment(window[1]);
+    if(!first.has_value() || !second.has_value() || !window.areFlagsDeadAfter(1))
+        return false;
+
+    long long total = first.value() + second.value();
+    window.replace(0, total >= 0 ? "add" : "sub", { "rsp", std::to_string(std::abs(total)) });
+    window.erase(1);
+    return true;
+}
+
+// Nothing after a `ret` or a `jmp` is executed until the next label
+static bool removeUnreachableCode(PeepholeWindow& window)
+{
+    if(window[0].mnemonic != "ret" && window[0].mnemonic != "jmp")
+        return false;
+
+    window.erase(1);
+    return true;
+}
+
+PeepholeOptimizer::PeepholeOptimizer() : rules({
+    PeepholeRule { .name = "push-pop-same-register", .windowSize = 2, .apply = removePushPopPair },
+    PeepholeRule { .name = "push-pop-into-move", .windowSize = 2, .apply = pushPopIntoMove },
+    PeepholeRule { .name = "push-pop-around-move", .windowSize = 3, .apply = removePushPopAroundMove },
+    PeepholeRule { .name = "redundant-stack-load", .windowSize = 2, .apply = removeRedundantStackLoad },
+    PeepholeRule { .name = "forward-move", .windowSize = 2, .apply = forwardMove },
+    PeepholeRule { .name = "dead-move", .windowSize = 1, .apply = removeDeadMove },
+    PeepholeRule { .name = "zero-stack-adjustment", .windowSize = 1, .apply = removeZeroStackAdjustment },
+    PeepholeRule { .name = "zero-register-with-xor", .windowSize = 1, .apply = zeroRegisterWithXor },
+    PeepholeRule { .name = "combine-stack-adjustments", .windowSize = 2, .apply = combineStackAdjustments },
+    PeepholeRule { .name = "unreachable-code", .windowSize = 2, .apply = removeUnreachableCode },
+})
+{
+}
+
+const std::vector<PeepholeRule>& PeepholeOptimizer::getRules() const
+{
+    return rules;
+}
+
+void PeepholeOptimizer::optimize(AssemblyCode& code)
+{
+    std::vector<AssemblyLine>& lines = code.getLines();
+    std::unordered_map<std::string, size_t> labels;
+    for(size_t i = 0; i < lines.size(); i++)
+    {
+        if(lines[i].type == AssemblyLineType::Label)
+            labels[lines[i].mnemonic] = i;
+    }
+
+    for(size_t pass = 0; pass < MAX_PASSES; pass++)
+    {
+        bool hasChanged = false;
+        for(size_t i = 0; i < lines.size(); i++)
+        {
+            for(PeepholeRule& rule : rules)
+            {
+                if(lines[i].isDeleted || lines[i].type != AssemblyLineType::Instruction)
+                    break;
+
+                // Collect the next instructions, a window can't cross a label or some user code
+                std::vector<size_t> indices;
+                for(size_t j = i; j < lines.size() && indices.size() < rule.windowSize; j++)
+                {
+                    if(lines[j].isDeleted || lines[j].type == AssemblyLineType::Other)
+                        continue;
+                    if(lines[j].type != AssemblyLineType::Instruction)
+                        break;
+                    indices.push_back(j);
+                }
+                if(indices.size() != rule.windowSize)
+                    continue;
+
+                PeepholeWindow window(lines, labels, indices);
+                if(rule.apply(window))
+                {
+                    rule.hits++;
+                    hasChanged = true;
+                }
+            }
+        }
+        if(!hasChanged)
+            break;
+    }
+}
\ No newline at end of file
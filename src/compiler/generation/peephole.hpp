@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+
+#include "assembly.hpp"
+
+class PeepholeWindow;
+
+/**
+ * @brief A rewrite rule of the peephole optimizer.
+ *
+ * The rule looks at `windowSize` consecutive instructions and returns true if it has rewritten them.
+ */
+struct PeepholeRule
+{
+    std::string name;
+    size_t windowSize;
+    std::function<bool(PeepholeWindow& window)> apply;
+    size_t hits = 0;
+};
+
+/**
+ * @brief Class responsible for removing redundant instructions from the generated assembly code.
+ *
+ * A table of rules is applied to every window of consecutive instructions until no rule matches anymore.
+ */
+class PeepholeOptimizer
+{
+public:
+    /**
+     * @brief Default constructor for the PeepholeOptimizer class.
+     *
+     * Initializes a PeepholeOptimizer object with the default table of rules.
+     */
+    PeepholeOptimizer();
+
+    /**
+     * @brief Optimize the given assembly code, deleting and rewriting its lines in place.
+     * @param code The assembly code of the text section.
+     */
+    void optimize(AssemblyCode& code);
+
+    /**
+     * @brief Get the rules of the optimizer, each one with the number of times it has been applied.
+     */
+    const std::vector<PeepholeRule>& getRules() const;
+
+private:
+    std::vector<PeepholeRule> rules;
+};
+
+/**
+ * @brief A view over some consecutive instructions of the assembly code, given to the peephole rules.
+ */
+class PeepholeWindow
+{
+public:
+    PeepholeWindow(std::vector<AssemblyLine>& lines, const std::unordered_map<std::string, size_t>& labels, std::vector<size_t> indices);
+
+    /**
+     * @brief Get the `index`-th instruction of the window.
+     */
+    AssemblyLine& operator[](size_t index);
+    size_t size() const;
+
+    /**
+     * @brief Remove the `index`-th instruction of the window from the code.
+     */
+    void erase(size_t index);
+    /**
+     * @brief Replace the `index`-th instruction of the window with a new instruction.
+     */
+    void replace(size_t index, const std::string& mnemonic, const std::vector<std::string>& operands);
+
+    /**
+     * @brief Check if the value of a register is never read after the `index`-th instruction of the window.
+     * @param registerName The name of the register (any of its sizes, like `rax`, `eax` or `al`).
+     * @return True only if it's certain that the register is dead, false if it's live or it can't be proven.
+     */
+    bool isRegisterDeadAfter(size_t index, const std::string& registerName) const;
+    /**
+     * @brief Check if the flags register is never read after the `index`-th instruction of the window.
+     * @return True only if it's certain that the flags are dead, false if they are live or it can't be proven.
+     */
+    bool areFlagsDeadAfter(size_t index) const;
+
+private:
+    bool isDeadAfter(size_t lineIndex, const std::string& registerName) const;
+
+    std::vector<AssemblyLine>& lines;
+    const std::unordered_map<std::string, size_t>& labels;
+    std::vector<size_t> indices;
+};
+
+namespace peephole
+{
+    /**
+     * @brief Get the name of the 64 bits register that contains the given register (`eax` -> `rax`).
+     * @return The name of the 64 bits register, or std::nullopt if the operand is not a register.
+     */
+    std::optional<std::string> fullRegister(const std::string& operand);
+
+    /**
+     * @brief Get the offset of an operand in the form `QWORD [rsp + N]`.
+     * @return The offset in bytes, or std::nullopt if the operand isn't a stack slot.
+     */
+    std::optional<long long> stackSlotOffset(const std::string& operand);
+}
\ No newline at end of file
@@ -0,0 +1,772 @@
+#include "runtime.hpp"
+
+#include "special/consts.hpp"
+#include "utils.hpp"
+#include "../optimizer/ast.hpp"
+
+const std::string OUTPUT_BUFFER_SIZE = "65536";
+const std::string INPUT_BUFFER_SIZE = "65536";
+// The small blocks are taken from chunks of this size, and the bigger ones are allocated directly by the system
+const int ARENA_CHUNK_SIZE = 1 << 20;
+const int PAGE_SIZE = 4096;
+// Each block starts with a header of 16 bytes, so that the memory stays aligned to 16 bytes: the size class (or the negated size of the
+// pages of a big block), and the length of the string in the block (or the next block of the free list)
+const int BLOCK_HEADER_SIZE = 16;
+// The size classes are the powers of 2 from 32 to 4096 bytes, with the header
+const int SIZE_CLASSES_COUNT = 8;
+const int SMALLEST_BLOCK_SIZE = 32;
+const int LARGEST_BLOCK_SIZE = SMALLEST_BLOCK_SIZE << (SIZE_CLASSES_COUNT - 1);
+// The allocations bigger than this (the size of the address space of a process) always fail
+const std::string LARGEST_ALLOCATION = "140737488355328";
+// From this size, `rep movsb` and `rep stosb` are faster than the loops on the recent processors
+const int REP_THRESHOLD = 512;
+// The bytes of a 64 bits register are set to the value of its lowest byte by multiplying it by this number (0x0101010101010101)
+const std::string BYTE_BROADCAST = "72340172838076673";
+// The inline copies and fills are at most this size, so that they don't make the code too big
+const long long LARGEST_INLINE_SIZE = 64;
+
+const std::string OUTPUT_BUFFER = "runtime.outputBuffer";
+const std::string OUTPUT_LENGTH = "runtime.outputLength";
+const std::string OUTPUT_IS_TERMINAL = "runtime.outputIsTerminal";
+const std::string INPUT_BUFFER = "runtime.inputBuffer";
+const std::string INPUT_START = "runtime.inputStart";
+const std::string INPUT_END = "runtime.inputEnd";
+const std::string FREE_LISTS = "runtime.freeLists";
+const std::string ARENA_NEXT = "runtime.arenaNext";
+const std::string ARENA_END = "runtime.arenaEnd";
+
+const std::string INITIALIZE_OUTPUT = "runtime.initializeOutput";
+const std::string FLUSH_OUTPUT = "runtime.flushOutput";
+const std::string FILL_INPUT = "runtime.fillInput";
+const std::string REFILL_ARENA = "runtime.refillArena";
+const std::string ALLOCATE_PAGES = "runtime.allocatePages";
+const std::string FREE_PAGES = "runtime.freePages";
+const std::string ALLOCATE = "runtime.allocate";
+const std::string FREE = "runtime.free";
+const std::string COPY_MEMORY = "runtime.copyMemory";
+const std::string REPORT_INDEX_OUT_OF_BOUNDS = "runtime.reportIndexOutOfBounds";
+
+// Written to stderr before exiting with INDEX_OUT_OF_BOUNDS_EXIT_CODE, like the VM and the C translation do
+const std::string INDEX_OUT_OF_BOUNDS_MESSAGE = "Index out of bounds";
+
+// Shared by all the calls of the intrinsics, whose parameters don't have a type
+static StatementDeclareVariableNode* intrinsicParameter()
+{
+    static StatementDeclareVariableNode parameter = StatementDeclareVariableNode
+    {
+        .type = new ExpressionIdentNode(ExpressionIdentNode { .ident = Token { .type = TokenType::Unknown, .value = std::nullopt } }),
+        .name = new ExpressionIdentNode(ExpressionIdentNode { .ident = Token { .type = TokenType::Unknown, .value = std::nullopt } }),
+    };
+    return &parameter;
+}
+
+// Starts a function whose stack is aligned to 16 bytes, with RUNTIME_STACK_SIZE bytes for the system, that preserves `rsi` and `rdi`
+static void beginRuntimeFunction(const std::string& name, GenerateData& generation)
+{
+    generation.code.emitBlankLine();
+    generation.code.emitLabel(name);
+    generation.functions.push_back(FunctionSymbol { .name = name });
+    generation.code.emit("push", { "rbp" });
+    generation.code.emit("mov", { "rbp", "rsp" });
+    generation.code.emit("push", { "rsi" });
+    generation.code.emit("push", { "rdi" });
+    generation.code.emit("and", { "rsp", "-16" });
+    generation.code.emit("sub", { "rsp", std::to_string(RUNTIME_STACK_SIZE) });
+}
+
+static void endRuntimeFunction(GenerateData& generation)
+{
+    generation.code.emit("lea", { "rsp", "[rbp - 16]" });
+    generation.code.emit("pop", { "rdi" });
+    generation.code.emit("pop", { "rsi" });
+    generation.code.emit("pop", { "rbp" });
+    generation.code.emit("ret");
+}
+
+// The intrinsics that create strings use the allocator too
+static bool usesAllocator(const GenerateData& generation)
+{
+    return generation.usesIntrinsic(IntrinsicType::Alloc) || generation.usesIntrinsic(IntrinsicType::Free)
+        || generation.usesIntrinsic(IntrinsicType::Slice) || generation.usesIntrinsic(IntrinsicType::Concat);
+}
+
+// Starts the function of an intrinsic, called with CallingConvention::Registers
+static void beginIntrinsic(const std::string& label, GenerateData& generation)
+{
+    generation.code.emitBlankLine();
+    generation.code.emitLabel(label);
+    generation.functions.push_back(FunctionSymbol { .name = label });
+}
+
+void runtime::declareIntrinsics(const ProgramNode& program, GenerateData& generation)
+{
+    std::unordered_set<std::string> calledFunctions = ast::calledFunctionsOf(program.nodes);
+    for(auto node : program.nodes)
+    {
+        if(auto definition = std::get_if<StatementFunctionDefinitionNode*>(&node->variant))
+            calledFunctions.merge(ast::calledFunctionsOf((*definition)->implementation->statements));
+    }
+
+    for(const Intrinsic& intrinsic : INTRINSICS)
+    {
+        if(!calledFunctions.contains(intrinsic.name) || generation.functionSignatures.contains(intrinsic.name))
+            continue;
+        generation.intrinsics.push_back(intrinsic);
+        // The intrinsics never write in the stack frames of the program
+        generation.functionSignatures[intrinsic.name] = FunctionSignature
+        {
+            .callingConvention = CallingConvention::Registers,
+            .isExternallyVisible = false,
+            .mayClobberMemory = false
+        };
+        generation.globalScope.definedFunctions[intrinsic.name] = Function
+        {
+            .name = intrinsic.name,
+            .parameters = std::vector<StatementDeclareVariableNode*>(intrinsic.parametersCount, intrinsicParameter())
+        };
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Print))
+    {
+        generation.dataSection.push_back(DataDefinition { .name = OUTPUT_LENGTH, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = OUTPUT_IS_TERMINAL, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = OUTPUT_BUFFER, .type = DataType::Reserved, .value = OUTPUT_BUFFER_SIZE });
+    }
+    if(generation.usesIntrinsic(IntrinsicType::Read))
+    {
+        generation.dataSection.push_back(DataDefinition { .name = INPUT_START, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = INPUT_END, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = INPUT_BUFFER, .type = DataType::Reserved, .value = INPUT_BUFFER_SIZE });
+    }
+    if(usesAllocator(generation))
+    {
+        generation.dataSection.push_back(DataDefinition { .name = ARENA_NEXT, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = ARENA_END, .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = FREE_LISTS, .type = DataType::Reserved, .value = std::to_string(SIZE_CLASSES_COUNT * 8) });
+    }
+}
+
+void runtime::generateStartup(GenerateData& generation)
+{
+    if(generation.usesIntrinsic(IntrinsicType::Print))
+        generation.code.emit("call", { INITIALIZE_OUTPUT });
+}
+
+static void generateOutputFunctions(const Target& target, GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+
+    // The output is line buffered when it's a terminal, so that the user sees each line as soon as it's printed
+    beginRuntimeFunction(INITIALIZE_OUTPUT, generation);
+    code.emit("mov", { "rcx", "[rel stdout]" });
+    target.generateIsTerminal(code);
+    code.emit("mov", { "[rel " + OUTPUT_IS_TERMINAL + "]", "rax" });
+    endRuntimeFunction(generation);
+
+    // Writes the whole buffer, even if the system writes only a part of it with each call
+    beginRuntimeFunction(FLUSH_OUTPUT, generation);
+    code.emit("xor", { "ebx", "ebx" });
+    code.emitLabel(FLUSH_OUTPUT + ".loop");
+    code.emit("mov", { "r8", "[rel " + OUTPUT_LENGTH + "]" });
+    code.emit("sub", { "r8", "rbx" });
+    code.emit("jle", { FLUSH_OUTPUT + ".end" });
+    code.emit("mov", { "rcx", "[rel stdout]" });
+    code.emit("lea", { "rdx", "[rel " + OUTPUT_BUFFER + "]" });
+    code.emit("add", { "rdx", "rbx" });
+    target.generateWrite(code);
+    code.emit("test", { "rax", "rax" });
+    code.emit("jle", { FLUSH_OUTPUT + ".end" });
+    code.emit("add", { "rbx", "rax" });
+    code.emit("jmp", { FLUSH_OUTPUT + ".loop" });
+    code.emitLabel(FLUSH_OUTPUT + ".end");
+    code.emit("mov", { "QWORD [rel " + OUTPUT_LENGTH + "]", "0" });
+    endRuntimeFunction(generation);
+
+    const std::string print = utils::internalFunctionLabel("print");
+    beginIntrinsic(print, generation);
+    code.emit("push", { "rsi" });
+    code.emit("push", { "rdi" });
+    code.emit("mov", { "rsi", "rcx" });
+    code.emit("mov", { "rdi", "rcx" });
+    code.emitLabel(print + ".loop");
+    code.emit("movzx", { "eax", "BYTE [rsi]" });
+    code.emit("test", { "eax", "eax" });
+    code.emit("jz", { print + ".end" });
+    code.emit("inc", { "rsi" });
+    code.emit("mov", { "rdx", "[rel " + OUTPUT_LENGTH + "]" });
+    code.emit("lea", { "r8", "[rel " + OUTPUT_BUFFER + "]" });
+    code.emit("mov", { "[r8 + rdx]", "al" });
+    code.emit("inc", { "rdx" });
+    code.emit("mov", { "[rel " + OUTPUT_LENGTH + "]", "rdx" });
+    code.emit("cmp", { "rdx", OUTPUT_BUFFER_SIZE });
+    code.emit("je", { print + ".flush" });
+    code.emit("cmp", { "eax", "10" });
+    code.emit("jne", { print + ".loop" });
+    code.emit("cmp", { "QWORD [rel " + OUTPUT_IS_TERMINAL + "]", "0" });
+    code.emit("je", { print + ".loop" });
+    code.emitLabel(print + ".flush");
+    code.emit("call", { FLUSH_OUTPUT });
+    code.emit("jmp", { print + ".loop" });
+    code.emitLabel(print + ".end");
+    code.emit("mov", { "rax", "rsi" });
+    code.emit("sub", { "rax", "rdi" });
+    code.emit("pop", { "rdi" });
+    code.emit("pop", { "rsi" });
+    code.emit("ret");
+}
+
+static void generateInputFunctions(const Target& target, GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+
+    // Reads as many bytes as the system gives (a line from a terminal, a whole chunk from a file), and returns 0 at the end of the input
+    beginRuntimeFunction(FILL_INPUT, generation);
+    // The user must see what the program printed before it waits for the input
+    if(generation.usesIntrinsic(IntrinsicType::Print))
+        code.emit("call", { FLUSH_OUTPUT });
+    code.emit("mov", { "rcx", "[rel stdin]" });
+    code.emit("lea", { "rdx", "[rel " + INPUT_BUFFER + "]" });
+    code.emit("mov", { "r8", INPUT_BUFFER_SIZE });
+    target.generateRead(code);
+    code.emit("test", { "rax", "rax" });
+    code.emit("jg", { FILL_INPUT + ".filled" });
+    code.emit("xor", { "eax", "eax" });
+    code.emitLabel(FILL_INPUT + ".filled");
+    code.emit("mov", { "QWORD [rel " + INPUT_START + "]", "0" });
+    code.emit("mov", { "[rel " + INPUT_END + "]", "rax" });
+    endRuntimeFunction(generation);
+
+    const std::string read = utils::internalFunctionLabel("read");
+    beginIntrinsic(read, generation);
+    code.emit("push", { "rsi" });
+    code.emit("push", { "rdi" });
+    code.emit("mov", { "rdi", "rcx" });
+    code.emit("xor", { "esi", "esi" });
+    // The maximum number of characters, that leaves space for the null character
+    code.emit("dec", { "rdx" });
+    code.emit("push", { "rdx" });
+    code.emit("test", { "rdx", "rdx" });
+    code.emit("js", { read + ".empty" });
+    code.emitLabel(read + ".loop");
+    code.emit("cmp", { "rsi", "[rsp]" });
+    code.emit("jge", { read + ".end" });
+    code.emit("mov", { "rax", "[rel " + INPUT_START + "]" });
+    code.emit("cmp", { "rax", "[rel " + INPUT_END + "]" });
+    code.emit("jl", { read + ".hasInput" });
+    code.emit("call", { FILL_INPUT });
+    code.emit("test", { "rax", "rax" });
+    code.emit("jz", { read + ".end" });
+    code.emit("xor", { "eax", "eax" });
+    code.emitLabel(read + ".hasInput");
+    code.emit("lea", { "rcx", "[rel " + INPUT_BUFFER + "]" });
+    code.emit("movzx", { "edx", "BYTE [rcx + rax]" });
+    code.emit("inc", { "rax" });
+    code.emit("mov", { "[rel " + INPUT_START + "]", "rax" });
+    code.emit("mov", { "[rdi + rsi]", "dl" });
+    code.emit("inc", { "rsi" });
+    code.emit("cmp", { "edx", "10" });
+    code.emit("jne", { read + ".loop" });
+    code.emitLabel(read + ".end");
+    code.emit("mov", { "BYTE [rdi + rsi]", "0" });
+    code.emit("mov", { "[rdi - " + std::to_string(STRING_LENGTH_SIZE) + "]", "rsi" });
+    code.emitLabel(read + ".empty");
+    code.emit("mov", { "rax", "rsi" });
+    code.emit("pop", { "rdx" });
+    code.emit("pop", { "rdi" });
+    code.emit("pop", { "rsi" });
+    code.emit("ret");
+}
+
+// Allocates the small blocks from free lists of blocks of the same size class, that are refilled with a bump allocator
+static void generateMemoryFunctions(const Target& target, GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+
+    // Maps a new chunk for the bump allocator, and returns 0 if there's no memory; the rest of the old chunk is lost
+    beginRuntimeFunction(REFILL_ARENA, generation);
+    code.emit("mov", { "ecx", std::to_string(ARENA_CHUNK_SIZE) });
+    target.generateAllocatePages(code);
+    code.emit("test", { "rax", "rax" });
+    code.emit("jz", { REFILL_ARENA + ".end" });
+    code.emit("mov", { "[rel " + ARENA_NEXT + "]", "rax" });
+    code.emit("add", { "rax", std::to_string(ARENA_CHUNK_SIZE) });
+    code.emit("mov", { "[rel " + ARENA_END + "]", "rax" });
+    code.emitLabel(REFILL_ARENA + ".end");
+    endRuntimeFunction(generation);
+
+    beginRuntimeFunction(ALLOCATE_PAGES, generation);
+    target.generateAllocatePages(code);
+    endRuntimeFunction(generation);
+
+    beginRuntimeFunction(FREE_PAGES, generation);
+    target.generateFreePages(code);
+    endRuntimeFunction(generation);
+
+    // The intrinsics are other names of the functions used by the runtime, so that the functions of the program can replace them
+    const std::string alloc = ALLOCATE;
+    beginIntrinsic(alloc, generation);
+    if(generation.usesIntrinsic(IntrinsicType::Alloc))
+        code.emitLabel(utils::internalFunctionLabel("alloc"));
+    code.emit("cmp", { "rcx", std::to_string(LARGEST_BLOCK_SIZE - BLOCK_HEADER_SIZE) });
+    code.emit("ja", { alloc + ".large" });
+    // The size class is the smallest one whose blocks contain the header and the requested bytes
+    code.emit("add", { "rcx", std::to_string(BLOCK_HEADER_SIZE) });
+    code.emit("xor", { "r8d", "r8d" });
+    code.emit("mov", { "eax", std::to_string(SMALLEST_BLOCK_SIZE) });
+    code.emitLabel(alloc + ".class");
+    code.emit("cmp", { "rax", "rcx" });
+    code.emit("jae", { alloc + ".classFound" });
+    code.emit("shl", { "rax", "1" });
+    code.emit("inc", { "r8" });
+    code.emit("jmp", { alloc + ".class" });
+    code.emitLabel(alloc + ".classFound");
+    code.emit("lea", { "r9", "[rel " + FREE_LISTS + "]" });
+    code.emit("mov", { "rcx", "[r9 + r8 * 8]" });
+    code.emit("test", { "rcx", "rcx" });
+    code.emit("jz", { alloc + ".bump" });
+    // A freed block is reused, after setting its memory and its length to 0
+    code.emit("mov", { "r10", "[rcx + 8]" });
+    code.emit("mov", { "[r9 + r8 * 8]", "r10" });
+    code.emit("mov", { "QWORD [rcx + 8]", "0" });
+    code.emit("lea", { "r10", "[rcx + " + std::to_string(BLOCK_HEADER_SIZE) + "]" });
+    code.emit("lea", { "r11", "[rcx + rax]" });
+    code.emitLabel(alloc + ".clear");
+    code.emit("mov", { "QWORD [r10]", "0" });
+    code.emit("mov", { "QWORD [r10 + 8]", "0" });
+    code.emit("add", { "r10", "16" });
+    code.emit("cmp", { "r10", "r11" });
+    code.emit("jb", { alloc + ".clear" });
+    code.emit("lea", { "rax", "[rcx + " + std::to_string(BLOCK_HEADER_SIZE) + "]" });
+    code.emit("ret");
+    // The memory of a new block comes from the system, so it's already set to 0
+    code.emitLabel(alloc + ".bump");
+    code.emit("mov", { "rcx", "[rel " + ARENA_NEXT + "]" });
+    code.emit("lea", { "r10", "[rcx + rax]" });
+    code.emit("cmp", { "r10", "[rel " + ARENA_END + "]" });
+    code.emit("ja", { alloc + ".refill" });
+    code.emit("mov", { "[rel " + ARENA_NEXT + "]", "r10" });
+    code.emit("mov", { "[rcx]", "r8" });
+    code.emit("lea", { "rax", "[rcx + " + std::to_string(BLOCK_HEADER_SIZE) + "]" });
+    code.emit("ret");
+    code.emitLabel(alloc + ".refill");
+    code.emit("push", { "rax" });
+    code.emit("push", { "r8" });
+    code.emit("call", { REFILL_ARENA });
+    code.emit("mov", { "rcx", "rax" });
+    code.emit("pop", { "r8" });
+    code.emit("pop", { "rax" });
+    code.emit("test", { "rcx", "rcx" });
+    code.emit("jnz", { alloc + ".bump" });
+    code.emit("xor", { "eax", "eax" });
+    code.emit("ret");
+    // The big blocks have their own pages, and their header contains their size instead of the next free block
+    code.emitLabel(alloc + ".large");
+    code.emit("mov", { "rax", LARGEST_ALLOCATION });
+    code.emit("cmp", { "rcx", "rax" });
+    code.emit("ja", { alloc + ".failed" });
+    code.emit("add", { "rcx", std::to_string(BLOCK_HEADER_SIZE + PAGE_SIZE - 1) });
+    code.emit("and", { "rcx", std::to_string(-PAGE_SIZE) });
+    code.emit("push", { "rcx" });
+    code.emit("call", { ALLOCATE_PAGES });
+    code.emit("pop", { "rcx" });
+    code.emit("test", { "rax", "rax" });
+    code.emit("jz", { alloc + ".failed" });
+    code.emit("neg", { "rcx" });
+    code.emit("mov", { "[rax]", "rcx" });
+    code.emit("add", { "rax", std::to_string(BLOCK_HEADER_SIZE) });
+    code.emit("ret");
+    code.emitLabel(alloc + ".failed");
+    code.emit("xor", { "eax", "eax" });
+    code.emit("ret");
+
+    const std::string free = FREE;
+    beginIntrinsic(free, generation);
+    if(generation.usesIntrinsic(IntrinsicType::Free))
+        code.emitLabel(utils::internalFunctionLabel("free"));
+    code.emit("test", { "rcx", "rcx" });
+    code.emit("jz", { free + ".end" });
+    code.emit("sub", { "rcx", std::to_string(BLOCK_HEADER_SIZE) });
+    code.emit("mov", { "rax", "[rcx]" });
+    code.emit("test", { "rax", "rax" });
+    code.emit("js", { free + ".large" });
+    code.emit("lea", { "r9", "[rel " + FREE_LISTS + "]" });
+    code.emit("mov", { "rdx", "[r9 + rax * 8]" });
+    code.emit("mov", { "[rcx + 8]", "rdx" });
+    code.emit("mov", { "[r9 + rax * 8]", "rcx" });
+    code.emit("jmp", { free + ".end" });
+    code.emitLabel(free + ".large");
+    code.emit("mov", { "rdx", "rax" });
+    code.emit("neg", { "rdx" });
+    code.emit("call", { FREE_PAGES });
+    code.emitLabel(free + ".end");
+    code.emit("xor", { "eax", "eax" });
+    code.emit("ret");
+}
+
+// Emits a loop that writes `xmm0` in the 16 bytes chunks of the `r8` bytes (at least 16) at the address in `rcx`, after loading them from
+// the address in `rdx` if `isCopy`; the last chunk overlaps the previous one instead of writing the rest byte by byte
+static void generateChunksLoop(const std::string& label, bool isCopy, GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+    code.emit("lea", { "r9", "[r8 - 16]" });
+    code.emit("xor", { "r10d", "r10d" });
+    code.emitLabel(label + ".chunk");
+    if(isCopy)
+        code.emit("movdqu", { "xmm0", "[rdx + r10]" });
+    code.emit("movdqu", { "[rcx + r10]", "xmm0" });
+    code.emit("add", { "r10", "16" });
+    code.emit("cmp", { "r10", "r9" });
+    code.emit("jb", { label + ".chunk" });
+    if(isCopy)
+        code.emit("movdqu", { "xmm0", "[rdx + r9]" });
+    code.emit("movdqu", { "[rcx + r9]", "xmm0" });
+    code.emit("ret");
+}
+
+// The functions on raw bytes use the SSE2 instructions, that all the x86-64 processors have, 16 bytes at a time
+static void generateBytesFunctions(GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+
+    if(generation.usesIntrinsic(IntrinsicType::Memcopy) || generation.usesIntrinsic(IntrinsicType::Slice) || generation.usesIntrinsic(IntrinsicType::Concat))
+    {
+        // Copies `r8` bytes from the address in `rdx` to the one in `rcx`, and returns the destination
+        beginIntrinsic(COPY_MEMORY, generation);
+        if(generation.usesIntrinsic(IntrinsicType::Memcopy))
+            code.emitLabel(utils::internalFunctionLabel("memcopy"));
+        code.emit("mov", { "rax", "rcx" });
+        code.emit("cmp", { "r8", "16" });
+        code.emit("jl", { COPY_MEMORY + ".small" });
+        code.emit("cmp", { "r8", std::to_string(REP_THRESHOLD) });
+        code.emit("jge", { COPY_MEMORY + ".large" });
+        generateChunksLoop(COPY_MEMORY, true, generation);
+        code.emitLabel(COPY_MEMORY + ".small");
+        code.emit("test", { "r8", "r8" });
+        code.emit("jle", { COPY_MEMORY + ".end" });
+        code.emitLabel(COPY_MEMORY + ".byte");
+        code.emit("dec", { "r8" });
+        code.emit("movzx", { "r9d", "BYTE [rdx + r8]" });
+        code.emit("mov", { "[rcx + r8]", "r9b" });
+        code.emit("jnz", { COPY_MEMORY + ".byte" });
+        code.emitLabel(COPY_MEMORY + ".end");
+        code.emit("ret");
+        code.emitLabel(COPY_MEMORY + ".large");
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        code.emit("mov", { "rdi", "rcx" });
+        code.emit("mov", { "rsi", "rdx" });
+        code.emit("mov", { "rcx", "r8" });
+        code.emit("rep movsb");
+        code.emit("pop", { "rdi" });
+        code.emit("pop", { "rsi" });
+        code.emit("ret");
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Memfill))
+    {
+        const std::string memfill = utils::internalFunctionLabel("memfill");
+        beginIntrinsic(memfill, generation);
+        code.emit("mov", { "rax", "rcx" });
+        code.emit("cmp", { "r8", "16" });
+        code.emit("jl", { memfill + ".small" });
+        code.emit("cmp", { "r8", std::to_string(REP_THRESHOLD) });
+        code.emit("jge", { memfill + ".large" });
+        code.emit("movzx", { "edx", "dl" });
+        code.emit("mov", { "r9", BYTE_BROADCAST });
+        code.emit("imul", { "rdx", "r9" });
+        code.emit("movq", { "xmm0", "rdx" });
+        code.emit("punpcklqdq", { "xmm0", "xmm0" });
+        generateChunksLoop(memfill, false, generation);
+        code.emitLabel(memfill + ".small");
+        code.emit("test", { "r8", "r8" });
+        code.emit("jle", { memfill + ".end" });
+        code.emitLabel(memfill + ".byte");
+        code.emit("dec", { "r8" });
+        code.emit("mov", { "[rcx + r8]", "dl" });
+        code.emit("jnz", { memfill + ".byte" });
+        code.emitLabel(memfill + ".end");
+        code.emit("ret");
+        code.emitLabel(memfill + ".large");
+        code.emit("push", { "rdi" });
+        code.emit("mov", { "rdi", "rcx" });
+        code.emit("mov", { "rcx", "r8" });
+        code.emit("mov", { "r9", "rax" });
+        code.emit("mov", { "eax", "edx" });
+        code.emit("rep stosb");
+        code.emit("mov", { "rax", "r9" });
+        code.emit("pop", { "rdi" });
+        code.emit("ret");
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Memcompare))
+    {
+        // The mask of `pmovmskb` has a bit set for each equal byte, so the first different byte is the first bit not set
+        const std::string memcompare = utils::internalFunctionLabel("memcompare");
+        beginIntrinsic(memcompare, generation);
+        code.emit("xor", { "r10d", "r10d" });
+        code.emit("lea", { "r9", "[r8 - 16]" });
+        code.emit("cmp", { "r8", "16" });
+        code.emit("jl", { memcompare + ".byte" });
+        code.emitLabel(memcompare + ".chunk");
+        code.emit("movdqu", { "xmm0", "[rcx + r10]" });
+        code.emit("movdqu", { "xmm1", "[rdx + r10]" });
+        code.emit("pcmpeqb", { "xmm0", "xmm1" });
+        code.emit("pmovmskb", { "eax", "xmm0" });
+        code.emit("xor", { "eax", "65535" });
+        code.emit("jnz", { memcompare + ".different" });
+        code.emit("add", { "r10", "16" });
+        code.emit("cmp", { "r10", "r9" });
+        code.emit("jle", { memcompare + ".chunk" });
+        code.emitLabel(memcompare + ".byte");
+        code.emit("cmp", { "r10", "r8" });
+        code.emit("jge", { memcompare + ".equal" });
+        code.emit("movzx", { "eax", "BYTE [rcx + r10]" });
+        code.emit("movzx", { "r9d", "BYTE [rdx + r10]" });
+        code.emit("sub", { "rax", "r9" });
+        code.emit("jnz", { memcompare + ".end" });
+        code.emit("inc", { "r10" });
+        code.emit("jmp", { memcompare + ".byte" });
+        code.emitLabel(memcompare + ".different");
+        code.emit("bsf", { "eax", "eax" });
+        code.emit("add", { "r10", "rax" });
+        code.emit("movzx", { "eax", "BYTE [rcx + r10]" });
+        code.emit("movzx", { "r9d", "BYTE [rdx + r10]" });
+        code.emit("sub", { "rax", "r9" });
+        code.emit("ret");
+        code.emitLabel(memcompare + ".equal");
+        code.emit("xor", { "eax", "eax" });
+        code.emitLabel(memcompare + ".end");
+        code.emit("ret");
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Strlength))
+    {
+        // The chunks are aligned to 16 bytes, so that reading them never crosses the end of a page after the null character
+        const std::string strlength = utils::internalFunctionLabel("strlength");
+        beginIntrinsic(strlength, generation);
+        code.emit("mov", { "rdx", "rcx" });
+        code.emit("and", { "rdx", "-16" });
+        code.emit("pxor", { "xmm1", "xmm1" });
+        code.emit("movdqa", { "xmm0", "[rdx]" });
+        code.emit("pcmpeqb", { "xmm0", "xmm1" });
+        code.emit("pmovmskb", { "eax", "xmm0" });
+        // The bytes of the first chunk before the string are ignored
+        code.emit("mov", { "r9", "rcx" });
+        code.emit("and", { "ecx", "15" });
+        code.emit("shr", { "eax", "cl" });
+        code.emit("test", { "eax", "eax" });
+        code.emit("jnz", { strlength + ".first" });
+        code.emitLabel(strlength + ".chunk");
+        code.emit("add", { "rdx", "16" });
+        code.emit("movdqa", { "xmm0", "[rdx]" });
+        code.emit("pcmpeqb", { "xmm0", "xmm1" });
+        code.emit("pmovmskb", { "eax", "xmm0" });
+        code.emit("test", { "eax", "eax" });
+        code.emit("jz", { strlength + ".chunk" });
+        code.emit("bsf", { "eax", "eax" });
+        code.emit("add", { "rax", "rdx" });
+        code.emit("sub", { "rax", "r9" });
+        code.emit("ret");
+        code.emitLabel(strlength + ".first");
+        code.emit("bsf", { "eax", "eax" });
+        code.emit("ret");
+    }
+}
+
+// The new strings are allocated with the allocator of the runtime, that sets their last character to 0
+static void generateStringFunctions(GenerateData& generation)
+{
+    AssemblyCode& code = generation.code;
+    const std::string lengthOf = std::to_string(STRING_LENGTH_SIZE);
+
+    if(generation.usesIntrinsic(IntrinsicType::Length))
+    {
+        beginIntrinsic(utils::internalFunctionLabel("length"), generation);
+        code.emit("mov", { "rax", "[rcx - " + lengthOf + "]" });
+        code.emit("ret");
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Slice))
+    {
+        const std::string slice = utils::internalFunctionLabel("slice");
+        beginIntrinsic(slice, generation);
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        // 0 <= start <= end <= length
+        code.emit("xor", { "r9d", "r9d" });
+        code.emit("mov", { "rax", "[rcx - " + lengthOf + "]" });
+        code.emit("cmp", { "r8", "rax" });
+        code.emit("cmovg", { "r8", "rax" });
+        code.emit("test", { "r8", "r8" });
+        code.emit("cmovl", { "r8", "r9" });
+        code.emit("test", { "rdx", "rdx" });
+        code.emit("cmovl", { "rdx", "r9" });
+        code.emit("cmp", { "rdx", "r8" });
+        code.emit("cmovg", { "rdx", "r8" });
+        code.emit("lea", { "rsi", "[rcx + rdx]" });
+        code.emit("mov", { "rdi", "r8" });
+        code.emit("sub", { "rdi", "rdx" });
+        code.emit("lea", { "rcx", "[rdi + 1]" });
+        code.emit("call", { ALLOCATE });
+        code.emit("test", { "rax", "rax" });
+        code.emit("jz", { slice + ".end" });
+        code.emit("mov", { "[rax - " + lengthOf + "]", "rdi" });
+        code.emit("push", { "rax" });
+        code.emit("mov", { "rcx", "rax" });
+        code.emit("mov", { "rdx", "rsi" });
+        code.emit("mov", { "r8", "rdi" });
+        code.emit("call", { COPY_MEMORY });
+        code.emit("pop", { "rax" });
+        code.emitLabel(slice + ".end");
+        code.emit("pop", { "rdi" });
+        code.emit("pop", { "rsi" });
+        code.emit("ret");
+    }
+
+    if(generation.usesIntrinsic(IntrinsicType::Concat))
+    {
+        const std::string concat = utils::internalFunctionLabel("concat");
+        beginIntrinsic(concat, generation);
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        code.emit("mov", { "rsi", "rcx" });
+        code.emit("mov", { "rdi", "rdx" });
+        code.emit("mov", { "rcx", "[rsi - " + lengthOf + "]" });
+        code.emit("add", { "rcx", "[rdi - " + lengthOf + "]" });
+        code.emit("inc", { "rcx" });
+        code.emit("call", { ALLOCATE });
+        code.emit("test", { "rax", "rax" });
+        code.emit("jz", { concat + ".end" });
+        code.emit("mov", { "rcx", "[rsi - " + lengthOf + "]" });
+        code.emit("add", { "rcx", "[rdi - " + lengthOf + "]" });
+        code.emit("mov", { "[rax - " + lengthOf + "]", "rcx" });
+        code.emit("push", { "rax" });
+        code.emit("mov", { "rcx", "rax" });
+        code.emit("mov", { "rdx", "rsi" });
+        code.emit("mov", { "r8", "[rsi - " + lengthOf + "]" });
+        code.emit("call", { COPY_MEMORY });
+        code.emit("mov", { "rcx", "[rsp]" });
+        code.emit("add", { "rcx", "[rsi - " + lengthOf + "]" });
+        code.emit("mov", { "rdx", "rdi" });
+        code.emit("mov", { "r8", "[rdi - " + lengthOf + "]" });
+        code.emit("call", { COPY_MEMORY });
+        code.emit("pop", { "rax" });
+        code.emitLabel(concat + ".end");
+        code.emit("pop", { "rdi" });
+        code.emit("pop", { "rsi" });
+        code.emit("ret");
+    }
+}
+
+void runtime::generateIntrinsics(const Target& target, GenerateData& generation)
+{
+    if(generation.usesIntrinsic(IntrinsicType::Print))
+        generateOutputFunctions(target, generation);
+    if(generation.usesIntrinsic(IntrinsicType::Read))
+        generateInputFunctions(target, generation);
+    if(usesAllocator(generation))
+        generateMemoryFunctions(target, generation);
+    generateBytesFunctions(generation);
+    generateStringFunctions(generation);
+    if(generation.usesBoundsChecks)
+    {
+        AssemblyCode& code = generation.code;
+        beginRuntimeFunction(REPORT_INDEX_OUT_OF_BOUNDS, generation);
+        code.emit("mov", { "rcx", "[rel stderr]" });
+        code.emit("lea", { "rdx", "[rel " + generation.defineStringLiteral(INDEX_OUT_OF_BOUNDS_MESSAGE + "\\n") + "]" });
+        code.emit("mov", { "r8", std::to_string(INDEX_OUT_OF_BOUNDS_MESSAGE.size() + 1) });
+        target.generateWrite(code);
+        endRuntimeFunction(generation);
+
+        // The output written before the error is kept, and the message comes after it
+        code.emitBlankLine();
+        code.emitLabel(INDEX_OUT_OF_BOUNDS);
+        generation.functions.push_back(FunctionSymbol { .name = INDEX_OUT_OF_BOUNDS });
+        if(generation.usesIntrinsic(IntrinsicType::Print))
+            code.emit("call", { FLUSH_OUTPUT });
+        code.emit("call", { REPORT_INDEX_OUT_OF_BOUNDS });
+        target.generateExit(std::to_string(INDEX_OUT_OF_BOUNDS_EXIT_CODE), code);
+    }
+}
+
+// Writes the chunks of 16 bytes of `xmm0`, the last one overlapping the previous one, then the rest with the parts of the register
+// (`r9` or `rdx`) whose names are given from the biggest one
+static void generateInlineStores(long long size, bool isCopy, const std::vector<std::string>& registerParts, GenerateData& generation)
+{
+    auto at = [](const std::string& base, long long offset) { return "[" + base + (offset == 0 ? "" : " + " + std::to_string(offset)) + "]"; };
+    long long offset = 0;
+    for(; offset + 16 <= size; offset += 16)
+    {
+        if(isCopy)
+            generation.code.emit("movdqu", { "xmm0", at("rdx", offset) });
+        generation.code.emit("movdqu", { at("rcx", offset), "xmm0" });
+    }
+    if(offset < size && size >= 16)
+    {
+        if(isCopy)
+            generation.code.emit("movdqu", { "xmm0", at("rdx", size - 16) });
+        generation.code.emit("movdqu", { at("rcx", size - 16), "xmm0" });
+        return;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        long long partSize = 8 >> i;
+        for(; offset + partSize <= size; offset += partSize)
+        {
+            if(isCopy)
+                generation.code.emit("mov", { registerParts[i], at("rdx", offset) });
+            generation.code.emit("mov", { at("rcx", offset), registerParts[i] });
+        }
+    }
+}
+
+bool runtime::generateInlineIntrinsic(const ExpressionFunctionCallNode* call, GenerateData& generation)
+{
+    std::optional<Intrinsic> intrinsic = findIntrinsic(call->functionName->ident.value.value());
+    if(!intrinsic.has_value() || !generation.usesIntrinsic(intrinsic->type)
+        || (intrinsic->type != IntrinsicType::Memcopy && intrinsic->type != IntrinsicType::Memfill))
+        return false;
+    std::optional<long long> size = ast::numberOf(call->arguments[2]);
+    if(!size.has_value() || size.value() < 0 || size.value() > LARGEST_INLINE_SIZE)
+        return false;
+
+    if(intrinsic->type == IntrinsicType::Memcopy)
+    {
+        generation.code.emitComment("Inline memcopy of " + std::to_string(size.value()) + " bytes");
+        generateInlineStores(size.value(), true, { "r9", "r9d", "r9w", "r9b" }, generation);
+    }
+    else
+    {
+        generation.code.emitComment("Inline memfill of " + std::to_string(size.value()) + " bytes");
+        if(size.value() > 0)
+        {
+            generation.code.emit("movzx", { "edx", "dl" });
+            generation.code.emit("mov", { "r9", BYTE_BROADCAST });
+            generation.code.emit("imul", { "rdx", "r9" });
+        }
+        if(size.value() >= 16)
+        {
+            generation.code.emit("movq", { "xmm0", "rdx" });
+            generation.code.emit("punpcklqdq", { "xmm0", "xmm0" });
+        }
+        generateInlineStores(size.value(), false, { "rdx", "edx", "dx", "dl" }, generation);
+    }
+    generation.code.emit("mov", { "rax", "rcx" });
+    return true;
+}
+
+void runtime::generateExit(const std::string& exitCode, const Target& target, GenerateData& generation)
+{
+    if(!generation.usesIntrinsic(IntrinsicType::Print))
+    {
+        target.generateExit(exitCode, generation.code);
+        return;
+    }
+
+    if(exitCode != "rax")
+        generation.code.emit("mov", { "rax", exitCode });
+    generation.code.emit("push", { "rax" });
+    generation.code.emit("call", { FLUSH_OUTPUT });
+    generation.code.emit("pop", { "rax" });
+    target.generateExit("rax", generation.code);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+#include "generation_data.hpp"
+#include "target.hpp"
+#include "../parser/node/core.hpp"
+
+/**
+ * @brief Functions that generate the runtime of the intrinsics, that is emitted with the program and shared by every target.
+ *
+ * The intrinsics are called with CallingConvention::Registers, and they talk to the system only through the Target.
+ * Their data and their helper functions have a `runtime.` prefix, that can't be used by the names of the program.
+ */
+namespace runtime
+{
+    /// The label where the code jumps when the index of an element isn't in the bounds of its array, that writes a message to stderr and exits with INDEX_OUT_OF_BOUNDS_EXIT_CODE.
+    const std::string INDEX_OUT_OF_BOUNDS = "runtime.indexOutOfBounds";
+
+    /**
+     * @brief Declare the intrinsics called by the program (and not replaced by its functions), with the data they need.
+     *
+     * Must be called after the signatures of the functions of the program are known.
+     */
+    void declareIntrinsics(const ProgramNode& program, GenerateData& generation);
+
+    /**
+     * @brief Generate the code that initializes the runtime of the intrinsics, after the startup of the target.
+     */
+    void generateStartup(GenerateData& generation);
+
+    /**
+     * @brief Generate the functions of the declared intrinsics, and the code reached by the failed bounds checks.
+     */
+    void generateIntrinsics(const Target& target, GenerateData& generation);
+
+    /**
+     * @brief Generate the code of a call to an intrinsic in place of the call, when it's small enough (`memcopy` and `memfill` with a constant size).
+     *
+     * The arguments are already in the registers of CallingConvention::Registers, and the result is written in `rax`.
+     * @return If the code has been generated, else the intrinsic must be called.
+     */
+    bool generateInlineIntrinsic(const ExpressionFunctionCallNode* call, GenerateData& generation);
+
+    /**
+     * @brief Generate the code that exits the process, writing the buffered output before.
+     * @param exitCode The exit code: a register or an immediate.
+     */
+    void generateExit(const std::string& exitCode, const Target& target, GenerateData& generation);
+}
\ No newline at end of file
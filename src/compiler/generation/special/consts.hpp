@@ -1,10 +1,28 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 const std::string TAB = "\t";
 const std::string NEW_LINE = "\n";
 const std::string START = "main";
 const std::string STRING_LITERAL_PREFIX = "strLit";
+// Bytes of the length of a string, stored before its characters
+const int STRING_LENGTH_SIZE = 8;
+// Comments that surround the code written by the user with the `asm!` macro
+const std::string ASM_MACRO_START = "asm! start";
+const std::string ASM_MACRO_END = "asm! end";
 
-const std::string EXIT_PROCESS_WINDOWS = "ExitProcess";
\ No newline at end of file
+const std::string EXIT_PROCESS_WINDOWS = "ExitProcess";
+// Bytes reserved on the stack for the callee by the Windows x64 calling convention
+const int SHADOW_SPACE_SIZE = 32;
+// Bytes of the stack reserved by the runtime functions for the calls to the system: the shadow space, the 5th argument and some space for the results
+const int RUNTIME_STACK_SIZE = 96;
+// Registers used to pass the first arguments to a function, in order
+const std::vector<std::string> ARGUMENT_REGISTERS = { "rcx", "rdx", "r8", "r9" };
+// Registers that keep an operand of a binary operation while the other one is computed, instead of pushing it on the stack
+const std::vector<std::string> TEMPORARY_REGISTERS = { "r10", "r11" };
+// Suffix of the label of a function that uses the internal calling convention
+const std::string INTERNAL_FUNCTION_SUFFIX = ".internal";
+// Exit code of a program that accesses an element outside of the bounds of its array
+const int INDEX_OUT_OF_BOUNDS_EXIT_CODE = 101;
\ No newline at end of file
@@ -4,4 +4,30 @@ struct Function
 {
     std::string name;
     std::vector<StatementDeclareVariableNode*> parameters;
+};
+
+/**
+ * @brief Enumeration representing how the arguments and the returned value of a function are passed.
+ */
+enum class CallingConvention
+{
+    /// The arguments are pushed on the stack and the returned value replaces them.
+    /// Used by the functions that contain an `asm!` macro without operands, because the user code reads the arguments from the stack.
+    Stack,
+    /// The first 4 arguments are passed in `rcx`, `rdx`, `r8` and `r9`, the others on the stack, and the returned value is in `rax`.
+    /// `rax`, `rbx`, `rcx`, `rdx` and `r8`-`r11` can be overwritten by the function.
+    Registers
+};
+
+/**
+ * @brief Structure representing what the code generation needs to know about a function before generating its calls.
+ */
+struct FunctionSignature
+{
+    CallingConvention callingConvention;
+    /// True if the function is referenced by the code written by the user with the `asm!` macro.
+    bool isExternallyVisible;
+    /// True if the function (or any function it calls) runs code written by the user with an `asm!` macro without operands
+    /// (or that clobbers `memory`), that can write anywhere in memory, also in the stack frame of the caller.
+    bool mayClobberMemory;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+
+/**
+ * @brief Enumeration representing the functions provided by the compiler.
+ *
+ * The strings keep their length in the 8 bytes before their characters: the string literals, the memory returned by
+ * `alloc` (an empty string) and the strings written by the intrinsics have it, so `read` needs a buffer returned by `alloc`.
+ */
+enum class IntrinsicType
+{
+    /// `int print(string text)`: write the text (until its null character) to stdout, and return its length.
+    Print,
+    /// `int read(string buffer, int size)`: read a line from stdin (with its `\n`, and at most `size - 1` characters),
+    /// write it in the buffer followed by a null character, and return its length (0 at the end of the input), that becomes the length of the buffer.
+    Read,
+    /// `string alloc(int size)`: allocate `size` bytes set to 0, and return their address (0 if there's no memory).
+    Alloc,
+    /// `int free(string memory)`: release the memory returned by `alloc` (nothing happens with 0), and return 0.
+    Free,
+    /// `int length(string text)`: return the length of the text, without reading its characters.
+    Length,
+    /// `string slice(string text, int start, int end)`: return a new string with the characters from `start` to `end` (excluded) of the text,
+    /// limited to the characters of the text.
+    Slice,
+    /// `string concat(string first, string second)`: return a new string with the characters of the first string followed by the second one.
+    Concat,
+    /// `string memcopy(string destination, string source, int size)`: copy `size` bytes from the source to the destination,
+    /// that must not overlap, and return the destination. The lengths of the strings don't change.
+    Memcopy,
+    /// `string memfill(string destination, int value, int size)`: set `size` bytes of the destination to the value (modulo 256), and return the destination.
+    Memfill,
+    /// `int memcompare(string first, string second, int size)`: compare the first `size` bytes of the strings, and return 0 if they are equal,
+    /// else the difference between the first different bytes (as unsigned numbers).
+    Memcompare,
+    /// `int strlength(string text)`: return the number of characters before the null character, for the strings without a length like the ones made by `asm!`.
+    Strlength
+};
+
+/**
+ * @brief Structure representing a function provided by the compiler, that the programs can call without defining it.
+ *
+ * A function defined by the program with the same name replaces the intrinsic.
+ */
+struct Intrinsic
+{
+    IntrinsicType type;
+    std::string name;
+    size_t parametersCount;
+};
+
+const std::vector<Intrinsic> INTRINSICS = {
+    { IntrinsicType::Print, "print", 1 },
+    { IntrinsicType::Read, "read", 2 },
+    { IntrinsicType::Alloc, "alloc", 1 },
+    { IntrinsicType::Free, "free", 1 },
+    { IntrinsicType::Length, "length", 1 },
+    { IntrinsicType::Slice, "slice", 3 },
+    { IntrinsicType::Concat, "concat", 2 },
+    { IntrinsicType::Memcopy, "memcopy", 3 },
+    { IntrinsicType::Memfill, "memfill", 3 },
+    { IntrinsicType::Memcompare, "memcompare", 3 },
+    { IntrinsicType::Strlength, "strlength", 1 }
+};
+
+/**
+ * @brief Get the intrinsic with the given name, if there's one.
+ */
+inline std::optional<Intrinsic> findIntrinsic(const std::string& name)
+{
+    for(const Intrinsic& intrinsic : INTRINSICS)
+    {
+        if(intrinsic.name == name)
+            return intrinsic;
+    }
+    return std::nullopt;
+}
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "target.hpp"
+
+#include "special/consts.hpp"
+#include "utils.hpp"
+
+// Numbers of the Linux x86-64 system calls
+const std::string SYSCALL_READ = "0";
+const std::string SYSCALL_WRITE = "1";
+const std::string SYSCALL_MMAP = "9";
+const std::string SYSCALL_MUNMAP = "11";
+const std::string SYSCALL_IOCTL = "16";
+const std::string SYSCALL_EXIT = "60";
+// `PROT_READ | PROT_WRITE` and `MAP_PRIVATE | MAP_ANONYMOUS`
+const std::string MMAP_PROTECTION = "3";
+const std::string MMAP_FLAGS = "34";
+// Minimum number of bytes requested to the kernel each time the heap is full
+const std::string HEAP_CHUNK_SIZE = "1048576";
+// The request of `ioctl` that gets the settings of a terminal, that fails if the file isn't a terminal
+const std::string IOCTL_TCGETS = "21505";
+
+std::shared_ptr<const Target> Target::create(TargetPlatform platform)
+{
+    switch(platform)
+    {
+        case TargetPlatform::Windows:
+            return std::make_shared<WindowsTarget>();
+        case TargetPlatform::Linux:
+            return std::make_shared<LinuxTarget>();
+    }
+    return nullptr;
+}
+
+std::string WindowsTarget::getEntryPoint() const
+{
+    return START;
+}
+
+void WindowsTarget::declareRuntime(const ProgramNode& program, GenerateData& generation) const
+{
+    generation.dataSection.push_back(DataDefinition { .name = "stdout", .type = DataType::QuadWord, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "stdin", .type = DataType::QuadWord, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "stderr", .type = DataType::QuadWord, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "bytesWritten", .type = DataType::Word, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "heapHandle", .type = DataType::QuadWord, .value = "0" });
+
+    generation.externalSymbols.insert(generation.externalSymbols.end(), {
+        EXIT_PROCESS_WINDOWS, "GetStdHandle", "WriteFile", "ReadFile", "GetConsoleMode", "GetProcessHeap", "HeapAlloc", "HeapFree",
+        "VirtualAlloc", "VirtualFree"
+    });
+}
+
+void WindowsTarget::generateStartup(GenerateData& generation) const
+{
+    generation.code.emit("sub", { "rsp", std::to_string(SHADOW_SPACE_SIZE) });
+
+    generation.code.emitComment("Get stdout");
+    generation.code.emit("mov", { "rcx", "-11" });
+    generation.code.emit("call", { "GetStdHandle" });
+    generation.code.emit("mov", { "[rel stdout]", "rax" });
+
+    generation.code.emitComment("Get stdin");
+    generation.code.emit("mov", { "rcx", "-10" });
+    generation.code.emit("call", { "GetStdHandle" });
+    generation.code.emit("mov", { "[rel stdin]", "rax" });
+
+    generation.code.emitComment("Get stderr");
+    generation.code.emit("mov", { "rcx", "-12" });
+    generation.code.emit("call", { "GetStdHandle" });
+    generation.code.emit("mov", { "[rel stderr]", "rax" });
+
+    generation.code.emitComment("Get heap handle");
+    generation.code.emit("call", { "GetProcessHeap" });
+    generation.code.emit("mov", { "[rel heapHandle]", "rax" });
+
+    generation.code.emit("add", { "rsp", std::to_string(SHADOW_SPACE_SIZE) });
+}
+
+void WindowsTarget::generateRuntimeFunctions(const ProgramNode& program, GenerateData& generation) const
+{
+    // The runtime is in `kernel32`
+}
+
+void WindowsTarget::generateExit(const std::string& exitCode, AssemblyCode& code) const
+{
+    code.emit("mov", { "rcx", exitCode });
+    // The process ends here, so the stack can be aligned without restoring it
+    code.emit("and", { "rsp", "-16" });
+    code.emit("sub", { "rsp", std::to_string(SHADOW_SPACE_SIZE) });
+    code.emit("call", { EXIT_PROCESS_WINDOWS });
+}
+
+// Calls a function of `kernel32` that returns its result through a pointer (its 4th or 2nd parameter), and leaves the result in `rax`
+static void generateKernel32IoCall(const std::string& function, const std::string& resultRegister, AssemblyCode& code)
+{
+    code.emit("mov", { "QWORD [rsp + 32]", "0" });
+    code.emit("mov", { "QWORD [rsp + 40]", "0" });
+    code.emit("lea", { resultRegister, "[rsp + 40]" });
+    code.emit("call", { function });
+}
+
+void WindowsTarget::generateWrite(AssemblyCode& code) const
+{
+    generateKernel32IoCall("WriteFile", "r9", code);
+    code.emit("mov", { "rax", "[rsp + 40]" });
+}
+
+void WindowsTarget::generateRead(AssemblyCode& code) const
+{
+    generateKernel32IoCall("ReadFile", "r9", code);
+    code.emit("mov", { "rax", "[rsp + 40]" });
+}
+
+void WindowsTarget::generateIsTerminal(AssemblyCode& code) const
+{
+    // Only the handles of a console have a mode
+    generateKernel32IoCall("GetConsoleMode", "rdx", code);
+    code.emit("test", { "eax", "eax" });
+    code.emit("setne", { "al" });
+    code.emit("movzx", { "eax", "al" });
+}
+
+void WindowsTarget::generateAllocatePages(AssemblyCode& code) const
+{
+    // MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE
+    code.emit("mov", { "rdx", "rcx" });
+    code.emit("xor", { "ecx", "ecx" });
+    code.emit("mov", { "r8d", "12288" });
+    code.emit("mov", { "r9d", "4" });
+    code.emit("call", { "VirtualAlloc" });
+}
+
+void WindowsTarget::generateFreePages(AssemblyCode& code) const
+{
+    // MEM_RELEASE releases the whole allocation, whose size must be 0
+    code.emit("xor", { "edx", "edx" });
+    code.emit("mov", { "r8d", "32768" });
+    code.emit("call", { "VirtualFree" });
+}
+
+std::string LinuxTarget::getEntryPoint() const
+{
+    return "_start";
+}
+
+void LinuxTarget::declareRuntime(const ProgramNode& program, GenerateData& generation) const
+{
+    // The standard streams are always open, so their file descriptors are known without asking the system
+    generation.dataSection.push_back(DataDefinition { .name = "stdout", .type = DataType::QuadWord, .value = "1" });
+    generation.dataSection.push_back(DataDefinition { .name = "stdin", .type = DataType::QuadWord, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "stderr", .type = DataType::QuadWord, .value = "2" });
+    generation.dataSection.push_back(DataDefinition { .name = "bytesWritten", .type = DataType::Word, .value = "0" });
+    generation.dataSection.push_back(DataDefinition { .name = "heapHandle", .type = DataType::QuadWord, .value = "1" });
+
+    if(utils::isNameUsedByAsmMacro(program.nodes, "HeapAlloc"))
+    {
+        generation.dataSection.push_back(DataDefinition { .name = "heapNext", .type = DataType::QuadWord, .value = "0" });
+        generation.dataSection.push_back(DataDefinition { .name = "heapEnd", .type = DataType::QuadWord, .value = "0" });
+    }
+}
+
+void LinuxTarget::generateStartup(GenerateData& generation) const
+{
+    // Nothing to initialize: the process starts directly in the code of the program
+}
+
+// Generates `name` with the Windows x64 calling convention, if the code written with the `asm!` macro calls it
+static bool beginRuntimeFunction(const ProgramNode& program, const std::string& name, GenerateData& generation)
+{
+    if(!utils::isNameUsedByAsmMacro(program.nodes, name))
+        return false;
+    generation.code.emitBlankLine();
+    generation.code.emitLabel(name);
+    generation.functions.push_back(FunctionSymbol { .name = name });
+    return true;
+}
+
+void LinuxTarget::generateRuntimeFunctions(const ProgramNode& program, GenerateData& generation) const
+{
+    AssemblyCode& code = generation.code;
+
+    if(beginRuntimeFunction(program, EXIT_PROCESS_WINDOWS, generation))
+        generateExit("rcx", code);
+
+    if(beginRuntimeFunction(program, "GetStdHandle", generation))
+    {
+        // -10, -11 and -12 are the handles of stdin, stdout and stderr
+        code.emit("mov", { "rax", "-10" });
+        code.emit("sub", { "rax", "rcx" });
+        code.emit("ret");
+    }
+
+    if(beginRuntimeFunction(program, "WriteFile", generation))
+    {
+        // `rsi` and `rdi` must be preserved for the caller, `rcx` and `r11` are overwritten by `syscall`
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        code.emit("mov", { "rdi", "rcx" });
+        code.emit("mov", { "rsi", "rdx" });
+        code.emit("mov", { "rdx", "r8" });
+        code.emit("mov", { "eax", SYSCALL_WRITE });
+        code.emit("syscall");
+        code.emit("pop", { "rdi" });
+        code.emit("pop", { "rsi" });
+        code.emit("mov", { "rcx", "rax" });
+        code.emit("xor", { "eax", "eax" });
+        code.emit("test", { "rcx", "rcx" });
+        code.emit("js", { "WriteFile.end" });
+        // The number of written bytes is returned only if the caller asks it
+        code.emit("test", { "r9", "r9" });
+        code.emit("jz", { "WriteFile.success" });
+        code.emit("mov", { "DWORD [r9]", "ecx" });
+        code.emitLabel("WriteFile.success");
+        code.emit("mov", { "eax", "1" });
+        code.emitLabel("WriteFile.end");
+        code.emit("ret");
+    }
+
+    if(beginRuntimeFunction(program, "ReadFile", generation))
+    {
+        // Like the console of Windows, a call reads at most one line, so a program that reads its input
+        // line by line behaves in the same way when the input comes from a pipe
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        code.emit("push", { "rbx" });
+        code.emit("mov", { "rdi", "rcx" });
+        code.emit("mov", { "rsi", "rdx" });
+        code.emit("lea", { "rbx", "[rdx + r8]" });
+        code.emit("mov", { "r8", "rdx" });
+        code.emitLabel("ReadFile.loop");
+        code.emit("cmp", { "rsi", "rbx" });
+        code.emit("jae", { "ReadFile.end" });
+        code.emit("mov", { "edx", "1" });
+        code.emit("mov", { "eax", SYSCALL_READ });
+        code.emit("syscall");
+        code.emit("test", { "rax", "rax" });
+        code.emit("jle", { "ReadFile.end" });
+        code.emit("inc", { "rsi" });
+        code.emit("cmp", { "BYTE [rsi - 1]", "10" });
+        code.emit("jne", { "ReadFile.loop" });
+        code.emitLabel("ReadFile.end");
+        code.emit("sub", { "rsi", "r8" });
+        code.emit("test", { "r9", "r9" });
+        code.emit("jz", { "ReadFile.success" });
+        code.emit("mov", { "DWORD [r9]", "esi" });
+        code.emitLabel("ReadFile.success");
+        code.emit("pop", { "rbx" });
+        code.emit("pop", { "rdi" });
+        code.emit("pop", { "rsi" });
+        code.emit("mov", { "eax", "1" });
+        code.emit("ret");
+    }
+
+    if(beginRuntimeFunction(program, "GetProcessHeap", generation))
+    {
+        code.emit("mov", { "rax", "[rel heapHandle]" });
+        code.emit("ret");
+    }
+
+    if(beginRuntimeFunction(program, "HeapAlloc", generation))
+    {
+        // The memory is taken from the end of the last chunk mapped by the kernel (that is already zeroed), and a new chunk is mapped when it's full
+        code.emit("add", { "r8", "15" });
+        code.emit("and", { "r8", "-16" });
+        code.emit("mov", { "rax", "[rel heapNext]" });
+        code.emit("lea", { "r10", "[rax + r8]" });
+        code.emit("cmp", { "r10", "[rel heapEnd]" });
+        code.emit("jbe", { "HeapAlloc.allocated" });
+
+        code.emit("push", { "rsi" });
+        code.emit("push", { "rdi" });
+        code.emit("push", { "r8" });
+        code.emit("mov", { "rsi", HEAP_CHUNK_SIZE });
+        code.emit("cmp", { "r8", "rsi" });
+        code.emit("cmova", { "rsi", "r8" });
+        code.emit("xor", { "edi", "edi" });
+        code.emit("mov", { "edx", MMAP_PROTECTION });
+        code.emit("mov", { "r10d", MMAP_FLAGS });
+        code.emit("mov", { "r8", "-1" });
+        code.emit("xor", { "r9d", "r9d" });
+        code.emit("mov", { "eax", SYSCALL_MMAP });
+        code.emit("syscall");
+        code.emit("pop", { "r8" });
+        code.emit("lea", { "r10", "[rax + r8]" });
+        code.emit("add", { "rsi", "rax" });
+        code.emit("pop", { "rdi" });
+        code.emit("test", { "rax", "rax" });
+        code.emit("js", { "HeapAlloc.failed" });
+        code.emit("mov", { "[rel heapEnd]", "rsi" });
+        code.emit("pop", { "rsi" });
+
+        code.emitLabel("HeapAlloc.allocated");
+        code.emit("mov", { "[rel heapNext]", "r10" });
+        code.emit("ret");
+
+        code.emitLabel("HeapAlloc.failed");
+        code.emit("pop", { "rsi" });
+        code.emit("xor", { "eax", "eax" });
+        code.emit("ret");
+    }
+
+    if(beginRuntimeFunction(program, "HeapFree", generation))
+    {
+        // The memory of the heap is never given back to the kernel
+        code.emit("mov", { "eax", "1" });
+        code.emit("ret");
+    }
+}
+
+void LinuxTarget::generateExit(const std::string& exitCode, AssemblyCode& code) const
+{
+    code.emit("mov", { "rdi", exitCode });
+    code.emit("mov", { "eax", SYSCALL_EXIT });
+    code.emit("syscall");
+}
+
+void LinuxTarget::generateWrite(AssemblyCode& code) const
+{
+    code.emit("mov", { "rdi", "rcx" });
+    code.emit("mov", { "rsi", "rdx" });
+    code.emit("mov", { "rdx", "r8" });
+    code.emit("mov", { "eax", SYSCALL_WRITE });
+    code.emit("syscall");
+}
+
+void LinuxTarget::generateRead(AssemblyCode& code) const
+{
+    code.emit("mov", { "rdi", "rcx" });
+    code.emit("mov", { "rsi", "rdx" });
+    code.emit("mov", { "rdx", "r8" });
+    code.emit("mov", { "eax", SYSCALL_READ });
+    code.emit("syscall");
+}
+
+void LinuxTarget::generateIsTerminal(AssemblyCode& code) const
+{
+    // The settings are written in the free space of the stack
+    code.emit("mov", { "rdi", "rcx" });
+    code.emit("mov", { "esi", IOCTL_TCGETS });
+    code.emit("lea", { "rdx", "[rsp + 32]" });
+    code.emit("mov", { "eax", SYSCALL_IOCTL });
+    code.emit("syscall");
+    code.emit("test", { "rax", "rax" });
+    code.emit("sete", { "al" });
+    code.emit("movzx", { "eax", "al" });
+}
+
+void LinuxTarget::generateAllocatePages(AssemblyCode& code) const
+{
+    code.emit("mov", { "rsi", "rcx" });
+    code.emit("xor", { "edi", "edi" });
+    code.emit("mov", { "edx", MMAP_PROTECTION });
+    code.emit("mov", { "r10d", MMAP_FLAGS });
+    code.emit("mov", { "r8", "-1" });
+    code.emit("xor", { "r9d", "r9d" });
+    code.emit("mov", { "eax", SYSCALL_MMAP });
+    code.emit("syscall");
+    // The errors are returned as negative numbers
+    code.emit("xor", { "ecx", "ecx" });
+    code.emit("test", { "rax", "rax" });
+    code.emit("cmovs", { "rax", "rcx" });
+}
+
+void LinuxTarget::generateFreePages(AssemblyCode& code) const
+{
+    code.emit("mov", { "rdi", "rcx" });
+    code.emit("mov", { "rsi", "rdx" });
+    code.emit("mov", { "eax", SYSCALL_MUNMAP });
+    code.emit("syscall");
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "generation_data.hpp"
+#include "../parser/node/core.hpp"
+
+/**
+ * @brief Enumeration representing the operating systems the generated code can run on.
+ */
+enum class TargetPlatform
+{
+    /// The program is linked with `kernel32` and talks to the system through its functions.
+    Windows,
+    /// The program is statically linked without libc and talks to the kernel with the `syscall` instruction.
+    Linux
+};
+
+/**
+ * @brief Class responsible for the code that depends on the operating system: the entry point of the program,
+ * how it exits and the runtime functions that the code written with the `asm!` macro can call.
+ *
+ * The rest of the Generator (and every optimization) is shared by all the targets.
+ */
+class Target
+{
+public:
+    virtual ~Target() = default;
+
+    /**
+     * @brief Create the target of a platform.
+     */
+    static std::shared_ptr<const Target> create(TargetPlatform platform);
+
+    /**
+     * @brief Get the name of the symbol where the execution of the program starts.
+     */
+    virtual std::string getEntryPoint() const = 0;
+
+    /**
+     * @brief Add the data and the external symbols needed by the runtime of the program.
+     * @param program The parsed program, used to include only the parts of the runtime it uses.
+     */
+    virtual void declareRuntime(const ProgramNode& program, GenerateData& generation) const = 0;
+
+    /**
+     * @brief Generate the code that initializes the runtime, at the start of the program.
+     */
+    virtual void generateStartup(GenerateData& generation) const = 0;
+
+    /**
+     * @brief Generate the functions of the runtime, after the code of the program.
+     */
+    virtual void generateRuntimeFunctions(const ProgramNode& program, GenerateData& generation) const = 0;
+
+    /**
+     * @brief Generate assembly code for exiting the process with a specified exit code.
+     * @param exitCode The exit code: a register or an immediate.
+     */
+    virtual void generateExit(const std::string& exitCode, AssemblyCode& code) const = 0;
+
+    /**
+     * @brief Generate the code that writes `r8` bytes from the address in `rdx` to the file whose handle is in `rcx`.
+     *
+     * The number of written bytes is left in `rax` (0 or less if nothing has been written). The code runs in a function of
+     * the runtime, with the stack aligned to 16 bytes and RUNTIME_STACK_SIZE free bytes at `rsp`, and it can overwrite `rsi`,
+     * `rdi` and the registers that the Windows x64 calling convention doesn't preserve.
+     */
+    virtual void generateWrite(AssemblyCode& code) const = 0;
+    /**
+     * @brief Generate the code that reads at most `r8` bytes from the file whose handle is in `rcx` into the address in `rdx`.
+     *
+     * The number of read bytes is left in `rax` (0 or less at the end of the file). It runs like the code of generateWrite.
+     */
+    virtual void generateRead(AssemblyCode& code) const = 0;
+    /**
+     * @brief Generate the code that leaves in `rax` 1 if the file whose handle is in `rcx` is a terminal, otherwise 0.
+     *
+     * It runs like the code of generateWrite.
+     */
+    virtual void generateIsTerminal(AssemblyCode& code) const = 0;
+    /**
+     * @brief Generate the code that asks the system for `rcx` bytes (a multiple of the size of a page) set to 0.
+     *
+     * The address of the memory is left in `rax` (0 if there's no memory). It runs like the code of generateWrite.
+     */
+    virtual void generateAllocatePages(AssemblyCode& code) const = 0;
+    /**
+     * @brief Generate the code that gives back to the system the `rdx` bytes at the address in `rcx`, allocated by generateAllocatePages.
+     *
+     * It runs like the code of generateWrite.
+     */
+    virtual void generateFreePages(AssemblyCode& code) const = 0;
+};
+
+/**
+ * @brief The Windows x64 target, whose runtime is `kernel32`.
+ */
+class WindowsTarget : public Target
+{
+public:
+    std::string getEntryPoint() const override;
+    void declareRuntime(const ProgramNode& program, GenerateData& generation) const override;
+    void generateStartup(GenerateData& generation) const override;
+    void generateRuntimeFunctions(const ProgramNode& program, GenerateData& generation) const override;
+    void generateExit(const std::string& exitCode, AssemblyCode& code) const override;
+    void generateWrite(AssemblyCode& code) const override;
+    void generateRead(AssemblyCode& code) const override;
+    void generateIsTerminal(AssemblyCode& code) const override;
+    void generateAllocatePages(AssemblyCode& code) const override;
+    void generateFreePages(AssemblyCode& code) const override;
+};
+
+/**
+ * @brief The Linux x86-64 target, that produces programs without any dependency.
+ *
+ * The code written with the `asm!` macro is portable between the targets: the functions of `kernel32` it calls
+ * (like `WriteFile` and `HeapAlloc`) are generated with the Windows x64 calling convention on top of the system calls.
+ */
+class LinuxTarget : public Target
+{
+public:
+    std::string getEntryPoint() const override;
+    void declareRuntime(const ProgramNode& program, GenerateData& generation) const override;
+    void generateStartup(GenerateData& generation) const override;
+    void generateRuntimeFunctions(const ProgramNode& program, GenerateData& generation) const override;
+    void generateExit(const std::string& exitCode, AssemblyCode& code) const override;
+    void generateWrite(AssemblyCode& code) const override;
+    void generateRead(AssemblyCode& code) const override;
+    void generateIsTerminal(AssemblyCode& code) const override;
+    void generateAllocatePages(AssemblyCode& code) const override;
+    void generateFreePages(AssemblyCode& code) const override;
+};
\ No newline at end of file
@@ -1,42 +1,164 @@
 #include "utils.hpp"
 
 #include "special/consts.hpp"
+#include "asm_macro.hpp"
+#include "../optimizer/ast.hpp"
 
-void utils::generateExitCode(const std::string &exitCode, std::stringstream &output)
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+std::string utils::accessVariable(const GenerateData& generation, const Variable &variable)
 {
-    output << TAB << "mov rcx, " << exitCode << NEW_LINE;
-    output << TAB << "call " << EXIT_PROCESS_WINDOWS << NEW_LINE;
+    if(variable.frameOffset.has_value())
+    {
+        long long frameOffset = variable.frameOffset.value();
+        return std::string("QWORD [rbp ") + (frameOffset < 0 ? "- " : "+ ") + std::to_string(std::abs(frameOffset)) + "]";
+    }
+    return "QWORD [rsp + " + std::to_string((generation.stackSize - variable.stackPtr - 1) * 8) + "]";
 }
 
-std::string utils::accessVariable(const GenerateData& generation, const Variable &variable)
+size_t utils::countArraySlots(const StatementDeclareVariableNode* array)
 {
-    std::stringstream output;
-    output << "QWORD [rsp + " << (generation.stackSize - variable.stackPtr - 1) * 8 << "]";
-    return output.str();
+    return (array->arrayLength.value() * ast::elementSizeOf(array) + 7) / 8;
 }
 
-void utils::useStdout(GenerateData& generation)
+size_t utils::countFrameSlots(const std::vector<StatementNode*>& statements, const std::optional<LoopInvariantCodeMotion>& loopInvariants)
 {
-    generation.output << TAB << "extern GetStdHandle" << NEW_LINE << TAB << "extern WriteFile" << NEW_LINE;
+    size_t usedSlots = 0;
+    size_t slotsCount = 0;
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+            {
+                if(node->arrayLength.has_value() && ast::initializationOf(statements, i) == nullptr)
+                    usedSlots += countArraySlots(node);
+                slotsCount = std::max(slotsCount, ++usedSlots);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                slotsCount = std::max(slotsCount, usedSlots + countFrameSlots(node->statements, loopInvariants));
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                slotsCount = std::max(slotsCount, usedSlots + countFrameSlots(node->scope->statements, loopInvariants));
+                if(node->elseScope.has_value())
+                    slotsCount = std::max(slotsCount, usedSlots + countFrameSlots(node->elseScope.value()->statements, loopInvariants));
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                size_t hoistedCount = loopInvariants.has_value() ? loopInvariants.value().getHoistedExpressions(node).size() : 0;
+                slotsCount = std::max(slotsCount, usedSlots + hoistedCount + countFrameSlots(node->scope->statements, loopInvariants));
+            }
+        }, statements[i]->variant);
+    }
+    return slotsCount;
 }
-void utils::useStdin(GenerateData& generation)
+
+bool utils::containsAsmMacro(const std::vector<StatementNode*>& statements)
+{
+    return containsAsmMacro(statements, [](const StatementMacroNode* macro) { return !hasAsmOperands(macro); });
+}
+
+bool utils::containsAsmMacro(const std::vector<StatementNode*>& statements, const std::function<bool(const StatementMacroNode*)>& condition)
 {
-    generation.output << TAB << "extern ReadFile" << NEW_LINE;
+    for(auto statement : statements)
+    {
+        bool containsAsm = std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementMacroNode*>)
+                return node->macroName->ident.value.value() == "asm!" && condition(node);
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return containsAsmMacro(node->statements, condition);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return containsAsmMacro(node->scope->statements, condition) || (node->elseScope.has_value() && containsAsmMacro(node->elseScope.value()->statements, condition));
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return containsAsmMacro(node->scope->statements, condition);
+            else
+                return false;
+        }, statement->variant);
+        if(containsAsm)
+            return true;
+    }
+    return false;
 }
-void utils::useHeapAllocation(GenerateData& generation)
+
+// Checks if `name` appears in the code as a whole identifier
+static bool containsIdentifier(const std::string& code, const std::string& name)
 {
-    generation.dataSection << TAB << "heapHandle dq 0" << NEW_LINE;
-    generation.output << TAB << "extern GetProcessHeap" << NEW_LINE << TAB << "extern HeapAlloc" << NEW_LINE << TAB << "extern HeapFree" << NEW_LINE;
+    auto isIdentifierCharacter = [](char character) { return std::isalnum((unsigned char) character) || character == '_' || character == '.'; };
+    for(size_t position = code.find(name); position != std::string::npos; position = code.find(name, position + 1))
+    {
+        size_t end = position + name.size();
+        if((position == 0 || !isIdentifierCharacter(code[position - 1])) && (end == code.size() || !isIdentifierCharacter(code[end])))
+            return true;
+    }
+    return false;
 }
-void utils::getStdoutHandle(GenerateData& generation)
+
+bool utils::isNameUsedByAsmMacro(const std::vector<StatementNode*>& statements, const std::string& name)
 {
-    generation.output << TAB << "; Get stdout" << NEW_LINE << TAB << "mov rcx, -11" << NEW_LINE << TAB << "call GetStdHandle" << NEW_LINE << TAB << "mov [rel stdout], rax" << NEW_LINE;
+    for(auto statement : statements)
+    {
+        bool isUsed = std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementMacroNode*>)
+            {
+                if(node->macroName->ident.value.value() != "asm!")
+                    return false;
+                return std::any_of(node->arguments.begin(), node->arguments.end(), [&](const ExpressionNode* argument)
+                {
+                    auto atom = std::get_if<ExpressionAtomNode*>(&argument->variant);
+                    if(atom == nullptr || !std::holds_alternative<ExpressionLiteralNode*>((*atom)->variant))
+                        return false;
+                    return containsIdentifier(std::get<ExpressionLiteralNode*>((*atom)->variant)->literal.value.value(), name);
+                });
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return isNameUsedByAsmMacro(node->statements, name);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return isNameUsedByAsmMacro(node->scope->statements, name) || (node->elseScope.has_value() && isNameUsedByAsmMacro(node->elseScope.value()->statements, name));
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return isNameUsedByAsmMacro(node->scope->statements, name);
+            else if constexpr (std::is_same_v<T, StatementFunctionDefinitionNode*>)
+                return isNameUsedByAsmMacro(node->implementation->statements, name);
+            else
+                return false;
+        }, statement->variant);
+        if(isUsed)
+            return true;
+    }
+    return false;
 }
-void utils::getStdinHandle(GenerateData& generation)
+
+std::string utils::internalFunctionLabel(const std::string& functionName)
 {
-    generation.output << TAB << "; Get stdin" << NEW_LINE << TAB << "mov rcx, -10" << NEW_LINE << TAB << "call GetStdHandle" << NEW_LINE << TAB << "mov [rel stdin], rax" << NEW_LINE;
+    return functionName + INTERNAL_FUNCTION_SUFFIX;
 }
-void utils::getHeapHandle(GenerateData& generation)
+
+utils::UnsignedDivisionMagic utils::computeUnsignedDivisionMagic(unsigned long long divisor)
 {
-    generation.output << TAB << "; Get heap handle" << NEW_LINE << TAB << "call GetProcessHeap" << NEW_LINE << TAB << "mov [rel heapHandle], rax" << NEW_LINE;
+    using uint128 = unsigned __int128;
+
+    unsigned int log2Divisor = 0;
+    while((uint128(1) << log2Divisor) < divisor)
+        log2Divisor++;
+
+    // Search the smallest shift whose multiplier fits in 64 bits and is precise enough for every dividend
+    for(unsigned int shift = 0; shift <= log2Divisor; shift++)
+    {
+        uint128 power = uint128(1) << (64 + shift);
+        uint128 multiplier = (power + divisor - 1) / divisor;
+        if(multiplier >> 64)
+            break;
+        if(multiplier * divisor - power <= (uint128(1) << shift))
+            return UnsignedDivisionMagic { .multiplier = (unsigned long long) multiplier, .shift = shift, .needsAddition = false };
+    }
+
+    // The multiplier needs 65 bits: its highest bit is added back through `n - t`
+    uint128 multiplier = ((uint128(1) << 64) * ((uint128(1) << log2Divisor) - divisor)) / divisor + 1;
+    return UnsignedDivisionMagic { .multiplier = (unsigned long long) multiplier, .shift = log2Divisor - 1, .needsAddition = true };
 }
\ No newline at end of file
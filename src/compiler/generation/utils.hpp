@@ -1,24 +1,69 @@
 #pragma once
 
 #include <string>
-#include <sstream>
+#include <functional>
 
 #include "generation_data.hpp"
 
 namespace utils
 {
+    std::string accessVariable(const GenerateData& generation, const Variable &variable);
+
     /**
-     * @brief Generate assembly code for exiting the process with a specified exit code.
-     * @param exitCode The exit code to use in the assembly code.
+     * @brief Count the 8 bytes slots needed by the elements of an array.
      */
-    void generateExitCode(const std::string &exitCode, std::stringstream &output);
+    size_t countArraySlots(const StatementDeclareVariableNode* array);
 
-    std::string accessVariable(const GenerateData& generation, const Variable &variable);
-    
-    void useStdout(GenerateData& generation);
-    void useStdin(GenerateData& generation);
-    void useHeapAllocation(GenerateData& generation);
-    void getStdoutHandle(GenerateData& generation);
-    void getStdinHandle(GenerateData& generation);
-    void getHeapHandle(GenerateData& generation);
+    /**
+     * @brief Count the slots of the stack frame needed by the variables declared in some statements.
+     *
+     * Scopes that are never alive at the same time share their slots. Function definitions aren't counted,
+     * because they have their own frame. The arrays that aren't initialized with an address have their elements in the frame.
+     * @param loopInvariants The expressions hoisted out of the loops, each one needs a slot while its loop runs.
+     */
+    size_t countFrameSlots(const std::vector<StatementNode*>& statements, const std::optional<LoopInvariantCodeMotion>& loopInvariants = std::nullopt);
+
+    /**
+     * @brief Check if some statements contain an `asm!` macro without operands (function definitions excluded).
+     *
+     * The code written by the user accesses the variables through hard-coded offsets from `rsp`,
+     * so their layout on the stack can't be changed.
+     */
+    bool containsAsmMacro(const std::vector<StatementNode*>& statements);
+
+    /**
+     * @brief Check if some statements contain an `asm!` macro that satisfies a condition (function definitions excluded).
+     */
+    bool containsAsmMacro(const std::vector<StatementNode*>& statements, const std::function<bool(const StatementMacroNode*)>& condition);
+
+    /**
+     * @brief Check if the code written with the `asm!` macro in some statements (function definitions included) uses a name.
+     */
+    bool isNameUsedByAsmMacro(const std::vector<StatementNode*>& statements, const std::string& name);
+
+    /**
+     * @brief Get the label of the code of a function that uses CallingConvention::Registers.
+     *
+     * The name of the function is left to its Windows x64 entry point, which is generated only if the function is externally visible.
+     */
+    std::string internalFunctionLabel(const std::string& functionName);
+
+    /**
+     * @brief The constants needed to replace an unsigned division by a constant with a multiplication.
+     *
+     * `n / divisor` is `(n * multiplier) >> (64 + shift)`, or when `needsAddition` is true
+     * `(t + ((n - t) >> 1)) >> shift` where `t = (n * multiplier) >> 64`.
+     */
+    struct UnsignedDivisionMagic
+    {
+        unsigned long long multiplier;
+        unsigned int shift;
+        bool needsAddition;
+    };
+
+    /**
+     * @brief Compute the magic number of an unsigned 64 bits division by a constant.
+     * @param divisor The divisor, it must be greater than 1.
+     */
+    UnsignedDivisionMagic computeUnsignedDivisionMagic(unsigned long long divisor);
 }
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "ast.hpp"
+
+#include <charconv>
+#include <algorithm>
+
+#include "../generation/asm_macro.hpp"
+
+const ExpressionNode* ast::skipBrackets(const ExpressionNode* expression)
+{
+    while(std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+    {
+        auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+        if(!std::holds_alternative<ExpressionBracketsNode*>(atom->variant))
+            break;
+        expression = std::get<ExpressionBracketsNode*>(atom->variant)->expression;
+    }
+    return expression;
+}
+
+std::optional<long long> ast::numberOf(const ExpressionNode* expression)
+{
+    expression = skipBrackets(expression);
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return std::nullopt;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(!std::holds_alternative<ExpressionLiteralNode*>(atom->variant))
+        return std::nullopt;
+    const Token& literal = std::get<ExpressionLiteralNode*>(atom->variant)->literal;
+    if(literal.type != TokenType::LiteralNumber)
+        return std::nullopt;
+
+    const std::string& digits = literal.value.value();
+    long long value = 0;
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if(result.ec != std::errc() || result.ptr != digits.data() + digits.size())
+        return std::nullopt;
+    return value;
+}
+
+std::optional<std::string> ast::variableNameOf(const ExpressionNode* expression)
+{
+    expression = skipBrackets(expression);
+    if(!std::holds_alternative<ExpressionAtomNode*>(expression->variant))
+        return std::nullopt;
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(!std::holds_alternative<ExpressionIdentNode*>(atom->variant))
+        return std::nullopt;
+    return std::get<ExpressionIdentNode*>(atom->variant)->ident.value.value();
+}
+
+bool ast::isVariableRead(const ExpressionNode* expression, const std::string& variableName)
+{
+    return std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+            return isVariableRead(node->lhs, variableName) || isVariableRead(node->rhs, variableName);
+        else
+        {
+            return std::visit([&](auto atom)
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+                    return atom->ident.value.value() == variableName;
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return isVariableRead(atom->expression, variableName);
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                    return std::any_of(atom->arguments.begin(), atom->arguments.end(), [&](auto argument) { return isVariableRead(argument, variableName); });
+                else if constexpr (std::is_same_v<V, ExpressionIndexNode*>)
+                    return atom->array->ident.value.value() == variableName || isVariableRead(atom->index, variableName);
+                else
+                    return false;
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+bool ast::isVariableModified(const std::vector<StatementNode*>& statements, const std::string& variableName)
+{
+    return std::any_of(statements.begin(), statements.end(), [&](const StatementNode* statement)
+    {
+        return std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+                return node->name->ident.value.value() == variableName;
+            else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+                return !node->index.has_value() && node->name->ident.value.value() == variableName;
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return isVariableModified(node->statements, variableName);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return isVariableModified(node->scope->statements, variableName) || (node->elseScope.has_value() && isVariableModified(node->elseScope.value()->statements, variableName));
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return isVariableModified(node->scope->statements, variableName);
+            else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+            {
+                auto outputs = asmOutputsOf(node);
+                return std::find(outputs.begin(), outputs.end(), variableName) != outputs.end();
+            }
+            else
+                return false;
+        }, statement->variant);
+    });
+}
+
+bool ast::containsFunctionCall(const ExpressionNode* expression)
+{
+    expression = skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        return containsFunctionCall(binary->lhs) || containsFunctionCall(binary->rhs);
+    }
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+        return containsFunctionCall(std::get<ExpressionIndexNode*>(atom->variant)->index);
+    return std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant);
+}
+
+static void collectCalledFunctions(const ExpressionNode* expression, std::unordered_set<std::string>& calledFunctions)
+{
+    expression = ast::skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        collectCalledFunctions(binary->lhs, calledFunctions);
+        collectCalledFunctions(binary->rhs, calledFunctions);
+        return;
+    }
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+    {
+        auto call = std::get<ExpressionFunctionCallNode*>(atom->variant);
+        calledFunctions.insert(call->functionName->ident.value.value());
+        for(auto argument : call->arguments)
+            collectCalledFunctions(argument, calledFunctions);
+    }
+    else if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+        collectCalledFunctions(std::get<ExpressionIndexNode*>(atom->variant)->index, calledFunctions);
+}
+
+static void collectCalledFunctions(const std::vector<StatementNode*>& statements, std::unordered_set<std::string>& calledFunctions)
+{
+    for(auto statement : statements)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+            {
+                if(node->index.has_value())
+                    collectCalledFunctions(node->index.value(), calledFunctions);
+                collectCalledFunctions(node->value, calledFunctions);
+            }
+            else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                collectCalledFunctions(node->expression, calledFunctions);
+            else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+            {
+                calledFunctions.insert(node->functionName->ident.value.value());
+                for(auto argument : node->arguments)
+                    collectCalledFunctions(argument, calledFunctions);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                collectCalledFunctions(node->statements, calledFunctions);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                collectCalledFunctions(node->condition, calledFunctions);
+                collectCalledFunctions(node->scope->statements, calledFunctions);
+                if(node->elseScope.has_value())
+                    collectCalledFunctions(node->elseScope.value()->statements, calledFunctions);
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                collectCalledFunctions(node->condition, calledFunctions);
+                collectCalledFunctions(node->scope->statements, calledFunctions);
+            }
+        }, statement->variant);
+    }
+}
+
+std::unordered_set<std::string> ast::calledFunctionsOf(const std::vector<StatementNode*>& statements)
+{
+    std::unordered_set<std::string> calledFunctions;
+    collectCalledFunctions(statements, calledFunctions);
+    return calledFunctions;
+}
+
+const StatementAssignVariableNode* ast::initializationOf(const std::vector<StatementNode*>& statements, size_t index)
+{
+    if(index + 1 >= statements.size() || !std::holds_alternative<StatementDeclareVariableNode*>(statements[index]->variant) ||
+       !std::holds_alternative<StatementAssignVariableNode*>(statements[index + 1]->variant))
+        return nullptr;
+    auto declaration = std::get<StatementDeclareVariableNode*>(statements[index]->variant);
+    auto assignment = std::get<StatementAssignVariableNode*>(statements[index + 1]->variant);
+    const std::string& variableName = declaration->name->ident.value.value();
+    if(assignment->index.has_value() || assignment->name->ident.value.value() != variableName || isVariableRead(assignment->value, variableName))
+        return nullptr;
+    return assignment;
+}
+
+bool ast::containsStackArray(const std::vector<StatementNode*>& statements)
+{
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        bool containsArray = std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+                return node->arrayLength.has_value() && initializationOf(statements, i) == nullptr;
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return containsStackArray(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return containsStackArray(node->scope->statements) || (node->elseScope.has_value() && containsStackArray(node->elseScope.value()->statements));
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return containsStackArray(node->scope->statements);
+            else
+                return false;
+        }, statements[i]->variant);
+        if(containsArray)
+            return true;
+    }
+    return false;
+}
+
+size_t ast::elementSizeOf(const StatementDeclareVariableNode* array)
+{
+    return array->type->ident.type == TokenType::KeywordByte ? 1 : 8;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+#include "../parser/node/statement.hpp"
+
+/**
+ * @brief Helpers to inspect the nodes of the AST, shared by the optimization passes.
+ */
+namespace ast
+{
+    /**
+     * @brief Get the expression inside any number of brackets (`((a + b))` -> `a + b`).
+     */
+    const ExpressionNode* skipBrackets(const ExpressionNode* expression);
+
+    /**
+     * @brief Get the value of an expression that is a number literal.
+     * @return The value, or std::nullopt if the expression isn't a number literal or its value doesn't fit in 64 bits.
+     */
+    std::optional<long long> numberOf(const ExpressionNode* expression);
+
+    /**
+     * @brief Get the name of the variable read by an expression that is just an identifier.
+     */
+    std::optional<std::string> variableNameOf(const ExpressionNode* expression);
+
+    /**
+     * @brief Check if an expression reads the variable with the given name.
+     */
+    bool isVariableRead(const ExpressionNode* expression, const std::string& variableName);
+
+    /**
+     * @brief Check if some statements contain a statement that declares or assigns the variable with the given name.
+     *
+     * Writing an element of an array doesn't change the variable, that keeps the address of the elements.
+     * The outputs of an `asm!` macro are assigned, but the macros without operands (that can change any variable) aren't considered.
+     */
+    bool isVariableModified(const std::vector<StatementNode*>& statements, const std::string& variableName);
+
+    /**
+     * @brief Check if an expression calls a function (that can have side effects and overwrite the registers).
+     */
+    bool containsFunctionCall(const ExpressionNode* expression);
+
+    /**
+     * @brief Get the names of the functions called by some statements, also inside the expressions and the nested scopes.
+     *
+     * The definitions of the functions are skipped, because their code isn't executed in place.
+     */
+    std::unordered_set<std::string> calledFunctionsOf(const std::vector<StatementNode*>& statements);
+
+    /**
+     * @brief Get the assignment that gives its first value to the variable declared by the statement at `index`.
+     *
+     * `int x = value;` is parsed as a declaration followed by an assignment. An array declared this way gets the address of its
+     * elements from the value (like the memory returned by `alloc`), instead of having them on the stack.
+     * @return The assignment, or nullptr if the statement isn't a declaration followed by an assignment that doesn't read the variable.
+     */
+    const StatementAssignVariableNode* initializationOf(const std::vector<StatementNode*>& statements, size_t index);
+
+    /**
+     * @brief Check if some statements declare an array whose elements are on the stack, also in the nested scopes.
+     *
+     * The definitions of the functions are skipped, because their arrays are in their own frame.
+     */
+    bool containsStackArray(const std::vector<StatementNode*>& statements);
+
+    /**
+     * @brief Get the number of bytes of each element of an array: 1 for `byte[N]`, 8 for the others.
+     */
+    size_t elementSizeOf(const StatementDeclareVariableNode* array);
+}
\ No newline at end of file
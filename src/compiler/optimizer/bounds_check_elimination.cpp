@@ -0,0 +1,155 @@
+#include "bounds_check_elimination.hpp"
+
+#include <algorithm>
+
+#include "ast.hpp"
+#include "loop_unrolling.hpp"
+
+// The ranges are only computed for small values, so that adding or multiplying their limits can't overflow
+const long long MAX_RANGE_LIMIT = 1LL << 31;
+
+static std::optional<ValueRange> checkedRange(long long min, long long max)
+{
+    if(min < -MAX_RANGE_LIMIT || max > MAX_RANGE_LIMIT)
+        return std::nullopt;
+    return ValueRange { .min = min, .max = max };
+}
+
+/**
+ * @brief Get the values that an expression can have, when the induction variables have the given ranges.
+ * @return The range, or std::nullopt if it isn't known.
+ */
+static std::optional<ValueRange> rangeOf(const ExpressionNode* expression, const std::unordered_map<std::string, ValueRange>& inductionRanges)
+{
+    expression = ast::skipBrackets(expression);
+    if(auto number = ast::numberOf(expression))
+        return checkedRange(number.value(), number.value());
+    if(auto variableName = ast::variableNameOf(expression))
+    {
+        auto range = inductionRanges.find(variableName.value());
+        if(range == inductionRanges.end())
+            return std::nullopt;
+        return range->second;
+    }
+    if(!std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+        return std::nullopt;
+
+    auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+    auto lhs = rangeOf(binary->lhs, inductionRanges);
+    auto rhs = rangeOf(binary->rhs, inductionRanges);
+    if(!lhs.has_value() || !rhs.has_value())
+        return std::nullopt;
+    switch(binary->operation)
+    {
+        case Operator::Add:
+            return checkedRange(lhs->min + rhs->min, lhs->max + rhs->max);
+        case Operator::Sub:
+            return checkedRange(lhs->min - rhs->max, lhs->max - rhs->min);
+        case Operator::Mul:
+        {
+            long long products[] = { lhs->min * rhs->min, lhs->min * rhs->max, lhs->max * rhs->min, lhs->max * rhs->max };
+            return checkedRange(*std::min_element(std::begin(products), std::end(products)), *std::max_element(std::begin(products), std::end(products)));
+        }
+        case Operator::Div:
+            // The division is unsigned, so only the positive values give the same result as a signed division
+            if(lhs->min < 0 || rhs->min <= 0)
+                return std::nullopt;
+            return checkedRange(lhs->min / rhs->max, lhs->max / rhs->min);
+        default:
+            return ValueRange { .min = 0, .max = 1 };
+    }
+}
+
+BoundsCheckElimination::BoundsCheckElimination(const std::vector<StatementNode*>& statements)
+{
+    analyze(statements, { });
+}
+
+bool BoundsCheckElimination::isInBounds(const ExpressionNode* index, size_t length) const
+{
+    auto range = indexRanges.find(index);
+    return range != indexRanges.end() && range->second.min >= 0 && range->second.max < (long long) std::min<size_t>(length, MAX_RANGE_LIMIT);
+}
+
+void BoundsCheckElimination::analyze(const std::vector<StatementNode*>& statements, const InductionRanges& inductionRanges)
+{
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+            {
+                if(node->index.has_value())
+                    analyzeIndex(node->index.value(), inductionRanges);
+                analyzeExpression(node->value, inductionRanges);
+            }
+            else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                analyzeExpression(node->expression, inductionRanges);
+            else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+            {
+                for(auto argument : node->arguments)
+                    analyzeExpression(argument, inductionRanges);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                analyze(node->statements, inductionRanges);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                analyzeExpression(node->condition, inductionRanges);
+                analyze(node->scope->statements, inductionRanges);
+                if(node->elseScope.has_value())
+                    analyze(node->elseScope.value()->statements, inductionRanges);
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                analyzeLoop(node, i > 0 ? statements[i - 1] : nullptr, inductionRanges);
+        }, statements[i]->variant);
+    }
+}
+
+void BoundsCheckElimination::analyzeLoop(const StatementWhileNode* loop, const StatementNode* previousStatement, const InductionRanges& inductionRanges)
+{
+    analyzeExpression(loop->condition, inductionRanges);
+
+    // In `i = start; while i < bound { ...; i = i + step; }` the body runs only while `i < bound`, and `i` only grows from `start`
+    InductionRanges bodyRanges = inductionRanges;
+    auto countedLoop = LoopUnrolling::findCountedLoop(loop);
+    if(countedLoop.has_value() && countedLoop.value().step <= MAX_RANGE_LIMIT && previousStatement != nullptr &&
+       std::holds_alternative<StatementAssignVariableNode*>(previousStatement->variant))
+    {
+        auto initialization = std::get<StatementAssignVariableNode*>(previousStatement->variant);
+        const std::string& inductionVariable = countedLoop.value().inductionVariable;
+        auto start = rangeOf(initialization->value, inductionRanges);
+        auto bound = rangeOf(countedLoop.value().bound, inductionRanges);
+        if(!initialization->index.has_value() && initialization->name->ident.value.value() == inductionVariable && start.has_value() && bound.has_value())
+            bodyRanges[inductionVariable] = ValueRange { .min = start->min, .max = std::max(start->min, bound->max - 1) };
+    }
+    analyze(loop->scope->statements, bodyRanges);
+}
+
+void BoundsCheckElimination::analyzeExpression(const ExpressionNode* expression, const InductionRanges& inductionRanges)
+{
+    expression = ast::skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        analyzeExpression(binary->lhs, inductionRanges);
+        analyzeExpression(binary->rhs, inductionRanges);
+        return;
+    }
+
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+    {
+        for(auto argument : std::get<ExpressionFunctionCallNode*>(atom->variant)->arguments)
+            analyzeExpression(argument, inductionRanges);
+    }
+    else if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+        analyzeIndex(std::get<ExpressionIndexNode*>(atom->variant)->index, inductionRanges);
+}
+
+void BoundsCheckElimination::analyzeIndex(const ExpressionNode* index, const InductionRanges& inductionRanges)
+{
+    if(auto range = rangeOf(index, inductionRanges))
+        indexRanges[index] = range.value();
+    analyzeExpression(index, inductionRanges);
+}
\ No newline at end of file
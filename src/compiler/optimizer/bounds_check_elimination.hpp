@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "../parser/node/statement.hpp"
+
+/**
+ * @brief Structure representing the values that an integer expression can have: every value from `min` to `max`.
+ */
+struct ValueRange
+{
+    long long min;
+    long long max;
+};
+
+/**
+ * @brief Class responsible for finding the accesses to the elements of the arrays whose index is always valid.
+ *
+ * The range of each index is computed from the number literals and from the induction variables of the counted loops
+ * that contain the access: in `i = 0; while i < 100 { ...; i = i + 1; }` the body sees `i` from 0 to 99.
+ * The generators don't check the indices that are proven to be in the bounds of their array.
+ */
+class BoundsCheckElimination
+{
+public:
+    /**
+     * @brief Analyze the accesses in some statements (the code of a function, or the code outside of the functions).
+     */
+    BoundsCheckElimination(const std::vector<StatementNode*>& statements);
+
+    /**
+     * @brief Check if an index (of an ExpressionIndexNode or of an assignment to an element) is always between 0 and `length - 1`.
+     */
+    bool isInBounds(const ExpressionNode* index, size_t length) const;
+
+private:
+    using InductionRanges = std::unordered_map<std::string, ValueRange>;
+
+    void analyze(const std::vector<StatementNode*>& statements, const InductionRanges& inductionRanges);
+    void analyzeLoop(const StatementWhileNode* loop, const StatementNode* previousStatement, const InductionRanges& inductionRanges);
+    void analyzeExpression(const ExpressionNode* expression, const InductionRanges& inductionRanges);
+    void analyzeIndex(const ExpressionNode* index, const InductionRanges& inductionRanges);
+
+    std::unordered_map<const ExpressionNode*, ValueRange> indexRanges;
+};
\ No newline at end of file
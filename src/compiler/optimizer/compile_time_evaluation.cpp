@@ -0,0 +1,530 @@
+#include "compile_time_evaluation.hpp"
+
+#include <charconv>
+#include <algorithm>
+
+#include "ast.hpp"
+
+/**
+ * @brief Get why an expression can't be part of a pure function, without considering the functions it calls.
+ * @return The reason, or std::nullopt if the expression can be evaluated while compiling.
+ */
+static std::optional<std::string> impurityOf(const ExpressionNode* expression)
+{
+    return std::visit([](auto node) -> std::optional<std::string>
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+        {
+            auto lhs = impurityOf(node->lhs);
+            return lhs.has_value() ? lhs : impurityOf(node->rhs);
+        }
+        else
+        {
+            return std::visit([](auto atom) -> std::optional<std::string>
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                    return atom->literal.type == TokenType::LiteralString ? std::optional<std::string>("it uses a string") : std::nullopt;
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return impurityOf(atom->expression);
+                else if constexpr (std::is_same_v<V, ExpressionIndexNode*>)
+                    return "it reads the elements of an array";
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                {
+                    for(auto argument : atom->arguments)
+                    {
+                        if(auto impurity = impurityOf(argument))
+                            return impurity;
+                    }
+                    return std::nullopt;
+                }
+                else
+                    return std::nullopt;
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+static bool isIntVariable(const StatementDeclareVariableNode* declaration)
+{
+    return declaration->type->ident.type == TokenType::KeywordInt && !declaration->arrayLength.has_value();
+}
+
+/**
+ * @brief Get why some statements can't be part of a pure function, without considering the functions they call.
+ */
+static std::optional<std::string> impurityOf(const std::vector<StatementNode*>& statements)
+{
+    for(const StatementNode* statement : statements)
+    {
+        std::optional<std::string> impurity = std::visit([](auto node) -> std::optional<std::string>
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                return impurityOf(node->expression);
+            else if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+                return isIntVariable(node) ? std::nullopt : std::optional<std::string>("it declares the variable `" + node->name->ident.value.value() + "` that isn't an `int`");
+            else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+                return node->index.has_value() ? std::optional<std::string>("it writes the elements of an array") : impurityOf(node->value);
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return impurityOf(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                if(auto impurity = impurityOf(node->condition))
+                    return impurity;
+                if(auto impurity = impurityOf(node->scope->statements))
+                    return impurity;
+                return node->elseScope.has_value() ? impurityOf(node->elseScope.value()->statements) : std::nullopt;
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                auto impurity = impurityOf(node->condition);
+                return impurity.has_value() ? impurity : impurityOf(node->scope->statements);
+            }
+            else if constexpr (std::is_same_v<T, StatementFunctionDefinitionNode*>)
+                return "it defines a function";
+            else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+            {
+                for(auto argument : node->arguments)
+                {
+                    if(auto impurity = impurityOf(argument))
+                        return impurity;
+                }
+                return std::nullopt;
+            }
+            else
+                return "it uses the `" + node->macroName->ident.value.value() + "` macro";
+        }, statement->variant);
+        if(impurity.has_value())
+            return impurity;
+    }
+    return std::nullopt;
+}
+
+// Checks if an expression reads a variable or an element, also in the arguments of its calls
+static bool readsVariables(const ExpressionNode* expression)
+{
+    return std::visit([](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+            return readsVariables(node->lhs) || readsVariables(node->rhs);
+        else
+        {
+            return std::visit([](auto atom)
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                    return false;
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return readsVariables(atom->expression);
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                    return std::any_of(atom->arguments.begin(), atom->arguments.end(), [](const ExpressionNode* argument) { return readsVariables(argument); });
+                else
+                    return true;
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+static std::string formatCall(const ExpressionFunctionCallNode* call, const std::vector<long long>& arguments)
+{
+    std::string text = call->functionName->ident.value.value() + "(";
+    for(size_t i = 0; i < arguments.size(); i++)
+        text += (i == 0 ? "" : ", ") + std::to_string(arguments[i]);
+    return text + ")";
+}
+
+CompileTimeEvaluation::CompileTimeEvaluation(const std::vector<StatementNode*>& program, size_t maxSteps, size_t maxDepth)
+    : maxSteps(maxSteps), maxDepth(maxDepth)
+{
+    for(const StatementNode* statement : program)
+    {
+        if(auto definition = std::get_if<StatementFunctionDefinitionNode*>(&statement->variant))
+            functions[(*definition)->functionName->ident.value.value()] = *definition;
+    }
+    findPureFunctions();
+    analyze(program);
+}
+
+std::optional<long long> CompileTimeEvaluation::getValue(const ExpressionFunctionCallNode* call) const
+{
+    auto value = values.find(call);
+    if(value == values.end())
+        return std::nullopt;
+    return value->second;
+}
+
+const std::vector<CompileTimeEvaluationReport>& CompileTimeEvaluation::getReports() const
+{
+    return reports;
+}
+
+void CompileTimeEvaluation::findPureFunctions()
+{
+    std::unordered_map<std::string, std::unordered_set<std::string>> calledFunctions;
+    for(const auto& [name, definition] : functions)
+    {
+        std::optional<std::string> impurity;
+        if(definition->returnType->ident.type != TokenType::KeywordInt)
+            impurity = "it doesn't return an `int`";
+        auto parameter = std::find_if(definition->parameters.begin(), definition->parameters.end(),
+            [](const StatementDeclareVariableNode* parameter) { return !isIntVariable(parameter); });
+        if(!impurity.has_value() && parameter != definition->parameters.end())
+            impurity = "its parameter `" + (*parameter)->name->ident.value.value() + "` isn't an `int`";
+        if(!impurity.has_value())
+            impurity = impurityOf(definition->implementation->statements);
+        if(impurity.has_value())
+            impureFunctions[name] = impurity.value();
+        calledFunctions[name] = ast::calledFunctionsOf(definition->implementation->statements);
+    }
+
+    // A function that calls a function that isn't pure (or an intrinsic) isn't pure either, while the recursive calls are allowed
+    bool hasChanged = true;
+    while(hasChanged)
+    {
+        hasChanged = false;
+        for(const auto& [name, called] : calledFunctions)
+        {
+            if(impureFunctions.contains(name))
+                continue;
+            auto impureCall = std::find_if(called.begin(), called.end(), [&](const std::string& calledFunction)
+            {
+                return !functions.contains(calledFunction) || impureFunctions.contains(calledFunction);
+            });
+            if(impureCall != called.end())
+            {
+                impureFunctions[name] = "it calls `" + *impureCall + "`, that isn't pure";
+                hasChanged = true;
+            }
+        }
+    }
+}
+
+void CompileTimeEvaluation::analyze(const std::vector<StatementNode*>& statements)
+{
+    for(const StatementNode* statement : statements)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                analyzeExpression(node->expression);
+            else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+            {
+                if(node->index.has_value())
+                    analyzeExpression(node->index.value());
+                analyzeExpression(node->value);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                analyze(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                analyzeExpression(node->condition);
+                analyze(node->scope->statements);
+                if(node->elseScope.has_value())
+                    analyze(node->elseScope.value()->statements);
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                analyzeExpression(node->condition);
+                analyze(node->scope->statements);
+            }
+            else if constexpr (std::is_same_v<T, StatementFunctionDefinitionNode*>)
+                analyze(node->implementation->statements);
+            else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+                evaluateRootCall(node);
+        }, statement->variant);
+    }
+}
+
+void CompileTimeEvaluation::analyzeExpression(const ExpressionNode* expression)
+{
+    std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+        {
+            analyzeExpression(node->lhs);
+            analyzeExpression(node->rhs);
+        }
+        else
+        {
+            std::visit([&](auto atom)
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    analyzeExpression(atom->expression);
+                else if constexpr (std::is_same_v<V, ExpressionIndexNode*>)
+                    analyzeExpression(atom->index);
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                    evaluateRootCall(atom);
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+void CompileTimeEvaluation::evaluateRootCall(const ExpressionFunctionCallNode* call)
+{
+    const std::string& name = call->functionName->ident.value.value();
+    auto function = functions.find(name);
+    bool isConstant = std::none_of(call->arguments.begin(), call->arguments.end(), [](const ExpressionNode* argument) { return readsVariables(argument); });
+    // The invalid calls are left to the generators, that report them
+    if(!isConstant || function == functions.end() || function->second->parameters.size() != call->arguments.size())
+    {
+        for(auto argument : call->arguments)
+            analyzeExpression(argument);
+        return;
+    }
+
+    size_t lineNumber = call->functionName->ident.metadata.lineNumber + 1;
+    auto impurity = impureFunctions.find(name);
+    if(impurity != impureFunctions.end())
+    {
+        reports.push_back(CompileTimeEvaluationReport { .lineNumber = lineNumber, .isEvaluated = false,
+                                                        .description = "`" + name + "` isn't pure: " + impurity->second });
+        for(auto argument : call->arguments)
+            analyzeExpression(argument);
+        return;
+    }
+
+    stepsLeft = maxSteps;
+    depth = 0;
+    failure.clear();
+    Scopes scopes;
+    std::optional<long long> value = evaluateCall(call, scopes);
+    if(!value.has_value())
+    {
+        reports.push_back(CompileTimeEvaluationReport { .lineNumber = lineNumber, .isEvaluated = false,
+                                                        .description = "`" + name + "` isn't evaluated: " + failure });
+        for(auto argument : call->arguments)
+            analyzeExpression(argument);
+        return;
+    }
+    values[call] = value.value();
+    reports.push_back(CompileTimeEvaluationReport { .lineNumber = lineNumber, .isEvaluated = true,
+                                                    .description = "`" + name + "` is evaluated to " + std::to_string(value.value()) });
+}
+
+bool CompileTimeEvaluation::run(const std::vector<StatementNode*>& statements, Scopes& scopes, std::optional<long long>& returnedValue)
+{
+    for(const StatementNode* statement : statements)
+    {
+        if(!consumeStep())
+            return false;
+        bool isRun = std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementReturnNode*>)
+            {
+                returnedValue = evaluate(node->expression, scopes);
+                return returnedValue.has_value();
+            }
+            else if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+            {
+                scopes.back()[node->name->ident.value.value()] = std::nullopt;
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+            {
+                const std::string& name = node->name->ident.value.value();
+                auto scope = std::find_if(scopes.rbegin(), scopes.rend(), [&](const auto& variables) { return variables.contains(name); });
+                std::optional<long long> value = evaluate(node->value, scopes);
+                if(scope == scopes.rend())
+                    failure = "it writes the variable `" + name + "`, that isn't declared";
+                else if(value.has_value())
+                    (*scope)[name] = value;
+                return scope != scopes.rend() && value.has_value();
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+            {
+                scopes.emplace_back();
+                bool isScopeRun = run(node->statements, scopes, returnedValue);
+                scopes.pop_back();
+                return isScopeRun;
+            }
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                std::optional<long long> condition = evaluate(node->condition, scopes);
+                if(!condition.has_value())
+                    return false;
+                const StatementScopeNode* scope = condition.value() != 0 ? node->scope : node->elseScope.value_or(nullptr);
+                if(scope == nullptr)
+                    return true;
+                scopes.emplace_back();
+                bool isScopeRun = run(scope->statements, scopes, returnedValue);
+                scopes.pop_back();
+                return isScopeRun;
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                while(!returnedValue.has_value())
+                {
+                    std::optional<long long> condition = evaluate(node->condition, scopes);
+                    if(!condition.has_value())
+                        return false;
+                    if(condition.value() == 0)
+                        return true;
+                    scopes.emplace_back();
+                    bool isScopeRun = run(node->scope->statements, scopes, returnedValue);
+                    scopes.pop_back();
+                    if(!isScopeRun)
+                        return false;
+                }
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+                return evaluateCall(node, scopes).has_value();
+            else
+            {
+                failure = "it can't be run while compiling";
+                return false;
+            }
+        }, statement->variant);
+        if(!isRun)
+            return false;
+        if(returnedValue.has_value())
+            return true;
+    }
+    return true;
+}
+
+std::optional<long long> CompileTimeEvaluation::evaluate(const ExpressionNode* expression, Scopes& scopes)
+{
+    if(!consumeStep())
+        return std::nullopt;
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        std::optional<long long> lhs = evaluate(binary->lhs, scopes);
+        if(!lhs.has_value())
+            return std::nullopt;
+        // The right operand of `&&` and `||` is evaluated only when the left one doesn't decide the result
+        if(binary->operation == Operator::And && lhs.value() == 0)
+            return 0;
+        if(binary->operation == Operator::Or && lhs.value() != 0)
+            return 1;
+        std::optional<long long> rhs = evaluate(binary->rhs, scopes);
+        if(!rhs.has_value())
+            return std::nullopt;
+
+        // The arithmetic wraps around like the 64 bits registers, and the division is unsigned like the `div` of the native code
+        unsigned long long lhsBits = static_cast<unsigned long long>(lhs.value());
+        unsigned long long rhsBits = static_cast<unsigned long long>(rhs.value());
+        switch(binary->operation)
+        {
+            case Operator::Add: return static_cast<long long>(lhsBits + rhsBits);
+            case Operator::Sub: return static_cast<long long>(lhsBits - rhsBits);
+            case Operator::Mul: return static_cast<long long>(lhsBits * rhsBits);
+            case Operator::Div:
+                if(rhsBits == 0)
+                {
+                    failure = "it divides by 0";
+                    return std::nullopt;
+                }
+                return static_cast<long long>(lhsBits / rhsBits);
+            case Operator::GreaterThan: return lhs.value() > rhs.value();
+            case Operator::LessThan: return lhs.value() < rhs.value();
+            case Operator::EqualTo: return lhs.value() == rhs.value();
+            case Operator::NotEqualTo: return lhs.value() != rhs.value();
+            case Operator::And:
+            case Operator::Or: return rhs.value() != 0;
+        }
+        return std::nullopt;
+    }
+
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    return std::visit([&](auto node) -> std::optional<long long>
+    {
+        using V = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+        {
+            // Like in the native code, the literals that don't fit in a signed 64 bits integer keep their bits
+            const std::string& digits = node->literal.value.value();
+            unsigned long long value = 0;
+            auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            if(node->literal.type != TokenType::LiteralNumber || result.ec != std::errc() || result.ptr != digits.data() + digits.size())
+            {
+                failure = "it uses the literal `" + digits + "`";
+                return std::nullopt;
+            }
+            return static_cast<long long>(value);
+        }
+        else if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+        {
+            const std::string& name = node->ident.value.value();
+            auto scope = std::find_if(scopes.rbegin(), scopes.rend(), [&](const auto& variables) { return variables.contains(name); });
+            if(scope == scopes.rend() || !scope->at(name).has_value())
+            {
+                failure = "it reads the variable `" + name + "` before giving it a value";
+                return std::nullopt;
+            }
+            return scope->at(name);
+        }
+        else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+            return evaluate(node->expression, scopes);
+        else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+            return evaluateCall(node, scopes);
+        else
+        {
+            failure = "it reads the elements of an array";
+            return std::nullopt;
+        }
+    }, atom->variant);
+}
+
+std::optional<long long> CompileTimeEvaluation::evaluateCall(const ExpressionFunctionCallNode* call, Scopes& scopes)
+{
+    const std::string& name = call->functionName->ident.value.value();
+    auto function = functions.find(name);
+    if(function == functions.end() || impureFunctions.contains(name) || function->second->parameters.size() != call->arguments.size())
+    {
+        failure = "it calls `" + name + "`, that can't be run while compiling";
+        return std::nullopt;
+    }
+
+    std::vector<long long> arguments;
+    for(auto argument : call->arguments)
+    {
+        std::optional<long long> value = evaluate(argument, scopes);
+        if(!value.has_value())
+            return std::nullopt;
+        arguments.push_back(value.value());
+    }
+    // A pure function always gives the same result with the same arguments
+    auto result = results.find({ name, arguments });
+    if(result != results.end())
+        return result->second;
+    if(depth == maxDepth)
+    {
+        failure = "`" + formatCall(call, arguments) + "` is deeper than " + std::to_string(maxDepth) + " nested calls";
+        return std::nullopt;
+    }
+
+    Scopes calleeScopes(1);
+    for(size_t i = 0; i < arguments.size(); i++)
+        calleeScopes.back()[function->second->parameters[i]->name->ident.value.value()] = arguments[i];
+    std::optional<long long> returnedValue;
+    depth++;
+    bool isRun = run(function->second->implementation->statements, calleeScopes, returnedValue);
+    depth--;
+    if(!isRun)
+        return std::nullopt;
+
+    // Reaching the end of a function returns 0
+    long long value = returnedValue.value_or(0);
+    results[{ name, arguments }] = value;
+    return value;
+}
+
+bool CompileTimeEvaluation::consumeStep()
+{
+    if(stepsLeft == 0)
+    {
+        failure = "it runs more than " + std::to_string(maxSteps) + " steps";
+        return false;
+    }
+    stepsLeft--;
+    return true;
+}
\ No newline at end of file
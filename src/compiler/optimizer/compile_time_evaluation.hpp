@@ -0,0 +1,87 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "../parser/node/statement.hpp"
+
+/// The number of statements and expressions that the evaluation of a call can run, if it's not configured.
+const size_t DEFAULT_MAX_EVALUATION_STEPS = 100000;
+/// The number of nested calls that the evaluation of a call can reach, if it's not configured.
+const size_t DEFAULT_MAX_EVALUATION_DEPTH = 64;
+
+/**
+ * @brief Structure representing the result of the evaluation of a call while compiling, shown to the user.
+ */
+struct CompileTimeEvaluationReport
+{
+    size_t lineNumber;
+    bool isEvaluated;
+    /// The value of the call, or why it isn't evaluated.
+    std::string description;
+};
+
+/**
+ * @brief Class responsible for computing while compiling the calls of pure functions whose arguments are constants.
+ *
+ * A function is pure when its result depends only on its arguments and it has no side effects: its parameters, its variables
+ * and its result are `int`, and it doesn't use `asm!`, arrays, strings or the intrinsics (like `print`), and calls only pure functions.
+ * The calls whose arguments don't read any variable are run by an interpreter of the AST, and the generators replace them
+ * with their result. A call that runs too many steps, recurses too deeply or divides by 0 is left to the program.
+ */
+class CompileTimeEvaluation
+{
+public:
+    /**
+     * @brief Analyze the functions of a program and evaluate its calls.
+     * @param maxSteps The number of statements and expressions that the evaluation of each call can run.
+     * @param maxDepth The number of nested calls that the evaluation of each call can reach.
+     */
+    CompileTimeEvaluation(const std::vector<StatementNode*>& program, size_t maxSteps, size_t maxDepth);
+
+    /**
+     * @brief Get the result of a call computed while compiling, or std::nullopt if the call must be run by the program.
+     */
+    std::optional<long long> getValue(const ExpressionFunctionCallNode* call) const;
+    /**
+     * @brief Get the result of the calls with constant arguments, in the order of the code.
+     */
+    const std::vector<CompileTimeEvaluationReport>& getReports() const;
+
+private:
+    using Scopes = std::vector<std::unordered_map<std::string, std::optional<long long>>>;
+
+    void findPureFunctions();
+    void analyze(const std::vector<StatementNode*>& statements);
+    void analyzeExpression(const ExpressionNode* expression);
+    void evaluateRootCall(const ExpressionFunctionCallNode* call);
+
+    /**
+     * @brief Run some statements, stopping at the first `return`.
+     * @param returnedValue Gets the value of the `return` that is reached.
+     * @return False if the statements can't be run while compiling (the reason is in `failure`).
+     */
+    bool run(const std::vector<StatementNode*>& statements, Scopes& scopes, std::optional<long long>& returnedValue);
+    std::optional<long long> evaluate(const ExpressionNode* expression, Scopes& scopes);
+    std::optional<long long> evaluateCall(const ExpressionFunctionCallNode* call, Scopes& scopes);
+    bool consumeStep();
+
+    size_t maxSteps;
+    size_t maxDepth;
+    std::unordered_map<std::string, const StatementFunctionDefinitionNode*> functions;
+    /// Why each function that isn't pure isn't pure.
+    std::unordered_map<std::string, std::string> impureFunctions;
+    /// The results of the calls already evaluated, by function and arguments.
+    std::map<std::pair<std::string, std::vector<long long>>, long long> results;
+
+    size_t stepsLeft = 0;
+    size_t depth = 0;
+    /// Why the evaluation of the current call failed.
+    std::string failure;
+
+    std::unordered_map<const ExpressionFunctionCallNode*, long long> values;
+    std::vector<CompileTimeEvaluationReport> reports;
+};
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "global_value_numbering.hpp"
+
+#include <algorithm>
+
+#include "ast.hpp"
+#include "../generation/asm_macro.hpp"
+
+// Each reused value takes a slot of the stack frame
+const size_t MAX_REUSED_VALUES = 32;
+
+static bool isComparison(Operator operation)
+{
+    return operation == Operator::GreaterThan || operation == Operator::LessThan || operation == Operator::EqualTo || operation == Operator::NotEqualTo ||
+        operation == Operator::And || operation == Operator::Or;
+}
+
+static bool isCommutative(Operator operation)
+{
+    return operation == Operator::Add || operation == Operator::Mul || operation == Operator::EqualTo || operation == Operator::NotEqualTo;
+}
+
+static std::string operatorSymbol(Operator operation)
+{
+    switch(operation)
+    {
+        case Operator::Add: return "+";
+        case Operator::Sub: return "-";
+        case Operator::Mul: return "*";
+        case Operator::Div: return "/";
+        case Operator::GreaterThan: return ">";
+        case Operator::LessThan: return "<";
+        case Operator::EqualTo: return "==";
+        case Operator::NotEqualTo: return "!=";
+        case Operator::And: return "&&";
+        case Operator::Or: return "||";
+    }
+    return "?";
+}
+
+/**
+ * @brief Get the text that identifies the value of an expression, the same for all the expressions with the same value.
+ * @param variables The variables read by the expression are added to it.
+ * @return The text, or std::nullopt if the expression calls a function or reads an element of an array (and so it could give a different result each time).
+ */
+static std::optional<std::string> valueKeyOf(const ExpressionNode* expression, std::unordered_set<std::string>& variables)
+{
+    expression = ast::skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        auto lhs = valueKeyOf(binary->lhs, variables);
+        auto rhs = valueKeyOf(binary->rhs, variables);
+        if(!lhs.has_value() || !rhs.has_value())
+            return std::nullopt;
+        if(isCommutative(binary->operation) && rhs.value() < lhs.value())
+            std::swap(lhs, rhs);
+        return "(" + lhs.value() + " " + operatorSymbol(binary->operation) + " " + rhs.value() + ")";
+    }
+
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    return std::visit([&](auto node) -> std::optional<std::string>
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionLiteralNode*>)
+        {
+            if(node->literal.type == TokenType::LiteralString)
+                return "\"" + node->literal.value.value() + "\"";
+            return node->literal.value.value();
+        }
+        else if constexpr (std::is_same_v<T, ExpressionIdentNode*>)
+        {
+            variables.insert(node->ident.value.value());
+            return node->ident.value.value();
+        }
+        else
+            return std::nullopt;
+    }, atom->variant);
+}
+
+template<typename AvailableValues>
+static void forgetValuesOf(const std::string& variableName, AvailableValues& available)
+{
+    std::erase_if(available, [&](const auto& value) { return value.second.variables.contains(variableName); });
+}
+
+GlobalValueNumbering::GlobalValueNumbering(const std::vector<StatementNode*>& statements, std::function<bool(const std::string&)> mayClobberMemory,
+                                           const LoopInvariantCodeMotion* loopInvariants)
+    : mayClobberMemory(mayClobberMemory), loopInvariants(loopInvariants)
+{
+    ControlFlowGraph graph(statements);
+    DominatorTree dominatorTree(graph);
+
+    const auto& blocks = graph.getBlocks();
+    std::vector<BlockEffects> effects(blocks.size());
+    for(size_t block = 0; block < blocks.size(); block++)
+    {
+        for(auto statement : blocks[block].statements)
+        {
+            std::visit([&](auto node)
+            {
+                using T = std::decay_t<decltype(node)>;
+                if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+                    effects[block].modifiedVariables.insert(node->name->ident.value.value());
+                if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+                {
+                    if(!node->index.has_value())
+                        effects[block].modifiedVariables.insert(node->name->ident.value.value());
+                    else
+                        effects[block].clobbersMemory |= containsClobberingCall(node->index.value());
+                    effects[block].clobbersMemory |= containsClobberingCall(node->value);
+                }
+                else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                    effects[block].clobbersMemory |= containsClobberingCall(node->expression);
+                else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+                {
+                    effects[block].clobbersMemory |= this->mayClobberMemory(node->functionName->ident.value.value());
+                    for(auto argument : node->arguments)
+                        effects[block].clobbersMemory |= containsClobberingCall(argument);
+                }
+                else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+                {
+                    for(const std::string& output : asmOutputsOf(node))
+                        effects[block].modifiedVariables.insert(output);
+                    effects[block].clobbersMemory |= asmMacroClobbersMemory(node) || containsClobberingAsmInput(node);
+                }
+            }, statement->variant);
+        }
+        if(blocks[block].condition != nullptr)
+            effects[block].clobbersMemory |= containsClobberingCall(blocks[block].condition);
+    }
+
+    visitBlock(graph.getEntry(), AvailableValues { }, graph, dominatorTree, effects);
+}
+
+std::optional<size_t> GlobalValueNumbering::getSavedSlot(const ExpressionNode* expression) const
+{
+    auto slot = savedSlots.find(expression);
+    if(slot == savedSlots.end())
+        return std::nullopt;
+    return slot->second;
+}
+
+std::optional<size_t> GlobalValueNumbering::getReusedSlot(const ExpressionNode* expression) const
+{
+    auto slot = reusedSlots.find(expression);
+    if(slot == reusedSlots.end())
+        return std::nullopt;
+    return slot->second;
+}
+
+size_t GlobalValueNumbering::getSlotsCount() const
+{
+    return slotsCount;
+}
+
+void GlobalValueNumbering::visitBlock(size_t block, AvailableValues available, const ControlFlowGraph& graph, const DominatorTree& dominatorTree,
+                                      const std::vector<BlockEffects>& effects)
+{
+    const auto& blocks = graph.getBlocks();
+    for(auto statement : blocks[block].statements)
+        numberStatement(statement, available);
+    if(blocks[block].condition != nullptr)
+    {
+        // The condition of a loop is generated before the loop and at the end of each iteration, or not at all if
+        // the loop is fully unrolled, so it can't be the first computation of a value
+        bool isLoopCondition = graph.getLoopOfHeader(block) != nullptr;
+        numberRootExpression(blocks[block].condition, available, !isLoopCondition);
+    }
+
+    for(size_t child : dominatorTree.getChildren(block))
+    {
+        AvailableValues childAvailable = available;
+        const auto& predecessors = blocks[child].predecessors;
+        if(predecessors.size() > 1)
+        {
+            // The child can be reached through other blocks after this one (the branches of an `if`, or the body of a
+            // loop when the child is its header): the values they change aren't available anymore
+            std::vector<bool> isVisited(blocks.size(), false);
+            std::vector<size_t> toVisit(predecessors.begin(), predecessors.end());
+            while(!toVisit.empty())
+            {
+                size_t current = toVisit.back();
+                toVisit.pop_back();
+                if(current == block || isVisited[current])
+                    continue;
+                isVisited[current] = true;
+
+                if(effects[current].clobbersMemory)
+                    childAvailable.clear();
+                for(const auto& variableName : effects[current].modifiedVariables)
+                    forgetValuesOf(variableName, childAvailable);
+                toVisit.insert(toVisit.end(), blocks[current].predecessors.begin(), blocks[current].predecessors.end());
+            }
+        }
+        visitBlock(child, childAvailable, graph, dominatorTree, effects);
+    }
+}
+
+void GlobalValueNumbering::numberStatement(const StatementNode* statement, AvailableValues& available)
+{
+    std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+            forgetValuesOf(node->name->ident.value.value(), available);
+        else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+        {
+            // The index of an element is computed before the value written in it
+            if(node->index.has_value())
+                numberRootExpression(node->index.value(), available, true);
+            numberRootExpression(node->value, available, true);
+            if(!node->index.has_value())
+                forgetValuesOf(node->name->ident.value.value(), available);
+        }
+        else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+            numberRootExpression(node->expression, available, true);
+        else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+        {
+            bool clobbersMemory = mayClobberMemory(node->functionName->ident.value.value());
+            for(auto argument : node->arguments)
+                clobbersMemory |= containsClobberingCall(argument);
+            if(clobbersMemory)
+            {
+                available.clear();
+                return;
+            }
+            for(auto argument : node->arguments)
+                numberExpression(argument, available, true);
+        }
+        else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+        {
+            // The code written by the user without operands can change any variable, the other code changes only its outputs
+            if(asmMacroClobbersMemory(node) || containsClobberingAsmInput(node))
+            {
+                available.clear();
+                return;
+            }
+            for(const std::string& output : asmOutputsOf(node))
+                forgetValuesOf(output, available);
+        }
+    }, statement->variant);
+}
+
+void GlobalValueNumbering::numberRootExpression(const ExpressionNode* expression, AvailableValues& available, bool canDefineValues)
+{
+    // The values computed before a call that may write in memory can't be trusted after it, and the order of evaluation
+    // of the operands decides which ones are computed before it: the whole expression is left as it is
+    if(containsClobberingCall(expression))
+    {
+        available.clear();
+        return;
+    }
+    numberExpression(expression, available, canDefineValues);
+}
+
+void GlobalValueNumbering::numberExpression(const ExpressionNode* expression, AvailableValues& available, bool canDefineValues)
+{
+    expression = ast::skipBrackets(expression);
+    // A hoisted expression is computed in the preheader of its loop, in a different place than the one in the graph
+    if(loopInvariants != nullptr && loopInvariants->isHoisted(expression))
+        return;
+
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        std::unordered_set<std::string> variables;
+        // A comparison (or `&&` and `||`) is better left where it is, so that it's fused with its conditional jump
+        auto key = isComparison(binary->operation) ? std::nullopt : valueKeyOf(expression, variables);
+        if(key.has_value())
+        {
+            auto value = available.find(key.value());
+            if(value != available.end())
+            {
+                auto leaderSlot = savedSlots.find(value->second.leader);
+                if(leaderSlot != savedSlots.end())
+                {
+                    reusedSlots[expression] = leaderSlot->second;
+                    return;
+                }
+                if(slotsCount < MAX_REUSED_VALUES)
+                {
+                    savedSlots[value->second.leader] = slotsCount;
+                    reusedSlots[expression] = slotsCount;
+                    slotsCount++;
+                    return;
+                }
+            }
+        }
+
+        numberExpression(binary->lhs, available, canDefineValues);
+        // The right operand of `&&` and `||` isn't always evaluated, so its values can't be reused after it
+        bool isShortCircuit = binary->operation == Operator::And || binary->operation == Operator::Or;
+        numberExpression(binary->rhs, available, canDefineValues && !isShortCircuit);
+        if(key.has_value() && canDefineValues && !available.contains(key.value()))
+            available[key.value()] = AvailableValue { .leader = expression, .variables = variables };
+        return;
+    }
+
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+    {
+        for(auto argument : std::get<ExpressionFunctionCallNode*>(atom->variant)->arguments)
+            numberExpression(argument, available, canDefineValues);
+    }
+    else if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+        numberExpression(std::get<ExpressionIndexNode*>(atom->variant)->index, available, canDefineValues);
+}
+
+bool GlobalValueNumbering::containsClobberingCall(const ExpressionNode* expression) const
+{
+    expression = ast::skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        return containsClobberingCall(binary->lhs) || containsClobberingCall(binary->rhs);
+    }
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+        return containsClobberingCall(std::get<ExpressionIndexNode*>(atom->variant)->index);
+    if(!std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+        return false;
+    auto call = std::get<ExpressionFunctionCallNode*>(atom->variant);
+    return mayClobberMemory(call->functionName->ident.value.value()) ||
+        std::any_of(call->arguments.begin(), call->arguments.end(), [&](const ExpressionNode* argument) { return containsClobberingCall(argument); });
+}
+
+bool GlobalValueNumbering::containsClobberingAsmInput(const StatementMacroNode* macro) const
+{
+    std::string error;
+    std::optional<AsmMacro> asmMacro = hasAsmOperands(macro) ? parseAsmMacro(macro, error) : std::nullopt;
+    if(!asmMacro.has_value())
+        return false;
+    return std::any_of(asmMacro->operands.begin(), asmMacro->operands.end(), [&](const AsmOperand& operand)
+    {
+        return operand.type == AsmOperandType::Input && containsClobberingCall(operand.value);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <optional>
+#include <functional>
+
+#include "../parser/node/statement.hpp"
+#include "../analysis/control_flow_graph.hpp"
+#include "../analysis/dominator_tree.hpp"
+#include "loop_invariant_code_motion.hpp"
+
+/**
+ * @brief Class responsible for finding the computations whose result has already been computed before.
+ *
+ * The dominator tree is visited from the entry, carrying the table of the values available at the start of each block:
+ * two expressions get the same value number when they apply the same operator to the same values (`a * b` and `b * a`
+ * too). When an expression is computed again, the first computation saves its result in a slot of the stack frame and
+ * the other one reads it from there.
+ * A value is forgotten when one of its variables is assigned (also as an output of an `asm!` macro), and all the values
+ * are forgotten by the `asm!` macros and the calls of the functions that may write in memory, since the slots are in memory too.
+ */
+class GlobalValueNumbering
+{
+public:
+    /**
+     * @brief Analyze some statements (the code of a function, or the code outside of the functions).
+     * @param mayClobberMemory Tells if calling the function with the given name may write in the stack frame of the caller.
+     * @param loopInvariants The expressions computed before the loops, that are left untouched.
+     */
+    GlobalValueNumbering(const std::vector<StatementNode*>& statements, std::function<bool(const std::string&)> mayClobberMemory,
+                         const LoopInvariantCodeMotion* loopInvariants);
+
+    /**
+     * @brief Get the slot where the result of an expression must be saved after computing it, because it's used again later.
+     */
+    std::optional<size_t> getSavedSlot(const ExpressionNode* expression) const;
+    /**
+     * @brief Get the slot that already contains the result of an expression, so that it doesn't need to be computed.
+     */
+    std::optional<size_t> getReusedSlot(const ExpressionNode* expression) const;
+    /**
+     * @brief Get the number of slots of the stack frame needed to keep the results.
+     */
+    size_t getSlotsCount() const;
+
+private:
+    struct AvailableValue
+    {
+        const ExpressionNode* leader;
+        std::unordered_set<std::string> variables;
+    };
+    using AvailableValues = std::unordered_map<std::string, AvailableValue>;
+
+    /// What a block can change of the values computed before it.
+    struct BlockEffects
+    {
+        std::unordered_set<std::string> modifiedVariables;
+        bool clobbersMemory = false;
+    };
+
+    void visitBlock(size_t block, AvailableValues available, const ControlFlowGraph& graph, const DominatorTree& dominatorTree,
+                    const std::vector<BlockEffects>& effects);
+    void numberStatement(const StatementNode* statement, AvailableValues& available);
+    void numberRootExpression(const ExpressionNode* expression, AvailableValues& available, bool canDefineValues);
+    void numberExpression(const ExpressionNode* expression, AvailableValues& available, bool canDefineValues);
+    bool containsClobberingCall(const ExpressionNode* expression) const;
+    /**
+     * @brief Check if an input of an `asm!` macro with operands calls a function that may write in memory.
+     */
+    bool containsClobberingAsmInput(const StatementMacroNode* macro) const;
+
+    std::function<bool(const std::string&)> mayClobberMemory;
+    const LoopInvariantCodeMotion* loopInvariants;
+    std::unordered_map<const ExpressionNode*, size_t> savedSlots;
+    std::unordered_map<const ExpressionNode*, size_t> reusedSlots;
+    size_t slotsCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "loop_invariant_code_motion.hpp"
+
+#include <algorithm>
+
+#include "ast.hpp"
+#include "../generation/asm_macro.hpp"
+
+// Each hoisted expression takes a slot of the stack frame
+const size_t MAX_HOISTED_EXPRESSIONS_PER_LOOP = 8;
+
+static bool isNonZeroNumber(const ExpressionNode* expression)
+{
+    auto number = ast::numberOf(expression);
+    return number.has_value() && number.value() != 0;
+}
+
+static bool isComparison(Operator operation)
+{
+    return operation == Operator::GreaterThan || operation == Operator::LessThan || operation == Operator::EqualTo || operation == Operator::NotEqualTo ||
+        operation == Operator::And || operation == Operator::Or;
+}
+
+// The right operand of `&&` and `||` is evaluated only when the left one doesn't decide the result
+static bool isShortCircuit(Operator operation)
+{
+    return operation == Operator::And || operation == Operator::Or;
+}
+
+/**
+ * @brief Check if an expression gives the same result in every iteration of a loop.
+ * @param isExecutedInEveryIteration If false, a division that could fail can't be computed before the loop.
+ */
+static bool isInvariant(const ExpressionNode* expression, const std::unordered_set<std::string>& modifiedVariables, bool isExecutedInEveryIteration)
+{
+    return std::visit([&](auto node)
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+        {
+            if(node->operation == Operator::Div && !isExecutedInEveryIteration && !isNonZeroNumber(node->rhs))
+                return false;
+            return isInvariant(node->lhs, modifiedVariables, isExecutedInEveryIteration) &&
+                isInvariant(node->rhs, modifiedVariables, isExecutedInEveryIteration && !isShortCircuit(node->operation));
+        }
+        else
+        {
+            return std::visit([&](auto atom)
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                    return true;
+                else if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+                    return !modifiedVariables.contains(atom->ident.value.value());
+                else if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return isInvariant(atom->expression, modifiedVariables, isExecutedInEveryIteration);
+                else
+                    // A function can have side effects, and the elements of an array can be written in the loop
+                    return false;
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+LoopInvariantCodeMotion::LoopInvariantCodeMotion(const std::vector<StatementNode*>& statements)
+{
+    ControlFlowGraph graph(statements);
+    DominatorTree dominatorTree(graph);
+    LoopNest loopNest(graph, dominatorTree);
+    for(auto loop : loopNest.getOutermostLoops())
+        analyzeLoop(loop, graph, dominatorTree);
+}
+
+const std::vector<const ExpressionNode*>& LoopInvariantCodeMotion::getHoistedExpressions(const StatementWhileNode* loop) const
+{
+    static const std::vector<const ExpressionNode*> NONE;
+    auto hoisted = hoistedExpressions.find(loop);
+    if(hoisted == hoistedExpressions.end())
+        return NONE;
+    return hoisted->second;
+}
+
+bool LoopInvariantCodeMotion::isHoisted(const ExpressionNode* expression) const
+{
+    return alreadyHoisted.contains(expression);
+}
+
+void LoopInvariantCodeMotion::analyzeLoop(const Loop* loop, const ControlFlowGraph& graph, const DominatorTree& dominatorTree)
+{
+    const auto& blocks = graph.getBlocks();
+
+    // The variables declared or assigned in any block of the loop
+    std::unordered_set<std::string> modifiedVariables;
+    bool containsAsmMacro = false;
+    for(size_t block = 0; block < blocks.size(); block++)
+    {
+        if(!loop->blocks[block])
+            continue;
+        for(auto statement : blocks[block].statements)
+        {
+            std::visit([&](auto node)
+            {
+                using T = std::decay_t<decltype(node)>;
+                if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+                    modifiedVariables.insert(node->name->ident.value.value());
+                else if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+                {
+                    if(!node->index.has_value())
+                        modifiedVariables.insert(node->name->ident.value.value());
+                }
+                else if constexpr (std::is_same_v<T, StatementMacroNode*>)
+                {
+                    for(const std::string& output : asmOutputsOf(node))
+                        modifiedVariables.insert(output);
+                    containsAsmMacro |= node->macroName->ident.value.value() == "asm!" && !hasAsmOperands(node);
+                }
+            }, statement->variant);
+        }
+    }
+
+    // A `return` leaves the loop without going through its header
+    bool hasOtherExits = false;
+    for(size_t block = 0; block < blocks.size(); block++)
+    {
+        if(!loop->blocks[block] || block == loop->header)
+            continue;
+        hasOtherExits |= std::any_of(blocks[block].successors.begin(), blocks[block].successors.end(),
+            [&](size_t successor) { return !loop->blocks[successor]; });
+    }
+
+    // The code written by the user without operands can change any variable
+    if(loop->statement != nullptr && !containsAsmMacro)
+    {
+        std::vector<const ExpressionNode*> hoisted;
+        for(size_t block = 0; block < blocks.size(); block++)
+        {
+            if(!loop->blocks[block])
+                continue;
+            // When the loop can only be left from its header, a block that dominates the latches runs in every iteration
+            bool isExecutedInEveryIteration = !hasOtherExits && std::all_of(loop->latches.begin(), loop->latches.end(),
+                [&](size_t latch) { return dominatorTree.dominates(block, latch); });
+
+            for(auto statement : blocks[block].statements)
+            {
+                std::visit([&](auto node)
+                {
+                    using T = std::decay_t<decltype(node)>;
+                    if constexpr (std::is_same_v<T, StatementAssignVariableNode*>)
+                    {
+                        if(node->index.has_value())
+                            hoistInvariants(node->index.value(), modifiedVariables, isExecutedInEveryIteration, hoisted);
+                        hoistInvariants(node->value, modifiedVariables, isExecutedInEveryIteration, hoisted);
+                    }
+                    else if constexpr (std::is_same_v<T, StatementReturnNode*>)
+                        hoistInvariants(node->expression, modifiedVariables, isExecutedInEveryIteration, hoisted);
+                    else if constexpr (std::is_same_v<T, ExpressionFunctionCallNode*>)
+                    {
+                        for(auto argument : node->arguments)
+                            hoistInvariants(argument, modifiedVariables, isExecutedInEveryIteration, hoisted);
+                    }
+                }, statement->variant);
+            }
+            if(blocks[block].condition != nullptr)
+                hoistInvariants(blocks[block].condition, modifiedVariables, isExecutedInEveryIteration, hoisted);
+        }
+        if(!hoisted.empty())
+            hoistedExpressions[loop->statement] = hoisted;
+    }
+
+    for(auto innerLoop : loop->innerLoops)
+        analyzeLoop(innerLoop, graph, dominatorTree);
+}
+
+void LoopInvariantCodeMotion::hoistInvariants(const ExpressionNode* expression, const std::unordered_set<std::string>& modifiedVariables,
+                                              bool isExecutedInEveryIteration, std::vector<const ExpressionNode*>& hoisted)
+{
+    expression = ast::skipBrackets(expression);
+    if(alreadyHoisted.contains(expression) || hoisted.size() >= MAX_HOISTED_EXPRESSIONS_PER_LOOP)
+        return;
+
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        // A comparison is better left where it is, so that it's fused with its conditional jump
+        if(!isComparison(binary->operation) && isInvariant(expression, modifiedVariables, isExecutedInEveryIteration))
+        {
+            hoisted.push_back(expression);
+            alreadyHoisted.insert(expression);
+            return;
+        }
+        hoistInvariants(binary->lhs, modifiedVariables, isExecutedInEveryIteration, hoisted);
+        hoistInvariants(binary->rhs, modifiedVariables, isExecutedInEveryIteration && !isShortCircuit(binary->operation), hoisted);
+    }
+    else
+    {
+        auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+        if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+        {
+            for(auto argument : std::get<ExpressionFunctionCallNode*>(atom->variant)->arguments)
+                hoistInvariants(argument, modifiedVariables, isExecutedInEveryIteration, hoisted);
+        }
+        else if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+            hoistInvariants(std::get<ExpressionIndexNode*>(atom->variant)->index, modifiedVariables, isExecutedInEveryIteration, hoisted);
+    }
+}
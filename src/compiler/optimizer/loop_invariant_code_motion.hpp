@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+
+#include "../parser/node/statement.hpp"
+#include "../analysis/control_flow_graph.hpp"
+#include "../analysis/dominator_tree.hpp"
+#include "../analysis/loop_nest.hpp"
+
+/**
+ * @brief Class responsible for finding the computations inside the loops that give the same result in every iteration.
+ *
+ * The loops are visited from the outermost ones, so a computation is moved out of as many loops as possible.
+ * The generator computes the hoisted expressions once in the preheader of the loop (after the check of the condition
+ * that guards the loop), stores them in the stack frame and reads them from there inside the loop.
+ */
+class LoopInvariantCodeMotion
+{
+public:
+    /**
+     * @brief Analyze the loops in some statements (the code of a function, or the code outside of the functions).
+     */
+    LoopInvariantCodeMotion(const std::vector<StatementNode*>& statements);
+
+    /**
+     * @brief Get the expressions to compute before entering a loop, in the order they must be computed.
+     */
+    const std::vector<const ExpressionNode*>& getHoistedExpressions(const StatementWhileNode* loop) const;
+    /**
+     * @brief Check if an expression is computed before the loop that contains it.
+     */
+    bool isHoisted(const ExpressionNode* expression) const;
+
+private:
+    void analyzeLoop(const Loop* loop, const ControlFlowGraph& graph, const DominatorTree& dominatorTree);
+    void hoistInvariants(const ExpressionNode* expression, const std::unordered_set<std::string>& modifiedVariables,
+                         bool isExecutedInEveryIteration, std::vector<const ExpressionNode*>& hoisted);
+
+    std::unordered_map<const StatementWhileNode*, std::vector<const ExpressionNode*>> hoistedExpressions;
+    std::unordered_set<const ExpressionNode*> alreadyHoisted;
+};
@@ -0,0 +1,230 @@
+#include "loop_unrolling.hpp"
+
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "ast.hpp"
+#include "../generation/utils.hpp"
+
+// The body of a loop is copied only if the unrolled code has at most this number of statements
+const size_t MAX_UNROLLED_STATEMENTS = 64;
+
+// Counts the statements, the nested ones included
+static size_t countStatements(const std::vector<StatementNode*>& statements)
+{
+    size_t count = 0;
+    for(auto statement : statements)
+    {
+        count++;
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                count += countStatements(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                count += countStatements(node->scope->statements) + (node->elseScope.has_value() ? countStatements(node->elseScope.value()->statements) : 0);
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                count += countStatements(node->scope->statements);
+        }, statement->variant);
+    }
+    return count;
+}
+
+static bool containsLoop(const std::vector<StatementNode*>& statements)
+{
+    return std::any_of(statements.begin(), statements.end(), [](const StatementNode* statement)
+    {
+        return std::visit([](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return true;
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return containsLoop(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return containsLoop(node->scope->statements) || (node->elseScope.has_value() && containsLoop(node->elseScope.value()->statements));
+            else
+                return false;
+        }, statement->variant);
+    });
+}
+
+LoopUnrolling::LoopUnrolling(const std::vector<StatementNode*>& statements, size_t factor, size_t maxFullUnrollTripCount)
+    : factor(factor), maxFullUnrollTripCount(maxFullUnrollTripCount)
+{
+    analyze(statements);
+}
+
+const LoopUnrollingPlan* LoopUnrolling::getPlan(const StatementWhileNode* loop) const
+{
+    auto plan = plans.find(loop);
+    if(plan == plans.end())
+        return nullptr;
+    return &plan->second;
+}
+
+size_t LoopUnrolling::getSlotsCount() const
+{
+    return slotsCount;
+}
+
+std::optional<CountedLoop> LoopUnrolling::findCountedLoop(const StatementWhileNode* loop)
+{
+    // The condition is `i < bound`
+    auto condition = ast::skipBrackets(loop->condition);
+    if(!std::holds_alternative<ExpressionBinaryOperatorNode*>(condition->variant))
+        return std::nullopt;
+    auto comparison = std::get<ExpressionBinaryOperatorNode*>(condition->variant);
+    auto inductionVariable = ast::variableNameOf(comparison->lhs);
+    auto boundVariable = ast::variableNameOf(comparison->rhs);
+    if(comparison->operation != Operator::LessThan || !inductionVariable.has_value() || (!boundVariable.has_value() && !ast::numberOf(comparison->rhs).has_value()))
+        return std::nullopt;
+
+    // The last statement is `i = i + step`
+    const auto& body = loop->scope->statements;
+    if(body.empty() || !std::holds_alternative<StatementAssignVariableNode*>(body.back()->variant))
+        return std::nullopt;
+    auto increment = std::get<StatementAssignVariableNode*>(body.back()->variant);
+    auto incrementValue = ast::skipBrackets(increment->value);
+    if(increment->index.has_value() || increment->name->ident.value.value() != inductionVariable.value() || !std::holds_alternative<ExpressionBinaryOperatorNode*>(incrementValue->variant))
+        return std::nullopt;
+    auto addition = std::get<ExpressionBinaryOperatorNode*>(incrementValue->variant);
+    if(addition->operation != Operator::Add)
+        return std::nullopt;
+    std::optional<long long> step;
+    if(ast::variableNameOf(addition->lhs) == inductionVariable)
+        step = ast::numberOf(addition->rhs);
+    else if(ast::variableNameOf(addition->rhs) == inductionVariable)
+        step = ast::numberOf(addition->lhs);
+    if(!step.has_value() || step.value() <= 0)
+        return std::nullopt;
+
+    // Nothing else in the body changes the induction variable or the bound (the code written by the user could change anything)
+    std::vector<StatementNode*> bodyWithoutIncrement(body.begin(), body.end() - 1);
+    if(ast::isVariableModified(bodyWithoutIncrement, inductionVariable.value()) || utils::containsAsmMacro(body))
+        return std::nullopt;
+    if(boundVariable.has_value() && (boundVariable == inductionVariable || ast::isVariableModified(body, boundVariable.value())))
+        return std::nullopt;
+
+    return CountedLoop
+    {
+        .inductionVariable = inductionVariable.value(),
+        .bound = comparison->rhs,
+        .step = step.value()
+    };
+}
+
+void LoopUnrolling::analyze(const std::vector<StatementNode*>& statements)
+{
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                analyzeLoop(node, i > 0 ? statements[i - 1] : nullptr);
+                analyze(node->scope->statements);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                analyze(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                analyze(node->scope->statements);
+                if(node->elseScope.has_value())
+                    analyze(node->elseScope.value()->statements);
+            }
+        }, statements[i]->variant);
+    }
+}
+
+void LoopUnrolling::analyzeLoop(const StatementWhileNode* loop, const StatementNode* previousStatement)
+{
+    // Only the innermost loops are unrolled, to limit the growth of the code
+    // The labels of the code written by the user would be defined more than once
+    auto countedLoop = findCountedLoop(loop);
+    if(!countedLoop.has_value() || containsLoop(loop->scope->statements) || utils::containsAsmMacro(loop->scope->statements, [](auto) { return true; }))
+        return;
+    size_t bodySize = countStatements(loop->scope->statements);
+
+    // The loop runs a known number of times if it's preceded by `i = start` and the bound is a constant
+    auto bound = ast::numberOf(countedLoop.value().bound);
+    if(bound.has_value() && previousStatement != nullptr && std::holds_alternative<StatementAssignVariableNode*>(previousStatement->variant))
+    {
+        auto initialization = std::get<StatementAssignVariableNode*>(previousStatement->variant);
+        auto start = ast::numberOf(initialization->value);
+        if(!initialization->index.has_value() && initialization->name->ident.value.value() == countedLoop.value().inductionVariable && start.has_value())
+        {
+            long long step = countedLoop.value().step;
+            long long tripCount = start.value() < bound.value() ? (bound.value() - start.value() + step - 1) / step : 0;
+            if(tripCount <= (long long) maxFullUnrollTripCount && tripCount * bodySize <= MAX_UNROLLED_STATEMENTS)
+            {
+                plans[loop] = LoopUnrollingPlan
+                {
+                    .fullUnrollTripCount = tripCount,
+                    .factor = (size_t) tripCount,
+                    .unrolledCondition = nullptr,
+                    .unrolledBoundVariable = std::nullopt,
+                    .bound = countedLoop.value().bound,
+                    .offset = 0
+                };
+                return;
+            }
+        }
+    }
+
+    if(factor <= 1 || factor * bodySize > MAX_UNROLLED_STATEMENTS)
+        return;
+    // The offset is subtracted with an immediate operand, and a constant bound must stay representable after the subtraction
+    long long step = countedLoop.value().step;
+    if(step > std::numeric_limits<int32_t>::max() / (long long) (factor - 1))
+        return;
+    long long offset = step * (long long) (factor - 1);
+    if(bound.has_value() && bound.value() < std::numeric_limits<long long>::min() + offset)
+        return;
+
+    // The name can't be used by a variable of the program
+    std::optional<std::string> boundVariable;
+    if(!bound.has_value())
+        boundVariable = "unrolled bound " + std::to_string(slotsCount++);
+    plans[loop] = LoopUnrollingPlan
+    {
+        .fullUnrollTripCount = std::nullopt,
+        .factor = factor,
+        .unrolledCondition = createUnrolledCondition(countedLoop.value(), offset, boundVariable),
+        .unrolledBoundVariable = boundVariable,
+        .bound = countedLoop.value().bound,
+        .offset = offset
+    };
+}
+
+const ExpressionNode* LoopUnrolling::createUnrolledCondition(const CountedLoop& countedLoop, long long offset, const std::optional<std::string>& boundVariable)
+{
+    auto literal = [&](long long value)
+    {
+        literalNodes.push_back(ExpressionLiteralNode { .literal = Token { .type = TokenType::LiteralNumber, .value = std::to_string(value) } });
+        atomNodes.push_back(ExpressionAtomNode { .variant = &literalNodes.back() });
+        expressionNodes.push_back(ExpressionNode { .variant = &atomNodes.back() });
+        return &expressionNodes.back();
+    };
+    auto binary = [&](ExpressionNode* lhs, ExpressionNode* rhs, Operator operation)
+    {
+        binaryNodes.push_back(ExpressionBinaryOperatorNode { .lhs = lhs, .rhs = rhs, .operation = operation });
+        expressionNodes.push_back(ExpressionNode { .variant = &binaryNodes.back() });
+        return &expressionNodes.back();
+    };
+
+    auto ident = [&](const std::string& name)
+    {
+        identNodes.push_back(ExpressionIdentNode { .ident = Token { .type = TokenType::Ident, .value = name } });
+        atomNodes.push_back(ExpressionAtomNode { .variant = &identNodes.back() });
+        expressionNodes.push_back(ExpressionNode { .variant = &atomNodes.back() });
+        return &expressionNodes.back();
+    };
+
+    // `i < bound - offset`, where `bound - offset` is computed while compiling or before the loop: `i + offset < bound` could overflow
+    if(boundVariable.has_value())
+        return binary(ident(countedLoop.inductionVariable), ident(boundVariable.value()), Operator::LessThan);
+    return binary(ident(countedLoop.inductionVariable), literal(ast::numberOf(countedLoop.bound).value() - offset), Operator::LessThan);
+}
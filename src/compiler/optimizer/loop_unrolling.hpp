@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "../parser/node/statement.hpp"
+
+/**
+ * @brief Structure representing a while loop that counts with an induction variable: `while i < bound { ...; i = i + step; }`.
+ *
+ * The induction variable is changed only by the last statement of the body, and the bound doesn't change inside the loop.
+ */
+struct CountedLoop
+{
+    std::string inductionVariable;
+    const ExpressionNode* bound;
+    long long step;
+};
+
+/**
+ * @brief Structure representing how the generator unrolls a counted loop.
+ */
+struct LoopUnrollingPlan
+{
+    /// The number of iterations, when it's known and small enough to replace the loop with copies of its body.
+    std::optional<long long> fullUnrollTripCount;
+    /// The number of copies of the body executed by each iteration of the unrolled loop.
+    size_t factor;
+    /// True when at least `factor` iterations are left (`i < bound - step * (factor - 1)`).
+    /// The iterations left over by the unrolled loop are executed by a remainder loop with the original condition.
+    const ExpressionNode* unrolledCondition;
+    /// When the bound isn't a constant, the hidden variable compared with the induction variable by the unrolled condition.
+    /// It's set to `bound - offset` before the loop, and the unrolled loop is skipped if the subtraction overflows.
+    std::optional<std::string> unrolledBoundVariable;
+    /// The bound of the loop.
+    const ExpressionNode* bound;
+    /// `step * (factor - 1)`, subtracted from the bound.
+    long long offset;
+};
+
+/**
+ * @brief Class responsible for choosing how to unroll the counted loops of some code.
+ */
+class LoopUnrolling
+{
+public:
+    /**
+     * @brief Analyze the loops in some statements (the code of a function, or the code outside of the functions).
+     * @param factor The number of copies of the body in a partially unrolled loop (1 disables the partial unrolling).
+     * @param maxFullUnrollTripCount The maximum number of iterations of a loop that is completely unrolled.
+     */
+    LoopUnrolling(const std::vector<StatementNode*>& statements, size_t factor, size_t maxFullUnrollTripCount);
+
+    /**
+     * @brief Get how a loop is unrolled, or nullptr if it's not unrolled.
+     */
+    const LoopUnrollingPlan* getPlan(const StatementWhileNode* loop) const;
+    /**
+     * @brief Get the number of slots of the stack frame needed by the hidden variables of the unrolled loops.
+     */
+    size_t getSlotsCount() const;
+
+    /**
+     * @brief Recognize the induction variable of a loop.
+     * @return The counted loop, or std::nullopt if the loop doesn't have the shape of a counted loop.
+     */
+    static std::optional<CountedLoop> findCountedLoop(const StatementWhileNode* loop);
+
+private:
+    void analyze(const std::vector<StatementNode*>& statements);
+    void analyzeLoop(const StatementWhileNode* loop, const StatementNode* previousStatement);
+    const ExpressionNode* createUnrolledCondition(const CountedLoop& countedLoop, long long offset, const std::optional<std::string>& boundVariable);
+
+    size_t factor;
+    size_t maxFullUnrollTripCount;
+    size_t slotsCount = 0;
+    std::unordered_map<const StatementWhileNode*, LoopUnrollingPlan> plans;
+
+    // The nodes of the conditions created by the pass (a deque never moves its elements)
+    std::deque<ExpressionNode> expressionNodes;
+    std::deque<ExpressionAtomNode> atomNodes;
+    std::deque<ExpressionIdentNode> identNodes;
+    std::deque<ExpressionLiteralNode> literalNodes;
+    std::deque<ExpressionBinaryOperatorNode> binaryNodes;
+};
@@ -0,0 +1,365 @@
+#include "loop_vectorization.hpp"
+
+#include <algorithm>
+
+#include "ast.hpp"
+
+// The line of the first token of an expression
+static size_t lineOf(const ExpressionNode* expression)
+{
+    return std::visit([](auto node) -> size_t
+    {
+        using T = std::decay_t<decltype(node)>;
+        if constexpr (std::is_same_v<T, ExpressionBinaryOperatorNode*>)
+            return lineOf(node->lhs);
+        else
+        {
+            return std::visit([](auto atom) -> size_t
+            {
+                using V = std::decay_t<decltype(atom)>;
+                if constexpr (std::is_same_v<V, ExpressionBracketsNode*>)
+                    return lineOf(atom->expression);
+                else if constexpr (std::is_same_v<V, ExpressionLiteralNode*>)
+                    return atom->literal.metadata.lineNumber;
+                else if constexpr (std::is_same_v<V, ExpressionIdentNode*>)
+                    return atom->ident.metadata.lineNumber;
+                else if constexpr (std::is_same_v<V, ExpressionFunctionCallNode*>)
+                    return atom->functionName->ident.metadata.lineNumber;
+                else
+                    return atom->array->ident.metadata.lineNumber;
+            }, node->variant);
+        }
+    }, expression->variant);
+}
+
+static bool containsLoop(const std::vector<StatementNode*>& statements)
+{
+    return std::any_of(statements.begin(), statements.end(), [](const StatementNode* statement)
+    {
+        return std::visit([](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementWhileNode*>)
+                return true;
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                return containsLoop(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+                return containsLoop(node->scope->statements) || (node->elseScope.has_value() && containsLoop(node->elseScope.value()->statements));
+            else
+                return false;
+        }, statement->variant);
+    });
+}
+
+static bool containsElementRead(const ExpressionNode* expression)
+{
+    expression = ast::skipBrackets(expression);
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        return containsElementRead(binary->lhs) || containsElementRead(binary->rhs);
+    }
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+    {
+        const auto& arguments = std::get<ExpressionFunctionCallNode*>(atom->variant)->arguments;
+        return std::any_of(arguments.begin(), arguments.end(), containsElementRead);
+    }
+    return std::holds_alternative<ExpressionIndexNode*>(atom->variant);
+}
+
+// The registers needed to compute a value in the lanes, besides the ones of the invariants.
+// Each operation overwrites its left operand, so its right operand needs another register unless it's an invariant.
+static size_t countTemporaryRegisters(const ExpressionNode* expression, const std::vector<const ExpressionNode*>& invariants)
+{
+    expression = ast::skipBrackets(expression);
+    if(!std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant) ||
+       std::find(invariants.begin(), invariants.end(), expression) != invariants.end())
+        return 1;
+    auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+    bool isRhsInvariant = std::find(invariants.begin(), invariants.end(), ast::skipBrackets(binary->rhs)) != invariants.end();
+    return std::max(countTemporaryRegisters(binary->lhs, invariants), isRhsInvariant ? 1 : countTemporaryRegisters(binary->rhs, invariants) + 1);
+}
+
+// Splits the value of `sum = ...` in the terms added to `sum`, that must appear once and be added.
+// A term that doesn't read `sum` is kept whole, so that it can be an invariant.
+static bool findReductionTerms(const ExpressionNode* expression, const std::string& variableName, bool isSubtracted,
+                               std::vector<ReductionTerm>& terms, bool& hasVariable)
+{
+    expression = ast::skipBrackets(expression);
+    if(!ast::isVariableRead(expression, variableName))
+    {
+        terms.push_back(ReductionTerm { .value = expression, .isSubtracted = isSubtracted });
+        return true;
+    }
+    if(ast::variableNameOf(expression) == variableName)
+    {
+        bool isValid = !hasVariable && !isSubtracted;
+        hasVariable = true;
+        return isValid;
+    }
+    auto binary = std::get_if<ExpressionBinaryOperatorNode*>(&expression->variant);
+    if(binary == nullptr || ((*binary)->operation != Operator::Add && (*binary)->operation != Operator::Sub))
+        return false;
+    return findReductionTerms((*binary)->lhs, variableName, isSubtracted, terms, hasVariable) &&
+        findReductionTerms((*binary)->rhs, variableName, (*binary)->operation == Operator::Sub ? !isSubtracted : isSubtracted, terms, hasVariable);
+}
+
+LoopVectorization::LoopVectorization(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters,
+                                     size_t vectorSize, const LoopUnrolling* loopUnrolling)
+    : vectorSize(vectorSize), loopUnrolling(loopUnrolling)
+{
+    // The arrays passed as parameters may point to any elements
+    scopes.emplace_back();
+    for(const StatementDeclareVariableNode* parameter : parameters)
+    {
+        std::optional<Array> array;
+        if(parameter->arrayLength.has_value())
+            array = Array { .declaration = parameter, .hasElementsOnStack = false };
+        scopes.back()[parameter->name->ident.value.value()] = array;
+    }
+    analyze(statements);
+}
+
+const VectorizedLoop* LoopVectorization::getVectorizedLoop(const StatementWhileNode* loop) const
+{
+    auto vectorizedLoop = vectorizedLoops.find(loop);
+    if(vectorizedLoop == vectorizedLoops.end())
+        return nullptr;
+    return &vectorizedLoop->second;
+}
+
+const std::vector<LoopVectorizationReport>& LoopVectorization::getReports() const
+{
+    return reports;
+}
+
+void LoopVectorization::analyze(const std::vector<StatementNode*>& statements)
+{
+    scopes.emplace_back();
+    for(size_t i = 0; i < statements.size(); i++)
+    {
+        std::visit([&](auto node)
+        {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, StatementDeclareVariableNode*>)
+            {
+                // An array declared without a value has its elements in the stack frame
+                std::optional<Array> array;
+                if(node->arrayLength.has_value())
+                    array = Array { .declaration = node, .hasElementsOnStack = ast::initializationOf(statements, i) == nullptr };
+                scopes.back()[node->name->ident.value.value()] = array;
+            }
+            else if constexpr (std::is_same_v<T, StatementWhileNode*>)
+            {
+                VectorizedLoop vectorizedLoop;
+                std::optional<std::string> failure = vectorize(node, vectorizedLoop);
+                // The tokenizer counts the lines from 0
+                reports.push_back(LoopVectorizationReport
+                {
+                    .lineNumber = lineOf(node->condition) + 1,
+                    .isVectorized = !failure.has_value(),
+                    .description = failure.has_value() ? "not vectorized, " + failure.value() :
+                        "vectorized, " + std::to_string(vectorizedLoop.lanesCount) + " lanes of " + std::to_string(vectorizedLoop.elementSize * 8) + " bits"
+                });
+                if(!failure.has_value())
+                    vectorizedLoops[node] = std::move(vectorizedLoop);
+                analyze(node->scope->statements);
+            }
+            else if constexpr (std::is_same_v<T, StatementScopeNode*>)
+                analyze(node->statements);
+            else if constexpr (std::is_same_v<T, StatementIfNode*>)
+            {
+                analyze(node->scope->statements);
+                if(node->elseScope.has_value())
+                    analyze(node->elseScope.value()->statements);
+            }
+        }, statements[i]->variant);
+    }
+    scopes.pop_back();
+}
+
+std::optional<std::string> LoopVectorization::vectorize(const StatementWhileNode* loop, VectorizedLoop& vectorizedLoop) const
+{
+    if(containsLoop(loop->scope->statements))
+        return "it contains another loop";
+    auto countedLoop = LoopUnrolling::findCountedLoop(loop);
+    if(!countedLoop.has_value())
+        return "it isn't a counted loop `while i < bound { ...; i = i + step; }`";
+    if(countedLoop.value().step != 1)
+        return "its induction variable grows by " + std::to_string(countedLoop.value().step) + " instead of 1";
+    const LoopUnrollingPlan* unrolling = loopUnrolling != nullptr ? loopUnrolling->getPlan(loop) : nullptr;
+    if(unrolling != nullptr && unrolling->fullUnrollTripCount.has_value())
+        return "it's unrolled completely";
+    const auto& body = loop->scope->statements;
+    if(body.size() == 1)
+        return "it only increments its induction variable";
+
+    const std::string& inductionVariable = countedLoop.value().inductionVariable;
+    vectorizedLoop.inductionVariable = inductionVariable;
+    vectorizedLoop.bound = countedLoop.value().bound;
+    std::vector<std::string> reductionVariables;
+    for(size_t i = 0; i + 1 < body.size(); i++)
+    {
+        if(!std::holds_alternative<StatementAssignVariableNode*>(body[i]->variant))
+            return "it contains a statement that isn't an assignment";
+        auto assignment = std::get<StatementAssignVariableNode*>(body[i]->variant);
+        const std::string& name = assignment->name->ident.value.value();
+        if(assignment->index.has_value())
+        {
+            if(!findArray(name).has_value())
+                return "`" + name + "` isn't an array";
+            if(ast::variableNameOf(assignment->index.value()) != inductionVariable)
+                return "the index of `" + name + "` isn't `" + inductionVariable + "`";
+            vectorizedLoop.statements.push_back(VectorStatement { .assignment = assignment, .isReduction = false, .terms = { } });
+            vectorizedLoop.accesses.emplace_back(name, assignment->index.value());
+            continue;
+        }
+
+        // A reduction is `sum = sum + value - value...`, where the variable is added once
+        std::vector<ReductionTerm> terms;
+        bool hasVariable = false;
+        if(!findReductionTerms(assignment->value, name, false, terms, hasVariable) || !hasVariable)
+            return "`" + name + "` isn't accumulated with `+` or `-`";
+        if(findArray(name).has_value())
+            return "the array `" + name + "` is assigned";
+        if(std::find(reductionVariables.begin(), reductionVariables.end(), name) != reductionVariables.end())
+            return "`" + name + "` is accumulated more than once";
+        reductionVariables.push_back(name);
+        vectorizedLoop.statements.push_back(VectorStatement { .assignment = assignment, .isReduction = true, .terms = terms });
+    }
+
+    for(const VectorStatement& statement : vectorizedLoop.statements)
+    {
+        if(!statement.isReduction)
+        {
+            if(std::optional<std::string> failure = analyzeValue(statement.assignment->value, reductionVariables, vectorizedLoop))
+                return failure;
+            continue;
+        }
+        for(const ReductionTerm& term : statement.terms)
+        {
+            if(std::optional<std::string> failure = analyzeValue(term.value, reductionVariables, vectorizedLoop))
+                return failure;
+        }
+    }
+
+    // Every array must have elements of the same size, so that the lanes of all the registers are the same iterations
+    std::vector<std::string> arrays;
+    for(const auto& [arrayName, index] : vectorizedLoop.accesses)
+    {
+        if(std::find(arrays.begin(), arrays.end(), arrayName) == arrays.end())
+            arrays.push_back(arrayName);
+    }
+    if(arrays.empty())
+        return "it doesn't access any array";
+    vectorizedLoop.elementSize = ast::elementSizeOf(findArray(arrays.front()).value().declaration);
+    for(const std::string& arrayName : arrays)
+    {
+        if(ast::elementSizeOf(findArray(arrayName).value().declaration) != vectorizedLoop.elementSize)
+            return "it mixes `int` and `byte` elements";
+    }
+    vectorizedLoop.lanesCount = vectorSize / vectorizedLoop.elementSize;
+
+    size_t registersCount = reductionVariables.size() + vectorizedLoop.invariants.size();
+    size_t temporaryRegistersCount = 0;
+    for(const VectorStatement& statement : vectorizedLoop.statements)
+    {
+        if(!statement.isReduction)
+        {
+            temporaryRegistersCount = std::max(temporaryRegistersCount, countTemporaryRegisters(statement.assignment->value, vectorizedLoop.invariants));
+            continue;
+        }
+        for(const ReductionTerm& term : statement.terms)
+        {
+            // The bytes are added to the 64 bits sums with `psadbw`, that needs a register of zeros
+            if(vectorizedLoop.elementSize == 1)
+            {
+                auto atom = std::get_if<ExpressionAtomNode*>(&term.value->variant);
+                if(atom == nullptr || !std::holds_alternative<ExpressionIndexNode*>((*atom)->variant))
+                    return "a term accumulated in `" + statement.assignment->name->ident.value.value() + "` isn't a single byte";
+                registersCount = reductionVariables.size() + vectorizedLoop.invariants.size() + 1;
+            }
+            temporaryRegistersCount = std::max(temporaryRegistersCount, countTemporaryRegisters(term.value, vectorizedLoop.invariants));
+        }
+    }
+    if(registersCount + temporaryRegistersCount > MAX_VECTOR_REGISTERS)
+        return "it needs more than " + std::to_string(MAX_VECTOR_REGISTERS) + " vector registers";
+
+    // The arrays written by the loop may share elements with the other arrays, unless they are all in the stack frame
+    for(size_t i = 0; i < arrays.size(); i++)
+    {
+        for(size_t j = i + 1; j < arrays.size(); j++)
+        {
+            auto isStored = [&](const std::string& arrayName)
+            {
+                return std::any_of(vectorizedLoop.statements.begin(), vectorizedLoop.statements.end(), [&](const VectorStatement& statement)
+                {
+                    return !statement.isReduction && statement.assignment->name->ident.value.value() == arrayName;
+                });
+            };
+            if(!isStored(arrays[i]) && !isStored(arrays[j]))
+                continue;
+            if(findArray(arrays[i]).value().hasElementsOnStack && findArray(arrays[j]).value().hasElementsOnStack)
+                continue;
+            vectorizedLoop.aliasChecks.emplace_back(arrays[i], arrays[j]);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> LoopVectorization::analyzeValue(const ExpressionNode* expression, const std::vector<std::string>& reductionVariables,
+                                                           VectorizedLoop& vectorizedLoop) const
+{
+    expression = ast::skipBrackets(expression);
+    const std::string& inductionVariable = vectorizedLoop.inductionVariable;
+
+    // A value that doesn't read the elements, the induction variable or the reductions is the same in every iteration
+    bool isInvariant = !containsElementRead(expression) && !ast::containsFunctionCall(expression) && !ast::isVariableRead(expression, inductionVariable) &&
+        std::none_of(reductionVariables.begin(), reductionVariables.end(), [&](const std::string& name) { return ast::isVariableRead(expression, name); });
+    if(isInvariant)
+    {
+        vectorizedLoop.invariants.push_back(expression);
+        return std::nullopt;
+    }
+
+    if(std::holds_alternative<ExpressionBinaryOperatorNode*>(expression->variant))
+    {
+        auto binary = std::get<ExpressionBinaryOperatorNode*>(expression->variant);
+        if(binary->operation != Operator::Add && binary->operation != Operator::Sub)
+            return "its values use an operation that isn't `+` or `-`";
+        if(std::optional<std::string> failure = analyzeValue(binary->lhs, reductionVariables, vectorizedLoop))
+            return failure;
+        return analyzeValue(binary->rhs, reductionVariables, vectorizedLoop);
+    }
+
+    auto atom = std::get<ExpressionAtomNode*>(expression->variant);
+    if(std::holds_alternative<ExpressionIndexNode*>(atom->variant))
+    {
+        auto element = std::get<ExpressionIndexNode*>(atom->variant);
+        const std::string& arrayName = element->array->ident.value.value();
+        if(!findArray(arrayName).has_value())
+            return "`" + arrayName + "` isn't an array";
+        if(ast::variableNameOf(element->index) != inductionVariable)
+            return "the index of `" + arrayName + "` isn't `" + inductionVariable + "`";
+        vectorizedLoop.accesses.emplace_back(arrayName, element->index);
+        return std::nullopt;
+    }
+    if(std::holds_alternative<ExpressionFunctionCallNode*>(atom->variant))
+        return "it calls a function";
+    if(ast::variableNameOf(expression) == inductionVariable)
+        return "it uses `" + inductionVariable + "` as a value";
+    return "it reads a variable accumulated by the loop";
+}
+
+std::optional<LoopVectorization::Array> LoopVectorization::findArray(const std::string& name) const
+{
+    // The innermost variable with the name hides the others, even if it isn't an array
+    for(size_t i = scopes.size(); i-- > 0; )
+    {
+        auto variable = scopes[i].find(name);
+        if(variable != scopes[i].end())
+            return variable->second;
+    }
+    return std::nullopt;
+}
\ No newline at end of file
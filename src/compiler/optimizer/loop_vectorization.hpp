@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "../parser/node/statement.hpp"
+#include "loop_unrolling.hpp"
+
+/// The vector registers used by a vectorized loop: `xmm0`-`xmm5` (or `ymm0`-`ymm5`) aren't preserved by the calls
+/// in both the Windows and the System V conventions, so the code that calls the functions doesn't need to save them.
+const size_t MAX_VECTOR_REGISTERS = 6;
+
+/**
+ * @brief Structure representing a value added to (or subtracted from) the variable of a reduction in each iteration.
+ */
+struct ReductionTerm
+{
+    const ExpressionNode* value;
+    bool isSubtracted;
+};
+
+/**
+ * @brief Structure representing a statement of a vectorized loop, that computes its value for all the lanes at once.
+ */
+struct VectorStatement
+{
+    /// An assignment to an element `a[i] = value`, or a reduction like `sum = sum + a[i] - b[i]`.
+    const StatementAssignVariableNode* assignment;
+    bool isReduction;
+    /// The terms of the reduction, whose lanes are accumulated in a register and added to the variable after the loop.
+    std::vector<ReductionTerm> terms;
+};
+
+/**
+ * @brief Structure representing how the generator vectorizes a counted loop.
+ *
+ * Each iteration of the vector loop runs `lanesCount` iterations of the original loop, while enough of them are left
+ * (`i + lanesCount - 1 < bound`), and the scalar loop runs the others. The accesses use the induction variable as index.
+ */
+struct VectorizedLoop
+{
+    std::string inductionVariable;
+    const ExpressionNode* bound;
+    /// The size of the elements of every array accessed by the loop: 1 for `byte` and 8 for `int`.
+    size_t elementSize;
+    size_t lanesCount;
+    std::vector<VectorStatement> statements;
+    /// The indices of the elements read and written by the loop, with the name of their array.
+    std::vector<std::pair<std::string, const ExpressionNode*>> accesses;
+    /// The pairs of arrays that may share elements: the vector loop runs only if their addresses are the same or far enough.
+    std::vector<std::pair<std::string, std::string>> aliasChecks;
+    /// The values that don't change in the loop, copied in every lane of a register before entering it.
+    std::vector<const ExpressionNode*> invariants;
+};
+
+/**
+ * @brief Structure representing the result of the vectorization of a loop, shown to the user.
+ */
+struct LoopVectorizationReport
+{
+    size_t lineNumber;
+    bool isVectorized;
+    /// How the loop is vectorized, or why it isn't.
+    std::string description;
+};
+
+/**
+ * @brief Class responsible for finding the counted loops whose iterations can run in the lanes of the vector registers.
+ *
+ * A loop is vectorized when its body (except the increment of the induction variable by 1) contains only assignments
+ * to elements indexed by the induction variable and reductions, whose values add and subtract elements indexed by the
+ * induction variable and values that don't change in the loop, and all its arrays have elements of the same size.
+ */
+class LoopVectorization
+{
+public:
+    /**
+     * @brief Analyze the loops in some statements (the code of a function, or the code outside of the functions).
+     * @param parameters The parameters of the function, whose arrays can be accessed by the loops.
+     * @param vectorSize The size in bytes of a vector register: 16 for SSE2 and 32 for AVX2.
+     * @param loopUnrolling The loops that are unrolled, the completely unrolled ones aren't vectorized.
+     */
+    LoopVectorization(const std::vector<StatementNode*>& statements, const std::vector<StatementDeclareVariableNode*>& parameters,
+                      size_t vectorSize, const LoopUnrolling* loopUnrolling);
+
+    /**
+     * @brief Get how a loop is vectorized, or nullptr if it's not vectorized.
+     */
+    const VectorizedLoop* getVectorizedLoop(const StatementWhileNode* loop) const;
+    /**
+     * @brief Get the result of the vectorization of every loop, in the order of the code.
+     */
+    const std::vector<LoopVectorizationReport>& getReports() const;
+
+private:
+    struct Array
+    {
+        const StatementDeclareVariableNode* declaration;
+        bool hasElementsOnStack;
+    };
+
+    void analyze(const std::vector<StatementNode*>& statements);
+    /**
+     * @brief Try to vectorize a loop.
+     * @return The reason why the loop can't be vectorized, or std::nullopt if it's vectorized.
+     */
+    std::optional<std::string> vectorize(const StatementWhileNode* loop, VectorizedLoop& vectorizedLoop) const;
+    /**
+     * @brief Check if the value of a statement can be computed in the lanes, and collect its accesses and invariants.
+     * @return The reason why the value can't be vectorized, or std::nullopt if it can.
+     */
+    std::optional<std::string> analyzeValue(const ExpressionNode* expression, const std::vector<std::string>& reductionVariables,
+                                            VectorizedLoop& vectorizedLoop) const;
+    std::optional<Array> findArray(const std::string& name) const;
+
+    size_t vectorSize;
+    const LoopUnrolling* loopUnrolling;
+    /// The variables declared in each scope around the code being analyzed, with their array (std::nullopt if they aren't arrays).
+    std::vector<std::unordered_map<std::string, std::optional<Array>>> scopes;
+    std::unordered_map<const StatementWhileNode*, VectorizedLoop> vectorizedLoops;
+    std::vector<LoopVectorizationReport> reports;
+};
\ No newline at end of file
@@ -9,6 +9,7 @@ enum ParsingStatementErrorType
     MissingSemicolon,
     InvalidExpression,
     InvalidVariableDeclaration,
+    InvalidArrayLength,
     ScopeNotClosed,
     IfStatementDoesntHaveAValidCondition,
     IfStatementDoesntHaveAValidScope,
@@ -29,6 +30,7 @@ const std::unordered_map<ParsingStatementErrorType, std::string> parsingErrorToS
     { MissingSemicolon, "Missing semicolon!" },
     { InvalidExpression, "Invalid expression!" },
     { InvalidVariableDeclaration, "Invalid variable declaration!" },
+    { InvalidArrayLength, "The length of an array must be a positive number between `[` and `]`!" },
     { ScopeNotClosed, "Scope not closed!" },
     { IfStatementDoesntHaveAValidCondition, "If statement doesn't have a valid condition!" },
     { IfStatementDoesntHaveAValidScope, "If statement doesn't have a valid scope!" },
@@ -28,6 +28,12 @@ std::ostream& operator<<(std::ostream& os, const ExpressionBracketsNode &node)
     return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const ExpressionIndexNode &node)
+{
+    os << "ExpressionIndexNode " << *node.array << " [" << *node.index << "]";
+    return os;
+}
+
 std::ostream& operator<<(std::ostream& os, const ExpressionAtomNode &node)
 {
     std::visit([&](auto arg)
@@ -72,6 +78,10 @@ unsigned char formatOperator(Operator operation)
             return '=='; 
         case Operator::NotEqualTo: 
             return '!='; 
+        case Operator::And:
+            return '&';
+        case Operator::Or:
+            return '|';
     }
 
     return 0;
@@ -82,20 +92,24 @@ unsigned char precedenceOfOperator(Operator operation)
     switch(operation)
     {
         case Operator::Add:
-            return 2;
+            return 4;
         case Operator::Sub:
-            return 2;
+            return 4;
         case Operator::Mul:
-            return 3;
+            return 5;
         case Operator::Div:
-            return 3;
+            return 5;
         case Operator::GreaterThan:
-            return 1;
+            return 3;
         case Operator::LessThan:
-            return 1;
+            return 3;
         case Operator::EqualTo:
-            return 1;
+            return 3;
         case Operator::NotEqualTo:
+            return 3;
+        case Operator::And:
+            return 2;
+        case Operator::Or:
             return 1;
     }
 
@@ -63,6 +63,20 @@ struct ExpressionBracketsNode
  */
 std::ostream& operator<<(std::ostream& os, const ExpressionBracketsNode &node);
 
+/**
+ * @brief A structure representing the access to an element of an array: `array[index]`.
+ */
+struct ExpressionIndexNode
+{
+    ExpressionIdentNode* array;
+    ExpressionNode* index;
+};
+
+/**
+ * @brief Formats the node as a string for debugging purposes.
+ */
+std::ostream& operator<<(std::ostream& os, const ExpressionIndexNode &node);
+
 enum class Operator
 {
     Add,
@@ -72,7 +86,11 @@ enum class Operator
     GreaterThan,
     LessThan,
     EqualTo,
-    NotEqualTo
+    NotEqualTo,
+    /// `&&`: the right operand is evaluated only if the left one isn't 0.
+    And,
+    /// `||`: the right operand is evaluated only if the left one is 0.
+    Or
 };
 
 struct ExpressionBinaryOperatorNode
@@ -89,7 +107,7 @@ std::ostream& operator<<(std::ostream& os, const ExpressionBinaryOperatorNode &n
 
 struct ExpressionAtomNode
 {
-    std::variant<ExpressionLiteralNode*, ExpressionIdentNode*, ExpressionBracketsNode*, ExpressionFunctionCallNode*> variant;
+    std::variant<ExpressionLiteralNode*, ExpressionIdentNode*, ExpressionBracketsNode*, ExpressionFunctionCallNode*, ExpressionIndexNode*> variant;
 };
 
 /**
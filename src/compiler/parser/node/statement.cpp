@@ -8,13 +8,19 @@ std::ostream& operator<<(std::ostream& os, const StatementReturnNode &node)
 
 std::ostream& operator<<(std::ostream& os, const StatementDeclareVariableNode &node)
 {
-    os << "StatementDeclareVariableNode " << *node.type << " " << *node.name;
+    os << "StatementDeclareVariableNode " << *node.type;
+    if(node.arrayLength.has_value())
+        os << " [" << node.arrayLength.value() << "]";
+    os << " " << *node.name;
     return os;
 }
 
 std::ostream& operator<<(std::ostream& os, const StatementAssignVariableNode &node)
 {
-    os << "StatementAssignVariableNode " << *node.name << " = " << *node.value;
+    os << "StatementAssignVariableNode " << *node.name;
+    if(node.index.has_value())
+        os << " [" << *node.index.value() << "]";
+    os << " = " << *node.value;
     return os;
 }
 
@@ -36,6 +36,8 @@ struct StatementDeclareVariableNode
 {
     ExpressionIdentNode* type;
     ExpressionIdentNode* name;
+    /// The number of elements when the variable is an array (`int[N]` or `byte[N]`), whose value is the address of its first element.
+    std::optional<size_t> arrayLength = std::nullopt;
 };
 
 /**
@@ -47,6 +49,8 @@ struct StatementAssignVariableNode
 {
     ExpressionIdentNode* name;
     ExpressionNode* value;
+    /// The index of the element that is written, when the statement is `array[index] = value;`.
+    std::optional<ExpressionNode*> index = std::nullopt;
 };
 
 /**
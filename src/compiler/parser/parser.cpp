@@ -58,6 +58,10 @@ static std::optional<Operator> tokenTypeToOperator(TokenType tokenType)
             return Operator::EqualTo;
         case TokenType::NotEqualSign:
             return Operator::NotEqualTo;
+        case TokenType::DoubleAmpersand:
+            return Operator::And;
+        case TokenType::DoublePipe:
+            return Operator::Or;
         default:
             return std::nullopt;
     }
@@ -82,7 +86,18 @@ std::optional<ExpressionAtomNode*> Parser::parseExpressionAtom(std::queue<Token>
         else if (token.type == TokenType::Ident)
         {
             tokens.pop();
-            if(tokens.empty() || tokens.front().type != TokenType::OpenRoundBracket)
+            if(!tokens.empty() && tokens.front().type == TokenType::OpenSquareBracket)
+            {
+                tokens.pop();
+
+                std::optional<ExpressionNode*> index = parseIndex(tokens);
+                if(index.has_value())
+                {
+                    return allocator.allocate_and_initialize<ExpressionAtomNode>(allocator.allocate_and_initialize<ExpressionIndexNode>(
+                        allocator.allocate_and_initialize<ExpressionIdentNode>(token), index.value()));
+                }
+            }
+            else if(tokens.empty() || tokens.front().type != TokenType::OpenRoundBracket)
                 return allocator.allocate_and_initialize<ExpressionAtomNode>(allocator.allocate_and_initialize<ExpressionIdentNode>(token));
             else
             {
@@ -112,6 +127,22 @@ std::optional<ExpressionAtomNode*> Parser::parseExpressionAtom(std::queue<Token>
             return allocator.allocate_and_initialize<ExpressionAtomNode>(
                 allocator.allocate_and_initialize<ExpressionBracketsNode>(expression.value()));
         }
+        else if (token.type == TokenType::ExclamationMark)
+        {
+            // `!operand` is `(operand == 0)`, so that the generators and the optimizations handle it like any comparison
+            tokens.pop();
+            std::optional<ExpressionAtomNode*> operand = parseExpressionAtom(tokens);
+            if(!operand.has_value())
+            {
+                std::cerr << "Expected expression after `!`" << std::endl;
+                return std::nullopt;
+            }
+            ExpressionNode* zero = allocator.allocate_and_initialize<ExpressionNode>(allocator.allocate_and_initialize<ExpressionAtomNode>(
+                allocator.allocate_and_initialize<ExpressionLiteralNode>(Token { .type = TokenType::LiteralNumber, .value = "0", .metadata = token.metadata })));
+            ExpressionNode* comparison = allocator.allocate_and_initialize<ExpressionNode>(allocator.allocate_and_initialize<ExpressionBinaryOperatorNode>(
+                allocator.allocate_and_initialize<ExpressionNode>(operand.value()), zero, Operator::EqualTo));
+            return allocator.allocate_and_initialize<ExpressionAtomNode>(allocator.allocate_and_initialize<ExpressionBracketsNode>(comparison));
+        }
     }
 
     return std::nullopt;
@@ -151,6 +182,24 @@ std::optional<ExpressionNode*> Parser::parseExpressionInternal(std::queue<Token>
     return expressionLhs;
 }
 
+std::optional<ExpressionNode*> Parser::parseIndex(std::queue<Token>& tokens)
+{
+    std::optional<ExpressionNode*> index = parseExpression(tokens);
+    if(!index.has_value())
+    {
+        std::cerr << "Expected expression after `[`" << std::endl;
+        return std::nullopt;
+    }
+    if(tokens.empty() || tokens.front().type != TokenType::CloseSquareBracket)
+    {
+        std::cerr << "Expected `]` after `[`" << std::endl;
+        return std::nullopt;
+    }
+    tokens.pop();
+
+    return index;
+}
+
 std::optional<ExpressionFunctionCallNode*> Parser::parseExpressionFunctionCall(std::queue<Token>& tokens, Token functionName)
 {
     std::vector<ExpressionNode*> arguments;
@@ -183,11 +232,31 @@ std::optional<StatementDeclareVariableNode*> Parser::parseVariableDeclaration(st
 {
     auto variableType = tokens.front();
 
-    if (variableType.type == TokenType::KeywordInt || variableType.type == TokenType::KeywordString)
+    if (variableType.type == TokenType::KeywordInt || variableType.type == TokenType::KeywordString || variableType.type == TokenType::KeywordByte)
     {
         tokens.pop();
 
-        if (tokens.empty() || tokens.front().type != TokenType::Ident)
+        // `int[N] name` declares an array of N elements, and `byte` is only the type of the elements of an array
+        std::optional<size_t> arrayLength = std::nullopt;
+        if (!tokens.empty() && tokens.front().type == TokenType::OpenSquareBracket)
+        {
+            tokens.pop();
+            if (tokens.empty() || tokens.front().type != TokenType::LiteralNumber)
+            {
+                error = ParsingStatementError { .type = ParsingStatementErrorType::InvalidArrayLength, .metadata = variableType.metadata, .hint = variableType.format() };
+                return std::nullopt;
+            }
+            arrayLength = std::stoull(tokens.front().value.value());
+            tokens.pop();
+            if (tokens.empty() || tokens.front().type != TokenType::CloseSquareBracket || arrayLength.value() == 0)
+            {
+                error = ParsingStatementError { .type = ParsingStatementErrorType::InvalidArrayLength, .metadata = variableType.metadata, .hint = variableType.format() };
+                return std::nullopt;
+            }
+            tokens.pop();
+        }
+
+        if (tokens.empty() || tokens.front().type != TokenType::Ident || (variableType.type == TokenType::KeywordByte && !arrayLength.has_value()))
         {    
             error = ParsingStatementError { .type = ParsingStatementErrorType::InvalidVariableDeclaration, .metadata = variableType.metadata, .hint = variableType.format() };
             return std::nullopt;
@@ -196,7 +265,7 @@ std::optional<StatementDeclareVariableNode*> Parser::parseVariableDeclaration(st
         {
             return allocator.allocate_and_initialize<StatementDeclareVariableNode>(
                     allocator.allocate_and_initialize<ExpressionIdentNode>(variableType),
-                    allocator.allocate_and_initialize<ExpressionIdentNode>(tokens.front()));
+                    allocator.allocate_and_initialize<ExpressionIdentNode>(tokens.front()), arrayLength);
         }
     }
     return std::nullopt;
@@ -294,7 +363,20 @@ std::optional<StatementNode*> Parser::parseStatement(std::queue<Token> &tokens,
                         return std::nullopt;
                     }
                 }
-                else if (tokens.front().type == TokenType::EqualSign)
+                std::optional<ExpressionNode*> index = std::nullopt;
+                if (tokens.front().type == TokenType::OpenSquareBracket)
+                {
+                    tokens.pop();
+
+                    index = parseIndex(tokens);
+                    if (!index.has_value() || tokens.empty() || tokens.front().type != TokenType::EqualSign)
+                    {
+                        error = ParsingStatementError { .type = ParsingStatementErrorType::InvalidExpression, .metadata = firstToken.metadata, .hint = firstToken.format() };
+                        return std::nullopt;
+                    }
+                }
+
+                if (tokens.front().type == TokenType::EqualSign)
                 {
                     tokens.pop();
 
@@ -307,7 +389,7 @@ std::optional<StatementNode*> Parser::parseStatement(std::queue<Token> &tokens,
                             
                             return allocator.allocate_and_initialize<StatementNode>(
                                 allocator.allocate_and_initialize<StatementAssignVariableNode>(
-                                    allocator.allocate_and_initialize<ExpressionIdentNode>(variableIdent), expressionNode.value()
+                                    allocator.allocate_and_initialize<ExpressionIdentNode>(variableIdent), expressionNode.value(), index
                                 )
                             );
                         }
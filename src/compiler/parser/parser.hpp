@@ -51,6 +51,10 @@ private:
     std::optional<ExpressionAtomNode*> parseExpressionAtom(std::queue<Token>& tokens);
     
     std::optional<ExpressionFunctionCallNode*> parseExpressionFunctionCall(std::queue<Token>& tokens, Token functionName);
+    /**
+     * @brief Parse the index of an element of an array, after the `[`, and the `]` that closes it.
+     */
+    std::optional<ExpressionNode*> parseIndex(std::queue<Token>& tokens);
 
     std::optional<StatementNode*> parseStatement(std::queue<Token> &tokens, ParsingStatementError &error);
     std::optional<StatementScopeNode*> parseScope(std::queue<Token> &tokens, ParsingStatementError &error);
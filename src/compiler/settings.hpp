@@ -1,6 +1,27 @@
+#pragma once
+
+/**
+ * @brief Enumeration representing the kind of file written by the compiler.
+ */
+enum class OutputFormat
+{
+    /// The NASM source code of the program.
+    Assembly,
+    /// An ELF64 relocatable object file, that can be linked with other object files.
+    ObjectFile,
+    /// A statically linked ELF64 executable file.
+    Executable,
+    /// The C99 translation of the program, to be compiled by a C compiler.
+    C
+};
+
 struct CompilerSettings
 {
     bool showTokenizerOutput;
     bool showParserOutput;
     bool showGeneratorOutput;
+    bool showOptimizerStatistics;
+    /// Print the name of each step of the compilation before running it.
+    bool showCompilationSteps = true;
+    OutputFormat outputFormat = OutputFormat::Assembly;
 };
\ No newline at end of file
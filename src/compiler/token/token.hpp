@@ -16,6 +16,7 @@ enum class TokenType
     KeywordReturn, ///< Keyword "return".
     KeywordInt,
     KeywordString,
+    KeywordByte,
     KeywordIf,
     KeywordElse,
     KeywordWhile,
@@ -39,6 +40,10 @@ enum class TokenType
     NotEqualSign,
     GreaterThanSign,
     LessThanSign,
+
+    ExclamationMark,
+    DoubleAmpersand,
+    DoublePipe,
     
     PlusSign,
     MinusSign,
@@ -49,6 +54,8 @@ enum class TokenType
     CloseRoundBracket,
     OpenCurlyBracket,
     CloseCurlyBracket,
+    OpenSquareBracket,
+    CloseSquareBracket,
 };
 
 /**
@@ -79,6 +86,8 @@ struct Token
             return "KeywordInt";
         case TokenType::KeywordString:
             return "KeywordString";
+        case TokenType::KeywordByte:
+            return "KeywordByte";
         case TokenType::KeywordIf:
             return "KeywordIf";
         case TokenType::KeywordElse:
@@ -113,6 +122,12 @@ struct Token
             return "==";
         case TokenType::NotEqualSign:
             return "!=";
+        case TokenType::ExclamationMark:
+            return "!";
+        case TokenType::DoubleAmpersand:
+            return "&&";
+        case TokenType::DoublePipe:
+            return "||";
             
         case TokenType::GreaterThanSign:
             return ">";
@@ -136,6 +151,10 @@ struct Token
             return "{";
         case TokenType::CloseCurlyBracket:
             return "}";
+        case TokenType::OpenSquareBracket:
+            return "[";
+        case TokenType::CloseSquareBracket:
+            return "]";
 
         default:
             return "[Unknown]";
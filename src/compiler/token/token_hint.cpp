@@ -20,7 +20,8 @@ void ParsingToken::addCharacter(char character)
         else if(character == '=' || character == ';' || character == '>' || character == '<' || 
                 character == '+' || character == '-' || character == '*' || character == '/' || 
                 character == '(' || character == ')' || character == '{' || character == '}' ||
-                character == ',' || character == '!')
+                character == ',' || character == '!' || character == '[' || character == ']' ||
+                character == '&' || character == '|')
             hint = TokenHint::Sign;
         else if(std::isalpha(character))
             hint = TokenHint::Alphabetic;
@@ -83,7 +84,26 @@ std::optional<Token> ParsingToken::intoResultingToken(Meta& metadata)
         }
         case TokenHint::Sign:
         {
-            if(lastCharacter == ';')
+            // The `!` alone is checked before the single characters, so that it can be followed by a bracket
+            if(currentTokenValue.length() == 2 && currentTokenValue[0] == '!' && lastCharacter != '=')
+            {
+                token = Token { .type = TokenType::ExclamationMark, .metadata = metadata };
+
+                *this = ParsingToken();
+                addCharacter(lastCharacter);
+            }
+            else if(currentTokenValue.length() == 2 && (currentTokenValue[0] == '&' || currentTokenValue[0] == '|'))
+            {
+                if(lastCharacter == currentTokenValue[0])
+                    token = Token { .type = lastCharacter == '&' ? TokenType::DoubleAmpersand : TokenType::DoublePipe, .metadata = metadata };
+                else
+                    token = Token { .type = TokenType::Unknown, .value = currentTokenValue.substr(0, 1), .metadata = metadata };
+
+                *this = ParsingToken();
+                if(token->type == TokenType::Unknown)
+                    addCharacter(lastCharacter);
+            }
+            else if(lastCharacter == ';')
             {
                 token = Token { .type = TokenType::Semicolon, .metadata = metadata };
 
@@ -163,6 +183,18 @@ std::optional<Token> ParsingToken::intoResultingToken(Meta& metadata)
 
                 *this = ParsingToken();
             }
+            else if(lastCharacter == '[')
+            {
+                token = Token { .type = TokenType::OpenSquareBracket, .metadata = metadata };
+
+                *this = ParsingToken();
+            }
+            else if(lastCharacter == ']')
+            {
+                token = Token { .type = TokenType::CloseSquareBracket, .metadata = metadata };
+
+                *this = ParsingToken();
+            }
             else if(currentTokenValue.length() == 3 && currentTokenValue[0] == '!' && currentTokenValue[1] == '=' && lastCharacter != '=')
             {
                 token = Token { .type = TokenType::NotEqualSign, .metadata = metadata };
@@ -200,7 +232,7 @@ std::optional<Token> ParsingToken::intoResultingToken(Meta& metadata)
         }
         case TokenHint::Number:
         {
-            if(std::isspace(lastCharacter) || lastCharacter == ';' || lastCharacter == ')' || lastCharacter == ',')
+            if(std::isspace(lastCharacter) || lastCharacter == ';' || lastCharacter == ')' || lastCharacter == ',' || lastCharacter == ']')
             {
                 token = Token { .type = TokenType::LiteralNumber, .value = currentTokenValue.substr(0, currentTokenValue.length() - 1), .metadata = metadata };
 
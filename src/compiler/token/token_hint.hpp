@@ -60,6 +60,7 @@ const std::unordered_map<std::string, Token> tokenValueToKeywordToken = {
     { "return", Token { .type = TokenType::KeywordReturn }},
     { "int", Token { .type = TokenType::KeywordInt }},
     { "string", Token { .type = TokenType::KeywordString }},
+    { "byte", Token { .type = TokenType::KeywordByte }},
     { "if", Token { .type = TokenType::KeywordIf }},
     { "else", Token { .type = TokenType::KeywordElse }},
     { "while", Token { .type = TokenType::KeywordWhile }},
@@ -1,6 +1,8 @@
 #include "tokenizer.hpp"
 #include "token_hint.hpp"
 
+#include <cctype>
+
 Tokenizer::Tokenizer()
 {
 
@@ -40,4 +42,53 @@ std::vector<Token> Tokenizer::tokenize(const std::string& string)
     parseToken(parsingToken, tokens, Meta { .lineNumber = lineNumber, .columnNumber = columnNumber});
 
     return tokens;
+}
+
+std::string decodeStringLiteral(const std::string& text)
+{
+    std::string bytes;
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        if(text[i] != '\\' || i + 1 == text.size())
+        {
+            bytes.push_back(text[i]);
+            continue;
+        }
+        char escaped = text[++i];
+        switch(escaped)
+        {
+            case 'n': bytes.push_back('\n'); break;
+            case 't': bytes.push_back('\t'); break;
+            case 'r': bytes.push_back('\r'); break;
+            case 'a': bytes.push_back('\a'); break;
+            case 'b': bytes.push_back('\b'); break;
+            case 'f': bytes.push_back('\f'); break;
+            case 'v': bytes.push_back('\v'); break;
+            case 'e': bytes.push_back(0x1B); break;
+            case 'x':
+            {
+                int value = 0;
+                size_t digits = 0;
+                while(digits < 2 && i + 1 < text.size() && std::isxdigit((unsigned char) text[i + 1]))
+                {
+                    char digit = std::tolower(text[++i]);
+                    value = value * 16 + (std::isdigit((unsigned char) digit) ? digit - '0' : digit - 'a' + 10);
+                    digits++;
+                }
+                bytes.push_back(value);
+                break;
+            }
+            default:
+                if(escaped >= '0' && escaped <= '7')
+                {
+                    int value = escaped - '0';
+                    for(size_t digits = 1; digits < 3 && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '7'; digits++)
+                        value = value * 8 + (text[++i] - '0');
+                    bytes.push_back(value);
+                }
+                else
+                    bytes.push_back(escaped);
+        }
+    }
+    return bytes;
 }
\ No newline at end of file
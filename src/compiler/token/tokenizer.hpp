@@ -31,4 +31,11 @@ public:
      * @return A vector of Token objects representing the tokens found in the source code.
      */
     std::vector<Token> tokenize(const std::string& string);
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Get the characters of a string literal, replacing its escape sequences (like `\n` or `\x41`) with the characters they represent.
+ *
+ * The escape sequences are the ones of the backquoted strings of NASM, so the literals can be written as they are in the assembly code.
+ */
+std::string decodeStringLiteral(const std::string& literal);
\ No newline at end of file
@@ -8,14 +8,51 @@ int main(int argc, char* argv[])
     CLIArguments cliArguments = CLIArguments(argc, argv);
 
     char* pathToFileToCompile = cliArguments.getPathToFileToCompile();
+    if(pathToFileToCompile != nullptr && cliArguments.shouldInterpret())
+    {
+        Compiler compiler = Compiler(Tokenizer(), Parser(), Generator(GeneratorSettings { .checkBounds = cliArguments.shouldCheckBounds(),
+            .maxEvaluationSteps = cliArguments.getMaxEvaluationSteps(), .maxEvaluationDepth = cliArguments.getMaxEvaluationDepth() }), CompilerSettings {
+            .showTokenizerOutput = false,
+            .showParserOutput = false,
+            .showGeneratorOutput = false,
+            .showOptimizerStatistics = false,
+            .showCompilationSteps = false
+        });
+        return compiler.compileAndInterpret(pathToFileToCompile);
+    }
+
+    if(pathToFileToCompile != nullptr && cliArguments.shouldRun())
+    {
+        // The program is run with the runtime of the compiler, that provides the functions of the Windows target
+        Compiler compiler = Compiler(Tokenizer(), Parser(), Generator(GeneratorSettings { .checkBounds = cliArguments.shouldCheckBounds(), .useAvx2 = cliArguments.shouldUseAvx2(),
+            .maxEvaluationSteps = cliArguments.getMaxEvaluationSteps(), .maxEvaluationDepth = cliArguments.getMaxEvaluationDepth(), .targetPlatform = TargetPlatform::Windows }), CompilerSettings {
+            .showTokenizerOutput = false,
+            .showParserOutput = false,
+            .showGeneratorOutput = false,
+            .showOptimizerStatistics = false,
+            .showCompilationSteps = false
+        });
+        return compiler.compileAndRun(pathToFileToCompile);
+    }
+
     if(pathToFileToCompile != nullptr)
     {
-        Compiler compiler = Compiler(Tokenizer(), Parser(), Generator(), CompilerSettings {
+        Compiler compiler = Compiler(Tokenizer(), Parser(), Generator(GeneratorSettings { .checkBounds = cliArguments.shouldCheckBounds(), .useAvx2 = cliArguments.shouldUseAvx2(),
+            .maxEvaluationSteps = cliArguments.getMaxEvaluationSteps(), .maxEvaluationDepth = cliArguments.getMaxEvaluationDepth(), .targetPlatform = cliArguments.getTargetPlatform() }), CompilerSettings {
             .showTokenizerOutput = true,
             .showParserOutput = true,
-            .showGeneratorOutput = true
+            .showGeneratorOutput = true,
+            .showOptimizerStatistics = true,
+            .outputFormat = cliArguments.getOutputFormat()
         });
-        int compileStatus = compiler.compileAndWriteToFile(pathToFileToCompile, "out.asm");
+        const char* outputFilePath = "out.asm";
+        if(cliArguments.getOutputFormat() == OutputFormat::ObjectFile)
+            outputFilePath = "out.o";
+        else if(cliArguments.getOutputFormat() == OutputFormat::Executable)
+            outputFilePath = "out";
+        else if(cliArguments.getOutputFormat() == OutputFormat::C)
+            outputFilePath = "out.c";
+        int compileStatus = compiler.compileAndWriteToFile(pathToFileToCompile, outputFilePath);
         if(compileStatus != 0)
             return compileStatus;
     }
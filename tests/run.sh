@@ -0,0 +1,38 @@
+#!/bin/bash
+# Runs a test program in one way and compares what it writes (stdout and stderr) and its exit code with the file
+# with the same name ending in `.expected`, whose last line is `exit CODE`. A file ending in `.WAY.expected` replaces it
+# for the ways that behave differently (like the VM, that can't run the `asm!` code). The file ending in `.in`, if there's one,
+# is the input of the program.
+# The ways are: `native` (the Linux executable), `run` (`--run`), `vm` (`--vm`) and `c` (`--emit-c` compiled by `cc`).
+# Usage: tests/run.sh PATH_TO_COMPILER WAY PROGRAM
+COMPILER=$(realpath "$1")
+WAY=$2
+PROGRAM=$(realpath "$3")
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+INPUT="${PROGRAM%.bc}.in"
+[ -f "$INPUT" ] || INPUT=/dev/null
+cd "$WORK" || exit 1
+
+case "$WAY" in
+    native)
+        "$COMPILER" --emit-executable --target=linux "$PROGRAM" </dev/null >compile.txt 2>&1 && [ -f out ] || { cat compile.txt; exit 1; }
+        ./out <"$INPUT" >output.txt 2>&1
+        ;;
+    run|vm)
+        "$COMPILER" --"$WAY" "$PROGRAM" <"$INPUT" >output.txt 2>&1
+        ;;
+    c)
+        "$COMPILER" --emit-c "$PROGRAM" </dev/null >compile.txt 2>&1 && cc -O2 -o out_c out.c >>compile.txt 2>&1 || { cat compile.txt; exit 1; }
+        ./out_c <"$INPUT" >output.txt 2>&1
+        ;;
+    *)
+        echo "Unknown way to run the program: $WAY"
+        exit 1
+        ;;
+esac
+echo "exit $?" >>output.txt
+
+EXPECTED="${PROGRAM%.bc}.$WAY.expected"
+[ -f "$EXPECTED" ] || EXPECTED="${PROGRAM%.bc}.expected"
+diff -u "$EXPECTED" output.txt